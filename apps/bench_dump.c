@@ -0,0 +1,965 @@
+/**
+  End-to-end decoder benchmark.
+
+  Synthetic channel bitstreams (several minutes of CCH or TCH traffic) are
+  generated, passed through channel impairment model and decoded by
+  tetrapol_phys_ch_recv()/tetrapol_phys_ch_process() as tetrapol_dump does.
+  Decoder output is checked against golden results, so speedups can not
+  silently break decoding.
+
+  CCH corpus follows superframe structure: BCH (D_SYSTEM_INFO) in frames
+  0-3 and 100-103, PCH in 98/99, RCH in frames with number % 25 == 14
+  and SDCH in the rest. SDCH carries DU (UI) and connection oriented TPDUs
+  for many terminal addresses and stuffing frames when idle. TCH corpus
+  contains voice frames with signalling data blocks.
+ */
+#define _GNU_SOURCE     // fopencookie()
+
+#include <tetrapol/bit_utils.h>
+#include <tetrapol/cch_encoder.h>
+#include <tetrapol/data_frame.h>
+#include <tetrapol/frame.h>
+#include <tetrapol/hdlc_frame.h>
+#include <tetrapol/log.h>
+#include <tetrapol/misc.h>
+#include <tetrapol/phys_ch.h>
+#include <tetrapol/system_config.h>
+#include <tetrapol/tetrapol.h>
+#include <tetrapol/tpdu.h>
+#include <tetrapol/tsdu_encode.h>
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+enum {
+    /// frame takes 20 ms
+    FRAMES_PER_S = 50,
+    DURATION_DEFAULT = 180,
+    NTERMS_DEFAULT = 1000,
+    NRUNS_DEFAULT = 3,
+    /// length of dropout in frames
+    DROPOUT_LEN = 25,
+    /// size of chunks passed to decoder (as tetrapol_dump reads them)
+    CHUNK_LEN = 4096,
+};
+
+/// decoder output expected for default corpus parameters
+typedef struct {
+    unsigned long tsdus;
+    uint64_t hash;
+} golden_t;
+
+typedef struct {
+    const char *name;
+    int radio_ch_type;
+    int band;
+    double ber;         ///< bit error rate
+    double slip;        ///< probability of bit slip per frame
+    double dropout;     ///< probability of dropout (DROPOUT_LEN frames) per frame
+    double load;        ///< probability of new message when channel is idle
+    /// golden results for each FEC mode
+    golden_t golden[3];
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    {
+        .name = "cch",
+        .radio_ch_type = TETRAPOL_RADIO_CCH,
+        .band = TETRAPOL_BAND_UHF,
+        .load = 0.7,
+        .golden = {
+            [TETRAPOL_FEC_ACCURATE] = { 1792, 0x54b49821ad239b73ULL },
+            [TETRAPOL_FEC_FAST] = { 1792, 0x54b49821ad239b73ULL },
+            [TETRAPOL_FEC_ADAPTIVE] = { 1792, 0x54b49821ad239b73ULL },
+        },
+    },
+    {
+        .name = "cch_impaired",
+        .radio_ch_type = TETRAPOL_RADIO_CCH,
+        .band = TETRAPOL_BAND_UHF,
+        .ber = 0.01,
+        .slip = 0.002,
+        .dropout = 0.001,
+        .load = 0.7,
+        .golden = {
+            [TETRAPOL_FEC_ACCURATE] = { 1559, 0x159fce912c5de6a6ULL },
+            [TETRAPOL_FEC_FAST] = { 1400, 0x922987cb9911eb4bULL },
+            [TETRAPOL_FEC_ADAPTIVE] = { 1559, 0x159fce912c5de6a6ULL },
+        },
+    },
+    {
+        .name = "cch_vhf",
+        .radio_ch_type = TETRAPOL_RADIO_CCH,
+        .band = TETRAPOL_BAND_VHF,
+        .ber = 0.003,
+        .slip = 0.001,
+        .load = 0.9,
+        .golden = {
+            [TETRAPOL_FEC_ACCURATE] = { 918, 0x66b15509fff04d17ULL },
+            [TETRAPOL_FEC_FAST] = { 827, 0xb2a72c032d9a2dd4ULL },
+            [TETRAPOL_FEC_ADAPTIVE] = { 918, 0x66b15509fff04d17ULL },
+        },
+    },
+    {
+        .name = "tch",
+        .radio_ch_type = TETRAPOL_RADIO_TCH,
+        .band = TETRAPOL_BAND_UHF,
+        .ber = 0.002,
+        .dropout = 0.0005,
+        .load = 0.05,
+        .golden = {
+            [TETRAPOL_FEC_ACCURATE] = { 377, 0x0b5740651d4b9e71ULL },
+            [TETRAPOL_FEC_FAST] = { 369, 0xf316719f1fe88265ULL },
+            [TETRAPOL_FEC_ADAPTIVE] = { 377, 0x0b5740651d4b9e71ULL },
+        },
+    },
+};
+
+typedef struct {
+    bool json;
+    bool packed;        ///< pass packed bits to decoder
+    bool print_golden;
+    int fec;
+    int duration;       ///< corpus length in seconds
+    int nterms;         ///< number of terminal addresses
+    int nruns;
+} bench_cfg_t;
+
+static uint64_t rnd_state;
+
+static uint64_t rnd(void)
+{
+    return xorshift64(&rnd_state);
+}
+
+static bool rnd_p(double p)
+{
+    return (rnd() >> 11) * 0x1p-53 < p;
+}
+
+// == Corpus generator ==
+
+typedef struct {
+    uint16_t x;     ///< terminal address is TTI (z = 0, y = 7)
+    uint8_t n_s;    ///< N(S) of next information frame
+    bool conn;      ///< TPDU connection is open
+} term_t;
+
+typedef struct {
+    const scenario_t *sc;
+    frame_encoder_t *fe;
+    cch_encoder_t *cch;     ///< NULL for TCH
+    int superframe_cpt;
+    int dropout;    ///< frames of dropout left
+    int nterms;
+    term_t *terms;
+    /// TCH signalling data frame being transmitted, one block per frame
+    frame_t sdch_frs[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
+    int sdch_nfrs;
+    int sdch_idx;
+    unsigned long tsdus;    ///< number of generated TSDUs
+    uint8_t *bits;  ///< generated stream, one bit per byte
+    int nbits;
+    int bits_cap;
+} gen_t;
+
+static bool gen_put_bit(gen_t *gen, uint8_t bit)
+{
+    if (gen->nbits == gen->bits_cap) {
+        const int cap = gen->bits_cap ? 2 * gen->bits_cap : 1 << 20;
+        uint8_t *bits = realloc(gen->bits, cap);
+        if (!bits) {
+            return false;
+        }
+        gen->bits = bits;
+        gen->bits_cap = cap;
+    }
+    gen->bits[gen->nbits++] = bit;
+
+    return true;
+}
+
+static bool gen_put_noise(gen_t *gen, int nbits)
+{
+    for (int i = 0; i < nbits; ++i) {
+        if (!gen_put_bit(gen, rnd() & 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// send encoded frame through channel impairment model
+static bool gen_put_frame(gen_t *gen, const uint8_t *fr_enc)
+{
+    if (!gen->dropout && rnd_p(gen->sc->dropout)) {
+        gen->dropout = DROPOUT_LEN;
+    }
+    if (gen->dropout) {
+        --gen->dropout;
+        return gen_put_noise(gen, FRAME_LEN);
+    }
+
+    for (int i = 0; i < FRAME_LEN; ++i) {
+        uint8_t bit = (fr_enc[i / 8] >> (i % 8)) & 1;
+        if (rnd_p(gen->sc->ber)) {
+            bit ^= 1;
+        }
+        if (!gen_put_bit(gen, bit)) {
+            return false;
+        }
+    }
+
+    if (rnd_p(gen->sc->slip)) {
+        if (rnd() & 1) {
+            --gen->nbits;
+        } else {
+            return gen_put_noise(gen, 1);
+        }
+    }
+
+    return true;
+}
+
+/// D_SYSTEM_INFO in normal mode, PAS 0001-3-2 4.4.76
+static int tsdu_system_info(uint8_t *buf, int size, int bch,
+        int superframe_cpt)
+{
+    const tsdu_d_system_info_t tsdu = {
+        .base.codop = D_SYSTEM_INFO,
+        .cell_state.bch = bch,
+        .cell_state.mode = CELL_STATE_MODE_NORMAL,
+        .cell_config._data = 0,     // default multiplexing
+        .country_code = 0x2a,
+        .system_id._data = 0x11,
+        .loc_area_id._data = 0x21,
+        .bn_id = 0x05,
+        .cell_id = { .bs_id = 12, .rsw_id = 3, },
+        .cell_bn._data = 0x042,
+        .u_ch_scrambling = 0x37,
+        .cell_radio_param = {
+            .tx_max = 3,
+            .radio_link_timeout = 15,
+            .pwr_tx_adjust = 8,
+            .rx_lev_access = 8,
+        },
+        .system_time = superframe_cpt / 30,
+        .cell_access._data = 0,
+        .superframe_cpt = superframe_cpt,
+    };
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+/// D_REGISTRATION_ACK, PAS 0001-3-2 4.4.65
+static int tsdu_registration_ack(uint8_t *buf, int size, int x)
+{
+    tsdu_d_registration_ack_t tsdu = {
+        .base.codop = D_REGISTRATION_ACK,
+        .complete_reg = 1,
+        .rt_min_activity = 10,
+        .host_adr.cna = ADDRESS_CNA_RFSI,
+        .host_adr.len = 9,
+        .rt_min_registration = 30,
+        .tlr_value = 20,
+        .group_id = rnd() % 4096,
+    };
+    tsdu.host_adr.rfsi.addr[0] = x & 0xf;
+    for (int i = 1; i < ARRAY_LEN(tsdu.host_adr.rfsi.addr); ++i) {
+        tsdu.host_adr.rfsi.addr[i] = rnd() & 0x7;
+    }
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+/// D_AUTHENTICATION, PAS 0001-3-2 4.4.13
+static int tsdu_authentication(uint8_t *buf, int size)
+{
+    tsdu_d_authentication_t tsdu = {
+        .base.codop = D_AUTHENTICATION,
+        .key_reference._data = rnd() & 0x0f,
+    };
+    for (int i = 0; i < ARRAY_LEN(tsdu.valid_rt); ++i) {
+        tsdu.valid_rt[i] = rnd();
+    }
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+/// D_EXPLICIT_SHORT_DATA with random length and content
+static int tsdu_explicit_short_data(uint8_t *buf, int size, int max_len)
+{
+    union {
+        tsdu_d_explicit_short_data_t tsdu;
+        uint8_t buf[sizeof(tsdu_d_explicit_short_data_t) + 64];
+    } esd;
+
+    esd.tsdu.base.codop = D_EXPLICIT_SHORT_DATA;
+    esd.tsdu.len = 1 + rnd() % (max_len - 1);
+    for (int i = 0; i < esd.tsdu.len; ++i) {
+        esd.tsdu.data[i] = rnd();
+    }
+
+    return tsdu_encode(&esd.tsdu.base, buf, size);
+}
+
+/// queue HDLC frame for transmission on SDCH
+static bool gen_put_hdlc(gen_t *gen, const hdlc_frame_t *hdlc_fr)
+{
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    const int nbits = hdlc_frame_build(data, hdlc_fr);
+    if (nbits < 0) {
+        return false;
+    }
+
+    if (gen->cch) {
+        return !cch_encoder_push(gen->cch, LOG_CH_SDCH, data, nbits);
+    }
+
+    gen->sdch_nfrs = data_frame_build(gen->sdch_frs, data, nbits, 0);
+    gen->sdch_idx = 0;
+
+    return gen->sdch_nfrs > 0;
+}
+
+/// start transmission of new SDCH message
+static bool gen_sdch_msg(gen_t *gen)
+{
+    uint8_t tsdu[64];
+    hdlc_frame_t hdlc_fr;
+    int tsdu_len;
+
+    term_t *term = &gen->terms[rnd() % gen->nterms];
+    const addr_t addr = { .z = 0, .y = 7, .x = term->x };
+    const int msg = rnd() % 8;
+
+    if (msg < 4) {
+        // DU (UI TPDU)
+        tsdu_len = (msg < 2) ?
+            tsdu_registration_ack(tsdu, sizeof(tsdu), term->x) :
+            tsdu_authentication(tsdu, sizeof(tsdu));
+        if (tsdu_len < 0 || tpdu_ui_build(&hdlc_fr, 1, &addr, msg & 1, 0, 0,
+                    tsdu, tsdu_len) != 1) {
+            return false;
+        }
+        ++gen->tsdus;
+        return gen_put_hdlc(gen, &hdlc_fr);
+    }
+
+    // information frame with TPDU, connection is referenced by its
+    // TSAP reference (the same on both sides)
+    int code;
+    tsdu_len = 0;
+    if (!term->conn) {
+        code = TPDU_CODE_FCR;
+        tsdu_len = tsdu_registration_ack(tsdu, sizeof(tsdu), term->x);
+        term->conn = true;
+    } else if (msg == 7) {
+        code = TPDU_CODE_DR;
+        term->conn = false;
+    } else {
+        code = TPDU_CODE_DT;
+        // TSDU fits into single HDLC frame
+        tsdu_len = tsdu_explicit_short_data(tsdu, sizeof(tsdu),
+                8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX - 2 - 1 - 3 - 2);
+    }
+    if (tsdu_len < 0 || tpdu_build(&hdlc_fr, 1, &addr, code, term->x % 15,
+                tsdu, tsdu_len) != 1) {
+        return false;
+    }
+    if (tsdu_len) {
+        ++gen->tsdus;
+    }
+    hdlc_fr.command.information.n_s = term->n_s;
+    term->n_s = (term->n_s + 1) % 8;
+
+    return gen_put_hdlc(gen, &hdlc_fr);
+}
+
+/// queue data frames of CCH logical channels starting in next frame
+static bool gen_cch_data(gen_t *gen)
+{
+    const int frame_no = cch_encoder_frame_no(gen->cch);
+    const int fn_mod = frame_no % 100;
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+
+    if (fn_mod == 0) {
+        uint8_t tsdu[32];
+        hdlc_frame_t hdlc_fr;
+
+        const int bch = frame_no / 100;
+        if (!bch) {
+            ++gen->superframe_cpt;
+        }
+        const addr_t addr = { .z = 0, .y = 7, .x = 0xfff };
+        const int tsdu_len = tsdu_system_info(tsdu, sizeof(tsdu), bch,
+                gen->superframe_cpt % 4096);
+        if (tsdu_len < 0 ||
+                tpdu_ui_build(&hdlc_fr, 1, &addr, 0, 0, 0, tsdu, tsdu_len) != 1) {
+            return false;
+        }
+        const int nbits = hdlc_frame_build(data, &hdlc_fr);
+        ++gen->tsdus;
+        return nbits > 0 && !cch_encoder_push(gen->cch, LOG_CH_BCH, data, nbits);
+    }
+
+    if (fn_mod == 98) {
+        // activation bitmap and 4 paged addresses, empty slots are
+        // filled by TTI no station
+        for (int i = 0; i < 8; ++i) {
+            data[i] = rnd();
+        }
+        for (int i = 0; i < 4; ++i) {
+            const addr_t addr = {
+                .z = 0,
+                .y = 7,
+                .x = (rnd() % 3) ? 0 : gen->terms[rnd() % gen->nterms].x,
+            };
+            addr_build(data + 8 + 2*i, &addr);
+        }
+        return !cch_encoder_push(gen->cch, LOG_CH_PCH, data, 2 * 64);
+    }
+
+    if (fn_mod == 99 || fn_mod <= 3) {
+        return true;
+    }
+
+    if (fn_mod % 25 == 14) {
+        // acknowledged random access addresses and FCS
+        for (int i = 0; i < 3; ++i) {
+            const addr_t addr = {
+                .z = 0,
+                .y = 7,
+                .x = (rnd() % 2) ? 0 : gen->terms[rnd() % gen->nterms].x,
+            };
+            addr_build(data + 2*i, &addr);
+        }
+        fcs_t fcs;
+        fcs_init(&fcs);
+        fcs_update(&fcs, data, 6 * 8);
+        data[6] = ~fcs.crc;
+        data[7] = ~fcs.crc >> 8;
+        return !cch_encoder_push(gen->cch, LOG_CH_RCH, data, 64);
+    }
+
+    if (!cch_encoder_pending(gen->cch, LOG_CH_SDCH) && rnd_p(gen->sc->load)) {
+        return gen_sdch_msg(gen);
+    }
+
+    return true;
+}
+
+static bool gen_cch_frame(gen_t *gen, frame_t *fr)
+{
+    if (!gen_cch_data(gen)) {
+        return false;
+    }
+    cch_encoder_get_frame(gen->cch, fr);
+
+    return true;
+}
+
+static bool gen_tch_frame(gen_t *gen, frame_t *fr)
+{
+    if (gen->sdch_idx == gen->sdch_nfrs && rnd_p(gen->sc->load)) {
+        if (!gen_sdch_msg(gen)) {
+            return false;
+        }
+    }
+    if (gen->sdch_idx < gen->sdch_nfrs) {
+        *fr = gen->sdch_frs[gen->sdch_idx++];
+        return true;
+    }
+
+    memset(fr, 0, sizeof(*fr));
+    fr->fr_type = FRAME_TYPE_VOICE;
+    for (int i = 0; i < ARRAY_LEN(fr->voice.voice1); ++i) {
+        fr->voice.voice1[i] = rnd() & 1;
+    }
+    for (int i = 0; i < ARRAY_LEN(fr->voice.voice2); ++i) {
+        fr->voice.voice2[i] = rnd() & 1;
+    }
+
+    return true;
+}
+
+/**
+  Generate corpus for scenario.
+
+  @return number of generated frames or -1 on error
+  */
+static int gen_corpus(gen_t *gen, const scenario_t *sc, const bench_cfg_t *cfg)
+{
+    memset(gen, 0, sizeof(*gen));
+    gen->sc = sc;
+    gen->nterms = cfg->nterms;
+    gen->terms = calloc(gen->nterms, sizeof(*gen->terms));
+    gen->fe = frame_encoder_create(sc->band, 0, DIR_DOWNLINK);
+    if (!gen->terms || !gen->fe) {
+        return -1;
+    }
+
+    // reproducible corpus for each scenario
+    rnd_state = 0x9e3779b97f4a7c15ULL ^ (uint64_t)(sc - scenarios);
+    for (int i = 0; i < gen->nterms; ++i) {
+        gen->terms[i].x = 1 + (i * 2039 + 7) % 4094;
+    }
+    // SCR must be detected by decoder
+    frame_encoder_set_scr(gen->fe, 1 + (sc - scenarios) * 37 % 127);
+
+    // receiver is started in the middle of superframe
+    if (sc->radio_ch_type == TETRAPOL_RADIO_CCH) {
+        gen->cch = cch_encoder_create(150);
+        if (!gen->cch) {
+            return -1;
+        }
+    }
+    if (!gen_put_noise(gen, 300)) {
+        return -1;
+    }
+
+    const int nframes = cfg->duration * FRAMES_PER_S;
+    for (int i = 0; i < nframes; ++i) {
+        frame_t fr;
+        const bool ok = gen->cch ?
+            gen_cch_frame(gen, &fr) : gen_tch_frame(gen, &fr);
+        if (!ok) {
+            return -1;
+        }
+
+        uint8_t fr_enc[FRAME_LEN / 8];
+        if (frame_encoder_encode(gen->fe, fr_enc, &fr) ||
+                !gen_put_frame(gen, fr_enc)) {
+            return -1;
+        }
+    }
+
+    return nframes;
+}
+
+static void gen_destroy(gen_t *gen)
+{
+    frame_encoder_destroy(gen->fe);
+    cch_encoder_destroy(gen->cch);
+    free(gen->terms);
+    free(gen->bits);
+}
+
+// == Decoder output check ==
+
+enum {
+    /// position of the first character of event name in event line
+    EVT_NAME_POS = sizeof("{ \"event\": \"") - 1,
+};
+
+/**
+  Output stream of decoder, TSDU events are hashed (FNV-1a), other events
+  are only counted because frame events include receive time.
+  */
+typedef struct {
+    uint64_t hash;
+    unsigned long tsdus;
+    unsigned long frames;
+    int pos;            ///< position in current line, up to EVT_NAME_POS
+    char line[EVT_NAME_POS + 1];
+} sink_t;
+
+static void hash_update(uint64_t *hash, const char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        *hash = (*hash ^ (uint8_t)buf[i]) * 0x100000001b3ULL;
+    }
+}
+
+static ssize_t sink_write(void *cookie, const char *buf, size_t size)
+{
+    sink_t *sink = cookie;
+    const size_t size_ = size;
+
+    while (size) {
+        if (sink->pos <= EVT_NAME_POS) {
+            sink->line[sink->pos++] = *buf++;
+            --size;
+            if (sink->pos > EVT_NAME_POS &&
+                    sink->line[EVT_NAME_POS] == 't') {
+                hash_update(&sink->hash, sink->line, sink->pos);
+            }
+            continue;
+        }
+
+        const char *nl = memchr(buf, '\n', size);
+        const size_t n = nl ? nl - buf + 1 : size;
+        const char evt = sink->line[EVT_NAME_POS];
+        if (evt == 't') {
+            hash_update(&sink->hash, buf, n);
+        }
+        if (nl) {
+            sink->tsdus += evt == 't';
+            sink->frames += evt == 'f';
+            sink->pos = 0;
+        }
+        buf += n;
+        size -= n;
+    }
+
+    return size_;
+}
+
+// == Benchmark ==
+
+typedef struct {
+    uint64_t ns;
+    sink_t sink;
+    phys_ch_stats_t stats;
+} result_t;
+
+static int bench_run(const scenario_t *sc, const bench_cfg_t *cfg,
+        const uint8_t *data, int len, result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    res->sink.hash = 0xcbf29ce484222325ULL;
+
+    const cookie_io_functions_t sink_io = { .write = sink_write };
+    FILE *out = fopencookie(&res->sink, "w", sink_io);
+    if (!out) {
+        return -1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 16);
+
+    const tetrapol_cfg_t tcfg = {
+        .band = sc->band,
+        .dir = DIR_DOWNLINK,
+        .radio_ch_type = sc->radio_ch_type,
+        .fec = cfg->fec,
+    };
+    tetrapol_t *tetrapol = tetrapol_create(&tcfg);
+    if (!tetrapol) {
+        fclose(out);
+        return -1;
+    }
+    tetrapol_set_output(tetrapol, out);
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(tetrapol);
+    if (!phys_ch) {
+        tetrapol_destroy(tetrapol);
+        fclose(out);
+        return -1;
+    }
+    tetrapol_phys_ch_set_profiling(phys_ch, true);
+
+    int ret = 0;
+    const uint64_t t = clock_ns();
+    for (int i = 0; i < len && ret >= 0; i += CHUNK_LEN) {
+        const int n = (len - i < CHUNK_LEN) ? len - i : CHUNK_LEN;
+        ret = cfg->packed ?
+            tetrapol_phys_ch_recv_packed(phys_ch, (uint8_t *)data + i, n) :
+            tetrapol_phys_ch_recv(phys_ch, (uint8_t *)data + i, n);
+        if (ret >= 0) {
+            ret = tetrapol_phys_ch_process(phys_ch);
+        }
+    }
+    fflush(out);
+    res->ns = clock_ns() - t;
+
+    tetrapol_phys_ch_get_stats(phys_ch, &res->stats);
+    tetrapol_phys_ch_destroy(phys_ch);
+    tetrapol_destroy(tetrapol);
+    fclose(out);
+
+    return ret;
+}
+
+static long peak_rss_kb(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    return ru.ru_maxrss;
+}
+
+static const char *fec_name(int fec)
+{
+    switch (fec) {
+        case TETRAPOL_FEC_FAST:
+            return "fast";
+        case TETRAPOL_FEC_ADAPTIVE:
+            return "adaptive";
+        default:
+            return "accurate";
+    }
+}
+
+static void print_result(const scenario_t *sc, const bench_cfg_t *cfg,
+        int nframes, unsigned long tsdus_sent, const result_t *res,
+        long rss_kb, long rss_dec_kb, const char *golden)
+{
+    const double s = res->ns * 1e-9;
+    const phys_ch_stats_t *st = &res->stats;
+
+    if (cfg->json) {
+        printf("{ \"bench\": \"dump\", \"scenario\": \"%s\", \"fec\": \"%s\", "
+                "\"frames\": %d, \"frames_ok\": %lu, \"sync_lost\": %lu, "
+                "\"tsdus_sent\": %lu, \"tsdus\": %lu, "
+                "\"s\": %.4f, \"frames_per_s\": %.0f, \"tsdus_per_s\": %.0f, "
+                "\"ns_sync\": %.1f, \"ns_frame\": %.1f, \"ns_link\": %.1f, "
+                "\"ns_tsdu\": %.1f, \"peak_rss_kb\": %ld, \"decoder_rss_kb\": %ld, "
+                "\"hash\": \"%016" PRIx64 "\", \"golden\": \"%s\" }\n",
+                sc->name, fec_name(cfg->fec), nframes, st->frames_ok,
+                st->sync_lost, tsdus_sent, st->tsdus, s, nframes / s,
+                st->tsdus / s, (double)st->ns_sync / nframes,
+                (double)st->ns_frame / nframes, (double)st->ns_link / nframes,
+                (double)st->ns_tsdu / nframes, rss_kb, rss_dec_kb,
+                res->sink.hash, golden);
+        return;
+    }
+
+    printf("%-13s %-8s %7d %6.1f%% %10.0f %7lu/%-7lu %9.0f %7.0f %7.0f %7.0f %7.0f %8ld %8ld  %s\n",
+            sc->name, fec_name(cfg->fec), nframes,
+            100.0 * st->frames_ok / nframes, nframes / s,
+            st->tsdus, tsdus_sent, st->tsdus / s,
+            (double)st->ns_sync / nframes, (double)st->ns_frame / nframes,
+            (double)st->ns_link / nframes, (double)st->ns_tsdu / nframes,
+            rss_kb, rss_dec_kb, golden);
+}
+
+/**
+  Run benchmark for single scenario.
+
+  @return 0 when decoder output matches golden results, 1 otherwise
+  */
+static int bench_scenario(const scenario_t *sc, const bench_cfg_t *cfg)
+{
+    gen_t gen;
+    const int nframes = gen_corpus(&gen, sc, cfg);
+    if (nframes < 0) {
+        fprintf(stderr, "Failed to generate corpus for %s\n", sc->name);
+        gen_destroy(&gen);
+        return 1;
+    }
+
+    uint8_t *data = gen.bits;
+    int len = gen.nbits;
+    if (cfg->packed) {
+        data = calloc((gen.nbits + 7) / 8, 1);
+        if (!data) {
+            gen_destroy(&gen);
+            return 1;
+        }
+        pack_bits(data, gen.bits, 0, gen.nbits);
+        len = (gen.nbits + 7) / 8;
+    }
+
+    const long rss_base_kb = peak_rss_kb();
+
+    result_t best = { .ns = 0 };
+    int ret = 0;
+    for (int run = 0; run < cfg->nruns; ++run) {
+        result_t res;
+        if (bench_run(sc, cfg, data, len, &res) < 0) {
+            fprintf(stderr, "Decoding of %s failed\n", sc->name);
+            ret = 1;
+            break;
+        }
+        // decoding must be deterministic
+        if (run && (res.sink.hash != best.sink.hash ||
+                    res.sink.tsdus != best.sink.tsdus)) {
+            fprintf(stderr, "%s: output differs between runs\n", sc->name);
+            ret = 1;
+        }
+        if (!run || res.ns < best.ns) {
+            best = res;
+        }
+    }
+
+    if (cfg->packed) {
+        free(data);
+    }
+    gen_destroy(&gen);
+    if (ret) {
+        return ret;
+    }
+
+    const char *golden = "-";
+    if (cfg->duration == DURATION_DEFAULT && cfg->nterms == NTERMS_DEFAULT) {
+        const golden_t *g = &sc->golden[cfg->fec];
+        golden = "ok";
+        if (g->tsdus != best.sink.tsdus || g->hash != best.sink.hash) {
+            golden = "FAIL";
+            ret = 1;
+        }
+    }
+
+    const long rss_kb = peak_rss_kb();
+    print_result(sc, cfg, nframes, gen.tsdus, &best, rss_kb,
+            rss_kb - rss_base_kb, golden);
+
+    if (cfg->print_golden) {
+        fprintf(stderr, "%s %s: { %lu, 0x%016" PRIx64 "ULL },\n",
+                sc->name, fec_name(cfg->fec), best.sink.tsdus, best.sink.hash);
+    }
+
+    return ret;
+}
+
+static void print_help(const char *prg_name)
+{
+    fprintf(stderr, "Measure throughput of whole decoder on synthetic channel streams.\n");
+    fprintf(stderr, "Usage: %s [OPTIONS ...]\n", prg_name);
+    fprintf(stderr, "    -s <SCENARIO>           run only single scenario:");
+    for (int i = 0; i < ARRAY_LEN(scenarios); ++i) {
+        fprintf(stderr, " %s", scenarios[i].name);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "    -f { ACCURATE | FAST | ADAPTIVE }\n");
+    fprintf(stderr, "                            error correction (default is ACCURATE)\n");
+    fprintf(stderr, "    -l <SECONDS>            length of generated stream (default is %d)\n",
+            DURATION_DEFAULT);
+    fprintf(stderr, "    -a <N>                  number of terminal addresses (default is %d)\n",
+            NTERMS_DEFAULT);
+    fprintf(stderr, "    -r <N>                  number of runs, the fastest is reported (default is %d)\n",
+            NRUNS_DEFAULT);
+    fprintf(stderr, "    -p                      pass packed bits to decoder\n");
+    fprintf(stderr, "    -j                      JSON output, single object per line\n");
+    fprintf(stderr, "    -g                      print golden results to stderr\n");
+    fprintf(stderr, "Golden results are checked only for default -l and -a.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bench_cfg_t cfg = {
+        .fec = TETRAPOL_FEC_ACCURATE,
+        .duration = DURATION_DEFAULT,
+        .nterms = NTERMS_DEFAULT,
+        .nruns = NRUNS_DEFAULT,
+    };
+    const char *scenario = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:f:ghjl:pr:s:")) != -1) {
+        switch (opt) {
+            case 'a':
+                cfg.nterms = atoi(optarg);
+                if (cfg.nterms < 1 || cfg.nterms > 4094) {
+                    fprintf(stderr, "Number of terminals must be 1..4094\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'f':
+                if (!strcmp(optarg, "ACCURATE")) {
+                    cfg.fec = TETRAPOL_FEC_ACCURATE;
+                } else if (!strcmp(optarg, "FAST")) {
+                    cfg.fec = TETRAPOL_FEC_FAST;
+                } else if (!strcmp(optarg, "ADAPTIVE")) {
+                    cfg.fec = TETRAPOL_FEC_ADAPTIVE;
+                } else {
+                    print_help(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'g':
+                cfg.print_golden = true;
+                break;
+
+            case 'j':
+                cfg.json = true;
+                break;
+
+            case 'l':
+                cfg.duration = atoi(optarg);
+                if (cfg.duration < 1) {
+                    fprintf(stderr, "Invalid stream length\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'p':
+                cfg.packed = true;
+                break;
+
+            case 'r':
+                cfg.nruns = atoi(optarg);
+                if (cfg.nruns < 1) {
+                    fprintf(stderr, "Invalid number of runs\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 's':
+                scenario = optarg;
+                break;
+
+            case 'h':
+                print_help(argv[0]);
+                exit(0);
+                break;
+
+            default:
+                print_help(argv[0]);
+                exit(EXIT_FAILURE);
+                break;
+        }
+    }
+
+    // do not measure logging
+    log_set_lvl(WTF - 1);
+
+    if (!cfg.json) {
+        printf("%-13s %-8s %7s %7s %10s %15s %9s %7s %7s %7s %7s %8s %8s  %s\n",
+                "scenario", "fec", "frames", "ok", "frames/s", "tsdus/sent",
+                "tsdus/s", "sync", "frame", "link", "tsdu", "rss_kb",
+                "dec_kb", "golden");
+    }
+    fflush(stdout);
+
+    int nfailed = 0;
+    int nrun = 0;
+    for (int i = 0; i < ARRAY_LEN(scenarios); ++i) {
+        if (scenario && strcmp(scenario, scenarios[i].name)) {
+            continue;
+        }
+        ++nrun;
+
+        // each scenario runs in own process to get its peak RSS
+        const pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (!pid) {
+            const int ret = bench_scenario(&scenarios[i], &cfg);
+            fflush(stdout);
+            _exit(ret);
+        }
+        int status;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+                WEXITSTATUS(status)) {
+            ++nfailed;
+        }
+    }
+
+    if (!nrun) {
+        fprintf(stderr, "Unknown scenario '%s'\n", scenario);
+        return EXIT_FAILURE;
+    }
+    if (!cfg.json) {
+        printf("times are in ns/frame, sync - frame synchronisation, "
+                "frame - error correction, link - data blocks, HDLC, TPDU, "
+                "tsdu - TSDU decoding and output\n");
+    }
+    if (nfailed) {
+        fprintf(stderr, "%d scenario(s) failed\n", nfailed);
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
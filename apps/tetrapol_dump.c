@@ -1,3 +1,4 @@
+#include <tetrapol/engine.h>
 #include <tetrapol/tetrapol.h>
 // TODO: should use only tetrapol.h, but hi-level interface not implemented yet
 #include <tetrapol/phys_ch.h>
@@ -6,6 +7,7 @@
 #include <poll.h>
 #include <signal.h>
 #include <getopt.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,10 +40,9 @@ static int do_read(int fd, uint8_t *buf, int len)
     return do_exit ? 0 : -1;
 }
 
-static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd)
+static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd, bool packed)
 {
     int ret = 0;
-    int data_len = 0;
     uint8_t data[4096];
 
     if (fcntl(fd, F_SETFL, O_NONBLOCK | fcntl(fd, F_GETFL))) {
@@ -51,24 +52,25 @@ static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd)
     signal(SIGINT, sigint_handler);
 
     while (ret == 0 && !do_exit) {
-        if (sizeof(data) - data_len > 0) {
-            const int rsize = do_read(fd, data + data_len, sizeof(data) - data_len);
-            if (rsize < 0) {
-                return rsize;
-            }
-            if (!rsize && !data_len) {
-                return 0;
-            }
-            data_len += rsize;
+        // packed bits are read directly into decoder buffer,
+        // unpacked must be packed by decoder anyway
+        int len = sizeof(data);
+        uint8_t *buf = packed ?
+            tetrapol_phys_ch_get_write_buffer(phys_ch, &len) : data;
+        if (!buf) {
+            return -1;
         }
 
-        const int rsize = tetrapol_phys_ch_recv(phys_ch, data, data_len);
-        if (rsize < 0) {
+        const int rsize = do_read(fd, buf, len);
+        if (rsize <= 0) {
             return rsize;
         }
-        if (rsize > 0) {
-            memmove(data, data + rsize, data_len - rsize);
-            data_len -= rsize;
+
+        ret = packed ?
+            tetrapol_phys_ch_commit(phys_ch, rsize) :
+            tetrapol_phys_ch_recv(phys_ch, data, rsize);
+        if (ret < 0) {
+            return ret;
         }
 
         ret = tetrapol_phys_ch_process(phys_ch);
@@ -77,6 +79,110 @@ static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd)
     return ret;
 }
 
+typedef struct {
+    const char *path;
+    tetrapol_cfg_t cfg;
+    int fd;
+    int ch_id;
+} input_t;
+
+static int tetrapol_engine_loop(tetrapol_engine_t *engine,
+        input_t *inputs, int ninputs)
+{
+    struct pollfd fds[TETRAPOL_ENGINE_MAX_CHANNELS];
+    uint8_t data[4096];
+    int nopen = ninputs;
+
+    for (int i = 0; i < ninputs; ++i) {
+        if (fcntl(inputs[i].fd, F_SETFL, O_NONBLOCK | fcntl(inputs[i].fd, F_GETFL))) {
+            return -1;
+        }
+        fds[i].fd = inputs[i].fd;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    while (nopen && !do_exit) {
+        if (poll(fds, ninputs, -1) < 0) {
+            return do_exit ? 0 : -1;
+        }
+
+        for (int i = 0; i < ninputs; ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+
+            const int rsize = read(fds[i].fd, data, sizeof(data));
+            if (rsize <= 0) {
+                // poll ignores negative fd
+                fds[i].fd = -1;
+                --nopen;
+                continue;
+            }
+
+            const uint8_t *buf = data;
+            int len = rsize;
+            while (len) {
+                const int n = tetrapol_engine_push(engine, inputs[i].ch_id, buf, len);
+                if (n < 0) {
+                    return n;
+                }
+                buf += n;
+                len -= n;
+                // channel queue is full, wait for decoder
+                if (len) {
+                    tetrapol_engine_flush(engine);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int tetrapol_dump_channels(input_t *inputs, int ninputs, bool packed,
+        int nworkers)
+{
+    int ret = -1;
+
+    tetrapol_engine_t *engine = tetrapol_engine_create(nworkers, stdout);
+    if (!engine) {
+        fprintf(stderr, "Failed to initialize TETRAPOL engine.\n");
+        return -1;
+    }
+
+    int nopen = 0;
+    for (; nopen < ninputs; ++nopen) {
+        input_t *in = &inputs[nopen];
+        in->fd = strcmp(in->path, "-") ? open(in->path, O_RDONLY) : STDIN_FILENO;
+        if (in->fd == -1) {
+            perror("Failed to open input file");
+            goto out;
+        }
+
+        in->ch_id = tetrapol_engine_add_channel(engine, &in->cfg, packed);
+        if (in->ch_id < 0) {
+            fprintf(stderr, "Failed to initialize TETRAPOL instance.\n");
+            ++nopen;
+            goto out;
+        }
+    }
+
+    ret = tetrapol_engine_loop(engine, inputs, ninputs);
+
+out:
+    tetrapol_engine_destroy(engine);
+    for (int i = 0; i < nopen; ++i) {
+        if (inputs[i].fd != STDIN_FILENO && inputs[i].fd != -1) {
+            close(inputs[i].fd);
+        }
+    }
+
+    return ret;
+}
+
 static void print_help(const char *prg_name)
 {
     fprintf(stderr, "Decode data from demodulated TETRAPOL channel.\n");
@@ -85,6 +191,17 @@ static void print_help(const char *prg_name)
     fprintf(stderr, "    -b { UHF | VHF }        radio band (default is UHF\n");
     fprintf(stderr, "    -t { CCH | TCH }        select betwen control and traffic channel\n");
     fprintf(stderr, "    -d { DOWN | UP }        direction, downlink/direct or uplink\n");
+    fprintf(stderr, "    -f { ACCURATE | FAST | ADAPTIVE }\n");
+    fprintf(stderr, "                            error correction, Viterbi (default), syndrome decoder or syndrome\n");
+    fprintf(stderr, "                            decoder with Viterbi for frames it fails to decode\n");
+    fprintf(stderr, "    -p                      input bits are packed, 8 bits per byte (first bit in LSB)\n");
+    fprintf(stderr, "    -T <SECONDS>            forget terminals idle for given time (default is %d, -1 never)\n",
+            TETRAPOL_TERMINAL_IDLE_TIMEOUT);
+    fprintf(stderr, "    -m <MB>                 limit memory used by terminals, the least recently active are\n");
+    fprintf(stderr, "                            forgotten (default is no limit)\n");
+    fprintf(stderr, "    -c <PATH>               add channel, can be repeated, channel uses -b, -t, -d, -f, -T\n");
+    fprintf(stderr, "                            and -m given before it, all channels are decoded by single process\n");
+    fprintf(stderr, "    -j <N>                  number of decoding threads for -c (default is number of CPUs)\n");
 }
 
 int main(int argc, char* argv[])
@@ -96,9 +213,13 @@ int main(int argc, char* argv[])
     };
 
     const char *in = NULL;
+    bool packed = false;
+    input_t inputs[TETRAPOL_ENGINE_MAX_CHANNELS];
+    int ninputs = 0;
+    int nworkers = 0;
 
     int opt;
-    while ((opt = getopt(argc, argv, "b:hi:t:d:")) != -1) {
+    while ((opt = getopt(argc, argv, "b:c:f:hi:j:m:t:T:d:p")) != -1) {
         switch (opt) {
             case 'b':
                 if (!strcmp(optarg, "VHF")) {
@@ -111,10 +232,45 @@ int main(int argc, char* argv[])
                 }
                 break;
 
+            case 'c':
+                if (ninputs == TETRAPOL_ENGINE_MAX_CHANNELS) {
+                    fprintf(stderr, "Too many channels.\n");
+                    exit(EXIT_FAILURE);
+                }
+                inputs[ninputs].path = optarg;
+                inputs[ninputs].cfg = cfg;
+                ++ninputs;
+                break;
+
+            case 'f':
+                if (!strcmp(optarg, "ACCURATE")) {
+                    cfg.fec = TETRAPOL_FEC_ACCURATE;
+                } else if (!strcmp(optarg, "FAST")) {
+                    cfg.fec = TETRAPOL_FEC_FAST;
+                } else if (!strcmp(optarg, "ADAPTIVE")) {
+                    cfg.fec = TETRAPOL_FEC_ADAPTIVE;
+                } else {
+                    print_help(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
             case 'i':
                 in = optarg;
                 break;
 
+            case 'j':
+                nworkers = atoi(optarg);
+                break;
+
+            case 'm':
+                cfg.terminal_mem_max = atoi(optarg) * 1024;
+                break;
+
+            case 'T':
+                cfg.terminal_idle_timeout = atoi(optarg);
+                break;
+
             case 't':
                 if (!strcmp("CCH", optarg)) {
                     cfg.radio_ch_type = TETRAPOL_RADIO_CCH;
@@ -142,6 +298,10 @@ int main(int argc, char* argv[])
                 }
                 break;
 
+            case 'p':
+                packed = true;
+                break;
+
             default:
                 print_help(argv[0]);
                 exit(EXIT_FAILURE);
@@ -149,6 +309,12 @@ int main(int argc, char* argv[])
         }
     }
 
+    if (ninputs) {
+        const int ret = tetrapol_dump_channels(inputs, ninputs, packed, nworkers);
+        fprintf(stderr, "Exiting.\n");
+        return ret;
+    }
+
     int infd = STDIN_FILENO;
     if (in && strcmp(in, "-")) {
         infd = open(in, O_RDONLY);
@@ -169,7 +335,7 @@ int main(int argc, char* argv[])
         return -1;
     }
 
-    const int ret = tetrapol_dump_loop(phys_ch, infd);
+    const int ret = tetrapol_dump_loop(phys_ch, infd, packed);
     tetrapol_phys_ch_destroy(phys_ch);
     if (infd != STDIN_FILENO) {
         close(infd);
@@ -0,0 +1,984 @@
+/**
+  Synthetic traffic generator for capacity testing.
+
+  Simulates single cell with one CCH and several TCHs. Population of
+  terminals registers, sends data messages and makes group calls, arrivals
+  are random with configured rates. Each channel is encoded into its own
+  bitstream, streams are written into files or decoded in process by
+  tetrapol_engine, the same way as tetrapol_dump -c does.
+
+  CCH carries D_SYSTEM_INFO in BCH, group activation bitmap and paged
+  terminals in PCH, acknowledged terminals in RCH and signalling (DU and
+  connection oriented TPDUs, segmented for long data messages) in SDCH.
+  TCH carries voice frames with signalling data frames while group call is
+  active, idle TCH is not transmitted and is received as noise.
+ */
+
+#include <tetrapol/addr.h>
+#include <tetrapol/bit_utils.h>
+#include <tetrapol/cch_encoder.h>
+#include <tetrapol/data_frame.h>
+#include <tetrapol/engine.h>
+#include <tetrapol/frame.h>
+#include <tetrapol/hdlc_frame.h>
+#include <tetrapol/misc.h>
+#include <tetrapol/system_config.h>
+#include <tetrapol/tetrapol.h>
+#include <tetrapol/tpdu.h>
+#include <tetrapol/tsdu_encode.h>
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    /// frame takes 20 ms
+    FRAMES_PER_S = 50,
+    /// streams are written (pushed into engine) in chunks of 1 s
+    CHUNK_FRAMES = FRAMES_PER_S,
+    /// SDCH messages waiting for CCH encoder queue
+    SDCH_BACKLOG_LEN = 1024,
+    /// the longest generated data message
+    DATA_MSG_LEN_MAX = 400,
+    /// voice frames sent on TCH before signalling, receiver gets sync
+    TCH_SYNC_FRAMES = 25,
+};
+
+typedef struct {
+    int ntchs;
+    int nterms;
+    int ngroups;
+    int duration;       ///< in seconds
+    double call_rate;   ///< group calls per terminal and hour
+    double call_len;    ///< mean call length in seconds
+    double reg_rate;    ///< registrations per terminal and hour
+    double msg_rate;    ///< data messages per terminal and hour
+    int band;
+    bool packed;
+    uint64_t seed;
+} gen_cfg_t;
+
+typedef struct {
+    uint16_t x;         ///< terminal address is TTI (z = 0, y = 7)
+    uint8_t n_s;        ///< N(S) of next information frame
+    bool registered;
+    uint16_t group_id;
+} term_t;
+
+/// encoded radio channel
+typedef struct {
+    frame_encoder_t *fe;
+    int scr;
+    tetrapol_cfg_t cfg;
+    FILE *out;          ///< output file or NULL
+    int ch_id;          ///< engine channel or -1
+    uint8_t *buf;       ///< bits of current chunk
+    int len;            ///< used bytes of buf
+    unsigned long tsdus;    ///< number of generated TSDUs
+} chan_t;
+
+typedef struct {
+    chan_t ch;
+    int tch_no;
+    int group_id;       ///< group of active call, -1 for idle channel
+    int frames;         ///< frames since start of call
+    int frames_left;    ///< frames to the end of call
+    /// signalling data frame being transmitted, one block per frame
+    frame_t frs[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
+    int nfrs;
+    int fr_idx;
+} tch_t;
+
+typedef struct {
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    int nbits;
+} sdch_msg_t;
+
+typedef struct {
+    unsigned long calls;
+    unsigned long calls_blocked;
+    unsigned long regs;
+    unsigned long msgs;
+    unsigned long msgs_dropped;
+    int backlog_max;
+} gen_stats_t;
+
+typedef struct {
+    const gen_cfg_t *cfg;
+    uint64_t rnd_state;
+    cch_encoder_t *cch_enc;
+    chan_t cch;
+    tch_t *tchs;
+    term_t *terms;
+    int superframe_cpt;
+    uint8_t seg_ref;
+    /// SDCH messages waiting for CCH encoder
+    sdch_msg_t backlog[SDCH_BACKLOG_LEN];
+    int backlog_head;
+    int backlog_len;
+    /// groups activated since last PCH, bit (group_id % 64)
+    uint64_t pch_groups;
+    uint16_t pch_addrs[4];
+    int pch_naddrs;
+    /// terminals which access is acknowledged in next RCH
+    uint16_t rch_addrs[3];
+    int rch_naddrs;
+    gen_stats_t stats;
+} gen_t;
+
+static uint64_t rnd(gen_t *gen)
+{
+    return xorshift64(&gen->rnd_state);
+}
+
+static double rnd_unif(gen_t *gen)
+{
+    return (rnd(gen) >> 11) * 0x1p-53;
+}
+
+/// number of arrivals in single frame for rate per terminal and hour
+static int rnd_arrivals(gen_t *gen, double rate)
+{
+    const double lambda = gen->cfg->nterms * rate / 3600 / FRAMES_PER_S;
+    // Poisson distribution, lambda is small
+    double p = exp(-lambda);
+    double cdf = p;
+    const double u = rnd_unif(gen);
+    int n = 0;
+    while (u > cdf && n < 100) {
+        ++n;
+        p *= lambda / n;
+        cdf += p;
+    }
+
+    return n;
+}
+
+static term_t *rnd_term(gen_t *gen)
+{
+    return &gen->terms[rnd(gen) % gen->cfg->nterms];
+}
+
+// == Signalling ==
+
+static int tsdu_system_info(gen_t *gen, uint8_t *buf, int size, int bch)
+{
+    const tsdu_d_system_info_t tsdu = {
+        .base.codop = D_SYSTEM_INFO,
+        .cell_state.bch = bch,
+        .cell_state.mode = CELL_STATE_MODE_NORMAL,
+        .cell_config.mux_type = CELL_CONFIG_MUX_TYPE_DEFAULT,
+        .country_code = 0x2a,
+        .system_id._data = 0x11,
+        .loc_area_id._data = 0x21,
+        .bn_id = 0x05,
+        .cell_id = { .bs_id = 12, .rsw_id = 3, },
+        .cell_bn._data = 0x042,
+        .u_ch_scrambling = gen->cch.scr,
+        .cell_radio_param = {
+            .tx_max = 3,
+            .radio_link_timeout = 15,
+            .pwr_tx_adjust = 8,
+            .rx_lev_access = 8,
+        },
+        .system_time = (gen->superframe_cpt / 30) % 256,
+        .superframe_cpt = gen->superframe_cpt % 4096,
+    };
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+static int tsdu_registration_ack(gen_t *gen, uint8_t *buf, int size,
+        const term_t *term)
+{
+    tsdu_d_registration_ack_t tsdu = {
+        .base.codop = D_REGISTRATION_ACK,
+        .complete_reg = 1,
+        .rt_min_activity = 10,
+        .host_adr.cna = ADDRESS_CNA_RFSI,
+        .host_adr.len = 9,
+        .rt_min_registration = 30,
+        .tlr_value = 20,
+        .group_id = term->group_id,
+    };
+    tsdu.host_adr.rfsi.addr[0] = term->x & 0xf;
+    for (int i = 1; i < ARRAY_LEN(tsdu.host_adr.rfsi.addr); ++i) {
+        tsdu.host_adr.rfsi.addr[i] = rnd(gen) % 10;
+    }
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+static int tsdu_authentication(gen_t *gen, uint8_t *buf, int size)
+{
+    tsdu_d_authentication_t tsdu = {
+        .base.codop = D_AUTHENTICATION,
+        .key_reference._data = rnd(gen) & 0x0f,
+    };
+    for (int i = 0; i < ARRAY_LEN(tsdu.valid_rt); ++i) {
+        tsdu.valid_rt[i] = rnd(gen);
+    }
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+static int tsdu_location_activity_ack(uint8_t *buf, int size)
+{
+    const tsdu_d_location_activity_ack_t tsdu = {
+        .base.codop = D_LOCATION_ACTIVITY_ACK,
+    };
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+static int tsdu_explicit_short_data(gen_t *gen, uint8_t *buf, int size)
+{
+    union {
+        tsdu_d_explicit_short_data_t tsdu;
+        uint8_t buf[sizeof(tsdu_d_explicit_short_data_t) + DATA_MSG_LEN_MAX];
+    } esd;
+
+    esd.tsdu.base.codop = D_EXPLICIT_SHORT_DATA;
+    // mostly short status messages, some long enough for segmentation
+    esd.tsdu.len = (rnd(gen) % 4) ?
+        1 + rnd(gen) % 32 : 1 + rnd(gen) % DATA_MSG_LEN_MAX;
+    for (int i = 0; i < esd.tsdu.len; ++i) {
+        esd.tsdu.data[i] = rnd(gen);
+    }
+
+    return tsdu_encode(&esd.tsdu.base, buf, size);
+}
+
+static int tsdu_group_activation(const tch_t *tch, uint8_t *buf, int size)
+{
+    const tsdu_d_group_activation_t tsdu = {
+        .base.codop = D_GROUP_ACTIVATION,
+        .activation_mode.type = ACTIVATION_MODE_TYPE_WITH_TONE,
+        .group_id = tch->group_id,
+        .coverage_id = 1,
+        .channel_id = 100 + tch->tch_no,
+        .u_ch_scrambling = tch->ch.scr,
+        .d_ch_scrambling = tch->ch.scr,
+    };
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+static int tsdu_group_end(uint8_t *buf, int size, int codop)
+{
+    // D_GROUP_END and D_GROUP_IDLE have the same structure
+    const tsdu_d_group_end_t tsdu = {
+        .base.codop = codop,
+        .cause = 0,
+    };
+
+    return tsdu_encode(&tsdu.base, buf, size);
+}
+
+/// queue HDLC frame for CCH SDCH
+static void gen_sdch_put(gen_t *gen, const hdlc_frame_t *hdlc_fr)
+{
+    if (gen->backlog_len == SDCH_BACKLOG_LEN) {
+        ++gen->stats.msgs_dropped;
+        return;
+    }
+
+    sdch_msg_t *msg = &gen->backlog[
+        (gen->backlog_head + gen->backlog_len) % SDCH_BACKLOG_LEN];
+    msg->nbits = hdlc_frame_build(msg->data, hdlc_fr);
+    if (msg->nbits > 0) {
+        ++gen->backlog_len;
+    }
+    if (gen->backlog_len > gen->stats.backlog_max) {
+        gen->stats.backlog_max = gen->backlog_len;
+    }
+}
+
+/// send TSDU to terminal (or broadcast) as DU
+static void gen_send_du(gen_t *gen, uint16_t x, const uint8_t *tsdu, int len)
+{
+    hdlc_frame_t hdlc_frs[SYS_PAR_N452];
+    const addr_t addr = { .z = 0, .y = 7, .x = x };
+
+    gen->seg_ref = (gen->seg_ref + 1) % 128;
+    const int n = tpdu_ui_build(hdlc_frs, ARRAY_LEN(hdlc_frs), &addr, 0, 0,
+            gen->seg_ref, tsdu, len);
+    for (int i = 0; i < n; ++i) {
+        gen_sdch_put(gen, &hdlc_frs[i]);
+    }
+    if (n > 0) {
+        ++gen->cch.tsdus;
+    }
+}
+
+/// send TSDU to terminal over connection (FCR), connection is closed by DR
+static void gen_send_conn(gen_t *gen, term_t *term, const uint8_t *tsdu,
+        int len)
+{
+    hdlc_frame_t hdlc_frs[SYS_PAR_N452 + 1];
+    const addr_t addr = { .z = 0, .y = 7, .x = term->x };
+
+    int n = tpdu_build(hdlc_frs, ARRAY_LEN(hdlc_frs) - 1, &addr,
+            TPDU_CODE_FCR, term->x % 15, tsdu, len);
+    if (n < 0) {
+        return;
+    }
+    ++gen->cch.tsdus;
+    n += tpdu_build(&hdlc_frs[n], 1, &addr, TPDU_CODE_DR, term->x % 15,
+            NULL, 0);
+
+    for (int i = 0; i < n; ++i) {
+        hdlc_frs[i].command.information.n_s = term->n_s;
+        term->n_s = (term->n_s + 1) % 8;
+        gen_sdch_put(gen, &hdlc_frs[i]);
+    }
+}
+
+static void gen_ack(gen_t *gen, const term_t *term)
+{
+    if (gen->rch_naddrs < ARRAY_LEN(gen->rch_addrs)) {
+        gen->rch_addrs[gen->rch_naddrs++] = term->x;
+    }
+}
+
+static void gen_registration(gen_t *gen)
+{
+    uint8_t tsdu[64];
+    term_t *term = rnd_term(gen);
+
+    gen_ack(gen, term);
+    ++gen->stats.regs;
+    if (term->registered) {
+        // periodic location activity
+        gen_send_du(gen, term->x, tsdu, tsdu_location_activity_ack(tsdu,
+                    sizeof(tsdu)));
+        return;
+    }
+
+    gen_send_du(gen, term->x, tsdu, tsdu_authentication(gen, tsdu,
+                sizeof(tsdu)));
+    gen_send_du(gen, term->x, tsdu, tsdu_registration_ack(gen, tsdu,
+                sizeof(tsdu), term));
+    term->registered = true;
+}
+
+static void gen_data_msg(gen_t *gen)
+{
+    uint8_t tsdu[1 + DATA_MSG_LEN_MAX];
+    term_t *term = rnd_term(gen);
+
+    ++gen->stats.msgs;
+    gen_send_conn(gen, term, tsdu, tsdu_explicit_short_data(gen, tsdu,
+                sizeof(tsdu)));
+}
+
+/// start transmission of signalling data frame on TCH
+static void tch_send_du(tch_t *tch, const uint8_t *tsdu, int len)
+{
+    hdlc_frame_t hdlc_fr;
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    const addr_t addr = { .z = 0, .y = 7, .x = 0xfff };
+
+    if (tpdu_ui_build(&hdlc_fr, 1, &addr, 0, 0, 0, tsdu, len) != 1) {
+        return;
+    }
+    const int nbits = hdlc_frame_build(data, &hdlc_fr);
+    if (nbits < 0) {
+        return;
+    }
+    tch->nfrs = data_frame_build(tch->frs, data, nbits, 0);
+    tch->fr_idx = 0;
+    ++tch->ch.tsdus;
+}
+
+static void gen_call(gen_t *gen)
+{
+    uint8_t tsdu[64];
+    const term_t *term = rnd_term(gen);
+
+    ++gen->stats.calls;
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        if (gen->tchs[i].group_id == term->group_id) {
+            // group call is already active
+            return;
+        }
+    }
+
+    tch_t *tch = NULL;
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        if (gen->tchs[i].group_id < 0) {
+            tch = &gen->tchs[i];
+            break;
+        }
+    }
+    if (!tch) {
+        ++gen->stats.calls_blocked;
+        return;
+    }
+
+    tch->group_id = term->group_id;
+    tch->frames = 0;
+    // exponentially distributed call length
+    tch->frames_left = TCH_SYNC_FRAMES + 1 - log(1 - rnd_unif(gen)) *
+        gen->cfg->call_len * FRAMES_PER_S;
+
+    const int len = tsdu_group_activation(tch, tsdu, sizeof(tsdu));
+    gen_send_du(gen, 0xfff, tsdu, len);
+    gen_ack(gen, term);
+    gen->pch_groups |= 1ULL << (tch->group_id % 64);
+    if (gen->pch_naddrs < ARRAY_LEN(gen->pch_addrs)) {
+        gen->pch_addrs[gen->pch_naddrs++] = term->x;
+    }
+}
+
+// == Channel encoding ==
+
+static int chan_init(gen_t *gen, chan_t *ch, int radio_ch_type, int fec,
+        int scr)
+{
+    ch->scr = scr;
+    ch->cfg.band = gen->cfg->band;
+    ch->cfg.dir = DIR_DOWNLINK;
+    ch->cfg.radio_ch_type = radio_ch_type;
+    ch->cfg.fec = fec;
+    ch->ch_id = -1;
+    ch->fe = frame_encoder_create(gen->cfg->band, scr, DIR_DOWNLINK);
+    ch->buf = malloc(CHUNK_FRAMES * FRAME_LEN);
+    if (!ch->fe || !ch->buf) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void chan_destroy(chan_t *ch)
+{
+    frame_encoder_destroy(ch->fe);
+    free(ch->buf);
+    if (ch->out) {
+        fclose(ch->out);
+    }
+}
+
+/// append frame to channel stream, noise is received when fr is NULL
+static int chan_put_frame(gen_t *gen, chan_t *ch, frame_t *fr)
+{
+    uint8_t fr_enc[FRAME_LEN / 8];
+    if (fr) {
+        if (frame_encoder_encode(ch->fe, fr_enc, fr)) {
+            return -1;
+        }
+    } else {
+        for (int i = 0; i < sizeof(fr_enc); ++i) {
+            fr_enc[i] = rnd(gen);
+        }
+    }
+
+    // encoder output has the same bit order as packed decoder input
+    if (gen->cfg->packed) {
+        memcpy(ch->buf + ch->len, fr_enc, sizeof(fr_enc));
+        ch->len += sizeof(fr_enc);
+    } else {
+        for (int i = 0; i < FRAME_LEN; ++i) {
+            ch->buf[ch->len++] = (fr_enc[i / 8] >> (i % 8)) & 1;
+        }
+    }
+
+    return 0;
+}
+
+static int chan_flush(chan_t *ch, tetrapol_engine_t *engine)
+{
+    if (ch->out && fwrite(ch->buf, 1, ch->len, ch->out) != ch->len) {
+        perror("Failed to write output");
+        return -1;
+    }
+
+    const uint8_t *buf = ch->buf;
+    while (engine && ch->len) {
+        const int n = tetrapol_engine_push(engine, ch->ch_id, buf, ch->len);
+        if (n < 0) {
+            return n;
+        }
+        buf += n;
+        ch->len -= n;
+        // channel queue is full, wait for decoder
+        if (ch->len) {
+            tetrapol_engine_flush(engine);
+        }
+    }
+    ch->len = 0;
+
+    return 0;
+}
+
+/// queue data of CCH logical channels starting in next frame
+static void gen_cch_data(gen_t *gen)
+{
+    const int frame_no = cch_encoder_frame_no(gen->cch_enc);
+    const int fn_mod = frame_no % 100;
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+
+    if (fn_mod == 0) {
+        uint8_t tsdu[32];
+        hdlc_frame_t hdlc_fr;
+        const addr_t addr = { .z = 0, .y = 7, .x = 0xfff };
+
+        const int bch = frame_no / 100;
+        if (!bch) {
+            ++gen->superframe_cpt;
+        }
+        const int len = tsdu_system_info(gen, tsdu, sizeof(tsdu), bch);
+        if (tpdu_ui_build(&hdlc_fr, 1, &addr, 0, 0, 0, tsdu, len) == 1) {
+            const int nbits = hdlc_frame_build(data, &hdlc_fr);
+            if (nbits > 0 &&
+                    !cch_encoder_push(gen->cch_enc, LOG_CH_BCH, data, nbits)) {
+                ++gen->cch.tsdus;
+            }
+        }
+    } else if (fn_mod == 98 && (gen->pch_groups || gen->pch_naddrs)) {
+        // activation bitmap and paged addresses, empty slots are filled by
+        // TTI no station
+        for (int i = 0; i < 8; ++i) {
+            data[i] = gen->pch_groups >> (8*i);
+        }
+        for (int i = 0; i < 4; ++i) {
+            const addr_t addr = {
+                .z = 0,
+                .y = 7,
+                .x = (i < gen->pch_naddrs) ? gen->pch_addrs[i] : 0,
+            };
+            addr_build(data + 8 + 2*i, &addr);
+        }
+        cch_encoder_push(gen->cch_enc, LOG_CH_PCH, data, 2 * 64);
+        gen->pch_groups = 0;
+        gen->pch_naddrs = 0;
+    } else if (fn_mod % 25 == 14 && gen->rch_naddrs) {
+        for (int i = 0; i < 3; ++i) {
+            const addr_t addr = {
+                .z = 0,
+                .y = 7,
+                .x = (i < gen->rch_naddrs) ? gen->rch_addrs[i] : 0,
+            };
+            addr_build(data + 2*i, &addr);
+        }
+        fcs_t fcs;
+        fcs_init(&fcs);
+        fcs_update(&fcs, data, 6 * 8);
+        data[6] = ~fcs.crc;
+        data[7] = ~fcs.crc >> 8;
+        cch_encoder_push(gen->cch_enc, LOG_CH_RCH, data, 64);
+        gen->rch_naddrs = 0;
+    }
+
+    // keep CCH encoder queue short, so backlog is measured here
+    while (gen->backlog_len &&
+            cch_encoder_pending(gen->cch_enc, LOG_CH_SDCH) < 2) {
+        const sdch_msg_t *msg = &gen->backlog[gen->backlog_head];
+        cch_encoder_push(gen->cch_enc, LOG_CH_SDCH, msg->data, msg->nbits);
+        gen->backlog_head = (gen->backlog_head + 1) % SDCH_BACKLOG_LEN;
+        --gen->backlog_len;
+    }
+}
+
+static int gen_tch_frame(gen_t *gen, tch_t *tch)
+{
+    if (tch->group_id < 0) {
+        return chan_put_frame(gen, &tch->ch, NULL);
+    }
+
+    uint8_t tsdu[16];
+    if (++tch->frames == TCH_SYNC_FRAMES) {
+        tch_send_du(tch, tsdu, tsdu_group_activation(tch, tsdu,
+                    sizeof(tsdu)));
+    }
+    if (tch->frames_left && !--tch->frames_left) {
+        tch_send_du(tch, tsdu, tsdu_group_end(tsdu, sizeof(tsdu),
+                    D_GROUP_END));
+        gen_send_du(gen, 0xfff, tsdu, tsdu_group_end(tsdu, sizeof(tsdu),
+                    D_GROUP_IDLE));
+    }
+
+    frame_t fr;
+    if (tch->fr_idx < tch->nfrs) {
+        fr = tch->frs[tch->fr_idx++];
+        // the call ends by D_GROUP_END
+        if (!tch->frames_left && tch->fr_idx == tch->nfrs) {
+            tch->group_id = -1;
+        }
+        return chan_put_frame(gen, &tch->ch, &fr);
+    }
+
+    memset(&fr, 0, sizeof(fr));
+    fr.fr_type = FRAME_TYPE_VOICE;
+    for (int i = 0; i < ARRAY_LEN(fr.voice.voice1); ++i) {
+        fr.voice.voice1[i] = rnd(gen) & 1;
+    }
+    for (int i = 0; i < ARRAY_LEN(fr.voice.voice2); ++i) {
+        fr.voice.voice2[i] = rnd(gen) & 1;
+    }
+
+    return chan_put_frame(gen, &tch->ch, &fr);
+}
+
+/// generate single frame of all channels
+static int gen_frame(gen_t *gen)
+{
+    for (int n = rnd_arrivals(gen, gen->cfg->reg_rate); n; --n) {
+        gen_registration(gen);
+    }
+    for (int n = rnd_arrivals(gen, gen->cfg->msg_rate); n; --n) {
+        gen_data_msg(gen);
+    }
+    for (int n = rnd_arrivals(gen, gen->cfg->call_rate); n; --n) {
+        gen_call(gen);
+    }
+
+    gen_cch_data(gen);
+    frame_t fr;
+    cch_encoder_get_frame(gen->cch_enc, &fr);
+    if (chan_put_frame(gen, &gen->cch, &fr)) {
+        return -1;
+    }
+
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        if (gen_tch_frame(gen, &gen->tchs[i])) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int gen_flush(gen_t *gen, tetrapol_engine_t *engine)
+{
+    if (chan_flush(&gen->cch, engine)) {
+        return -1;
+    }
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        if (chan_flush(&gen->tchs[i].ch, engine)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void gen_destroy(gen_t *gen)
+{
+    cch_encoder_destroy(gen->cch_enc);
+    chan_destroy(&gen->cch);
+    if (gen->tchs) {
+        for (int i = 0; i < gen->cfg->ntchs; ++i) {
+            chan_destroy(&gen->tchs[i].ch);
+        }
+    }
+    free(gen->tchs);
+    free(gen->terms);
+    free(gen);
+}
+
+static gen_t *gen_create(const gen_cfg_t *cfg, int fec)
+{
+    gen_t *gen = calloc(1, sizeof(gen_t));
+    if (!gen) {
+        return NULL;
+    }
+    gen->cfg = cfg;
+    gen->rnd_state = cfg->seed ? cfg->seed : 0x9e3779b97f4a7c15ULL;
+
+    gen->terms = calloc(cfg->nterms, sizeof(term_t));
+    gen->tchs = calloc(cfg->ntchs, sizeof(tch_t));
+    // receiver is started in the middle of superframe
+    gen->cch_enc = cch_encoder_create(150);
+    if (!gen->terms || !gen->tchs || !gen->cch_enc) {
+        goto err;
+    }
+
+    for (int i = 0; i < cfg->nterms; ++i) {
+        gen->terms[i].x = 1 + (i * 2039 + 7) % 4094;
+        gen->terms[i].group_id = 1 + rnd(gen) % cfg->ngroups;
+    }
+
+    // each channel has its own scrambling, decoder must detect it
+    if (chan_init(gen, &gen->cch, TETRAPOL_RADIO_CCH, fec, 1)) {
+        goto err;
+    }
+    for (int i = 0; i < cfg->ntchs; ++i) {
+        gen->tchs[i].tch_no = i;
+        gen->tchs[i].group_id = -1;
+        if (chan_init(gen, &gen->tchs[i].ch, TETRAPOL_RADIO_TCH, fec,
+                    2 + (i * 37) % 126)) {
+            goto err;
+        }
+    }
+
+    return gen;
+
+err:
+    gen_destroy(gen);
+    return NULL;
+}
+
+static int open_outputs(gen_t *gen, const char *prefix)
+{
+    char path[4096];
+
+    snprintf(path, sizeof(path), "%s_cch.bits", prefix);
+    gen->cch.out = fopen(path, "wb");
+    if (!gen->cch.out) {
+        perror("Failed to open output file");
+        return -1;
+    }
+
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        snprintf(path, sizeof(path), "%s_tch%03d.bits", prefix, i);
+        gen->tchs[i].ch.out = fopen(path, "wb");
+        if (!gen->tchs[i].ch.out) {
+            perror("Failed to open output file");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int add_channels(gen_t *gen, tetrapol_engine_t *engine)
+{
+    gen->cch.ch_id = tetrapol_engine_add_channel(engine, &gen->cch.cfg,
+            gen->cfg->packed);
+    if (gen->cch.ch_id < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        chan_t *ch = &gen->tchs[i].ch;
+        ch->ch_id = tetrapol_engine_add_channel(engine, &ch->cfg,
+                gen->cfg->packed);
+        if (ch->ch_id < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void print_stats(const gen_t *gen)
+{
+    const gen_stats_t *st = &gen->stats;
+
+    unsigned long tch_tsdus = 0;
+    for (int i = 0; i < gen->cfg->ntchs; ++i) {
+        tch_tsdus += gen->tchs[i].ch.tsdus;
+    }
+
+    fprintf(stderr, "channels: 1 CCH + %d TCH, %d s, %d terminals, "
+            "%d groups\n", gen->cfg->ntchs, gen->cfg->duration,
+            gen->cfg->nterms, gen->cfg->ngroups);
+    fprintf(stderr, "calls: %lu (%lu blocked), registrations: %lu, "
+            "data messages: %lu\n", st->calls, st->calls_blocked, st->regs,
+            st->msgs);
+    fprintf(stderr, "TSDUs: CCH %lu, TCH %lu\n", gen->cch.tsdus, tch_tsdus);
+    fprintf(stderr, "SDCH backlog: max %d HDLC frames, %lu dropped\n",
+            st->backlog_max, st->msgs_dropped);
+}
+
+static void print_help(const char *prg_name)
+{
+    fprintf(stderr, "Generate synthetic traffic of TETRAPOL cell (CCH and TCHs).\n");
+    fprintf(stderr, "Usage: %s [OPTIONS ...] { -o <PREFIX> | -e }\n", prg_name);
+    fprintf(stderr, "    -o <PREFIX>             write channels into files PREFIX_cch.bits, PREFIX_tchNNN.bits\n");
+    fprintf(stderr, "    -e                      decode channels in process by engine, events go to stdout\n");
+    fprintf(stderr, "    -j <N>                  number of decoding threads for -e (default is number of CPUs)\n");
+    fprintf(stderr, "    -f { ACCURATE | FAST | ADAPTIVE }\n");
+    fprintf(stderr, "                            error correction used by -e (default is ACCURATE)\n");
+    fprintf(stderr, "    -b { UHF | VHF }        radio band (default is UHF)\n");
+    fprintf(stderr, "    -p                      output bits are packed, 8 bits per byte (first bit in LSB)\n");
+    fprintf(stderr, "    -n <N>                  number of TCHs (default is 8)\n");
+    fprintf(stderr, "    -a <N>                  number of terminals (default is 2000)\n");
+    fprintf(stderr, "    -g <N>                  number of groups (default is 50)\n");
+    fprintf(stderr, "    -l <SECONDS>            length of generated traffic (default is 600)\n");
+    fprintf(stderr, "    -c <RATE>               group calls per terminal and hour (default is 1)\n");
+    fprintf(stderr, "    -m <RATE>               data messages per terminal and hour (default is 4)\n");
+    fprintf(stderr, "    -r <RATE>               registrations per terminal and hour (default is 2)\n");
+    fprintf(stderr, "    -L <SECONDS>            mean group call length (default is 20)\n");
+    fprintf(stderr, "    -s <SEED>               seed of random generator\n");
+}
+
+int main(int argc, char *argv[])
+{
+    gen_cfg_t cfg = {
+        .ntchs = 8,
+        .nterms = 2000,
+        .ngroups = 50,
+        .duration = 600,
+        .call_rate = 1,
+        .call_len = 20,
+        .reg_rate = 2,
+        .msg_rate = 4,
+        .band = TETRAPOL_BAND_UHF,
+    };
+    const char *prefix = NULL;
+    bool engine_out = false;
+    int nworkers = 0;
+    int fec = TETRAPOL_FEC_ACCURATE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b:c:ef:g:hj:l:L:m:n:o:pr:s:")) != -1) {
+        switch (opt) {
+            case 'a':
+                cfg.nterms = atoi(optarg);
+                break;
+
+            case 'b':
+                if (!strcmp(optarg, "VHF")) {
+                    cfg.band = TETRAPOL_BAND_VHF;
+                } else if (!strcmp(optarg, "UHF")) {
+                    cfg.band = TETRAPOL_BAND_UHF;
+                } else {
+                    print_help(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'c':
+                cfg.call_rate = atof(optarg);
+                break;
+
+            case 'e':
+                engine_out = true;
+                break;
+
+            case 'f':
+                if (!strcmp(optarg, "ACCURATE")) {
+                    fec = TETRAPOL_FEC_ACCURATE;
+                } else if (!strcmp(optarg, "FAST")) {
+                    fec = TETRAPOL_FEC_FAST;
+                } else if (!strcmp(optarg, "ADAPTIVE")) {
+                    fec = TETRAPOL_FEC_ADAPTIVE;
+                } else {
+                    print_help(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'g':
+                cfg.ngroups = atoi(optarg);
+                break;
+
+            case 'j':
+                nworkers = atoi(optarg);
+                break;
+
+            case 'l':
+                cfg.duration = atoi(optarg);
+                break;
+
+            case 'L':
+                cfg.call_len = atof(optarg);
+                break;
+
+            case 'm':
+                cfg.msg_rate = atof(optarg);
+                break;
+
+            case 'n':
+                cfg.ntchs = atoi(optarg);
+                break;
+
+            case 'o':
+                prefix = optarg;
+                break;
+
+            case 'p':
+                cfg.packed = true;
+                break;
+
+            case 'r':
+                cfg.reg_rate = atof(optarg);
+                break;
+
+            case 's':
+                cfg.seed = strtoull(optarg, NULL, 0);
+                break;
+
+            case 'h':
+                print_help(argv[0]);
+                exit(0);
+
+            default:
+                print_help(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if ((!prefix && !engine_out) || cfg.ntchs < 0 ||
+            cfg.ntchs >= TETRAPOL_ENGINE_MAX_CHANNELS || cfg.nterms < 1 ||
+            cfg.ngroups < 1 || cfg.ngroups > 4095 || cfg.duration < 1) {
+        print_help(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    gen_t *gen = gen_create(&cfg, fec);
+    if (!gen) {
+        fprintf(stderr, "Failed to initialize generator.\n");
+        return EXIT_FAILURE;
+    }
+
+    tetrapol_engine_t *engine = NULL;
+    if (engine_out) {
+        engine = tetrapol_engine_create(nworkers, stdout);
+        if (!engine || add_channels(gen, engine)) {
+            fprintf(stderr, "Failed to initialize TETRAPOL engine.\n");
+            goto err;
+        }
+    }
+    if (prefix && open_outputs(gen, prefix)) {
+        goto err;
+    }
+
+    const uint64_t t_start = clock_ns();
+    uint64_t ns_gen = 0;
+    const int nframes = cfg.duration * FRAMES_PER_S;
+    for (int fr_no = 0; fr_no < nframes; ++fr_no) {
+        const uint64_t t = clock_ns();
+        if (gen_frame(gen)) {
+            fprintf(stderr, "Failed to encode frame.\n");
+            goto err;
+        }
+        ns_gen += clock_ns() - t;
+        if ((fr_no + 1) % CHUNK_FRAMES == 0 || fr_no + 1 == nframes) {
+            if (gen_flush(gen, engine)) {
+                goto err;
+            }
+        }
+    }
+    if (engine) {
+        tetrapol_engine_flush(engine);
+    }
+    const double wall = (clock_ns() - t_start) * 1e-9;
+
+    print_stats(gen);
+    if (engine) {
+        // decoding runs in parallel with generator
+        fprintf(stderr, "decoded %d s of %d channels in %.2f s "
+                "(generator %.2f s), %.1fx real time\n", cfg.duration,
+                1 + cfg.ntchs, wall, ns_gen * 1e-9, cfg.duration / wall);
+        tetrapol_engine_destroy(engine);
+    }
+    gen_destroy(gen);
+
+    return 0;
+
+err:
+    if (engine) {
+        tetrapol_engine_destroy(engine);
+    }
+    gen_destroy(gen);
+
+    return EXIT_FAILURE;
+}
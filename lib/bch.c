@@ -59,14 +59,17 @@ bool bch_push_frame(bch_t *bch, const frame_t *fr)
         return false;
     }
 
+    if (!data_frame_check_fcs(bch->data_fr)) {
+        data_frame_reset(bch->data_fr);
+        return false;
+    }
+
     uint8_t tpdu_data[SYS_PAR_N200_BYTES_MAX];
     const int nblocks = data_frame_blocks(bch->data_fr);
     const int size = data_frame_get_bytes(bch->data_fr, tpdu_data);
 
     hdlc_frame_t hdlc_fr;
-    if (!hdlc_frame_parse(&hdlc_fr, tpdu_data, size)) {
-        return false;
-    }
+    hdlc_frame_parse_data(&hdlc_fr, tpdu_data, size);
 
     if (hdlc_fr.command.cmd != COMMAND_UNNUMBERED_UI) {
         return false;
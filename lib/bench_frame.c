@@ -0,0 +1,515 @@
+#define _POSIX_C_SOURCE 200809L
+
+// include, we are measuring static methods
+#include "frame.c"
+
+#include <tetrapol/misc.h>
+
+#include <getopt.h>
+#include <stdio.h>
+
+/**
+  Frame decoder microbenchmark.
+
+  Frames with random content are encoded by frame_encoder_encode() for all
+  128 SCRs, voice and data frames alternate. Bit errors are added after
+  channel differential encoding (as the channel does), then frames are
+  differentially decoded the same way as phys_ch does.
+
+  Each decoding stage is repeated over all frames until it runs at least
+  for given time, result is reported in ns/frame and frames/s.
+  */
+
+enum {
+    NFRAMES_DEFAULT = 4096,
+    NFRAMES_MAX = 16 * 4096,
+    NBERS_MAX = 16,
+};
+
+typedef struct {
+    int band;
+    double ber;
+    int nframes;
+    uint8_t (*data)[FRAME_DATA_LEN];    ///< received frame data
+    const uint8_t **data_ptrs;
+    int *scr;
+    int *fr_type;
+    frame_t *frs;       ///< output of decoding
+    frame_t *frs_dec;   ///< frames decoded by accurate decoder (for CRC)
+} corpus_t;
+
+typedef struct {
+    bool json;
+    double min_time;    ///< minimal time of single measurement in seconds
+} bench_cfg_t;
+
+static uint64_t rnd_state = 1;
+
+static uint64_t rnd(void)
+{
+    return xorshift64(&rnd_state);
+}
+
+static double now(void)
+{
+    return clock_ns() * 1e-9;
+}
+
+static const char *band_name(int band)
+{
+    return (band == TETRAPOL_BAND_VHF) ? "VHF" : "UHF";
+}
+
+static bool corpus_create(corpus_t *corpus, int band, double ber, int nframes)
+{
+    corpus->band = band;
+    corpus->ber = ber;
+    corpus->nframes = nframes;
+    corpus->data = malloc(nframes * sizeof(*corpus->data));
+    corpus->data_ptrs = malloc(nframes * sizeof(*corpus->data_ptrs));
+    corpus->scr = malloc(nframes * sizeof(*corpus->scr));
+    corpus->fr_type = malloc(nframes * sizeof(*corpus->fr_type));
+    corpus->frs = malloc(nframes * sizeof(*corpus->frs));
+    corpus->frs_dec = malloc(nframes * sizeof(*corpus->frs_dec));
+    if (!corpus->data || !corpus->data_ptrs || !corpus->scr ||
+            !corpus->fr_type || !corpus->frs || !corpus->frs_dec) {
+        return false;
+    }
+
+    // probability of bit error scaled to 32 bits
+    const uint64_t ber_thr = ber * 4294967296.0;
+
+    frame_encoder_t *fe = frame_encoder_create(band, 0, DIR_DOWNLINK);
+    if (!fe) {
+        return false;
+    }
+
+    for (int i = 0; i < nframes; ++i) {
+        corpus->scr[i] = i % 128;
+        corpus->fr_type[i] = (i / 128) % 2 ? FRAME_TYPE_VOICE : FRAME_TYPE_DATA;
+
+        frame_t fr;
+        memset(&fr, 0, sizeof(fr));
+        fr.fr_type = corpus->fr_type[i];
+        uint8_t *bits = (uint8_t *)&fr.voice;
+        for (int j = 1; j < sizeof(frame_voice_t); ++j) {
+            bits[j] = rnd() & 1;
+        }
+
+        uint8_t fr_enc[FRAME_LEN / 8];
+        frame_encoder_set_scr(fe, corpus->scr[i]);
+        frame_encoder_encode(fe, fr_enc, &fr);
+
+        uint8_t bit = 0;
+        for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+            const int k = FRAME_HDR_LEN + j;
+            uint8_t b = (fr_enc[k / 8] >> (k % 8)) & 1;
+            if ((rnd() & 0xffffffff) < ber_thr) {
+                b ^= 1;
+            }
+            bit ^= b;
+            corpus->data[i][j] = bit;
+        }
+        corpus->data_ptrs[i] = corpus->data[i];
+    }
+
+    frame_encoder_destroy(fe);
+
+    frame_decoder_t *fd = frame_decoder_create(band, 0, FRAME_TYPE_AUTO);
+    if (!fd) {
+        return false;
+    }
+    for (int i = 0; i < nframes; ++i) {
+        frame_decoder_reset(fd, band, corpus->scr[i], FRAME_TYPE_AUTO);
+        frame_decoder_decode(fd, &corpus->frs_dec[i], corpus->data[i]);
+    }
+    frame_decoder_destroy(fd);
+
+    return true;
+}
+
+static void corpus_destroy(corpus_t *corpus)
+{
+    free(corpus->data);
+    free(corpus->data_ptrs);
+    free(corpus->scr);
+    free(corpus->fr_type);
+    free(corpus->frs);
+    free(corpus->frs_dec);
+}
+
+/// keeps results of measured functions alive
+static volatile unsigned bench_sink;
+
+/**
+  Run measured stage over all frames in corpus.
+
+  @return number of valid results (decoded frames, matching CRCs, ...), or
+    value derived from results for stages without validity
+  */
+typedef unsigned (*bench_fnc_t)(corpus_t *corpus, frame_decoder_t *fd);
+
+static unsigned bench_descramble(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        uint8_t tmp[FRAME_DATA_LEN];
+        frame_descramble(tmp, corpus->data[i], corpus->scr[i]);
+        r += tmp[i % FRAME_DATA_LEN];
+    }
+
+    return r;
+}
+
+static unsigned bench_diff_dec(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        uint8_t tmp[FRAME_DATA_LEN];
+        memcpy(tmp, corpus->data[i], sizeof(tmp));
+        frame_diff_dec(tmp);
+        r += tmp[i % FRAME_DATA_LEN];
+    }
+
+    return r;
+}
+
+static unsigned bench_deinterleave(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        uint8_t deint[FRAME_DATA_LEN];
+        frame_deinterleave1(deint, corpus->data[i], corpus->band);
+        frame_deinterleave2(deint, corpus->data[i], corpus->band,
+                corpus->fr_type[i]);
+        r += deint[i % FRAME_DATA_LEN];
+    }
+
+    return r;
+}
+
+static unsigned bench_deinterleave_fused(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        uint8_t deint[FRAME_DATA_LEN];
+        frame_deinterleave_fused(deint, corpus->data[i], corpus->band,
+                corpus->scr[i], corpus->fr_type[i], 0, FRAME_DATA_LEN);
+        r += deint[i % FRAME_DATA_LEN];
+    }
+
+    return r;
+}
+
+static unsigned bench_viterbi(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        uint8_t dec[26 + 50];
+        r += frame_viterbi26(dec, corpus->data[i]);
+        r += frame_viterbi50(dec + 26, corpus->data[i] + 2*26);
+    }
+
+    return r;
+}
+
+static unsigned bench_viterbi_batch(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; i += VITERBI_BATCH) {
+        const int m = (corpus->nframes - i < VITERBI_BATCH) ?
+            corpus->nframes - i : VITERBI_BATCH;
+        uint8_t dec[VITERBI_BATCH][26 + 50];
+        uint8_t *dec_ptrs[VITERBI_BATCH];
+        const uint8_t *in[VITERBI_BATCH];
+        int fixed[VITERBI_BATCH];
+
+        for (int j = 0; j < m; ++j) {
+            dec_ptrs[j] = dec[j];
+            in[j] = corpus->data[i + j];
+        }
+        frame_viterbi_batch(dec_ptrs, in, fixed, m, 26);
+        for (int j = 0; j < m; ++j) {
+            r += fixed[j];
+            dec_ptrs[j] = dec[j] + 26;
+            in[j] = corpus->data[i + j] + 2*26;
+        }
+        frame_viterbi_batch(dec_ptrs, in, fixed, m, 50);
+        for (int j = 0; j < m; ++j) {
+            r += fixed[j];
+        }
+    }
+
+    return r;
+}
+
+static unsigned bench_crc(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        const frame_t *fr = &corpus->frs_dec[i];
+        r += frame_check_crc(fr->blob_, fr->fr_type);
+    }
+
+    return r;
+}
+
+static unsigned bench_decode(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    for (int i = 0; i < corpus->nframes; ++i) {
+        frame_decoder_reset(fd, corpus->band, corpus->scr[i], FRAME_TYPE_AUTO);
+        frame_decoder_decode(fd, &corpus->frs[i], corpus->data[i]);
+        r += !corpus->frs[i].broken;
+    }
+
+    return r;
+}
+
+static unsigned bench_decode_batch(corpus_t *corpus, frame_decoder_t *fd)
+{
+    // frames are grouped by SCR in real channel, corpus frames cycle SCR,
+    // so whole corpus is decoded for each SCR as single batch
+    unsigned r = 0;
+    for (int scr = 0; scr < 128; ++scr) {
+        const uint8_t *data_ptrs[NFRAMES_MAX / 128];
+        int n = 0;
+        for (int i = scr; i < corpus->nframes; i += 128) {
+            data_ptrs[n++] = corpus->data[i];
+        }
+        frame_decoder_reset(fd, corpus->band, scr, FRAME_TYPE_AUTO);
+        frame_decoder_decode_batch(fd, corpus->frs, data_ptrs, n);
+        for (int i = 0; i < n; ++i) {
+            r += !corpus->frs[i].broken;
+        }
+    }
+
+    return r;
+}
+
+static unsigned bench_scr_score(corpus_t *corpus, frame_decoder_t *fd)
+{
+    unsigned r = 0;
+    frame_decoder_reset(fd, corpus->band, 0, FRAME_TYPE_AUTO);
+    for (int i = 0; i < corpus->nframes; ++i) {
+        int scr_score[128];
+        frame_decoder_scr_score(fd, scr_score, corpus->data[i]);
+        r += scr_score[corpus->scr[i]] > 0;
+    }
+
+    return r;
+}
+
+static unsigned bench_check_scr(corpus_t *corpus, frame_decoder_t *fd)
+{
+    const uint64_t scr_mask[2] = { ~0ULL, ~0ULL };
+    unsigned r = 0;
+    frame_decoder_reset(fd, corpus->band, 0, FRAME_TYPE_AUTO);
+    for (int i = 0; i < corpus->nframes; ++i) {
+        uint64_t scr_ok[2];
+        frame_decoder_check_scr(fd, scr_ok, scr_mask, corpus->data[i]);
+        r += (scr_ok[corpus->scr[i] / 64] >> (corpus->scr[i] % 64)) & 1;
+    }
+
+    return r;
+}
+
+static void bench_run(const bench_cfg_t *cfg, corpus_t *corpus,
+        const char *stage, const char *fec, int fec_id, bool has_valid,
+        bench_fnc_t fnc)
+{
+    frame_decoder_t *fd = frame_decoder_create(corpus->band, 0, FRAME_TYPE_AUTO);
+    if (!fd) {
+        fprintf(stderr, "Failed to create frame decoder\n");
+        exit(EXIT_FAILURE);
+    }
+    frame_decoder_set_fec(fd, fec_id);
+
+    // warm up caches and get number of valid results
+    const unsigned valid = fnc(corpus, fd);
+
+    int nruns = 0;
+    const double t_start = now();
+    double t;
+    do {
+        bench_sink += fnc(corpus, fd);
+        ++nruns;
+        t = now() - t_start;
+    } while (t < cfg->min_time);
+
+    frame_decoder_destroy(fd);
+
+    const double nframes = (double)nruns * corpus->nframes;
+    const double ns_per_frame = t * 1e9 / nframes;
+    const double frames_per_s = nframes / t;
+
+    if (cfg->json) {
+        printf("{ \"bench\": \"frame\", \"stage\": \"%s\", ", stage);
+        if (fec) {
+            printf("\"fec\": \"%s\", ", fec);
+        }
+        printf("\"band\": \"%s\", \"ber\": %g, \"frames\": %d, \"runs\": %d, "
+                "\"ns_per_frame\": %.1f, \"frames_per_s\": %.0f",
+                band_name(corpus->band), corpus->ber, corpus->nframes, nruns,
+                ns_per_frame, frames_per_s);
+        if (has_valid) {
+            printf(", \"valid\": %u", valid);
+        }
+        printf(" }\n");
+    } else {
+        char valid_str[32] = "-";
+        if (has_valid) {
+            snprintf(valid_str, sizeof(valid_str), "%u/%d", valid, corpus->nframes);
+        }
+        printf("%-18s %-9s %-4s %-7g %10.1f %12.0f %13s\n",
+                stage, fec ? fec : "-", band_name(corpus->band), corpus->ber,
+                ns_per_frame, frames_per_s, valid_str);
+    }
+    fflush(stdout);
+}
+
+static void bench_corpus(const bench_cfg_t *cfg, corpus_t *corpus)
+{
+    static const struct {
+        const char *stage;
+        bool has_valid;
+        bench_fnc_t fnc;
+    } stages[] = {
+        { "descramble", false, bench_descramble },
+        { "diff_dec", false, bench_diff_dec },
+        { "deinterleave", false, bench_deinterleave },
+        { "deinterleave_fused", false, bench_deinterleave_fused },
+        { "viterbi", false, bench_viterbi },
+        { "viterbi_batch", false, bench_viterbi_batch },
+        { "crc", true, bench_crc },
+        { "scr_score", true, bench_scr_score },
+        { "check_scr", true, bench_check_scr },
+    };
+    static const struct {
+        const char *name;
+        int fec;
+    } fecs[] = {
+        { "accurate", TETRAPOL_FEC_ACCURATE },
+        { "fast", TETRAPOL_FEC_FAST },
+        { "adaptive", TETRAPOL_FEC_ADAPTIVE },
+    };
+
+    for (int i = 0; i < ARRAY_LEN(stages); ++i) {
+        if (stages[i].fnc == bench_diff_dec &&
+                corpus->band != TETRAPOL_BAND_UHF) {
+            continue;
+        }
+        bench_run(cfg, corpus, stages[i].stage, NULL, TETRAPOL_FEC_ACCURATE,
+                stages[i].has_valid, stages[i].fnc);
+    }
+    for (int i = 0; i < ARRAY_LEN(fecs); ++i) {
+        bench_run(cfg, corpus, "decode", fecs[i].name, fecs[i].fec, true,
+                bench_decode);
+        bench_run(cfg, corpus, "decode_batch", fecs[i].name, fecs[i].fec,
+                true, bench_decode_batch);
+    }
+}
+
+static void print_help(const char *prg_name)
+{
+    fprintf(stderr, "Measure speed of frame decoding stages.\n");
+    fprintf(stderr, "Usage: %s [OPTIONS ...]\n", prg_name);
+    fprintf(stderr, "    -b { UHF | VHF }        measure only single band (default is both)\n");
+    fprintf(stderr, "    -e <BER>                bit error rate, can be repeated (default is 0, 0.001, 0.01, 0.05)\n");
+    fprintf(stderr, "    -n <N>                  number of frames in corpus (default is %d, at most %d)\n",
+            NFRAMES_DEFAULT, NFRAMES_MAX);
+    fprintf(stderr, "    -t <SECONDS>            minimal time of each measurement (default is 0.2)\n");
+    fprintf(stderr, "    -j                      JSON output, single object per line\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bench_cfg_t cfg = {
+        .json = false,
+        .min_time = 0.2,
+    };
+    int bands[2] = { TETRAPOL_BAND_VHF, TETRAPOL_BAND_UHF };
+    int nbands = 2;
+    double bers[NBERS_MAX] = { 0, 0.001, 0.01, 0.05 };
+    int nbers = 4;
+    bool bers_set = false;
+    int nframes = NFRAMES_DEFAULT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:e:hjn:t:")) != -1) {
+        switch (opt) {
+            case 'b':
+                nbands = 1;
+                if (!strcmp(optarg, "VHF")) {
+                    bands[0] = TETRAPOL_BAND_VHF;
+                } else if (!strcmp(optarg, "UHF")) {
+                    bands[0] = TETRAPOL_BAND_UHF;
+                } else {
+                    print_help(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'e':
+                if (!bers_set) {
+                    bers_set = true;
+                    nbers = 0;
+                }
+                if (nbers == NBERS_MAX) {
+                    fprintf(stderr, "Too many BERs.\n");
+                    exit(EXIT_FAILURE);
+                }
+                bers[nbers++] = atof(optarg);
+                break;
+
+            case 'h':
+                print_help(argv[0]);
+                exit(0);
+                break;
+
+            case 'j':
+                cfg.json = true;
+                break;
+
+            case 'n':
+                nframes = atoi(optarg);
+                if (nframes < 128 || nframes > NFRAMES_MAX) {
+                    print_help(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 't':
+                cfg.min_time = atof(optarg);
+                break;
+
+            default:
+                print_help(argv[0]);
+                exit(EXIT_FAILURE);
+                break;
+        }
+    }
+
+    // do not measure logging, even WTF messages are logged for broken frames
+    log_set_lvl(WTF - 1);
+
+    if (!cfg.json) {
+        printf("%-18s %-9s %-4s %-7s %10s %12s %13s\n",
+                "stage", "fec", "band", "ber", "ns/frame", "frames/s", "valid");
+    }
+
+    for (int b = 0; b < nbands; ++b) {
+        for (int e = 0; e < nbers; ++e) {
+            corpus_t corpus;
+            rnd_state = 1;
+            if (!corpus_create(&corpus, bands[b], bers[e], nframes)) {
+                fprintf(stderr, "Failed to create corpus\n");
+                exit(EXIT_FAILURE);
+            }
+            bench_corpus(&cfg, &corpus);
+            corpus_destroy(&corpus);
+        }
+    }
+
+    return 0;
+}
@@ -144,6 +144,8 @@ void cch_fr_error(cch_t *cch)
     pch_reset(cch->pch);
 }
 
-void cch_tick(time_evt_t *te, void *cch)
+void cch_tick(time_evt_t *te, void *cch_)
 {
+    cch_t *cch = cch_;
+    sdch_tick(te, cch->sdch);
 }
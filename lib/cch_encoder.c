@@ -0,0 +1,250 @@
+#define LOG_PREFIX "cch_encoder"
+
+#include <tetrapol/cch_encoder.h>
+#include <tetrapol/addr.h>
+#include <tetrapol/bit_utils.h>
+#include <tetrapol/data_frame.h>
+#include <tetrapol/hdlc_frame.h>
+#include <tetrapol/log.h>
+#include <tetrapol/misc.h>
+#include <tetrapol/system_config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    /// number of data frames which can be queued per logical channel
+    QUEUE_LEN = 16,
+};
+
+enum {
+    ENC_CH_BCH,
+    ENC_CH_PCH,
+    ENC_CH_RCH,
+    ENC_CH_SDCH,
+    ENC_CH_NUM,
+};
+
+typedef struct {
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    int nbits;
+} queue_item_t;
+
+typedef struct {
+    queue_item_t queue[QUEUE_LEN];
+    int head;       ///< index of first queued data frame
+    int len;        ///< number of queued data frames
+    int max_nbits;  ///< the longest data frame allowed
+    /// blocks of data frame being transmitted
+    frame_t frs[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
+    int nfrs;
+    int fr_idx;     ///< next block to transmit
+    bool idle;      ///< transmitted data frame is idle filler
+} enc_ch_t;
+
+struct cch_encoder_priv_t {
+    int frame_no;
+    int stuffing_idx;   ///< index of next SDCH stuffing frame
+    enc_ch_t chs[ENC_CH_NUM];
+};
+
+static int enc_ch_idx(int log_ch)
+{
+    switch (log_ch) {
+        case LOG_CH_BCH:
+            return ENC_CH_BCH;
+
+        case LOG_CH_PCH:
+            return ENC_CH_PCH;
+
+        case LOG_CH_RCH:
+            return ENC_CH_RCH;
+
+        case LOG_CH_SDCH:
+            return ENC_CH_SDCH;
+
+        default:
+            return -1;
+    }
+}
+
+cch_encoder_t *cch_encoder_create(int frame_no)
+{
+    cch_encoder_t *enc = calloc(1, sizeof(cch_encoder_t));
+    if (!enc) {
+        return NULL;
+    }
+
+    enc->frame_no = frame_no % 200;
+    // BCH: 3 blocks + parity block fits into frames 0-3
+    enc->chs[ENC_CH_BCH].max_nbits = 3 * 64;
+    enc->chs[ENC_CH_PCH].max_nbits = 2 * 64;
+    enc->chs[ENC_CH_RCH].max_nbits = 64;
+    enc->chs[ENC_CH_SDCH].max_nbits = SYS_PAR_DATA_FRAME_BLOCKS_MAX * 64;
+
+    return enc;
+}
+
+void cch_encoder_destroy(cch_encoder_t *enc)
+{
+    free(enc);
+}
+
+int cch_encoder_frame_no(const cch_encoder_t *enc)
+{
+    return enc->frame_no;
+}
+
+int cch_encoder_push(cch_encoder_t *enc, int log_ch, const uint8_t *data,
+        int nbits)
+{
+    const int idx = enc_ch_idx(log_ch);
+    if (idx < 0) {
+        LOG(ERR, "unsupported logical channel %d", log_ch);
+        return -1;
+    }
+
+    enc_ch_t *ch = &enc->chs[idx];
+    if (nbits <= 0 || nbits % 64 || nbits > ch->max_nbits ||
+            (idx == ENC_CH_PCH && nbits != ch->max_nbits)) {
+        LOG(ERR, "invalid data frame length %d", nbits);
+        return -1;
+    }
+    if (ch->len == QUEUE_LEN) {
+        LOG(DBG, "queue full");
+        return -1;
+    }
+
+    queue_item_t *item = &ch->queue[(ch->head + ch->len) % QUEUE_LEN];
+    memcpy(item->data, data, nbits / 8);
+    item->nbits = nbits;
+    ++ch->len;
+
+    return 0;
+}
+
+int cch_encoder_pending(const cch_encoder_t *enc, int log_ch)
+{
+    const int idx = enc_ch_idx(log_ch);
+    if (idx < 0) {
+        return 0;
+    }
+
+    const enc_ch_t *ch = &enc->chs[idx];
+    const bool in_progress = !ch->idle && ch->fr_idx < ch->nfrs;
+
+    return ch->len + (in_progress ? 1 : 0);
+}
+
+/// PCH without activation and paged addresses
+static int pch_idle_build(uint8_t *data)
+{
+    const addr_t no_st = { .z = 0, .y = 7, .x = 0 };
+
+    memset(data, 0, 8);
+    for (int i = 0; i < 4; ++i) {
+        addr_build(&data[8 + 2*i], &no_st);
+    }
+
+    return 2 * 64;
+}
+
+/// RCH without acknowledged addresses
+static int rch_idle_build(uint8_t *data)
+{
+    const addr_t no_st = { .z = 0, .y = 7, .x = 0 };
+
+    for (int i = 0; i < 3; ++i) {
+        addr_build(&data[2*i], &no_st);
+    }
+
+    fcs_t fcs;
+    fcs_init(&fcs);
+    fcs_update(&fcs, data, 6 * 8);
+    const uint16_t crc = ~fcs.crc;
+    data[6] = crc & 0xff;
+    data[7] = crc >> 8;
+
+    return 64;
+}
+
+static int idle_build(cch_encoder_t *enc, int idx, uint8_t *data)
+{
+    switch (idx) {
+        case ENC_CH_PCH:
+            return pch_idle_build(data);
+
+        case ENC_CH_RCH:
+            return rch_idle_build(data);
+
+        default: {
+            const int nbits = hdlc_frame_build_stuffing(data,
+                    enc->stuffing_idx);
+            enc->stuffing_idx =
+                (enc->stuffing_idx + 1) % HDLC_STUFFING_PATTERNS;
+            return nbits;
+        }
+    }
+}
+
+/**
+  Start transmission of next data frame, queued one when use_queue is set
+  and queue is not empty, idle filler otherwise.
+  */
+static void enc_ch_next(cch_encoder_t *enc, int idx, bool use_queue)
+{
+    enc_ch_t *ch = &enc->chs[idx];
+    uint8_t idle[2 * 8];
+    const uint8_t *data;
+    int nbits;
+
+    if (use_queue && ch->len) {
+        const queue_item_t *item = &ch->queue[ch->head];
+        data = item->data;
+        nbits = item->nbits;
+        ch->head = (ch->head + 1) % QUEUE_LEN;
+        --ch->len;
+        ch->idle = false;
+    } else {
+        nbits = idle_build(enc, idx, idle);
+        data = idle;
+        ch->idle = true;
+    }
+
+    ch->nfrs = data_frame_build(ch->frs, data, nbits, 0);
+    ch->fr_idx = 0;
+}
+
+void cch_encoder_get_frame(cch_encoder_t *enc, frame_t *fr)
+{
+    const int fn_mod = enc->frame_no % 100;
+    enc_ch_t *ch;
+
+    if (fn_mod <= 3) {
+        // BCH data frame must start in frame 0, the rest is stuffed
+        ch = &enc->chs[ENC_CH_BCH];
+        if (fn_mod == 0 || ch->fr_idx == ch->nfrs) {
+            enc_ch_next(enc, ENC_CH_BCH, fn_mod == 0);
+        }
+    } else if (fn_mod == 98 || fn_mod == 99) {
+        ch = &enc->chs[ENC_CH_PCH];
+        if (fn_mod == 98) {
+            enc_ch_next(enc, ENC_CH_PCH, true);
+        } else if (ch->fr_idx == ch->nfrs) {
+            // encoder started in frame 99, send second block of idle PCH
+            enc_ch_next(enc, ENC_CH_PCH, false);
+            ch->fr_idx = 1;
+        }
+    } else if (fn_mod % 25 == 14) {
+        ch = &enc->chs[ENC_CH_RCH];
+        enc_ch_next(enc, ENC_CH_RCH, true);
+    } else {
+        ch = &enc->chs[ENC_CH_SDCH];
+        if (ch->fr_idx == ch->nfrs) {
+            enc_ch_next(enc, ENC_CH_SDCH, true);
+        }
+    }
+
+    *fr = ch->frs[ch->fr_idx++];
+    enc->frame_no = (enc->frame_no + 1) % 200;
+}
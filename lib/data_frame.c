@@ -16,11 +16,23 @@ enum {
     FN_11 = 03,
 };
 
+/// Part of frame used by data frame, bits are packed, first bit in LSB
+typedef struct {
+    uint64_t data;
+    uint8_t fn;
+    uint8_t asb;
+    bool broken;
+} block_t;
+
 struct data_frame_priv_t {
-    frame_t frames[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
+    block_t blocks[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
     int fn[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
     int nframes;
     int nerrs;
+    /// FCS state after all frames
+    fcs_t fcs;
+    /// FCS state before last frame, last frame of multiblock is parity
+    fcs_t fcs_prev;
 };
 
 data_frame_t *data_frame_create(void)
@@ -49,21 +61,31 @@ void data_frame_reset(data_frame_t *data_fr)
 {
     data_fr->nframes = 0;
     data_fr->nerrs = 0;
+    fcs_init(&data_fr->fcs);
+    fcs_init(&data_fr->fcs_prev);
+}
+
+static void data_frame_update_fcs(data_frame_t *data_fr, int fr_no)
+{
+    uint8_t bytes[8];
+
+    pack64_bytes(bytes, data_fr->blocks[fr_no].data);
+    data_fr->fcs_prev = data_fr->fcs;
+    fcs_update(&data_fr->fcs, bytes, 64);
 }
 
 static bool check_parity(data_frame_t *data_fr)
 {
-    for (int i = 3; i < 3 + 64; ++i) {
-        int parity = 0;
-        for (int fr_no = 0; fr_no < data_fr->nframes; ++fr_no) {
-            parity ^= data_fr->frames[fr_no].data.data[i];
-        }
-        if (parity) {
-            return false;
-        }
+    uint64_t parity = 0;
+    uint8_t parity_asb = 0;
+
+    for (int fr_no = 0; fr_no < data_fr->nframes; ++fr_no) {
+        parity ^= data_fr->blocks[fr_no].data;
+        parity_asb ^= data_fr->blocks[fr_no].asb;
     }
 
-    return true;
+    // first data bit is not checked, first ASB bit is
+    return !(parity & ~1ULL) && !(parity_asb & 1);
 }
 
 static void fix_by_parity(data_frame_t *data_fr)
@@ -71,7 +93,7 @@ static void fix_by_parity(data_frame_t *data_fr)
     int err_fr_no = 0;
 
     for (int fr_no = 0; fr_no < data_fr->nframes; ++fr_no) {
-        if (data_fr->frames[fr_no].broken) {
+        if (data_fr->blocks[fr_no].broken) {
             err_fr_no = fr_no;
             break;
         }
@@ -82,15 +104,27 @@ static void fix_by_parity(data_frame_t *data_fr)
         return;
     }
 
-    for (int i = 1; i < 1 + 64 + 2; ++i) {
-        int bit = 0;
-        for (int fr_no = 0; fr_no < data_fr->nframes; ++fr_no) {
-            if (fr_no != err_fr_no) {
-                bit ^= data_fr->frames[fr_no].data.data[i];
-            }
-            data_fr->frames[err_fr_no].data.data[i] = bit;
+    // second FN bit, data and first ASB bit
+    block_t *err_block = &data_fr->blocks[err_fr_no];
+    uint64_t data = 0;
+    uint8_t fn = err_block->fn & 1;
+    uint8_t asb = err_block->asb & 2;
+    for (int fr_no = 0; fr_no < data_fr->nframes; ++fr_no) {
+        if (fr_no != err_fr_no) {
+            data ^= data_fr->blocks[fr_no].data;
+            fn ^= data_fr->blocks[fr_no].fn & 2;
+            asb ^= data_fr->blocks[fr_no].asb & 1;
         }
     }
+    err_block->data = data;
+    err_block->fn = fn;
+    err_block->asb = asb;
+
+    // FCS was updated with broken data, recompute it
+    fcs_init(&data_fr->fcs);
+    for (int fr_no = 0; fr_no < data_fr->nframes; ++fr_no) {
+        data_frame_update_fcs(data_fr, fr_no);
+    }
 }
 
 static int data_frame_check_multiblock(data_frame_t *data_fr)
@@ -124,7 +158,7 @@ static int data_frame_push_frame_(data_frame_t *data_fr, const frame_t *fr)
 
 int data_frame_push_frame(data_frame_t *data_fr, const frame_t *fr)
 {
-    if (data_fr->nframes == ARRAY_LEN(data_fr->frames)) {
+    if (data_fr->nframes == ARRAY_LEN(data_fr->blocks)) {
         data_frame_reset(data_fr);
     }
 
@@ -138,7 +172,12 @@ int data_frame_push_frame(data_frame_t *data_fr, const frame_t *fr)
     const int fn = fr->data.data[0] | (fr->data.data[1] << 1);
     data_fr->fn[data_fr->nframes] = fr->broken ? -1 : fn;
 
-    memcpy(&data_fr->frames[data_fr->nframes], fr, sizeof(frame_t));
+    block_t *block = &data_fr->blocks[data_fr->nframes];
+    block->data = fr->data_packed;
+    block->fn = fn;
+    block->asb = fr->data.asb[0] | (fr->data.asb[1] << 1);
+    block->broken = fr->broken;
+    data_frame_update_fcs(data_fr, data_fr->nframes);
     ++data_fr->nframes;
 
     // single frame
@@ -158,7 +197,7 @@ int data_frame_push_frame(data_frame_t *data_fr, const frame_t *fr)
     }
 
     const int fn_prev = data_fr->fn[data_fr->nframes - 2];
-    const bool fr_errors_prev = data_fr->frames[data_fr->nframes - 2].broken;
+    const bool fr_errors_prev = data_fr->blocks[data_fr->nframes - 2].broken;
 
     // check for dualframe or multiframe
     if (data_fr->nframes == 2) {
@@ -240,17 +279,80 @@ int data_frame_push_frame(data_frame_t *data_fr, const frame_t *fr)
     return data_frame_push_frame_(data_fr, fr);
 }
 
+bool data_frame_check_fcs(const data_frame_t *data_fr)
+{
+    return fcs_check((data_fr->nframes <= 2) ?
+            &data_fr->fcs : &data_fr->fcs_prev);
+}
+
 int data_frame_get_bytes(data_frame_t *data_fr, uint8_t *data)
 {
     const int nframes = (data_fr->nframes <= 2) ?
         data_fr->nframes : data_fr->nframes - 1;
 
-    memset(data, 0, 8*nframes);
     for (int fr_no = 0; fr_no < nframes; ++fr_no) {
-        pack_bits(data, data_fr->frames[fr_no].data.data + 2, 64*fr_no, 64);
+        pack64_bytes(data + 8*fr_no, data_fr->blocks[fr_no].data);
     }
 
     data_frame_reset(data_fr);
 
     return nframes * 64;
 }
+
+/// fill data frame block, data bits are also stored packed (data_packed)
+static void data_frame_build_block(frame_t *fr, uint64_t data, int fn, int asb)
+{
+    memset(fr, 0, sizeof(*fr));
+    fr->fr_type = FRAME_TYPE_DATA;
+    fr->data.data[0] = fn & 1;
+    fr->data.data[1] = fn >> 1;
+    for (int i = 0; i < 64; ++i) {
+        fr->data.data[2 + i] = (data >> i) & 1;
+    }
+    fr->data.asb[0] = asb & 1;
+    fr->data.asb[1] = asb >> 1;
+    fr->data_packed = data;
+}
+
+int data_frame_build(frame_t *frs, const uint8_t *data, int nbits, int asb)
+{
+    const int nblocks = nbits / 64;
+    if (nbits % 64 || !nblocks || nblocks > SYS_PAR_DATA_FRAME_BLOCKS_MAX) {
+        LOG(ERR, "invalid data frame length %d", nbits);
+        return -1;
+    }
+
+    uint64_t parity = 0;
+    for (int fr_no = 0; fr_no < nblocks; ++fr_no) {
+        uint64_t block = 0;
+        memcpy(&block, data + 8*fr_no, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        block = __builtin_bswap64(block);
+#endif
+        parity ^= block;
+
+        int fn;
+        if (nblocks == 1) {
+            fn = FN_00;
+        } else if (nblocks == 2) {
+            fn = fr_no ? FN_11 : FN_01;
+        } else if (fr_no == 0) {
+            fn = FN_01;
+        } else if (fr_no == 1 || fr_no == nblocks - 1) {
+            fn = FN_10;
+        } else {
+            fn = FN_11;
+        }
+        data_frame_build_block(&frs[fr_no], block, fn, asb);
+    }
+
+    if (nblocks <= 2) {
+        return nblocks;
+    }
+
+    // parity block, the first ASB bit is XOR of data blocks
+    const int parity_asb = (asb & 2) | ((nblocks % 2) ? (asb & 1) : 0);
+    data_frame_build_block(&frs[nblocks], parity, FN_01, parity_asb);
+
+    return nblocks + 1;
+}
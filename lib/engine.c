@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200809L
+#define LOG_PREFIX "engine"
+
+#include <tetrapol/engine.h>
+#include <tetrapol/log.h>
+#include <tetrapol/phys_ch.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+enum {
+    /// size of channel input queue in bytes
+    CH_BUF_LEN = 1 << 16,
+};
+
+typedef struct {
+    int id;
+    tetrapol_t *tetrapol;
+    phys_ch_t *phys_ch;
+    bool packed;
+
+    pthread_mutex_t lock;   ///< protects items below
+    uint8_t *in_buf;        ///< data pushed by producer
+    int in_len;
+    bool queued;            ///< channel is queued or being decoded
+    bool failed;            ///< decoder returned error, data are dropped
+    int worker;             ///< the last worker which decoded channel
+
+    uint8_t *work_buf;      ///< data being decoded, owned by worker
+} channel_t;
+
+/// Queue of channels ready for decoding, owner takes channels from head,
+/// other workers steal from tail.
+typedef struct {
+    pthread_mutex_t lock;
+    channel_t *chs[TETRAPOL_ENGINE_MAX_CHANNELS];
+    int head;
+    int len;
+} ch_queue_t;
+
+typedef struct {
+    int id;
+    tetrapol_engine_t *engine;
+    pthread_t thread;
+    ch_queue_t queue;
+} worker_t;
+
+struct tetrapol_engine_priv_t {
+    FILE *out;
+    int log_lvl;
+
+    pthread_mutex_t lock;   ///< protects items below
+    pthread_cond_t work_cond;   ///< signaled when channel is queued
+    pthread_cond_t idle_cond;   ///< signaled when nbusy drops to 0
+    int ntasks;             ///< channels in worker queues
+    int nbusy;              ///< channels queued or being decoded
+    bool stop;
+    int nchannels;
+    channel_t *channels[TETRAPOL_ENGINE_MAX_CHANNELS];
+
+    int nworkers;
+    worker_t *workers;
+};
+
+static void ch_queue_push(ch_queue_t *queue, channel_t *ch)
+{
+    pthread_mutex_lock(&queue->lock);
+    // each channel is queued at most once, queue can not overflow
+    const int i = (queue->head + queue->len) % TETRAPOL_ENGINE_MAX_CHANNELS;
+    queue->chs[i] = ch;
+    ++queue->len;
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static channel_t *ch_queue_pop_head(ch_queue_t *queue)
+{
+    channel_t *ch = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->len) {
+        ch = queue->chs[queue->head];
+        queue->head = (queue->head + 1) % TETRAPOL_ENGINE_MAX_CHANNELS;
+        --queue->len;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return ch;
+}
+
+static channel_t *ch_queue_pop_tail(ch_queue_t *queue)
+{
+    channel_t *ch = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->len) {
+        --queue->len;
+        const int i = (queue->head + queue->len) % TETRAPOL_ENGINE_MAX_CHANNELS;
+        ch = queue->chs[i];
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return ch;
+}
+
+static void engine_schedule(tetrapol_engine_t *engine, int worker, channel_t *ch)
+{
+    // count task before it is visible to workers, ntasks must not go below 0
+    pthread_mutex_lock(&engine->lock);
+    ++engine->ntasks;
+    ch_queue_push(&engine->workers[worker].queue, ch);
+    pthread_cond_signal(&engine->work_cond);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/// Take channel from own queue or steal one from other worker.
+static channel_t *worker_take(worker_t *worker)
+{
+    tetrapol_engine_t *engine = worker->engine;
+
+    channel_t *ch = ch_queue_pop_head(&worker->queue);
+    for (int i = 1; !ch && i < engine->nworkers; ++i) {
+        const int victim = (worker->id + i) % engine->nworkers;
+        ch = ch_queue_pop_tail(&engine->workers[victim].queue);
+    }
+
+    if (ch) {
+        pthread_mutex_lock(&engine->lock);
+        --engine->ntasks;
+        pthread_mutex_unlock(&engine->lock);
+    }
+
+    return ch;
+}
+
+static int channel_decode(channel_t *ch, int len)
+{
+    const int ret = ch->packed ?
+        tetrapol_phys_ch_recv_packed(ch->phys_ch, ch->work_buf, len) :
+        tetrapol_phys_ch_recv(ch->phys_ch, ch->work_buf, len);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return tetrapol_phys_ch_process(ch->phys_ch);
+}
+
+static void worker_run(worker_t *worker, channel_t *ch)
+{
+    tetrapol_engine_t *engine = worker->engine;
+
+    pthread_mutex_lock(&ch->lock);
+    uint8_t *buf = ch->in_buf;
+    ch->in_buf = ch->work_buf;
+    ch->work_buf = buf;
+    const int len = ch->in_len;
+    ch->in_len = 0;
+    ch->worker = worker->id;
+    const bool failed = ch->failed;
+    pthread_mutex_unlock(&ch->lock);
+
+    if (!failed && channel_decode(ch, len) < 0) {
+        LOG(ERR, "channel %d: decoding failed, channel disabled", ch->id);
+        pthread_mutex_lock(&ch->lock);
+        ch->failed = true;
+        ch->in_len = 0;
+        pthread_mutex_unlock(&ch->lock);
+    }
+
+    pthread_mutex_lock(&ch->lock);
+    const bool again = ch->in_len > 0;
+    if (!again) {
+        ch->queued = false;
+        pthread_mutex_lock(&engine->lock);
+        if (!--engine->nbusy) {
+            pthread_cond_broadcast(&engine->idle_cond);
+        }
+        pthread_mutex_unlock(&engine->lock);
+    }
+    pthread_mutex_unlock(&ch->lock);
+
+    // keep channel on the same worker while data are comming
+    if (again) {
+        engine_schedule(engine, worker->id, ch);
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *worker = arg;
+    tetrapol_engine_t *engine = worker->engine;
+
+    log_set_lvl(engine->log_lvl);
+
+    while (true) {
+        channel_t *ch = worker_take(worker);
+        if (ch) {
+            worker_run(worker, ch);
+            continue;
+        }
+
+        pthread_mutex_lock(&engine->lock);
+        while (!engine->ntasks && !engine->stop) {
+            pthread_cond_wait(&engine->work_cond, &engine->lock);
+        }
+        const bool stop = engine->stop && !engine->ntasks;
+        pthread_mutex_unlock(&engine->lock);
+
+        if (stop) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void channel_destroy(channel_t *ch)
+{
+    tetrapol_phys_ch_destroy(ch->phys_ch);
+    tetrapol_destroy(ch->tetrapol);
+    pthread_mutex_destroy(&ch->lock);
+    free(ch->in_buf);
+    free(ch->work_buf);
+    free(ch);
+}
+
+static channel_t *channel_create(const tetrapol_cfg_t *cfg, bool packed)
+{
+    channel_t *ch = calloc(1, sizeof(channel_t));
+    if (!ch) {
+        return NULL;
+    }
+
+    ch->packed = packed;
+    ch->in_buf = malloc(CH_BUF_LEN);
+    ch->work_buf = malloc(CH_BUF_LEN);
+    if (!ch->in_buf || !ch->work_buf) {
+        goto err_buf;
+    }
+
+    ch->tetrapol = tetrapol_create(cfg);
+    if (!ch->tetrapol) {
+        goto err_buf;
+    }
+
+    ch->phys_ch = tetrapol_phys_ch_create(ch->tetrapol);
+    if (!ch->phys_ch) {
+        goto err_phys_ch;
+    }
+
+    pthread_mutex_init(&ch->lock, NULL);
+
+    return ch;
+
+err_phys_ch:
+    tetrapol_destroy(ch->tetrapol);
+err_buf:
+    free(ch->in_buf);
+    free(ch->work_buf);
+    free(ch);
+
+    return NULL;
+}
+
+tetrapol_engine_t *tetrapol_engine_create(int nworkers, FILE *out)
+{
+    if (nworkers <= 0) {
+        nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+        if (nworkers <= 0) {
+            nworkers = 1;
+        }
+    }
+
+    tetrapol_engine_t *engine = calloc(1, sizeof(tetrapol_engine_t));
+    if (!engine) {
+        return NULL;
+    }
+
+    engine->workers = calloc(nworkers, sizeof(worker_t));
+    if (!engine->workers) {
+        free(engine);
+        return NULL;
+    }
+
+    engine->out = out;
+    engine->log_lvl = log_get_lvl();
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->work_cond, NULL);
+    pthread_cond_init(&engine->idle_cond, NULL);
+
+    for (int i = 0; i < nworkers; ++i) {
+        worker_t *worker = &engine->workers[i];
+        worker->id = i;
+        worker->engine = engine;
+        pthread_mutex_init(&worker->queue.lock, NULL);
+    }
+
+    // workers must see complete worker array, start them after init
+    engine->nworkers = nworkers;
+    for (int i = 0; i < nworkers; ++i) {
+        worker_t *worker = &engine->workers[i];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker)) {
+            LOG(ERR, "failed to start worker thread");
+            engine->nworkers = i;
+            tetrapol_engine_destroy(engine);
+            return NULL;
+        }
+    }
+
+    return engine;
+}
+
+void tetrapol_engine_destroy(tetrapol_engine_t *engine)
+{
+    tetrapol_engine_flush(engine);
+
+    pthread_mutex_lock(&engine->lock);
+    engine->stop = true;
+    pthread_cond_broadcast(&engine->work_cond);
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int i = 0; i < engine->nworkers; ++i) {
+        pthread_join(engine->workers[i].thread, NULL);
+    }
+    for (int i = 0; i < engine->nworkers; ++i) {
+        pthread_mutex_destroy(&engine->workers[i].queue.lock);
+    }
+
+    for (int i = 0; i < engine->nchannels; ++i) {
+        channel_destroy(engine->channels[i]);
+    }
+
+    pthread_cond_destroy(&engine->idle_cond);
+    pthread_cond_destroy(&engine->work_cond);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine->workers);
+    free(engine);
+}
+
+int tetrapol_engine_add_channel(tetrapol_engine_t *engine,
+        const tetrapol_cfg_t *cfg, bool packed)
+{
+    channel_t *ch = channel_create(cfg, packed);
+    if (!ch) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    const int ch_id = engine->nchannels;
+    if (ch_id < TETRAPOL_ENGINE_MAX_CHANNELS) {
+        ch->id = ch_id;
+        ch->worker = ch_id % engine->nworkers;
+        tetrapol_set_output(ch->tetrapol, engine->out);
+        tetrapol_set_ch_id(ch->tetrapol, ch_id);
+        engine->channels[ch_id] = ch;
+        ++engine->nchannels;
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (ch_id >= TETRAPOL_ENGINE_MAX_CHANNELS) {
+        LOG(ERR, "too many channels");
+        channel_destroy(ch);
+        return -1;
+    }
+
+    return ch_id;
+}
+
+int tetrapol_engine_push(tetrapol_engine_t *engine, int ch_id,
+        const uint8_t *buf, int len)
+{
+    pthread_mutex_lock(&engine->lock);
+    channel_t *ch = (ch_id >= 0 && ch_id < engine->nchannels) ?
+        engine->channels[ch_id] : NULL;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!ch || len < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&ch->lock);
+    if (ch->failed) {
+        pthread_mutex_unlock(&ch->lock);
+        return -1;
+    }
+
+    if (len > CH_BUF_LEN - ch->in_len) {
+        len = CH_BUF_LEN - ch->in_len;
+    }
+    memcpy(ch->in_buf + ch->in_len, buf, len);
+    ch->in_len += len;
+
+    const bool schedule = len && !ch->queued;
+    if (schedule) {
+        ch->queued = true;
+        pthread_mutex_lock(&engine->lock);
+        ++engine->nbusy;
+        pthread_mutex_unlock(&engine->lock);
+    }
+    const int worker = ch->worker;
+    pthread_mutex_unlock(&ch->lock);
+
+    if (schedule) {
+        engine_schedule(engine, worker, ch);
+    }
+
+    return len;
+}
+
+void tetrapol_engine_flush(tetrapol_engine_t *engine)
+{
+    pthread_mutex_lock(&engine->lock);
+    while (engine->nbusy) {
+        pthread_cond_wait(&engine->idle_cond, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    fflush(engine->out);
+}
@@ -14,15 +14,50 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // used when decoding firts part of frame, common to data and voice frames
 enum {
     FRAME_DATA_LEN1 = 52,
 };
 
+/// results of linear checks of frame, bit is set for each failed check
+typedef struct {
+    uint32_t common;    ///< parity syndromes of first part of frame
+    uint64_t data;      ///< checks valid for data frame only
+    uint8_t voice;      ///< checks valid for voice frame only
+} scr_checks_t;
+
+/**
+  Weights of linear checks used for SCR estimation, number of checks in
+  each group and penalty for failed check.
+  */
+enum {
+    SCR_CHK_COMMON = 26,
+    SCR_CHK_DATA = 50 + 5 + 2 + 1,
+    SCR_CHK_VOICE = 3 + 1,
+    SCR_CHK_FAIL = 5,
+};
+
 struct frame_decoder_priv_t {
     int band;
     int scr;
     int fr_type;
+    int fec;            ///< TETRAPOL_FEC_ACCURATE, _FAST or _ADAPTIVE
+    int scr_mask_band;  ///< band for which scr_mask1 and scr_chk are computed
+    /**
+      Scrambling sequence for first part of frame for all SCRs, after
+      differential decoding and deinterleaving. Bit scr % 64 of
+      scr_mask1[j][scr / 64] is j-th bit of sequence for given SCR.
+      */
+    uint64_t scr_mask1[FRAME_DATA_LEN1][2];
+    /// linear checks of scrambling sequence for each SCR
+    scr_checks_t scr_chk[128];
+    frame_decoder_stats_t stats;
 };
 
 struct frame_encoder_priv_t {
@@ -47,7 +82,7 @@ struct frame_encoder_priv_t {
     if i % 8 == 7:
       print()
   */
-static uint8_t scramb_table[127] = {
+static const uint8_t scramb_table[127] = {
     1, 1, 1, 1, 1, 1, 1, 0,
     1, 0, 1, 0, 1, 0, 0, 1,
     1, 0, 0, 1, 1, 1, 0, 1,
@@ -252,41 +287,158 @@ static void frame_deinterleave2(uint8_t *fr_data_deint, const uint8_t *fr_data,
     }
 }
 
-// http://ghsi.de/CRC/index.php?Polynom=10010
-static void mk_crc5(uint8_t *res, const uint8_t *input, int input_len)
+// generated by gen_frame_tables.py from tables above
+#include "frame_tables.h"
+
+/**
+  Descramble, differentialy decode (UHF only) and deinterleave part of frame
+  in single pass, it gives the same result as frame_descramble(),
+  frame_diff_dec() and frame_deinterleave1() or frame_deinterleave2().
+
+  @param fr_data_deint Output, deinterleaved frame.
+  @param fr_data Received frame data.
+  @param begin First deinterleaved bit, 0 or FRAME_DATA_LEN1.
+  @param end The bit after the last one, FRAME_DATA_LEN1 or FRAME_DATA_LEN.
+  */
+static void frame_deinterleave_fused(uint8_t *fr_data_deint,
+        const uint8_t *fr_data, int band, int scr, int fr_type,
+        int begin, int end)
 {
-    uint8_t inv;
-    memset(res, 0, 5);
+    const int uhf = (band == TETRAPOL_BAND_UHF);
+    const int data = (fr_type == FRAME_TYPE_DATA);
+    const uint8_t *perm = fused_perm[uhf][data];
+    const uint8_t *mask = fused_scr_mask[uhf][data][scr];
+
+    if (!uhf) {
+        for (int k = begin; k < end; ++k) {
+            fr_data_deint[k] = fr_data[perm[k]] ^ ((mask[k / 8] >> (k % 8)) & 1);
+        }
+        return;
+    }
 
-    for (int i = 0; i < input_len; ++i)
-    {
-        inv = input[i] ^ res[0];
+    const uint8_t *prev = fused_prev_UHF[data];
+    for (int k = begin; k < end; ++k) {
+        fr_data_deint[k] = fr_data[perm[k]] ^ fr_data[prev[k]] ^
+            ((mask[k / 8] >> (k % 8)) & 1);
+    }
 
-        res[0] = res[1];
-        res[1] = res[2];
-        res[2] = res[3] ^ inv;
-        res[3] = res[4];
-        res[4] = inv;
+    // the first bit is not differentialy encoded
+    const int first = fused_first_UHF[data];
+    if (first >= begin && first < end) {
+        fr_data_deint[first] ^= fr_data[0];
     }
 }
 
+/**
+  CRC tables for bits packed by pack8() (first bit in LSB), CRC register is
+  held in bit reversed form, bit 0 is the first bit of CRC.
+
+  crcN_table[b] is CRC of 8 bits of b, generated by:
+    for b in range(256):
+        c = b
+        for _ in range(8):
+            c = (c >> 1) ^ (poly if c & 1 else 0)
+  where poly is 0x14 for CRC5 and 0x06 for CRC3.
+  */
+static const uint8_t crc5_table[256] = {
+    0x00, 0x0e, 0x1c, 0x12, 0x11, 0x1f, 0x0d, 0x03, 0x0b, 0x05, 0x17, 0x19,
+    0x1a, 0x14, 0x06, 0x08, 0x16, 0x18, 0x0a, 0x04, 0x07, 0x09, 0x1b, 0x15,
+    0x1d, 0x13, 0x01, 0x0f, 0x0c, 0x02, 0x10, 0x1e, 0x05, 0x0b, 0x19, 0x17,
+    0x14, 0x1a, 0x08, 0x06, 0x0e, 0x00, 0x12, 0x1c, 0x1f, 0x11, 0x03, 0x0d,
+    0x13, 0x1d, 0x0f, 0x01, 0x02, 0x0c, 0x1e, 0x10, 0x18, 0x16, 0x04, 0x0a,
+    0x09, 0x07, 0x15, 0x1b, 0x0a, 0x04, 0x16, 0x18, 0x1b, 0x15, 0x07, 0x09,
+    0x01, 0x0f, 0x1d, 0x13, 0x10, 0x1e, 0x0c, 0x02, 0x1c, 0x12, 0x00, 0x0e,
+    0x0d, 0x03, 0x11, 0x1f, 0x17, 0x19, 0x0b, 0x05, 0x06, 0x08, 0x1a, 0x14,
+    0x0f, 0x01, 0x13, 0x1d, 0x1e, 0x10, 0x02, 0x0c, 0x04, 0x0a, 0x18, 0x16,
+    0x15, 0x1b, 0x09, 0x07, 0x19, 0x17, 0x05, 0x0b, 0x08, 0x06, 0x14, 0x1a,
+    0x12, 0x1c, 0x0e, 0x00, 0x03, 0x0d, 0x1f, 0x11, 0x14, 0x1a, 0x08, 0x06,
+    0x05, 0x0b, 0x19, 0x17, 0x1f, 0x11, 0x03, 0x0d, 0x0e, 0x00, 0x12, 0x1c,
+    0x02, 0x0c, 0x1e, 0x10, 0x13, 0x1d, 0x0f, 0x01, 0x09, 0x07, 0x15, 0x1b,
+    0x18, 0x16, 0x04, 0x0a, 0x11, 0x1f, 0x0d, 0x03, 0x00, 0x0e, 0x1c, 0x12,
+    0x1a, 0x14, 0x06, 0x08, 0x0b, 0x05, 0x17, 0x19, 0x07, 0x09, 0x1b, 0x15,
+    0x16, 0x18, 0x0a, 0x04, 0x0c, 0x02, 0x10, 0x1e, 0x1d, 0x13, 0x01, 0x0f,
+    0x1e, 0x10, 0x02, 0x0c, 0x0f, 0x01, 0x13, 0x1d, 0x15, 0x1b, 0x09, 0x07,
+    0x04, 0x0a, 0x18, 0x16, 0x08, 0x06, 0x14, 0x1a, 0x19, 0x17, 0x05, 0x0b,
+    0x03, 0x0d, 0x1f, 0x11, 0x12, 0x1c, 0x0e, 0x00, 0x1b, 0x15, 0x07, 0x09,
+    0x0a, 0x04, 0x16, 0x18, 0x10, 0x1e, 0x0c, 0x02, 0x01, 0x0f, 0x1d, 0x13,
+    0x0d, 0x03, 0x11, 0x1f, 0x1c, 0x12, 0x00, 0x0e, 0x06, 0x08, 0x1a, 0x14,
+    0x17, 0x19, 0x0b, 0x05,
+};
+
+static const uint8_t crc3_table[256] = {
+    0x00, 0x06, 0x01, 0x07, 0x02, 0x04, 0x03, 0x05, 0x04, 0x02, 0x05, 0x03,
+    0x06, 0x00, 0x07, 0x01, 0x05, 0x03, 0x04, 0x02, 0x07, 0x01, 0x06, 0x00,
+    0x01, 0x07, 0x00, 0x06, 0x03, 0x05, 0x02, 0x04, 0x07, 0x01, 0x06, 0x00,
+    0x05, 0x03, 0x04, 0x02, 0x03, 0x05, 0x02, 0x04, 0x01, 0x07, 0x00, 0x06,
+    0x02, 0x04, 0x03, 0x05, 0x00, 0x06, 0x01, 0x07, 0x06, 0x00, 0x07, 0x01,
+    0x04, 0x02, 0x05, 0x03, 0x03, 0x05, 0x02, 0x04, 0x01, 0x07, 0x00, 0x06,
+    0x07, 0x01, 0x06, 0x00, 0x05, 0x03, 0x04, 0x02, 0x06, 0x00, 0x07, 0x01,
+    0x04, 0x02, 0x05, 0x03, 0x02, 0x04, 0x03, 0x05, 0x00, 0x06, 0x01, 0x07,
+    0x04, 0x02, 0x05, 0x03, 0x06, 0x00, 0x07, 0x01, 0x00, 0x06, 0x01, 0x07,
+    0x02, 0x04, 0x03, 0x05, 0x01, 0x07, 0x00, 0x06, 0x03, 0x05, 0x02, 0x04,
+    0x05, 0x03, 0x04, 0x02, 0x07, 0x01, 0x06, 0x00, 0x06, 0x00, 0x07, 0x01,
+    0x04, 0x02, 0x05, 0x03, 0x02, 0x04, 0x03, 0x05, 0x00, 0x06, 0x01, 0x07,
+    0x03, 0x05, 0x02, 0x04, 0x01, 0x07, 0x00, 0x06, 0x07, 0x01, 0x06, 0x00,
+    0x05, 0x03, 0x04, 0x02, 0x01, 0x07, 0x00, 0x06, 0x03, 0x05, 0x02, 0x04,
+    0x05, 0x03, 0x04, 0x02, 0x07, 0x01, 0x06, 0x00, 0x04, 0x02, 0x05, 0x03,
+    0x06, 0x00, 0x07, 0x01, 0x00, 0x06, 0x01, 0x07, 0x02, 0x04, 0x03, 0x05,
+    0x05, 0x03, 0x04, 0x02, 0x07, 0x01, 0x06, 0x00, 0x01, 0x07, 0x00, 0x06,
+    0x03, 0x05, 0x02, 0x04, 0x00, 0x06, 0x01, 0x07, 0x02, 0x04, 0x03, 0x05,
+    0x04, 0x02, 0x05, 0x03, 0x06, 0x00, 0x07, 0x01, 0x02, 0x04, 0x03, 0x05,
+    0x00, 0x06, 0x01, 0x07, 0x06, 0x00, 0x07, 0x01, 0x04, 0x02, 0x05, 0x03,
+    0x07, 0x01, 0x06, 0x00, 0x05, 0x03, 0x04, 0x02, 0x03, 0x05, 0x02, 0x04,
+    0x01, 0x07, 0x00, 0x06,
+};
+
+/**
+  CRC of unpacked bits, 8 bits at time using table.
+
+  @return CRC bits packed into byte, the first bit in LSB.
+  */
+static inline uint8_t crc_bits(const uint8_t *table, uint8_t poly,
+        const uint8_t *input, int input_len)
+{
+    uint8_t crc = 0;
+
+    for ( ; input_len >= 8; input += 8, input_len -= 8) {
+        crc = table[crc ^ pack8(input)];
+    }
+    for ( ; input_len; ++input, --input_len) {
+        const uint8_t inv = (crc ^ *input) & 1;
+        crc = (crc >> 1) ^ (inv ? poly : 0);
+    }
+
+    return crc;
+}
+
+// http://ghsi.de/CRC/index.php?Polynom=10010
+static inline uint8_t crc5(const uint8_t *input, int input_len)
+{
+    return crc_bits(crc5_table, 0x14, input, input_len);
+}
+
 // http://ghsi.de/CRC/index.php?Polynom=1010
-static void mk_crc3(uint8_t *res, const uint8_t *input, int input_len)
+static inline uint8_t crc3(const uint8_t *input, int input_len)
 {
-    uint8_t inv;
-    memset(res, 0, 3);
+    return crc_bits(crc3_table, 0x06, input, input_len) ^ 0x07;
+}
 
-    for (int i = 0; i < input_len; ++i)
-    {
-        inv = input[i] ^ res[0];
+static void mk_crc5(uint8_t *res, const uint8_t *input, int input_len)
+{
+    const uint8_t crc = crc5(input, input_len);
+
+    for (int i = 0; i < 5; ++i) {
+        res[i] = (crc >> i) & 1;
+    }
+}
+
+static void mk_crc3(uint8_t *res, const uint8_t *input, int input_len)
+{
+    const uint8_t crc = crc3(input, input_len);
 
-        res[0] = res[1];
-        res[1] = res[2] ^ inv;
-        res[2] = inv;
+    for (int i = 0; i < 3; ++i) {
+        res[i] = (crc >> i) & 1;
     }
-    res[0] = res[0] ^ 1;
-    res[1] = res[1] ^ 1;
-    res[2] = res[2] ^ 1;
 }
 
 /**
@@ -370,17 +522,19 @@ static bool frame_check_crc(const uint8_t *fr_data, frame_type_t fr_type)
     }
 
     if (fr_type == FRAME_TYPE_DATA) {
-        uint8_t crc[5];
-
-        mk_crc5(crc, fr_data, 69);
-        return !memcmp(fr_data + 69, crc, 5);
+        uint8_t crc = 0;
+        for (int i = 0; i < 5; ++i) {
+            crc |= fr_data[69 + i] << i;
+        }
+        return crc5(fr_data, 69) == crc;
     }
 
     if (fr_type == FRAME_TYPE_VOICE) {
-        uint8_t crc[3];
-
-        mk_crc3(crc, fr_data, 23);
-        return !memcmp(fr_data + 23, crc, 3);
+        uint8_t crc = 0;
+        for (int i = 0; i < 3; ++i) {
+            crc |= fr_data[23 + i] << i;
+        }
+        return crc3(fr_data, 23) == crc;
     }
     return false;
 }
@@ -392,6 +546,10 @@ frame_decoder_t *frame_decoder_create(int band, int scr, int fr_type)
         return NULL;
     }
 
+    fd->fec = TETRAPOL_FEC_ACCURATE;
+    fd->scr_mask_band = -1;
+    memset(&fd->stats, 0, sizeof(fd->stats));
+
     frame_decoder_reset(fd, band, scr, fr_type);
 
     return fd;
@@ -414,6 +572,16 @@ void frame_decoder_set_scr(frame_decoder_t *fd, int scr)
     fd->scr = scr;
 }
 
+void frame_decoder_set_fec(frame_decoder_t *fd, int fec)
+{
+    fd->fec = fec;
+}
+
+void frame_decoder_get_stats(frame_decoder_t *fd, frame_decoder_stats_t *stats)
+{
+    memcpy(stats, &fd->stats, sizeof(*stats));
+}
+
 /**
   Fix some errors in frame. This routine is pretty naive, suboptimal and does
   not use all possible potential of error correction.
@@ -512,47 +680,433 @@ int frame_fix_errs(uint8_t *fr_data, uint8_t *fr_errs, int len, int *bits_fixed)
     return nerrs;
 }
 
+// encoder output (2 bits) for state transition, index is (state << 1) | bit
+static const uint8_t viterbi_table[8] = { 0, 3, 1, 2, 3, 0, 2, 1, };
+
+enum {
+    VITERBI_MAX_LEN = 50,   ///< the longest convolutional block in frame
+    VITERBI_INF = 0x80,     ///< metric of state not reachable yet
+};
+
+/// 16 bit lane for each of 4 assumed start (= end) states
+#define VITERBI_LANES 0x0001000100010001ULL
+#define VITERBI_GUARD 0x8000800080008000ULL
+
+/**
+  Branch metric (Hamming distance of received bit pair and encoder output),
+  index is [received bit pair][(state << 1) | bit].
+
+  for r in range(4):
+      print([bin(r ^ e).count('1') for e in (0, 3, 1, 2, 3, 0, 2, 1)])
+  */
+static const uint8_t viterbi_bm[4][8] = {
+    { 0, 2, 1, 1, 2, 0, 1, 1, },
+    { 1, 1, 0, 2, 1, 1, 2, 0, },
+    { 1, 1, 2, 0, 1, 1, 0, 2, },
+    { 2, 0, 1, 1, 0, 2, 1, 1, },
+};
+
+/**
+  Tail-biting Viterbi decoder, the code is decoded with every start state
+  and the best path which ends in its start state is used.
+
+  All 4 start states are evaluated in single pass, each in own 16 bit lane
+  of path metrics word, one word for each encoder state. Survivor decisions
+  are packed into 16 bits per step, bit (4*state + start). Ties are broken
+  the same way as by exhaustive search, lower predecessor state and lower
+  start state wins.
+
+  @param dec Output, decoded bits.
+  @param in_bits Received bits, 2*size bits, one bit per byte.
+  @param size Number of decoded bits, at most VITERBI_MAX_LEN.
+
+  @return Path metric (number of fixed bits) of the best path.
+  */
+static inline int frame_viterbi_(uint8_t *dec, const uint8_t *in_bits, int size)
+{
+    uint16_t back[VITERBI_MAX_LEN];
+    uint64_t tab[4];
+
+    for (int u = 0; u < 4; ++u) {
+        tab[u] = (VITERBI_INF * VITERBI_LANES) & ~(0xffffULL << (16 * u));
+    }
+
+    for (int p = size - 1; p >= 0; --p) {
+        const uint8_t *bm = viterbi_bm[in_bits[2*p] | (in_bits[2*p + 1] << 1)];
+        uint64_t tab2[4];
+        uint16_t decisions = 0;
+        for (int v = 0; v < 4; ++v) {
+            // state v is reached from states u1 and u2 by encoding bit v & 1
+            const int u1 = v >> 1;
+            const int u2 = u1 | 2;
+            const uint64_t r1 = tab[u1] + bm[(u1 << 1) | (v & 1)] * VITERBI_LANES;
+            const uint64_t r2 = tab[u2] + bm[(u2 << 1) | (v & 1)] * VITERBI_LANES;
+            // guard bit is cleared in lanes where r2 < r1
+            const uint64_t take2 = ~((r2 | VITERBI_GUARD) - r1) & VITERBI_GUARD;
+            const uint64_t mask = (take2 >> 15) * 0xffff;
+            tab2[v] = (r1 & ~mask) | (r2 & mask);
+            // move lane bits 0, 16, 32, 48 into bits 45..48
+            decisions |= ((((take2 >> 15) * 0x0000200040008001ULL) >> 45) & 0xf) << (4 * v);
+        }
+        back[p] = decisions;
+        memcpy(tab, tab2, sizeof(tab));
+    }
+
+    int s = 0;
+    int mi = tab[0] & 0xffff;
+    for (int i = 1; i < 4; ++i) {
+        const int m = (tab[i] >> (16 * i)) & 0xffff;
+        if (m < mi) {
+            mi = m;
+            s = i;
+        }
+    }
+
+    int z = s;
+    for (int p = 0; p < size; ++p) {
+        dec[(size + p - 2) % size] = z & 1;
+        z = (z >> 1) | (((back[p] >> (4 * z + s)) & 1) << 1);
+    }
+
+    return mi;
+}
+
 /**
   Fix errors in frame, using the Viterbi algorithm.
   */
-int frame_viterbi(uint8_t *dec,const uint8_t *in_bits,int size)
-{
-  static unsigned char viterbi_table[8]={0,3,1,2,3,0,2,1};
-  int mi=999;
-  for(int s=0;s<4;s++) {
-    int back[size][4];
-    int tab[4],tab2[4];
-    memset(back,-1,sizeof(back));
-    for(int i=0;i<4;i++)
-      tab[i]=9999;
-    tab[s]=0;
-    for(int p=size-1;p>=0;p--) {
-      for(int i=0;i<4;i++) tab2[i]=9999;
-      for(int u=0;u<4;u++) {
-        for(int x=0;x<2;x++) {
-          int v=(u<<1)|x;
-          int e=viterbi_table[v];           //auto e=(encode64(v)>>4)&3;
-          int r=tab[u];
-          if(in_bits[2*p]!=(e&1)) r++;
-          if(in_bits[2*p+1]!=((e>>1)&1)) r++;
-          if(tab2[v%4]>r) {
-            tab2[v%4]=r;
-            back[p][v%4]=u;
-          }
-        }
-      }
-      memcpy(tab,tab2,sizeof(tab));
-    }
-    if(mi>tab[s]) {
-      mi=tab[s];
-      int z=s;
-      for(int p=0;p<size;p++) {
-        dec[(size+p-2)%size]=(z&1);
-        z=back[p][z];
-      }
-    }
-  }
-  return mi;
+int frame_viterbi(uint8_t *dec, const uint8_t *in_bits, int size)
+{
+    return frame_viterbi_(dec, in_bits, size);
+}
+
+/// block lengths are compile time constants for both decoder calls
+static int frame_viterbi26(uint8_t *dec, const uint8_t *in_bits)
+{
+    return frame_viterbi_(dec, in_bits, 26);
+}
+
+static int frame_viterbi50(uint8_t *dec, const uint8_t *in_bits)
+{
+    return frame_viterbi_(dec, in_bits, 50);
+}
+
+/*
+  Vector operations for frame_viterbi_batch(), byte lanes, one lane for
+  each pair (frame, start state), lane number is 4*frame + start state.
+  */
+#if defined(__AVX2__)
+#define VITERBI_BATCH 8
+typedef __m256i vit_vec_t;
+#define vit_set1_32(x)  _mm256_set1_epi32(x)
+#define vit_load(p)     _mm256_loadu_si256((const __m256i *)(p))
+#define vit_add(a, b)   _mm256_add_epi8(a, b)
+#define vit_sub(a, b)   _mm256_sub_epi8(a, b)
+#define vit_xor(a, b)   _mm256_xor_si256(a, b)
+#define vit_min(a, b)   _mm256_min_epu8(a, b)
+#define vit_eq_mask(a, b) \
+    ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)))
+#define vit_store(p, a) _mm256_storeu_si256((__m256i *)(p), a)
+#elif defined(__SSE2__)
+#define VITERBI_BATCH 4
+typedef __m128i vit_vec_t;
+#define vit_set1_32(x)  _mm_set1_epi32(x)
+#define vit_load(p)     _mm_loadu_si128((const __m128i *)(p))
+#define vit_add(a, b)   _mm_add_epi8(a, b)
+#define vit_sub(a, b)   _mm_sub_epi8(a, b)
+#define vit_xor(a, b)   _mm_xor_si128(a, b)
+#define vit_min(a, b)   _mm_min_epu8(a, b)
+#define vit_eq_mask(a, b) \
+    ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)))
+#define vit_store(p, a) _mm_storeu_si128((__m128i *)(p), a)
+#else
+#define VITERBI_BATCH 1
+#endif
+
+#if VITERBI_BATCH > 1
+/**
+  The same as frame_viterbi_() for up to VITERBI_BATCH blocks at once.
+  Each block occupies 4 byte lanes (one for each start state) of vector.
+
+  @param dec Output, decoded bits for each block.
+  @param in_bits Received bits for each block.
+  @param metric Output, path metric for each block.
+  @param n Number of blocks, at most VITERBI_BATCH.
+  @param size Number of decoded bits, at most VITERBI_MAX_LEN.
+  */
+static inline void frame_viterbi_batch(uint8_t **dec,
+        const uint8_t **in_bits, int *metric, int n, int size)
+{
+    uint32_t back[VITERBI_MAX_LEN][4];
+    vit_vec_t tab[4];
+
+    if (n <= 0) {
+        return;
+    }
+
+    // metric 0 for the start state, INF for others
+    for (int u = 0; u < 4; ++u) {
+        tab[u] = vit_set1_32(VITERBI_INF * 0x01010101u & ~(0xffu << (8 * u)));
+    }
+
+    const vit_vec_t one = vit_set1_32(0x01010101);
+    const vit_vec_t two = vit_set1_32(0x02020202);
+    for (int p = size - 1; p >= 0; --p) {
+        // received bits, the same for all start states of block
+        uint32_t in0[VITERBI_BATCH], in1[VITERBI_BATCH];
+        for (int f = 0; f < VITERBI_BATCH; ++f) {
+            const int i = (f < n) ? f : 0;
+            in0[f] = in_bits[i][2*p] * 0x01010101;
+            in1[f] = in_bits[i][2*p + 1] * 0x01010101;
+        }
+        const vit_vec_t b0 = vit_load(in0);
+        const vit_vec_t b1 = vit_load(in1);
+
+        // branch metric for each encoder output
+        vit_vec_t bm[4];
+        bm[0] = vit_add(b0, b1);
+        bm[1] = vit_add(vit_xor(b0, one), b1);
+        bm[2] = vit_sub(two, bm[1]);
+        bm[3] = vit_sub(two, bm[0]);
+
+        vit_vec_t tab2[4];
+        for (int v = 0; v < 4; ++v) {
+            const int u1 = v >> 1;
+            const int u2 = u1 | 2;
+            const vit_vec_t r1 = vit_add(tab[u1], bm[viterbi_table[(u1 << 1) | (v & 1)]]);
+            const vit_vec_t r2 = vit_add(tab[u2], bm[viterbi_table[(u2 << 1) | (v & 1)]]);
+            tab2[v] = vit_min(r1, r2);
+            // u2 is survivor only when strictly better
+            back[p][v] = ~vit_eq_mask(tab2[v], r1);
+        }
+        memcpy(tab, tab2, sizeof(tab));
+    }
+
+    uint8_t tab_[4][4 * VITERBI_BATCH];
+    for (int u = 0; u < 4; ++u) {
+        vit_store(tab_[u], tab[u]);
+    }
+
+    for (int f = 0; f < n; ++f) {
+        int s = 0;
+        for (int i = 1; i < 4; ++i) {
+            if (tab_[i][4*f + i] < tab_[s][4*f + s]) {
+                s = i;
+            }
+        }
+        metric[f] = tab_[s][4*f + s];
+
+        const int lane = 4*f + s;
+        int z = s;
+        for (int p = 0; p < size; ++p) {
+            dec[f][(size + p - 2) % size] = z & 1;
+            z = (z >> 1) | (((back[p][z] >> lane) & 1) << 1);
+        }
+    }
+}
+#else
+static inline void frame_viterbi_batch(uint8_t **dec,
+        const uint8_t **in_bits, int *metric, int n, int size)
+{
+    for (int f = 0; f < n; ++f) {
+        metric[f] = frame_viterbi_(dec[f], in_bits[f], size);
+    }
+}
+#endif
+
+/**
+  Lower bound of number of bit errors in first part of frame. Single bit
+  error makes syndromes in at most 3 consecutive checks (cyclic), so this is
+  the minimal number of 3 checks wide windows which cover all syndromes.
+
+  Some optimal cover leaves a gap before some run of syndromes, covering
+  greedily from start of each run gives the optimum.
+
+  @param syn Syndromes, bit i is set when i-th check fails.
+  */
+static int frame_errs_min1(uint32_t syn)
+{
+    const uint32_t mask = (1UL << 26) - 1;
+    uint32_t starts = syn & ~((syn << 1) | (syn >> 25)) & mask;
+
+    if (!starts) {
+        // no syndromes or all checks failed
+        return syn ? (26 + 2) / 3 : 0;
+    }
+
+    int nerrs_min = INT_MAX;
+    while (starts) {
+        const int start = __builtin_ctz(starts);
+        starts &= starts - 1;
+
+        uint32_t s = ((syn >> start) | (syn << (26 - start))) & mask;
+        int nerrs = 0;
+        for ( ; s; ++nerrs) {
+            s &= ~(7UL << __builtin_ctz(s));
+        }
+        if (nerrs < nerrs_min) {
+            nerrs_min = nerrs;
+        }
+    }
+
+    return nerrs_min;
+}
+
+/**
+  Screen first part of frame before Viterbi decoding. Frame with 6 or more
+  bits fixed is broken (see frame_decode_part1_done()), Viterbi decoder
+  fixes at least frame_errs_min1() bits, so such frames are rejected
+  without decoding and the result is the same.
+
+  Set fr->syndromes to number of syndromes in first part, first part
+  solution is stored into frame and syndromes into fr_errs.
+
+  @return true when frame is rejected (marked as broken)
+  */
+static bool frame_screen1(frame_decoder_t *fd, frame_t *fr,
+        uint8_t *fr_errs, const uint8_t *fr_data_deint)
+{
+    ++fd->stats.frames;
+    fr->syndromes = frame_decode1(fr->blob_, fr_errs, fr_data_deint, fd->fr_type);
+    if (fr->syndromes < 6) {
+        return false;
+    }
+
+    uint32_t syn = 0;
+    for (int i = 0; i < 26; ++i) {
+        syn |= (uint32_t)fr_errs[i] << i;
+    }
+    if (frame_errs_min1(syn) < 6) {
+        return false;
+    }
+
+    ++fd->stats.screened;
+    fr->broken = 1;
+    fr->fr_type = (fd->fr_type == FRAME_TYPE_AUTO) ? (frame_type_t)fr->d : fd->fr_type;
+    memset(fr->blob_ + 26, 0, 100);
+
+    return true;
+}
+
+/**
+  Use result of first part decoding, get frame type and deinterleave second
+  part of frame.
+
+  @param f1 Number of bits fixed in first part.
+
+  @return true when second part is convolutionaly coded and must be decoded
+  */
+static bool frame_decode_part1_done(frame_decoder_t *fd, frame_t *fr, int f1,
+        uint8_t *fr_data_deint, const uint8_t *fr_data)
+{
+    fr->bits_fixed += f1;
+    // if too many bits are fixed, we suppose that the packet is broken
+    if (f1 >= 6) {
+        fr->broken = 1;
+    }
+
+    fr->fr_type = (fd->fr_type == FRAME_TYPE_AUTO) ? (frame_type_t)fr->d : fd->fr_type;
+
+    frame_deinterleave_fused(fr_data_deint, fr_data, fd->band, fd->scr,
+            fr->fr_type, FRAME_DATA_LEN1, FRAME_DATA_LEN);
+    if (fr->broken == 0 && fr->fr_type != FRAME_TYPE_VOICE) {
+        uint8_t sol[50], errs[50];
+        fr->syndromes += decode_data_frame(sol, errs, fr_data_deint + 52, 50);
+        return true;
+    }
+
+    memcpy(fr->blob_ + 26, fr_data_deint + 52, 100);
+    return false;
+}
+
+static void frame_decode_part2_done(frame_t *fr, int f2)
+{
+    if (f2 >= 11) {
+        fr->broken = 1;
+    }
+    fr->bits_fixed += f2;
+}
+
+static void frame_decode_done(frame_t *fr)
+{
+    fr->data_packed = pack64(fr->data.data + 2);
+}
+
+/**
+  Decode frame by syndrome decoder, errors are fixed by frame_fix_errs().
+  First part of frame must be already decoded by frame_screen1().
+
+  @return true when frame is decoded without errors and CRC matches
+  */
+static bool frame_decode_fast(frame_decoder_t *fd, frame_t *fr,
+        uint8_t *fr_errs, uint8_t *fr_data_deint, const uint8_t *fr_data)
+{
+    fr->broken = fr->syndromes;
+    if (fr->broken) {
+        fr->broken -= frame_fix_errs(fr->blob_, fr_errs, 26, &fr->bits_fixed);
+    }
+
+    fr->fr_type = (fd->fr_type == FRAME_TYPE_AUTO) ? (frame_type_t)fr->d : fd->fr_type;
+
+    frame_deinterleave_fused(fr_data_deint, fr_data, fd->band, fd->scr,
+            fr->fr_type, FRAME_DATA_LEN1, FRAME_DATA_LEN);
+    if (fr->broken > 0) {
+        memcpy(fr->blob_ + 26, fr_data_deint + 52, 100);
+        return false;
+    }
+
+    fr->broken = frame_decode2(fr->blob_, fr_errs, fr_data_deint, fr->fr_type);
+    fr->syndromes += fr->broken;
+    if (fr->broken) {
+        fr->broken -= frame_fix_errs(fr->blob_ + 26, fr_errs + 26, 50, &fr->bits_fixed);
+        if (fr->broken > 0) {
+            return false;
+        }
+    }
+
+    fr->broken = frame_check_crc(fr->blob_, fr->fr_type) ? 0 : -1;
+
+    return !fr->broken;
+}
+
+/**
+  Try syndrome decoder when enabled.
+
+  @return true when frame is done, false when it should be decoded by Viterbi
+  */
+static bool frame_decode_fec_fast(frame_decoder_t *fd, frame_t *fr,
+        uint8_t *fr_errs, uint8_t *fr_data_deint, const uint8_t *fr_data)
+{
+    if (fd->fec == TETRAPOL_FEC_ACCURATE) {
+        return false;
+    }
+
+    const int syndromes = fr->syndromes;
+    ++fd->stats.fast;
+    if (frame_decode_fast(fd, fr, fr_errs, fr_data_deint, fr_data)) {
+        ++fd->stats.fast_ok;
+        return true;
+    }
+    if (fd->fec == TETRAPOL_FEC_FAST) {
+        return true;
+    }
+
+    // adaptive, start again with Viterbi decoder
+    fr->broken = 0;
+    fr->bits_fixed = 0;
+    fr->syndromes = syndromes;
+
+    return false;
+}
+
+static void frame_decode_viterbi_done(frame_decoder_t *fd, frame_t *fr)
+{
+    ++fd->stats.viterbi;
+    if (!fr->broken) {
+        fr->broken = frame_check_crc(fr->blob_, fr->fr_type) ? 0 : -1;
+    }
+    if (!fr->broken) {
+        ++fd->stats.viterbi_ok;
+    }
 }
 
 void frame_decoder_decode(frame_decoder_t *fd, frame_t *fr, const uint8_t *fr_data)
@@ -566,69 +1120,313 @@ void frame_decoder_decode(frame_decoder_t *fd, frame_t *fr, const uint8_t *fr_da
     }
 
     fr->bits_fixed = 0;
+    fr->broken = 0;
 
-    uint8_t fr_data_tmp[FRAME_DATA_LEN];
-
-    frame_descramble(fr_data_tmp, fr_data, fd->scr);
-    if (fd->band == TETRAPOL_BAND_UHF) {
-        frame_diff_dec(fr_data_tmp);
+    uint8_t fr_data_deint[FRAME_DATA_LEN];
+    uint8_t fr_errs[26 + 50];
+    frame_deinterleave_fused(fr_data_deint, fr_data, fd->band, fd->scr,
+            FRAME_TYPE_DATA, 0, FRAME_DATA_LEN1);
+    if (!frame_screen1(fd, fr, fr_errs, fr_data_deint) &&
+            !frame_decode_fec_fast(fd, fr, fr_errs, fr_data_deint, fr_data)) {
+        const int f1 = frame_viterbi26(fr->blob_, fr_data_deint);
+        if (frame_decode_part1_done(fd, fr, f1, fr_data_deint, fr_data)) {
+            const int f2 = frame_viterbi50(fr->blob_ + 26, fr_data_deint + 52);
+            frame_decode_part2_done(fr, f2);
+        }
+        frame_decode_viterbi_done(fd, fr);
     }
 
-    uint8_t fr_data_deint[FRAME_DATA_LEN];
-#if 0
-    uint8_t fr_errs[FRAME_DATA_LEN];
+    frame_decode_done(fr);
+}
 
-    frame_deinterleave1(fr_data_deint, fr_data_tmp, fd->band);
-    fr->broken = frame_decode1(fr->blob_, fr_errs, fr_data_deint, fd->fr_type);
-    fr->syndromes = fr->broken;
+void frame_decoder_decode_batch(frame_decoder_t *fd, frame_t *frs,
+        const uint8_t *const *fr_data, int n)
+{
+    if (fd->fr_type != FRAME_TYPE_AUTO &&
+            fd->fr_type != FRAME_TYPE_VOICE &&
+            fd->fr_type  != FRAME_TYPE_DATA)
+    {
+        for (int i = 0; i < n; ++i) {
+            frs[i].broken = -2;
+        }
+        return;
+    }
 
-    fr->fr_type = (fd->fr_type == FRAME_TYPE_AUTO) ? fr->d : fd->fr_type;
+    for (int i0 = 0; i0 < n; i0 += VITERBI_BATCH) {
+        const int m = (n - i0 < VITERBI_BATCH) ? n - i0 : VITERBI_BATCH;
+        frame_t *fr = &frs[i0];
+
+        uint8_t fr_data_deint[VITERBI_BATCH][FRAME_DATA_LEN];
+        uint8_t *dec[VITERBI_BATCH];
+        const uint8_t *in[VITERBI_BATCH];
+        int fixed[VITERBI_BATCH];
+
+        // frames rejected by screen or decoded by syndrome decoder are not
+        // decoded by Viterbi decoder
+        int idx[VITERBI_BATCH];
+        int m1 = 0;
+        for (int i = 0; i < m; ++i) {
+            uint8_t fr_errs[26 + 50];
+            fr[i].bits_fixed = 0;
+            fr[i].broken = 0;
+            frame_deinterleave_fused(fr_data_deint[i], fr_data[i0 + i],
+                    fd->band, fd->scr, FRAME_TYPE_DATA, 0, FRAME_DATA_LEN1);
+            if (!frame_screen1(fd, &fr[i], fr_errs, fr_data_deint[i]) &&
+                    !frame_decode_fec_fast(fd, &fr[i], fr_errs,
+                        fr_data_deint[i], fr_data[i0 + i])) {
+                idx[m1] = i;
+                dec[m1] = fr[i].blob_;
+                in[m1] = fr_data_deint[i];
+                ++m1;
+            }
+        }
+        frame_viterbi_batch(dec, in, fixed, m1, 26);
+
+        // only frames which survived first part continue
+        int idx2[VITERBI_BATCH];
+        int m2 = 0;
+        for (int j = 0; j < m1; ++j) {
+            const int i = idx[j];
+            if (frame_decode_part1_done(fd, &fr[i], fixed[j],
+                        fr_data_deint[i], fr_data[i0 + i])) {
+                idx2[m2] = i;
+                dec[m2] = fr[i].blob_ + 26;
+                in[m2] = fr_data_deint[i] + 52;
+                ++m2;
+            }
+        }
+        frame_viterbi_batch(dec, in, fixed, m2, 50);
+        for (int j = 0; j < m2; ++j) {
+            frame_decode_part2_done(&fr[idx2[j]], fixed[j]);
+        }
 
-    if (fr->broken) {
-        fr->broken -= frame_fix_errs(fr->blob_, fr_errs, 26, &fr->bits_fixed);
-        if (fr->broken > 0) {
-            return;
+        for (int j = 0; j < m1; ++j) {
+            frame_decode_viterbi_done(fd, &fr[idx[j]]);
+        }
+        for (int i = 0; i < m; ++i) {
+            frame_decode_done(&fr[i]);
         }
     }
+}
 
-    frame_deinterleave2(fr_data_deint, fr_data_tmp, fd->band, fr->fr_type);
-    fr->broken = frame_decode2(fr->blob_, fr_errs, fr_data_deint, fr->fr_type);
-    fr->syndromes += fr->broken;
+/**
+  Bit-sliced saturating add, r = min(a + b, 7). The 3 bit metric a is held in
+  a[0..2], the 2 bit branch metric in b0, b1, bit k of each word belongs
+  to k-th lane.
+  */
+static inline void bs_add_sat(uint64_t *r, const uint64_t *a,
+        uint64_t b0, uint64_t b1)
+{
+    const uint64_t c0 = a[0] & b0;
+    const uint64_t c1 = (a[1] & b1) | (c0 & (a[1] ^ b1));
+    const uint64_t c2 = a[2] & c1;
+    r[0] = (a[0] ^ b0) | c2;
+    r[1] = (a[1] ^ b1 ^ c0) | c2;
+    r[2] = (a[2] ^ c1) | c2;
+}
 
-    if (fr->fr_type == FRAME_TYPE_VOICE) {
-        fr->broken = frame_check_crc(fr->blob_, fr->fr_type) ? 0 : -1;
-        return;
+/// bit-sliced minimum of two 3 bit numbers
+static inline void bs_min(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const uint64_t lt =
+        (~a[2] & b[2]) | (~(a[2] ^ b[2]) & (
+            (~a[1] & b[1]) | (~(a[1] ^ b[1]) & ~a[0] & b[0])));
+    for (int i = 0; i < 3; ++i) {
+        r[i] = (a[i] & lt) | (b[i] & ~lt);
     }
+}
 
-    if (fr->broken) {
-        fr->broken -= frame_fix_errs(fr->blob_ + 26, fr_errs + 26, 50, &fr->bits_fixed);
-        if (fr->broken > 0) {
-            return;
+/**
+  The same as frame_viterbi() but computes only the path metric, for 64
+  frames at once. Metrics are bit-sliced and saturated at 7, which is
+  enough to decide if frame_viterbi() would return value less than limit.
+
+  @param in_bits Input bits, bit k of in_bits[j] is j-th bit of k-th frame.
+  @param size Number of decoded bits.
+  @param limit Metric limit, must be less than 7.
+
+  @return mask of frames with path metric less than limit
+  */
+static uint64_t frame_viterbi_metric64(const uint64_t *in_bits, int size,
+        int limit)
+{
+    uint64_t res = 0;
+    for (int s = 0; s < 4; ++s) {
+        uint64_t tab[4][3];
+        for (int i = 0; i < 4; ++i) {
+            tab[i][0] = tab[i][1] = tab[i][2] = (i == s) ? 0 : ~0ULL;
+        }
+        for (int p = size - 1; p >= 0; --p) {
+            uint64_t tab2[4][3];
+            for (int v = 0; v < 4; ++v) {
+                // two transitions lead into state v
+                uint64_t m[2][3];
+                for (int k = 0; k < 2; ++k) {
+                    const int u = (v >> 1) | (k << 1);
+                    const int e = viterbi_table[(u << 1) | (v & 1)];
+                    const uint64_t d0 = in_bits[2*p] ^ -(uint64_t)(e & 1);
+                    const uint64_t d1 = in_bits[2*p + 1] ^ -(uint64_t)(e >> 1);
+                    bs_add_sat(m[k], tab[u], d0 ^ d1, d0 & d1);
+                }
+                bs_min(tab2[v], m[0], m[1]);
+            }
+            memcpy(tab, tab2, sizeof(tab));
+        }
+        for (int x = 0; x < limit; ++x) {
+            res |= ((x & 1) ? tab[s][0] : ~tab[s][0]) &
+                ((x & 2) ? tab[s][1] : ~tab[s][1]) &
+                ((x & 4) ? tab[s][2] : ~tab[s][2]);
         }
     }
 
-#else
-    fr->broken=0;
-    frame_deinterleave1(fr_data_deint, fr_data_tmp, fd->band);
-    int f1=frame_viterbi(fr->blob_,fr_data_deint,26);
-    fr->bits_fixed+=f1;
-    if(f1>=6) fr->broken=1; //if too many bits are fixed, we suppose that the packet is broken
+    return res;
+}
 
-    fr->fr_type = (fd->fr_type == FRAME_TYPE_AUTO) ? (frame_type_t)fr->d : fd->fr_type;
+/**
+  Do the same checks as decoder does (parity syndromes, frame type bit,
+  zero padding and CRC) but without error correction. All checks are
+  linear (or affine) functions of deinterleaved frame.
+  */
+static void mk_scr_checks(scr_checks_t *chk, const uint8_t *fr_data_deint)
+{
+    uint8_t sol[26 + 50], errs[26 + 50];
+    decode_data_frame(sol, errs, fr_data_deint, 26);
+    decode_data_frame(sol + 26, errs + 26, fr_data_deint + 2*26, 50);
 
-    frame_deinterleave2(fr_data_deint, fr_data_tmp, fd->band, fr->fr_type);
-    if (fr->broken==0 && fr->fr_type != FRAME_TYPE_VOICE) {
-      int f2=frame_viterbi(fr->blob_+26,fr_data_deint+52,50);
-      if(f2>=11) fr->broken=1;
-      fr->bits_fixed+=f2;
+    chk->common = 0;
+    for (int i = 0; i < 26; ++i) {
+        chk->common |= (uint32_t)errs[i] << i;
     }
-    else {
-      memcpy(fr->blob_+26,fr_data_deint+52,100);
+
+    uint8_t crc = crc5(sol, 69);
+    chk->data = 0;
+    for (int i = 0; i < 50; ++i) {
+        chk->data |= (uint64_t)errs[26 + i] << i;
     }
-    if(fr->broken) return;
-#endif
+    for (int i = 0; i < 5; ++i) {
+        chk->data |= (uint64_t)(((crc >> i) & 1) ^ sol[69 + i]) << (50 + i);
+    }
+    chk->data |= (uint64_t)sol[74] << 55;
+    chk->data |= (uint64_t)sol[75] << 56;
+    chk->data |= (uint64_t)(sol[0] ^ FRAME_TYPE_DATA) << 57;
+
+    crc = crc3(sol, 23);
+    chk->voice = 0;
+    for (int i = 0; i < 3; ++i) {
+        chk->voice |= (((crc >> i) & 1) ^ sol[23 + i]) << i;
+    }
+    chk->voice |= (sol[0] ^ FRAME_TYPE_VOICE) << 3;
+}
 
-    fr->broken = frame_check_crc(fr->blob_, fr->fr_type) ? 0 : -1;
+/**
+  Scrambling, differential decoding and deinterleaving are all linear,
+  the deinterleaved frame for any SCR is the same deinterleaved frame
+  XORed with deinterleaved scrambling sequence. Result of linear checks
+  can be split in the same way.
+  */
+static void frame_decoder_mk_scr_mask(frame_decoder_t *fd)
+{
+    const uint8_t zero[FRAME_DATA_LEN] = { 0 };
+
+    scr_checks_t chk0;
+    mk_scr_checks(&chk0, zero);
+
+    memset(fd->scr_mask1, 0, sizeof(fd->scr_mask1));
+    for (int scr = 0; scr < 128; ++scr) {
+        uint8_t fr_data_tmp[FRAME_DATA_LEN];
+        frame_descramble(fr_data_tmp, zero, scr);
+        if (fd->band == TETRAPOL_BAND_UHF) {
+            frame_diff_dec(fr_data_tmp);
+        }
+
+        uint8_t fr_data_deint[FRAME_DATA_LEN];
+        frame_deinterleave1(fr_data_deint, fr_data_tmp, fd->band);
+        frame_deinterleave2(fr_data_deint, fr_data_tmp, fd->band,
+                FRAME_TYPE_DATA);
+        for (int j = 0; j < FRAME_DATA_LEN1; ++j) {
+            fd->scr_mask1[j][scr / 64] |=
+                (uint64_t)fr_data_deint[j] << (scr % 64);
+        }
+
+        // remove constant part of affine checks
+        scr_checks_t *chk = &fd->scr_chk[scr];
+        mk_scr_checks(chk, fr_data_deint);
+        chk->common ^= chk0.common;
+        chk->data ^= chk0.data;
+        chk->voice ^= chk0.voice;
+    }
+    fd->scr_mask_band = fd->band;
+}
+
+void frame_decoder_scr_score(frame_decoder_t *fd, int *scr_score,
+        const uint8_t *fr_data)
+{
+    if (fd->scr_mask_band != fd->band) {
+        frame_decoder_mk_scr_mask(fd);
+    }
+
+    // SCR 0 - no descrambling
+    uint8_t fr_data_deint[FRAME_DATA_LEN];
+    frame_deinterleave_fused(fr_data_deint, fr_data, fd->band, 0,
+            FRAME_TYPE_DATA, 0, FRAME_DATA_LEN);
+
+    scr_checks_t chk;
+    mk_scr_checks(&chk, fr_data_deint);
+
+    for (int scr = 0; scr < 128; ++scr) {
+        const scr_checks_t *scr_chk = &fd->scr_chk[scr];
+        const int common = SCR_CHK_COMMON - SCR_CHK_FAIL *
+            __builtin_popcount(chk.common ^ scr_chk->common);
+        const int data = SCR_CHK_DATA - SCR_CHK_FAIL *
+            __builtin_popcountll(chk.data ^ scr_chk->data);
+        const int voice = SCR_CHK_VOICE - SCR_CHK_FAIL *
+            __builtin_popcount(chk.voice ^ scr_chk->voice);
+        scr_score[scr] = common + ((data > voice) ? data : voice);
+    }
+}
+
+void frame_decoder_check_scr(frame_decoder_t *fd, uint64_t *scr_ok,
+        const uint64_t *scr_mask, const uint8_t *fr_data)
+{
+    if (fd->scr_mask_band != fd->band) {
+        frame_decoder_mk_scr_mask(fd);
+    }
+
+    // SCR 0 - no descrambling
+    uint8_t fr_data_deint[FRAME_DATA_LEN];
+    frame_deinterleave_fused(fr_data_deint, fr_data, fd->band, 0,
+            FRAME_TYPE_DATA, 0, FRAME_DATA_LEN1);
+
+    const int scr = fd->scr;
+    const int fr_type = fd->fr_type;
+    fd->fr_type = FRAME_TYPE_AUTO;
+    for (int w = 0; w < 2; ++w) {
+        scr_ok[w] = 0;
+        if (!scr_mask[w]) {
+            continue;
+        }
+
+        // first part of frame is broken when more than 5 bits are fixed,
+        // the most of wrong SCRs are refused here
+        uint64_t in_bits[FRAME_DATA_LEN1];
+        for (int j = 0; j < FRAME_DATA_LEN1; ++j) {
+            in_bits[j] = fd->scr_mask1[j][w] ^ -(uint64_t)fr_data_deint[j];
+        }
+        uint64_t cand = scr_mask[w] &
+            frame_viterbi_metric64(in_bits, FRAME_DATA_LEN1 / 2, 6);
+
+        // full decoding for the remaining ones
+        for ( ; cand; cand &= cand - 1) {
+            frame_t fr;
+            fd->scr = 64 * w + __builtin_ctzll(cand);
+            frame_decoder_decode(fd, &fr, fr_data);
+            if (!fr.broken) {
+                scr_ok[w] |= cand & -cand;
+            }
+        }
+    }
+    fd->scr = scr;
+    fd->fr_type = fr_type;
 }
 
 frame_encoder_t *frame_encoder_create(int band, int scr, int dir)
@@ -685,7 +1483,9 @@ static void frame_encode1(uint8_t *out_bytes, const uint8_t *in_bits)
     // drop one bit copy from data_1
     data_1 &= 0x5555555555555555LL;
 
-    *(uint64_t *)out_bytes = htole64(data ^ data_1 ^ data_2);
+    // shifted copies overflow behind 2*26 bits, second part is stored there
+    *(uint64_t *)out_bytes = htole64((data ^ data_1 ^ data_2) &
+            ((1ULL << (2*26)) - 1));
 }
 
 /**
@@ -763,7 +1563,7 @@ for i in range(8):
             print('\n    ', end='')
     print(' },')
   */
-static uint8_t scramb_tables[8][19+16] = {
+static const uint8_t scramb_tables[8][19+16] = {
 {
     0x7f, 0x95, 0xb9, 0x4b, 0x63, 0x6f, 0x6d, 0x12,
     0x87, 0x3e, 0x75, 0x16, 0x79, 0x14, 0x06, 0x81,
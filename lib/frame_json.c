@@ -1,3 +1,4 @@
+#include <tetrapol/bit_utils.h>
 #include <tetrapol/frame_json.h>
 #include <tetrapol/misc.h>
 
@@ -9,31 +10,31 @@
 
 void frame_json(tpol_t *tpol, const frame_t *fr)
 {
-    printf("{ \"event\": \"frame\", ");
-    printf("\"rx_offs\": %" PRIu64 ", ", tpol->rx_offs);
+    FILE *out = tetrapol_evt_begin(tpol, "frame");
+    fprintf(out, "\"rx_offs\": %" PRIu64 ", ", tpol->rx_offs);
 
     struct timeval tv;
     struct tm gmt;
     gettimeofday(&tv, NULL);
     gmtime_r(&tv.tv_sec, &gmt);
 
-    printf("\"rx_time\": \"%4d-%02d-%02dT%02d-%02d-%02d.%06ld\", ",
+    fprintf(out, "\"rx_time\": \"%4d-%02d-%02dT%02d-%02d-%02d.%06ld\", ",
             gmt.tm_year + 1900, gmt.tm_mon + 1, gmt.tm_mday,
             gmt.tm_hour, gmt.tm_min, gmt.tm_sec, tv.tv_usec);
 
 
-    printf("\"frame\": { ");
+    fprintf(out, "\"frame\": { ");
     {
         if (tpol->frame_no != FRAME_NO_UNKNOWN) {
-            printf("\"frame_no\": %d, ", tpol->frame_no);
+            fprintf(out, "\"frame_no\": %d, ", tpol->frame_no);
         } else {
-            printf("\"frame_no\": null, ");
+            fprintf(out, "\"frame_no\": null, ");
         }
 
         if (!fr->broken) {
-            printf("\"state\": \"ok\", ");
-            printf("\"syndromes\": %d, ", fr->syndromes);
-            printf("\"bits_fixed\": %d, ", fr->bits_fixed);
+            fprintf(out, "\"state\": \"ok\", ");
+            fprintf(out, "\"syndromes\": %d, ", fr->syndromes);
+            fprintf(out, "\"bits_fixed\": %d, ", fr->bits_fixed);
 
             const char *fr_type;
             switch (fr->fr_type) {
@@ -48,23 +49,20 @@ void frame_json(tpol_t *tpol, const frame_t *fr)
                 default:
                     fr_type = "FIXME";
             }
-            printf("\"type\": \"%s\", ", fr_type);
+            fprintf(out, "\"type\": \"%s\", ", fr_type);
 
             if (fr->fr_type == FRAME_TYPE_DATA) {
-                printf("\"asb\": [%d, %d], ", fr->data.asb[0], fr->data.asb[1]);
-                printf("\"fn\": [%d, %d], ", fr->data.data[0], fr->data.data[1]);
+                fprintf(out, "\"asb\": [%d, %d], ", fr->data.asb[0], fr->data.asb[1]);
+                fprintf(out, "\"fn\": [%d, %d], ", fr->data.data[0], fr->data.data[1]);
 
                 uint8_t data[8];
-                memset(data, 0, sizeof(data));
-                for (int i = 0; i < 8*8; ++i) {
-                    data[i / 8] |= fr->data.data[i + 2] << (i % 8);
-                }
+                pack64_bytes(data, fr->data_packed);
                 char buf[3*sizeof(data)];
-                printf("\"data\": { \"encoding\": \"hex\", \"value\": \"%s\" } ",
+                fprintf(out, "\"data\": { \"encoding\": \"hex\", \"value\": \"%s\" } ",
                         sprint_hex2(buf, data, sizeof(data)));
 
             } else if (fr->fr_type == FRAME_TYPE_VOICE) {
-                printf("\"asb\": [%d, %d], ", fr->voice.asb[0], fr->voice.asb[1]);
+                fprintf(out, "\"asb\": [%d, %d], ", fr->voice.asb[0], fr->voice.asb[1]);
                 uint8_t voice[120/8];
                 memset(voice, 0, sizeof(voice));
 
@@ -76,23 +74,24 @@ void frame_json(tpol_t *tpol, const frame_t *fr)
                 }
 
                 char buf[120/8*3];
-                printf("\"data\": { \"encoding\": \"hex\", \"value\": \"%s\" } ",
+                fprintf(out, "\"data\": { \"encoding\": \"hex\", \"value\": \"%s\" } ",
                         sprint_hex2(buf, voice, 120/8));
 
             } else {
-                printf("\"FIXME\": \"FIXME\" ");
+                fprintf(out, "\"FIXME\": \"FIXME\" ");
             }
         } else if (fr->broken == -1) {
-            printf("\"state\": \"bad_CRC\", ");
-            printf("\"syndromes\": %d, ", fr->syndromes);
-            printf("\"bits_fixed\": %d ", fr->bits_fixed);
+            fprintf(out, "\"state\": \"bad_CRC\", ");
+            fprintf(out, "\"syndromes\": %d, ", fr->syndromes);
+            fprintf(out, "\"bits_fixed\": %d ", fr->bits_fixed);
         } else if (fr->broken > 0) {
-            printf("\"state\": %d, ", fr->broken);
+            fprintf(out, "\"state\": %d, ", fr->broken);
         } else {
-            printf("\"state\": \"FIXME\", ");
+            fprintf(out, "\"state\": \"FIXME\", ");
         }
     }
-    printf("}");
+    fprintf(out, "}");
 
-    printf("}\n");
+    fprintf(out, "}\n");
+    tetrapol_evt_end(tpol);
 }
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+
+# Generate fused descrambling, differential decoding and deinterleaving
+# tables for frame decoder.
+#
+# Usage: gen_frame_tables.py frame.c frame_tables.h
+#
+# Source tables (scrambling sequence, differential precoding and
+# interleaving) are taken from frame.c, so there is only one copy of them.
+#
+# Frame decoder does for received frame data r
+#   t[j] = r[j] ^ s[j]                      descrambling, s depends on SCR
+#   u[j] = t[j] ^ t[j - d[j]]               UHF only, u[0] = t[0]
+#   deint[k] = u[T[k]]                      deinterleaving
+# everything is linear, so
+#   deint[k] = r[T[k]] ^ r[T[k] - d[T[k]]] ^ m[k]
+# where m is the scrambling sequence passed through the same steps.
+# For T[k] = 0 (no differential decoding) both indexes are 0 and the bit
+# must be fixed by fused_first_UHF.
+
+import re
+import sys
+
+FRAME_DATA_LEN = 152
+FRAME_DATA_LEN1 = 52
+
+
+def parse_table(src, name):
+    m = re.search(r'\b' + name + r'\[[^]]*\]\s*=\s*\{([^}]*)\}', src)
+    if not m:
+        sys.exit('table %s not found' % name)
+    return [int(v) for v in re.findall(r'\d+', m.group(1))]
+
+
+def c_array(values, indent):
+    lines = []
+    for i in range(0, len(values), 16):
+        lines.append(indent + ', '.join(str(v) for v in values[i:i+16]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    src = open(sys.argv[1]).read()
+    scramb = parse_table(src, 'scramb_table')
+    precod = parse_table(src, 'diff_precod_UHF')
+    int_VHF = parse_table(src, 'interleave_voice_VHF')
+    int_voice_UHF = parse_table(src, 'interleave_voice_UHF')
+    int_data_UHF = parse_table(src, 'interleave_data_UHF')
+
+    # [band][fr_type], band 0 - VHF, 1 - UHF, fr_type 0 - voice, 1 - data,
+    # the first part of frame is interleaved as data for both types
+    int_tables = [[int_VHF, int_VHF], [int_voice_UHF, int_data_UHF]]
+
+    def perm(band, data):
+        t = int_tables[band][data]
+        return int_tables[band][1][:FRAME_DATA_LEN1] + t[FRAME_DATA_LEN1:]
+
+    def prev(band, data):
+        return [0 if j == 0 else j - precod[j] for j in perm(band, data)]
+
+    def mask(band, data, scr):
+        if scr == 0:
+            s = [0] * FRAME_DATA_LEN
+        else:
+            s = [scramb[(j + scr) % 127] for j in range(FRAME_DATA_LEN)]
+        m = [s[j] for j in perm(band, data)]
+        if band == 1:
+            m = [a ^ (s[b] if j else 0)
+                    for a, b, j in zip(m, prev(band, data), perm(band, data))]
+        packed = [0] * (FRAME_DATA_LEN // 8)
+        for k, b in enumerate(m):
+            packed[k // 8] |= b << (k % 8)
+        return packed
+
+    out = open(sys.argv[2], 'w')
+    out.write('// Generated by gen_frame_tables.py from frame.c, do not edit.\n\n')
+
+    out.write('/// source bit of deinterleaved frame, [band][fr_type][bit]\n')
+    out.write('static const uint8_t fused_perm[2][2][FRAME_DATA_LEN] = {\n')
+    for band in range(2):
+        out.write('    {\n')
+        for data in range(2):
+            out.write('        {\n%s\n        },\n' %
+                    c_array(perm(band, data), ' ' * 12))
+        out.write('    },\n')
+    out.write('};\n\n')
+
+    out.write('/// source bit of differential decoding, UHF only, [fr_type][bit]\n')
+    out.write('static const uint8_t fused_prev_UHF[2][FRAME_DATA_LEN] = {\n')
+    for data in range(2):
+        out.write('    {\n%s\n    },\n' % c_array(prev(1, data), ' ' * 8))
+    out.write('};\n\n')
+
+    out.write('/// deinterleaved bit from first bit of frame, UHF only, [fr_type]\n')
+    out.write('static const uint8_t fused_first_UHF[2] = { %d, %d };\n\n' %
+            tuple(perm(1, data).index(0) for data in range(2)))
+
+    out.write('/// scrambling mask of deinterleaved frame, [band][fr_type][scr][byte]\n')
+    out.write('static const uint8_t fused_scr_mask[2][2][128][FRAME_DATA_LEN / 8] = {\n')
+    for band in range(2):
+        out.write('    {\n')
+        for data in range(2):
+            out.write('        {\n')
+            for scr in range(128):
+                out.write('            { %s },\n' %
+                        ', '.join('0x%02x' % v for v in mask(band, data, scr)))
+            out.write('        },\n')
+        out.write('    },\n')
+    out.write('};\n')
+
+
+if __name__ == '__main__':
+    main()
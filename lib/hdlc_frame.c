@@ -3,6 +3,7 @@
 #include <tetrapol/hdlc_frame.h>
 #include <tetrapol/bit_utils.h>
 #include <tetrapol/misc.h>
+#include <tetrapol/system_config.h>
 
 #include <stdbool.h>
 #include <string.h>
@@ -93,7 +94,45 @@ static void command_parse(command_t *cmd, uint8_t data)
     };
 }
 
-bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int nbits)
+static uint8_t command_build(const command_t *cmd)
+{
+    switch (cmd->cmd) {
+        case COMMAND_INFORMATION:
+            return (cmd->information.n_r << 5) | (cmd->information.p_e << 4) |
+                (cmd->information.n_s << 1);
+
+        case COMMAND_SUPERVISION_RR:
+        case COMMAND_SUPERVISION_RNR:
+        case COMMAND_SUPERVISION_REJ:
+            return cmd->cmd | (cmd->supervision.n_r << 5) |
+                (cmd->supervision.p_e << 4);
+
+        case COMMAND_DACH:
+            return cmd->cmd | (cmd->dach_access.seq_no << 5) |
+                (cmd->dach_access.retry << 4);
+
+        case COMMAND_UNNUMBERED_UI:
+        case COMMAND_UNNUMBERED_DISC:
+        case COMMAND_UNNUMBERED_UA:
+        case COMMAND_UNNUMBERED_SNRM:
+        case COMMAND_UNNUMBERED_FRMR:
+        case COMMAND_UNNUMBERED_DM:
+            return cmd->cmd | (cmd->unnumbered.p_e << 4);
+
+        case COMMAND_UNNUMBERED_UI_P0:
+            return cmd->cmd | (cmd->unnumbered.ra << 4);
+
+        case COMMAND_UNNUMBERED_U_RR:
+            return cmd->cmd | (cmd->unnumbered.response_format << 6) |
+                (cmd->unnumbered.p_e << 4);
+
+        default:
+            return cmd->cmd;
+    }
+}
+
+void hdlc_frame_parse_data(hdlc_frame_t *hdlc_frame, const uint8_t *data,
+        int nbits)
 {
     addr_parse(&hdlc_frame->addr, data, 0);
     command_parse(&hdlc_frame->command, data[2]);
@@ -101,6 +140,11 @@ bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int nbits)
     hdlc_frame->nbits = nbits - 3*8 - 2*8;
     // copy FCS behind the data for future use
     memcpy(hdlc_frame->data, data + 3, (hdlc_frame->nbits + 2*8 + 7) / 8);
+}
+
+bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int nbits)
+{
+    hdlc_frame_parse_data(hdlc_frame, data, nbits);
 
     return check_fcs(data, nbits);
 }
@@ -135,7 +179,7 @@ for l in res:
 static const struct {
     uint8_t data[5];
     uint8_t index;
-} stuff_pat[40] = {
+} stuff_pat[HDLC_STUFFING_PATTERNS] = {
     { .data = { 0x04, 0x85, 0x76, 0x3e, 0x69, }, .index = 36, },
     { .data = { 0x09, 0x0a, 0xec, 0x7c, 0xd2, }, .index = 37, },
     { .data = { 0x0a, 0xec, 0x7c, 0xd2, 0x09, }, .index = 5, },
@@ -209,3 +253,43 @@ int hdlc_frame_stuffing_idx(const hdlc_frame_t *hdlc_frame)
         -1 : stuff_pat[pos].index;
 }
 
+int hdlc_frame_build(uint8_t *data, const hdlc_frame_t *hdlc_frame)
+{
+    const int len = hdlc_frame->nbits / 8;
+    // address, command, data and FCS padded to whole blocks
+    const int size = 8 * ((2 + 1 + len + 2 + 7) / 8);
+    if (hdlc_frame->nbits % 8 || len < 0 ||
+            size > 8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX) {
+        LOG(ERR, "invalid HDLC frame length %d", hdlc_frame->nbits);
+        return -1;
+    }
+
+    memset(data, 0, size);
+    addr_build(data, &hdlc_frame->addr);
+    data[2] = command_build(&hdlc_frame->command);
+    memcpy(data + 3, hdlc_frame->data, len);
+
+    fcs_t fcs;
+    fcs_init(&fcs);
+    fcs_update(&fcs, data, 8 * (size - 2));
+    const uint16_t crc = ~fcs.crc;
+    data[size - 2] = crc & 0xff;
+    data[size - 1] = crc >> 8;
+
+    return 8 * size;
+}
+
+int hdlc_frame_build_stuffing(uint8_t *data, int idx)
+{
+    int i = 0;
+    while (stuff_pat[i].index != idx % ARRAY_LEN(stuff_pat)) {
+        ++i;
+    }
+
+    const addr_t addr = { .z = 0, .y = 7, .x = 0 };
+    addr_build(data, &addr);
+    data[2] = COMMAND_UNNUMBERED_UI;
+    memcpy(data + 3, stuff_pat[i].data, sizeof(stuff_pat[i].data));
+
+    return 64;
+}
@@ -221,8 +221,22 @@ void link_rx_glitch(link_t *link)
     link->rx_glitch = true;
 }
 
-void link_tick(time_evt_t* te, link_t *link)
+bool link_tick(time_evt_t* te, link_t *link, struct timeval *deadline)
 {
-    link->rx_glitch |= te->rx_glitch;
-    tpdu_du_tick(te, link->tpdu_ui);
+    return tpdu_du_tick(te, link->tpdu_ui, deadline);
+}
+
+bool link_tick_required(const link_t *link)
+{
+    return tpdu_du_tick_required(link->tpdu_ui);
+}
+
+bool link_is_busy(const link_t *link)
+{
+    return tpdu_ui_is_busy(link->tpdu_ui) || tpdu_is_busy(link->tpdu);
+}
+
+size_t link_mem_size(void)
+{
+    return sizeof(link_t) + tpdu_mem_size() + tpdu_ui_mem_size();
 }
@@ -59,15 +59,17 @@ static int tp_address_decode(const uint8_t *data, int len, lsdu_cd_tp_address_t
         return -1;
     }
 
-    lsdu->signature = get_bits(4, &data[1], 4);
-    lsdu->modifier_number = get_bits(4, &data[1], 0);
+    bit_reader_t br;
+    bit_reader_init(&br, data, len);
+    bit_reader_skip(&br, 8);
+    lsdu->modifier_number = bit_reader_get(&br, 4);
+    lsdu->signature = bit_reader_get(&br, 4);
 
-    const uint8_t *d = &data[2];
-    if (address_decode(&lsdu->rt_address, &d)) {
+    if (address_decode(&lsdu->rt_address, &br)) {
         LOG(WTF, "Only single address is supported");
     }
-    lsdu->_stuffing_len = len - (d - data);
-    memcpy(lsdu->_stuffing, d, lsdu->_stuffing_len);
+    lsdu->_stuffing_len = bit_reader_left(&br) / 8;
+    bit_reader_get_bytes(&br, lsdu->_stuffing, lsdu->_stuffing_len);
 
     return 0;
 }
@@ -1,6 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <tetrapol/log.h>
 #include <tetrapol/misc.h>
 #include <stdio.h>
+#include <time.h>
 
 char *sprint_hex(char *str, const uint8_t *bytes, int n)
 {
@@ -36,3 +39,20 @@ char *sprint_hex2(char *str, const uint8_t *bytes, int n)
     return str;
 }
 
+uint64_t clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+uint64_t xorshift64(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
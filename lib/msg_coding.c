@@ -3,43 +3,42 @@
 #include <tetrapol/bit_utils.h>
 #include <tetrapol/log.h>
 #include <tetrapol/msg_coding.h>
+#include <tetrapol/misc.h>
 
 #include <stdlib.h>
 
-/**
-  @param data_ptr Ponter to address structure, on return points to next address.
-  @return true if another address follows, false otherwise.
-  */
-bool address_decode(address_t *address, const uint8_t **data_ptr)
+bool address_decode(address_t *address, bit_reader_t *br)
 {
-    const uint8_t *data = *data_ptr;
+    const int pos = bit_reader_tell(br);
 
-    const bool li = get_bits(1, data, 0);
-    address->cna = get_bits(3, data, 1);
+    const bool li = bit_reader_get(br, 1);
+    address->cna = bit_reader_get(br, 3);
 
     switch (address->cna) {
-        case ADDRESS_CNA_NOT_SIGNIFICANT:
+        case ADDRESS_CNA_NOT_SIGNIFICANT: {
             address->len = 0;
-            if (get_bits(4, data, 4) != 0) {
-                LOG(WTF, "CND == 0 but address = 0x%0x", get_bits(4, data, 4));
+            const int zero = bit_reader_get(br, 4);
+            if (zero != 0) {
+                LOG(WTF, "CND == 0 but address = 0x%0x", zero);
             }
-            ++data;
             break;
+        }
 
         case ADDRESS_CNA_RFSI:
             address->len = 9;
             for (int i = 0; i < 9; ++i) {
-                address->rfsi.addr[i] = get_bits(4, data , 4 + 4*i);
+                address->rfsi.addr[i] = bit_reader_get(br, 4);
             }
-            data += 5;
             break;
 
         case ADDRESS_CNA_PABX:
-            address->len = get_bits(4, data, 4);
+            address->len = bit_reader_get(br, 4);
             for (int i = 0; i < address->len; ++i) {
-                address->pabx[i] = get_bits(4, data, 8 + 4*i);
+                address->pabx[i] = bit_reader_get(br, 4);
+            }
+            if (address->len % 2) {
+                bit_reader_skip(br, 4);
             }
-            data += 1 + (address->len + 1) / 2;
             break;
 
         case ADDRESS_CNA_X400:
@@ -49,19 +48,53 @@ bool address_decode(address_t *address, const uint8_t **data_ptr)
         case ADDRESS_CNA_ESCAPED_CODE:
             address->len = 0;
             LOG(ERR, "TODO: unsupported address CNA");
+            bit_reader_seek(br, pos);
             break;
 
         default:
             address->len = 0;
             LOG(WTF, "unknown address CNA");
+            bit_reader_seek(br, pos);
             break;
     }
 
-    *data_ptr = data;
-
     return li;
 }
 
+int address_encode(uint8_t *data, const address_t *address, bool li)
+{
+    data[0] = (li << 7) | ((address->cna & 0x7) << 4);
+
+    switch (address->cna) {
+        case ADDRESS_CNA_NOT_SIGNIFICANT:
+            return 1;
+
+        case ADDRESS_CNA_RFSI:
+            for (int i = 0; i < 9; ++i) {
+                set_bits(4, data, 4 + 4*i, address->rfsi.addr[i]);
+            }
+            return 5;
+
+        case ADDRESS_CNA_PABX:
+            if (address->len > ARRAY_LEN(address->pabx)) {
+                LOG(ERR, "too long PABX address %d", address->len);
+                return -1;
+            }
+            set_bits(4, data, 4, address->len);
+            for (int i = 0; i < address->len; ++i) {
+                set_bits(4, data, 8 + 4*i, address->pabx[i]);
+            }
+            if (address->len % 2) {
+                set_bits(4, data, 8 + 4*address->len, 0);
+            }
+            return 1 + (address->len + 1) / 2;
+
+        default:
+            LOG(ERR, "TODO: unsupported address CNA %d", address->cna);
+            return -1;
+    }
+}
+
 void address_print(const address_t *address)
 {
     LOGF("\t\tADDRESS CNA=%i ", address->cna);
@@ -91,24 +124,19 @@ void address_print(const address_t *address)
     }
 }
 
-int address_list_decode(address_list_t **ptr_addrs, const uint8_t *data)
+void cell_id_decode(cell_id_t *cell_id, bit_reader_t *br)
 {
-    // TODO: check len
-    address_list_t *addrs = *ptr_addrs;
-    do {
-        const int n = addrs ? (addrs->nadrs + 1) : 1;
-        const int l = sizeof(address_list_t) + n * sizeof(address_t);
-        address_list_t *p = realloc(addrs, l);
-        if (!p) {
-            *ptr_addrs = addrs;
-            return -1;
-        }
-        addrs = p;
-        addrs->nadrs = n;
-    } while (address_decode(&addrs->called_adr[addrs->nadrs-1], &data));
-
-    *ptr_addrs = addrs;
-
-    return 0;
+    int type = bit_reader_get(br, 2);
+    if (type == CELL_ID_FORMAT_0) {
+        cell_id->bs_id = bit_reader_get(br, 6);
+        cell_id->rsw_id = bit_reader_get(br, 4);
+    } else if (type == CELL_ID_FORMAT_1) {
+        cell_id->rsw_id = bit_reader_get(br, 6);
+        cell_id->bs_id = bit_reader_get(br, 4);
+    } else {
+        LOG(WTF, "unknown cell_id_type (%d)", type);
+        bit_reader_skip(br, 10);
+        cell_id->bs_id = -1;
+        cell_id->rsw_id = -1;
+    }
 }
-
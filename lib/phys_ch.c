@@ -1,6 +1,13 @@
+// Various defs for various versions of glibc to make endian.h working
+#define _DEFAULT_SOURCE 1
+#define __USE_BSD
+#define __USE_MISC
+#include <endian.h>
+
 #define LOG_PREFIX "phys_ch"
 
 #include <tetrapol/tetrapol_int.h>
+#include <tetrapol/bit_utils.h>
 #include <tetrapol/log.h>
 #include <tetrapol/frame_json.h>
 #include <tetrapol/system_config.h>
@@ -23,6 +30,36 @@
 
 #define DATA_OFFS (FRAME_LEN/2)
 
+// no. of 64 bit words covering positions in resynchronization window
+#define RESYNC_WORDS ((DATA_OFFS + 63) / 64)
+
+// capacity of input ring buffer in bits, must be power of 2
+#define DATA_LEN (1 << 12)
+
+// no. of bytes from ring buffer start mirrored after its end
+#define DATA_PAD 8
+
+// positions are moved back when they reach this, must be multiple of DATA_LEN
+#define DATA_REBASE (1 << 30)
+
+// differentialy encoded frame synchronization sequence, bits 1-7 of frame
+// header packed into byte (first bit in LSB), bit 0 depends on previous frame
+#define FRAME_DSYNC 0xca
+#define FRAME_DSYNC_MASK 0xfe
+
+/**
+  Sequential test for SCR detection. Frame is decoded without errors with
+  probability at least ~0.5 for the right SCR and ~0.003 for a wrong one.
+  Each frame adds log-likelihood ratio (scaled by 2) to score of every
+  evaluated SCR. SCR is detected when its score exceeds all others by
+  SCR_LLR_LOCK (false detection probability < 1e-6 for all 127 wrong SCRs),
+  SCR with score under SCR_LLR_DROP is not evaluated anymore.
+  */
+#define SCR_LLR_OK 10
+#define SCR_LLR_FAIL 1
+#define SCR_LLR_LOCK 40
+#define SCR_LLR_DROP -10
+
 struct phys_ch_priv_t {
     int band;           ///< VHF or UHF
     uint8_t dir;        ///< direction (downlink / uplink)
@@ -34,10 +71,18 @@ struct phys_ch_priv_t {
     int scr_guess;      ///< SCR with best score when guessing SCR
     int scr_confidence; ///< required confidence for SCR detection
     int scr_stat[128];  ///< statistics for SCR detection
-    uint8_t *data_begin;    ///< start of unprocessed part of data
-    uint8_t *data_end;      ///< end of unprocessed part of data
-    uint8_t data[10*FRAME_LEN];
+    int scr_llr[128];   ///< SCR score for sequential test
+    int scr_est[128];   ///< SCR score from frame structure checks
+    uint64_t scr_active[2]; ///< bitmap of SCRs evaluated in detection
+    int data_begin;     ///< start of unprocessed part of data (bit position)
+    int data_end;       ///< end of unprocessed part of data (bit position)
+    /// ring buffer with received bits packed into bytes, first bit in LSB,
+    /// data start is mirrored in padding, any word can be read at once
+    uint8_t data[DATA_LEN / 8 + DATA_PAD];
+    uint8_t wbuf[64];   ///< write buffer used when data_end is not aligned
     frame_decoder_t *fd;
+    bool prof;          ///< measure time spent in decoding layers
+    phys_ch_stats_t stats;  ///< TSDU counters are kept in tpol
     // CCH specific data, will be union with traffich CH specicic data
     tp_timer_t *tp_timer;
     cch_t *cch;
@@ -45,7 +90,24 @@ struct phys_ch_priv_t {
     tpol_t *tpol;
 };
 
-static int process_frame(phys_ch_t *phys_ch, const uint8_t *fr_data);
+static int process_frame(phys_ch_t *phys_ch, const uint8_t *fr_data,
+        uint64_t *t);
+
+/// start of time measurement, see prof_lap()
+static inline uint64_t prof_start(const phys_ch_t *phys_ch)
+{
+    return phys_ch->prof ? clock_ns() : 0;
+}
+
+/// add time elapsed from *t to counter ns, *t is moved to current time
+static inline void prof_lap(const phys_ch_t *phys_ch, uint64_t *ns, uint64_t *t)
+{
+    if (phys_ch->prof) {
+        const uint64_t now = clock_ns();
+        *ns += now - *t;
+        *t = now;
+    }
+}
 
 phys_ch_t *tetrapol_phys_ch_create(tetrapol_t *tetrapol)
 {
@@ -60,10 +122,10 @@ phys_ch_t *tetrapol_phys_ch_create(tetrapol_t *tetrapol)
     phys_ch->band = cfg->band;
     phys_ch->dir = cfg->dir;
     phys_ch->radio_ch_type = cfg->radio_ch_type;
-    phys_ch->data_begin = phys_ch->data_end = phys_ch->data + DATA_OFFS;
+    phys_ch->data_begin = phys_ch->data_end = DATA_OFFS;
     phys_ch->tpol->rx_offs = 0;
     phys_ch->tpol->frame_no = FRAME_NO_UNKNOWN;
-    phys_ch->scr = PHYS_CH_SCR_DETECT;
+    tetrapol_phys_ch_set_scr(phys_ch, PHYS_CH_SCR_DETECT);
     phys_ch->scr_last = PHYS_CH_SCR_DETECT;
     phys_ch->scr_confidence = 50;
     phys_ch->tp_timer = tp_timer_create();
@@ -74,6 +136,7 @@ phys_ch_t *tetrapol_phys_ch_create(tetrapol_t *tetrapol)
         free(phys_ch);
         return NULL;
     }
+    frame_decoder_set_fec(phys_ch->fd, cfg->fec);
 
     if (cfg->radio_ch_type == TETRAPOL_RADIO_CCH) {
         phys_ch->cch = cch_create(phys_ch->tpol);
@@ -106,6 +169,29 @@ void tetrapol_phys_ch_destroy(phys_ch_t *phys_ch)
     if (phys_ch->radio_ch_type == TETRAPOL_RADIO_TCH) {
         tch_destroy(phys_ch->tch);
     }
+
+    const tpol_t *tpol = phys_ch->tpol;
+    if (tpol->terminals_idle || tpol->terminals_evicted) {
+        LOG(INFO, "terminals forgotten: %lu idle, %lu over memory limit",
+                tpol->terminals_idle, tpol->terminals_evicted);
+    }
+
+    frame_decoder_stats_t stats;
+    frame_decoder_get_stats(phys_ch->fd, &stats);
+    if (stats.frames) {
+        LOG(INFO, "frames: %lu, rejected before FEC: %lu (%.1f %%)",
+                stats.frames, stats.screened,
+                100.0 * stats.screened / stats.frames);
+    }
+    if (stats.fast) {
+        LOG(INFO, "syndrome decoder: %lu frames, %lu valid (%.1f %%)",
+                stats.fast, stats.fast_ok, 100.0 * stats.fast_ok / stats.fast);
+    }
+    if (stats.viterbi) {
+        LOG(INFO, "Viterbi decoder: %lu frames, %lu valid (%.1f %%)",
+                stats.viterbi, stats.viterbi_ok,
+                100.0 * stats.viterbi_ok / stats.viterbi);
+    }
     frame_decoder_destroy(phys_ch->fd);
     tp_timer_destroy(phys_ch->tp_timer);
     free(phys_ch);
@@ -120,6 +206,32 @@ void tetrapol_phys_ch_set_scr(phys_ch_t *phys_ch, int scr)
 {
     phys_ch->scr = scr;
     memset(&phys_ch->scr_stat, 0, sizeof(phys_ch->scr_stat));
+    memset(&phys_ch->scr_llr, 0, sizeof(phys_ch->scr_llr));
+    memset(&phys_ch->scr_est, 0, sizeof(phys_ch->scr_est));
+    phys_ch->scr_active[0] = phys_ch->scr_active[1] = ~0ULL;
+}
+
+int tetrapol_phys_ch_get_scr_estimate(phys_ch_t *phys_ch, int *confidence)
+{
+    int scr_max = 0, scr_max2 = 1;
+    if (phys_ch->scr_est[0] < phys_ch->scr_est[1]) {
+        scr_max = 1;
+        scr_max2 = 0;
+    }
+    for (int scr = 2; scr < ARRAY_LEN(phys_ch->scr_est); ++scr) {
+        if (phys_ch->scr_est[scr] > phys_ch->scr_est[scr_max]) {
+            scr_max2 = scr_max;
+            scr_max = scr;
+        } else if (phys_ch->scr_est[scr] > phys_ch->scr_est[scr_max2]) {
+            scr_max2 = scr;
+        }
+    }
+
+    if (confidence) {
+        *confidence = phys_ch->scr_est[scr_max] - phys_ch->scr_est[scr_max2];
+    }
+
+    return scr_max;
 }
 
 int tetrapol_phys_ch_get_scr_confidence(phys_ch_t *phys_ch)
@@ -127,53 +239,238 @@ int tetrapol_phys_ch_get_scr_confidence(phys_ch_t *phys_ch)
     return phys_ch->scr_confidence;
 }
 
+void tetrapol_phys_ch_set_profiling(phys_ch_t *phys_ch, bool enable)
+{
+    phys_ch->prof = enable;
+    phys_ch->tpol->prof = enable;
+}
+
+void tetrapol_phys_ch_get_stats(phys_ch_t *phys_ch, phys_ch_stats_t *stats)
+{
+    *stats = phys_ch->stats;
+    stats->tsdus = phys_ch->tpol->tsdus;
+    stats->terminals = phys_ch->tpol->terminals;
+    stats->terminals_idle = phys_ch->tpol->terminals_idle;
+    stats->terminals_evicted = phys_ch->tpol->terminals_evicted;
+    stats->ns_tsdu = phys_ch->tpol->ns_tsdu;
+    // TSDUs are decoded from link layer, do not count them twice
+    stats->ns_link -= (stats->ns_link > stats->ns_tsdu) ?
+        stats->ns_tsdu : stats->ns_link;
+}
+
 void tetrapol_phys_ch_set_scr_confidence(
         phys_ch_t *phys_ch, int scr_confidence)
 {
     phys_ch->scr_confidence = scr_confidence;
 }
 
-static uint8_t differential_dec(uint8_t *data, int size, uint8_t first_bit)
+/// get 64 bits starting at bit position pos, first bit in LSB
+static inline uint64_t get_word(const uint8_t *data, int pos)
+{
+    const int i = (pos / 8) & (DATA_LEN / 8 - 1);
+    uint64_t w;
+    memcpy(&w, &data[i], sizeof(w));
+    w = le64toh(w);
+    if (pos % 8) {
+        w = (w >> (pos % 8)) | ((uint64_t)data[i + 8] << (64 - pos % 8));
+    }
+    return w;
+}
+
+/**
+  Get free space in buffer, history preceding data_begin is kept for
+  resynchronization.
+
+  @return free space in buffer (in bits)
+  */
+static int data_space(const phys_ch_t *phys_ch)
+{
+    // one byte is reserved for unaligned writes
+    const int keep = (phys_ch->data_begin - DATA_OFFS) & ~7;
+    return DATA_LEN - 8 - (phys_ch->data_end - keep);
+}
+
+/// store byte into ring buffer at byte index idx
+static inline void set_byte(phys_ch_t *phys_ch, int idx, uint8_t byte)
 {
-    while (size--) {
-        first_bit = *data = *data ^ first_bit;
-        ++data;
+    idx &= DATA_LEN / 8 - 1;
+    phys_ch->data[idx] = byte;
+    if (idx < DATA_PAD) {
+        phys_ch->data[DATA_LEN / 8 + idx] = byte;
     }
-    return first_bit;
+}
+
+/// append single byte of packed bits at the end of data
+static inline void put_byte(phys_ch_t *phys_ch, uint8_t byte)
+{
+    const int idx = phys_ch->data_end / 8;
+    const int offs = phys_ch->data_end % 8;
+
+    if (offs) {
+        const uint8_t d = phys_ch->data[idx & (DATA_LEN / 8 - 1)];
+        set_byte(phys_ch, idx, (d & ((1 << offs) - 1)) | (byte << offs));
+        set_byte(phys_ch, idx + 1, byte >> (8 - offs));
+    } else {
+        set_byte(phys_ch, idx, byte);
+    }
+    phys_ch->data_end += 8;
 }
 
 int tetrapol_phys_ch_recv(phys_ch_t *phys_ch, uint8_t *buf, int len)
 {
-    const int data_len = phys_ch->data_end - phys_ch->data_begin;
+    const uint8_t inv = (phys_ch->dir == DIR_UPLINK) ? 0xff : 0x00;
+    int i = 0;
+    while (i < len) {
+        const int n = data_space(phys_ch);
+        if (n < 8) {
+            // buffer is full, process data to make some space
+            const int r = tetrapol_phys_ch_process(phys_ch);
+            if (r < 0) {
+                return r;
+            }
+            continue;
+        }
+        const int end = (n < len - i) ? i + n : len;
+
+        for ( ; i + 8 <= end; i += 8) {
+            put_byte(phys_ch, pack8(&buf[i]) ^ inv);
+        }
+        if (i < end) {
+            uint8_t tail[8];
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, &buf[i], end - i);
+            put_byte(phys_ch, pack8(tail) ^ inv);
+            // drop padding bits
+            phys_ch->data_end -= 8 - (end - i);
+            i = end;
+        }
+    }
+
+    return len;
+}
+
+uint8_t *tetrapol_phys_ch_get_write_buffer(phys_ch_t *phys_ch, int *len)
+{
+    int n = data_space(phys_ch) / 8;
+    while (n < 1) {
+        // buffer is full, process data to make some space
+        if (tetrapol_phys_ch_process(phys_ch) < 0) {
+            return NULL;
+        }
+        n = data_space(phys_ch) / 8;
+    }
+
+    if (phys_ch->data_end % 8) {
+        *len = (n < sizeof(phys_ch->wbuf)) ? n : sizeof(phys_ch->wbuf);
+        return phys_ch->wbuf;
+    }
+
+    const int idx = (phys_ch->data_end / 8) & (DATA_LEN / 8 - 1);
+    *len = (n < DATA_LEN / 8 - idx) ? n : DATA_LEN / 8 - idx;
+
+    return &phys_ch->data[idx];
+}
+
+int tetrapol_phys_ch_commit(phys_ch_t *phys_ch, int len)
+{
+    if (len < 0 || 8 * len > data_space(phys_ch)) {
+        LOG(ERR, "commit of %d bytes exceeds free space", len);
+        return -1;
+    }
 
-    memmove(phys_ch->data, phys_ch->data_begin - DATA_OFFS, data_len + DATA_OFFS);
-    phys_ch->data_begin = phys_ch->data + DATA_OFFS;
-    phys_ch->data_end = phys_ch->data_begin + data_len;
+    const uint8_t inv = (phys_ch->dir == DIR_UPLINK) ? 0xff : 0x00;
+    if (phys_ch->data_end % 8) {
+        for (int i = 0; i < len; ++i) {
+            put_byte(phys_ch, phys_ch->wbuf[i] ^ inv);
+        }
+        return 0;
+    }
 
-    const int space = sizeof(phys_ch->data) - data_len - DATA_OFFS;
-    len = (len > space) ? space : len;
+    // data were written directly into ring buffer
+    const int idx = (phys_ch->data_end / 8) & (DATA_LEN / 8 - 1);
+    uint8_t *d = &phys_ch->data[idx];
+    if (inv) {
+        int i = 0;
+        for ( ; i + 8 <= len; i += 8) {
+            uint64_t w;
+            memcpy(&w, &d[i], sizeof(w));
+            w = ~w;
+            memcpy(&d[i], &w, sizeof(w));
+        }
+        for ( ; i < len; ++i) {
+            d[i] = ~d[i];
+        }
+    }
+    if (idx < DATA_PAD) {
+        memcpy(&phys_ch->data[DATA_LEN / 8 + idx], d,
+                (DATA_PAD - idx < len) ? DATA_PAD - idx : len);
+    }
+    phys_ch->data_end += 8 * len;
 
-    memcpy(phys_ch->data_end, buf, len);
-    phys_ch->data_end += len;
+    return 0;
+}
 
-    if (phys_ch->dir == DIR_UPLINK) {
-        for (uint8_t *b = phys_ch->data_end - len; b < phys_ch->data_end; ++b) {
-            *b ^= 0x01;
+int tetrapol_phys_ch_recv_packed(phys_ch_t *phys_ch, uint8_t *buf, int len)
+{
+    int i = 0;
+    while (i < len) {
+        int n;
+        uint8_t *d = tetrapol_phys_ch_get_write_buffer(phys_ch, &n);
+        if (!d) {
+            return -1;
+        }
+        n = (n < len - i) ? n : len - i;
+        memcpy(d, &buf[i], n);
+        const int r = tetrapol_phys_ch_commit(phys_ch, n);
+        if (r < 0) {
+            return r;
         }
+        i += n;
     }
 
     return len;
 }
 
 // compare bite stream to differentialy encoded synchronization sequence
-static int cmp_frame_sync(const uint8_t *data)
+static int cmp_frame_sync(const phys_ch_t *phys_ch, int pos)
 {
-    const uint8_t frame_dsync[] = { 1, 0, 1, 0, 0, 1, 1, };
-    int sync_err = 0;
-    for(int i = 0; i < sizeof(frame_dsync); ++i) {
-        sync_err += frame_dsync[i] ^ data[i + 1];
+    const uint8_t hdr = get_word(phys_ch->data, pos);
+    return __builtin_popcount((hdr ^ FRAME_DSYNC) & FRAME_DSYNC_MASK);
+}
+
+/**
+  Compare synchronization sequence for 64 consecutive positions at once.
+
+  Error counters are bit-sliced, bit k of cnt[i] is i-th bit of number of
+  errors for position pos + k. Each bit of synchronization sequence is
+  compared with whole word, the mismatches are summed by carry chain.
+  */
+static void cmp_frame_sync64(const phys_ch_t *phys_ch, int pos, uint64_t *cnt)
+{
+    cnt[0] = cnt[1] = cnt[2] = 0;
+    for (int i = 0; i < FRAME_HDR_LEN; ++i) {
+        if (!(FRAME_DSYNC_MASK & (1 << i))) {
+            continue;
+        }
+        uint64_t m = get_word(phys_ch->data, pos + i);
+        if (FRAME_DSYNC & (1 << i)) {
+            m = ~m;
+        }
+        // max. 7 errors, can not overflow 3 bits
+        const uint64_t c0 = cnt[0] & m;
+        const uint64_t c1 = cnt[1] & c0;
+        cnt[0] ^= m;
+        cnt[1] ^= c0;
+        cnt[2] |= c1;
     }
-    return sync_err;
+}
+
+/// get lanes of bit-sliced counter with value equal to errs
+static inline uint64_t sync_errs_eq(const uint64_t *cnt, int errs)
+{
+    return ((errs & 1) ? cnt[0] : ~cnt[0]) &
+        ((errs & 2) ? cnt[1] : ~cnt[1]) &
+        ((errs & 4) ? cnt[2] : ~cnt[2]);
 }
 
 /**
@@ -185,34 +482,153 @@ static int cmp_frame_sync(const uint8_t *data)
   */
 static int find_frame_sync(phys_ch_t *phys_ch)
 {
-    const uint8_t *end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
-    int sync_err = MAX_FRAME_SYNC_ERR + 1;
+    const int end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
     while (phys_ch->data_begin <= end) {
-        sync_err = cmp_frame_sync(phys_ch->data_begin) +
-            cmp_frame_sync(phys_ch->data_begin + FRAME_LEN);
-        if (sync_err <= MAX_FRAME_SYNC_ERR) {
-            break;
+        uint64_t cnt1[3], cnt2[3];
+        cmp_frame_sync64(phys_ch, phys_ch->data_begin, cnt1);
+        cmp_frame_sync64(phys_ch, phys_ch->data_begin + FRAME_LEN, cnt2);
+
+        uint64_t match = 0;
+        for (int e1 = 0; e1 <= MAX_FRAME_SYNC_ERR; ++e1) {
+            for (int e2 = 0; e1 + e2 <= MAX_FRAME_SYNC_ERR; ++e2) {
+                match |= sync_errs_eq(cnt1, e1) & sync_errs_eq(cnt2, e2);
+            }
         }
 
-        ++phys_ch->data_begin;
-        ++phys_ch->tpol->rx_offs;
-    }
+        int n = end - phys_ch->data_begin + 1;
+        if (n < 64) {
+            match &= (1ULL << n) - 1;
+        } else {
+            n = 64;
+        }
+        if (match) {
+            n = __builtin_ctzll(match);
+        }
 
-    if (sync_err <= MAX_FRAME_SYNC_ERR) {
-        phys_ch->sync_errs = 0;
-        return 1;
+        phys_ch->data_begin += n;
+        phys_ch->tpol->rx_offs += n;
+        if (match) {
+            phys_ch->sync_errs = 0;
+            return 1;
+        }
     }
 
     return 0;
 }
 
+/**
+  Differential decoding of 64 bits, each output bit is XOR of all
+  preceding input bits (prefix parity).
+
+  @param w Word to decode, first bit in LSB.
+  @param carry Last decoded bit of previous word.
+  */
+static inline uint64_t differential_dec(uint64_t w, uint64_t carry)
+{
+    w ^= w << 1;
+    w ^= w << 2;
+    w ^= w << 4;
+    w ^= w << 8;
+    w ^= w << 16;
+    w ^= w << 32;
+
+    return w ^ -carry;
+}
+
 static void copy_frame_data(phys_ch_t *phys_ch, uint8_t *fr_data)
 {
-    memcpy(fr_data, phys_ch->data_begin + FRAME_HDR_LEN, FRAME_DATA_LEN);
+    uint64_t carry = 0;
+    for (int i = 0; i < FRAME_DATA_LEN; i += 64) {
+        const uint64_t w = differential_dec(get_word(phys_ch->data,
+                    phys_ch->data_begin + FRAME_HDR_LEN + i), carry);
+        carry = w >> 63;
+
+        for (int j = 0; j < 64 && i + j < FRAME_DATA_LEN; j += 8) {
+            unpack8(&fr_data[i + j], w >> j);
+        }
+    }
+
     phys_ch->data_begin += FRAME_LEN;
     phys_ch->tpol->rx_offs += FRAME_LEN;
+}
+
+/// mask of lanes first..last (inclusive) falling into w-th word of lane set
+static inline uint64_t lane_range(int w, int first, int last)
+{
+    first -= 64 * w;
+    last -= 64 * w;
+    if (last < 0 || first > 63) {
+        return 0;
+    }
+    first = (first < 0) ? 0 : first;
+    last = (last > 63) ? 63 : last;
 
-    differential_dec(fr_data, FRAME_DATA_LEN, 0);
+    return (~0ULL >> (63 - last)) & (~0ULL << first);
+}
+
+/**
+  Nearest match in lane set where lane k is position data_begin + k.
+
+  @return distance from data_begin or INT_MAX if not found in max_dist
+  */
+static int nearest_fwd(const uint64_t *lanes, int max_dist)
+{
+    for (int w = 0; w < RESYNC_WORDS; ++w) {
+        const uint64_t m = lanes[w] & lane_range(w, 0, max_dist);
+        if (m) {
+            return 64 * w + __builtin_ctzll(m);
+        }
+    }
+
+    return INT_MAX;
+}
+
+/**
+  Nearest match in lane set where lane k is position
+  data_begin - (DATA_OFFS - 1) + k.
+
+  @return distance from data_begin or INT_MAX if not found in max_dist
+  */
+static int nearest_rev(const uint64_t *lanes, int max_dist)
+{
+    for (int w = RESYNC_WORDS - 1; w >= 0; --w) {
+        const uint64_t m = lanes[w] &
+            lane_range(w, DATA_OFFS - 1 - max_dist, DATA_OFFS - 1);
+        if (m) {
+            return DATA_OFFS - 1 - (64 * w + 63 - __builtin_clzll(m));
+        }
+    }
+
+    return INT_MAX;
+}
+
+/**
+  Find position with least number of sync errors in distance max_dist
+  around data_begin. Nearer position wins, for the same distance
+  the position after data_begin is preferred.
+
+  @param fwd Error counters for positions data_begin + k.
+  @param rev Error counters for positions data_begin - (DATA_OFFS - 1) + k.
+  @param sync_errs Number of errors on returned position.
+
+  @return offset of best position from data_begin
+  */
+static int find_best_sync(uint64_t fwd[][3], uint64_t rev[][3], int max_dist,
+        int *sync_errs)
+{
+    for (int errs = 0; ; ++errs) {
+        uint64_t fwd_eq[RESYNC_WORDS], rev_eq[RESYNC_WORDS];
+        for (int w = 0; w < RESYNC_WORDS; ++w) {
+            fwd_eq[w] = sync_errs_eq(fwd[w], errs);
+            rev_eq[w] = sync_errs_eq(rev[w], errs);
+        }
+        const int dist_fwd = nearest_fwd(fwd_eq, max_dist);
+        const int dist_rev = nearest_rev(rev_eq, max_dist);
+        if (dist_fwd != INT_MAX || dist_rev != INT_MAX) {
+            *sync_errs = errs;
+            return (dist_fwd <= dist_rev) ? dist_fwd : -dist_rev;
+        }
+    }
 }
 
 /// return number of acquired frames (0 or 1) or -1 on error
@@ -223,7 +639,7 @@ static int get_frame(phys_ch_t *phys_ch, uint8_t *fr_data)
     }
 
     // are we in sync?
-    if (cmp_frame_sync(phys_ch->data_begin) == 0) {
+    if (cmp_frame_sync(phys_ch, phys_ch->data_begin) == 0) {
         copy_frame_data(phys_ch, fr_data);
         if (phys_ch->sync_errs > 0) {
             --phys_ch->sync_errs;
@@ -239,50 +655,40 @@ static int get_frame(phys_ch_t *phys_ch, uint8_t *fr_data)
     // look for synchoronization pattern shifted by some offset from expected
     // possition. At the same time look for synchronization pattern of the
     // following frame. If pattern(s) are found, synchronization is restored.
-    int sync_errs1 = INT_MAX;
-    int sync_errs2 = INT_MAX;
-    const uint8_t *end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
-    uint8_t *data = phys_ch->data_begin;
-    uint8_t *rdata = phys_ch->data_begin;
-    uint8_t *sync_pos1 = NULL;
-    uint8_t *sync_pos2 = NULL;
-    for (int i = 0; i < DATA_OFFS; ++i) {
-        if (data > end) {
-            return 0;
-        }
-
-        int e = cmp_frame_sync(data);
-        if (e < sync_errs1) {
-            sync_pos1 = data;
-            sync_errs1 = e;
-        }
-
-        e = cmp_frame_sync(rdata);
-        if (e < sync_errs1) {
-            sync_pos1 = rdata;
-            sync_errs1 = e;
-        }
-
-        e = cmp_frame_sync(data + FRAME_LEN);
-        if (e < sync_errs2) {
-            sync_pos2 = data;
-            sync_errs2 = e;
-        }
-
-        e = cmp_frame_sync(rdata + FRAME_LEN);
-        if (e < sync_errs2) {
-            sync_pos2 = rdata;
-            sync_errs2 = e;
-        }
-
-        if (sync_errs1 == 0 || sync_errs2 == 0) {
-            break;
-        }
+    // Errors for whole search window are computed at once, then the same
+    // position is chosen as by scanning alternately after and before
+    // data_begin and stopping at first exact match.
+    const int end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
+    const int begin = phys_ch->data_begin;
+    uint64_t fwd1[RESYNC_WORDS][3], rev1[RESYNC_WORDS][3];
+    uint64_t fwd2[RESYNC_WORDS][3], rev2[RESYNC_WORDS][3];
+    uint64_t fwd0[RESYNC_WORDS], rev0[RESYNC_WORDS];
+    for (int w = 0; w < RESYNC_WORDS; ++w) {
+        const int rbegin = begin - (DATA_OFFS - 1) + 64 * w;
+        cmp_frame_sync64(phys_ch, begin + 64 * w, fwd1[w]);
+        cmp_frame_sync64(phys_ch, begin + FRAME_LEN + 64 * w, fwd2[w]);
+        cmp_frame_sync64(phys_ch, rbegin, rev1[w]);
+        cmp_frame_sync64(phys_ch, rbegin + FRAME_LEN, rev2[w]);
+        fwd0[w] = sync_errs_eq(fwd1[w], 0) | sync_errs_eq(fwd2[w], 0);
+        rev0[w] = sync_errs_eq(rev1[w], 0) | sync_errs_eq(rev2[w], 0);
+    }
 
-        ++data;
-        --rdata;
+    int max_dist = DATA_OFFS - 1;
+    const int dist_fwd = nearest_fwd(fwd0, max_dist);
+    const int dist_rev = nearest_rev(rev0, max_dist);
+    if (dist_fwd < max_dist || dist_rev < max_dist) {
+        max_dist = (dist_fwd < dist_rev) ? dist_fwd : dist_rev;
+    }
+    if (begin + max_dist > end) {
+        return 0;
     }
 
+    int sync_errs1, sync_errs2;
+    const int sync_pos1 = begin +
+        find_best_sync(fwd1, rev1, max_dist, &sync_errs1);
+    const int sync_pos2 = begin +
+        find_best_sync(fwd2, rev2, max_dist, &sync_errs2);
+
     // increase error counter only if we have not found 2 consecutive sync patterns
     if (sync_errs1 != 0 || sync_errs2 != 0 || sync_pos1 != sync_pos2) {
         phys_ch->sync_errs = 2 * phys_ch->sync_errs + 2;
@@ -293,7 +699,7 @@ static int get_frame(phys_ch_t *phys_ch, uint8_t *fr_data)
         return -1;
     }
 
-    uint8_t *sync_pos = (sync_errs1 < sync_errs2) ? sync_pos1 : sync_pos2;
+    const int sync_pos = (sync_errs1 < sync_errs2) ? sync_pos1 : sync_pos2;
     phys_ch->tpol->rx_offs += sync_pos - phys_ch->data_begin;
     phys_ch->data_begin = sync_pos;
 
@@ -305,12 +711,21 @@ static int get_frame(phys_ch_t *phys_ch, uint8_t *fr_data)
 
 int tetrapol_phys_ch_process(phys_ch_t *phys_ch)
 {
+    uint64_t t = prof_start(phys_ch);
+
+    // keep positions small, shift by multiple of DATA_LEN does not move data
+    if (phys_ch->data_begin > DATA_REBASE) {
+        phys_ch->data_begin -= DATA_REBASE;
+        phys_ch->data_end -= DATA_REBASE;
+    }
+
     if (!phys_ch->has_frame_sync) {
         int n = phys_ch->data_end - phys_ch->data_begin;
         phys_ch->has_frame_sync = find_frame_sync(phys_ch);
         n -= phys_ch->data_end - phys_ch->data_begin;
         if (!phys_ch->has_frame_sync) {
             tp_timer_tick(phys_ch->tp_timer, true, n * 20000 / 160);
+            prof_lap(phys_ch, &phys_ch->stats.ns_sync, &t);
             return 0;
         }
         LOG(INFO, "Frame sync found");
@@ -323,12 +738,15 @@ int tetrapol_phys_ch_process(phys_ch_t *phys_ch)
     int r = 1;
     uint8_t fr_data[FRAME_DATA_LEN];
     while ((r = get_frame(phys_ch, fr_data)) > 0) {
-        process_frame(phys_ch, fr_data);
+        prof_lap(phys_ch, &phys_ch->stats.ns_sync, &t);
+        process_frame(phys_ch, fr_data, &t);
         tp_timer_tick(phys_ch->tp_timer, false, 20000);
         if (phys_ch->tpol->frame_no != FRAME_NO_UNKNOWN) {
             phys_ch->tpol->frame_no = (phys_ch->tpol->frame_no + 1) % 200;
         }
+        prof_lap(phys_ch, &phys_ch->stats.ns_link, &t);
     }
+    prof_lap(phys_ch, &phys_ch->stats.ns_sync, &t);
 
     if (r == 0) {
         return 0;
@@ -336,6 +754,7 @@ int tetrapol_phys_ch_process(phys_ch_t *phys_ch)
 
     LOG(INFO, "Frame sync lost");
     phys_ch->has_frame_sync = false;
+    ++phys_ch->stats.sync_lost;
 
     return 0;
 }
@@ -347,20 +766,77 @@ int tetrapol_phys_ch_process(phys_ch_t *phys_ch)
   */
 static void detect_scr(phys_ch_t *phys_ch, const uint8_t *fr_data)
 {
-    // compute SCR statistics
+    // estimate SCR from frame structure first, it is cheap and the right SCR
+    // is usually found from 2 frames, scores of wrong SCRs are kept around 0
+    int scr_score[ARRAY_LEN(phys_ch->scr_est)];
+    frame_decoder_scr_score(phys_ch->fd, scr_score, fr_data);
+    for (int scr = 0; scr < ARRAY_LEN(phys_ch->scr_est); ++scr) {
+        phys_ch->scr_est[scr] += scr_score[scr];
+        if (phys_ch->scr_est[scr] < 0) {
+            phys_ch->scr_est[scr] = 0;
+        }
+    }
+
+    int confidence;
+    const int scr_est = tetrapol_phys_ch_get_scr_estimate(phys_ch, &confidence);
+    if (confidence >= PHYS_CH_SCR_EST_CONFIDENCE) {
+        tetrapol_phys_ch_set_scr(phys_ch, scr_est);
+        LOG(INFO, "SCR estimated %d", scr_est);
+        phys_ch->scr_guess = scr_est;
+        return;
+    }
+
+    // fall back to decoding of frame with all SCRs
+    uint64_t scr_ok[2];
+    frame_decoder_check_scr(phys_ch->fd, scr_ok, phys_ch->scr_active, fr_data);
+
+    // compute SCR statistics, dropped SCRs are counted as broken
     for(int scr = 0; scr < ARRAY_LEN(phys_ch->scr_stat); ++scr) {
-        frame_t fr;
-        frame_decoder_reset(phys_ch->fd, phys_ch->band, scr, FRAME_TYPE_AUTO);
-        frame_decoder_decode(phys_ch->fd, &fr, fr_data);
-        if (fr.broken) {
+        const uint64_t scr_bit = 1ULL << (scr % 64);
+        if (!(scr_ok[scr / 64] & scr_bit)) {
             phys_ch->scr_stat[scr] -= 2;
             if (phys_ch->scr_stat[scr] < 0) {
                 phys_ch->scr_stat[scr] = 0;
             }
+            if (phys_ch->scr_active[scr / 64] & scr_bit) {
+                phys_ch->scr_llr[scr] -= SCR_LLR_FAIL;
+                if (phys_ch->scr_llr[scr] <= SCR_LLR_DROP) {
+                    phys_ch->scr_active[scr / 64] &= ~scr_bit;
+                }
+            }
             continue;
         }
 
         ++phys_ch->scr_stat[scr];
+        phys_ch->scr_llr[scr] += SCR_LLR_OK;
+    }
+
+    // all SCRs were dropped (bad signal), start the test again
+    if (!phys_ch->scr_active[0] && !phys_ch->scr_active[1]) {
+        memset(&phys_ch->scr_llr, 0, sizeof(phys_ch->scr_llr));
+        phys_ch->scr_active[0] = phys_ch->scr_active[1] = ~0ULL;
+    }
+
+    // sequential test, lock SCR as soon as it is reliable
+    int llr_max = 0, llr_max2 = 1;
+    if (phys_ch->scr_llr[0] < phys_ch->scr_llr[1]) {
+        llr_max = 1;
+        llr_max2 = 0;
+    }
+    for(int scr = 2; scr < ARRAY_LEN(phys_ch->scr_llr); ++scr) {
+        if (phys_ch->scr_llr[scr] > phys_ch->scr_llr[llr_max]) {
+            llr_max2 = llr_max;
+            llr_max = scr;
+        } else if (phys_ch->scr_llr[scr] > phys_ch->scr_llr[llr_max2]) {
+            llr_max2 = scr;
+        }
+    }
+    if (phys_ch->scr_llr[llr_max] >= SCR_LLR_LOCK &&
+            phys_ch->scr_llr[llr_max] - phys_ch->scr_llr[llr_max2] >= SCR_LLR_LOCK) {
+        tetrapol_phys_ch_set_scr(phys_ch, llr_max);
+        LOG(INFO, "SCR detected %d", llr_max);
+        phys_ch->scr_guess = llr_max;
+        return;
     }
 
     // get difference in statistic for two best SCRs
@@ -384,7 +860,8 @@ static void detect_scr(phys_ch_t *phys_ch, const uint8_t *fr_data)
     phys_ch->scr_guess = scr_max;
 }
 
-static int process_frame(phys_ch_t *phys_ch, const uint8_t *fr_data)
+static int process_frame(phys_ch_t *phys_ch, const uint8_t *fr_data,
+        uint64_t *t)
 {
     if (phys_ch->scr == PHYS_CH_SCR_DETECT) {
         detect_scr(phys_ch, fr_data);
@@ -394,7 +871,9 @@ static int process_frame(phys_ch_t *phys_ch, const uint8_t *fr_data)
         phys_ch->scr_guess : phys_ch->scr;
 
     if (phys_ch->scr_last != scr) {
-        printf("{ \"event\": \"scr\", \"scr\": %d }\n", scr);
+        FILE *out = tetrapol_evt_begin(phys_ch->tpol, "scr");
+        fprintf(out, "\"scr\": %d }\n", scr);
+        tetrapol_evt_end(phys_ch->tpol);
         phys_ch-> scr_last = scr;
     }
 
@@ -405,9 +884,12 @@ static int process_frame(phys_ch_t *phys_ch, const uint8_t *fr_data)
     frame_decoder_reset(phys_ch->fd, phys_ch->band, scr, fr_type);
     frame_decoder_decode(phys_ch->fd, &fr, fr_data);
 
+    ++phys_ch->stats.frames;
     if (!fr.broken) {
+        ++phys_ch->stats.frames_ok;
         frame_json(phys_ch->tpol, &fr);
     }
+    prof_lap(phys_ch, &phys_ch->stats.ns_frame, t);
 
     if (phys_ch->radio_ch_type == TETRAPOL_RADIO_CCH) {
         // TODO: report when frame_no is detected
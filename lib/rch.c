@@ -55,6 +55,7 @@ bool rch_push_frame(rch_t *rch, const frame_t *fr)
         return false;
     }
 
+    const bool fcs_ok = data_frame_check_fcs(rch->data_fr);
     uint8_t data[(92 + 7) / 8];
     const int size = data_frame_get_bytes(rch->data_fr, data);
     if (size != 64) {
@@ -62,7 +63,7 @@ bool rch_push_frame(rch_t *rch, const frame_t *fr)
         return false;
     }
 
-    if (!check_fcs(data, size)) {
+    if (!fcs_ok) {
         LOG(DBG, "invalid FCS");
         return false;
     }
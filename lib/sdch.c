@@ -76,12 +76,14 @@ bool sdch_dl_push_data_frame(sdch_t *sdch, const frame_t *fr)
         terminal_list_rx_glitch(sdch->tlist);
     }
 
+    const bool fcs_ok = data_frame_check_fcs(sdch->data_fr);
     uint8_t data[SYS_PAR_N200_BYTES_MAX];
     const int size = data_frame_get_bytes(sdch->data_fr, data);
 
     hdlc_frame_t hdlc_fr;
+    hdlc_frame_parse_data(&hdlc_fr, data, size);
 
-    if (!hdlc_frame_parse(&hdlc_fr, data, size)) {
+    if (!fcs_ok) {
         // PAS 0001-3-3 7.4.1.9 stuffing frames are dropped, FCS does not match
         int idx = hdlc_frame_stuffing_idx(&hdlc_fr);
         if (idx == -1) {
@@ -6,82 +6,247 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <glib.h>
+enum {
+    /// Initial size of address table is 2^TABLE_BITS_MIN
+    TABLE_BITS_MIN = 6,
+    /// Number of terminals allocated at once
+    SLAB_LEN = 64,
+};
 
 struct terminal_priv_t {
     link_t *link;
+    addr_t addr;
+    int idx;                ///< index in terminal_list_t.terms
+    int heap_idx;           ///< index in terminal_list_t.heap, -1 if not there
+    int64_t deadline;       ///< time of next tick (us), valid in heap only
+    unsigned rx_glitch_cnt; ///< value of terminal_list_t.rx_glitch_cnt seen
+    int64_t last_rx;        ///< time of last received frame (us)
+    terminal_t *lru_prev;   ///< more recently active terminal
+    terminal_t *lru_next;   ///< less recently active terminal
+    terminal_t *next_free;  ///< next free slab entry, valid only for free ones
+};
+
+typedef struct slab_t slab_t;
+struct slab_t {
+    slab_t *next;
+    terminal_t terms[SLAB_LEN];
 };
 
+/// Entry of open addressing table, terminal is NULL for empty entry
+typedef struct {
+    terminal_t *term;
+    uint16_t key;
+} table_entry_t;
+
 struct terminal_list_priv_t {
-    GTree *tree;
+    /// Linear probing hash table with packed address as key
+    table_entry_t *table;
+    int table_size;
+    int table_bits;     ///< log2(table_size)
+    /// Live terminals in dense array
+    terminal_t **terms;
+    int nterms;
+    int terms_size;
+    /// Min-heap of terminals with running timers ordered by deadline
+    terminal_t **heap;
+    int heap_len;
+    /// Incremented by each RX glitch, it is reported lazily to terminals
+    unsigned rx_glitch_cnt;
+    /// Terminals ordered by time of last received frame, the newest first
+    terminal_t *lru_head;
+    terminal_t *lru_tail;
+    int64_t now;            ///< time of last tick (us)
+    int64_t idle_timeout;   ///< idle terminals are destroyed (us), -1 never
+    int nterms_max;         ///< limit of number of terminals, 0 no limit
+    /// Terminal structures are allocated by slabs, never moved
+    slab_t *slabs;
+    terminal_t *free_terms;
     tpol_t *tpol;
     int log_ch;
 };
 
-static terminal_t* terminal_create(tpol_t *tpol, int log_ch)
+static inline int table_idx(const terminal_list_t *tlist, uint16_t key)
 {
-    terminal_t *term = malloc(sizeof(terminal_t));
-    if (!term) {
-        return NULL;
+    // Fibonacci hashing, all bits of key affects the top bits of product
+    return ((uint32_t)key * 2654435769u) >> (32 - tlist->table_bits);
+}
+
+static int table_resize(terminal_list_t *tlist, int bits)
+{
+    const int size = 1 << bits;
+    table_entry_t *table = calloc(size, sizeof(table_entry_t));
+    if (!table) {
+        return -1;
     }
 
-    term->link = link_create(tpol, log_ch);
-    if (!term->link) {
-        free(term);
-        return NULL;
+    table_entry_t *old_table = tlist->table;
+    const int old_size = tlist->table_size;
+    tlist->table = table;
+    tlist->table_size = size;
+    tlist->table_bits = bits;
+
+    for (int i = 0; i < old_size; ++i) {
+        if (!old_table[i].term) {
+            continue;
+        }
+        int idx = table_idx(tlist, old_table[i].key);
+        while (table[idx].term) {
+            idx = (idx + 1) & (size - 1);
+        }
+        table[idx] = old_table[i];
     }
+    free(old_table);
 
-    return term;
+    return 0;
 }
 
-static void terminal_destroy(terminal_t *term)
+static terminal_t *terminal_alloc(terminal_list_t *tlist)
 {
-    if (!term) {
-        return;
+    if (!tlist->free_terms) {
+        slab_t *slab = malloc(sizeof(slab_t));
+        if (!slab) {
+            return NULL;
+        }
+        slab->next = tlist->slabs;
+        tlist->slabs = slab;
+        for (int i = SLAB_LEN - 1; i >= 0; --i) {
+            slab->terms[i].next_free = tlist->free_terms;
+            tlist->free_terms = &slab->terms[i];
+        }
     }
 
+    terminal_t *term = tlist->free_terms;
+    tlist->free_terms = term->next_free;
+
+    return term;
+}
+
+static void terminal_free(terminal_list_t *tlist, terminal_t *term)
+{
     link_destroy(term->link);
-    free(term);
+    term->link = NULL;
+    term->next_free = tlist->free_terms;
+    tlist->free_terms = term;
 }
 
-static inline void terminal_destroy_(gpointer term)
+static inline void heap_set(terminal_list_t *tlist, int idx, terminal_t *term)
 {
-    terminal_destroy(term);
+    tlist->heap[idx] = term;
+    term->heap_idx = idx;
 }
 
-int terminal_push_hdlc_frame(terminal_t* term, const hdlc_frame_t *hdlc_fr)
+static void heap_sift_up(terminal_list_t *tlist, int idx)
 {
-    return link_push_hdlc_frame(term->link, hdlc_fr);
+    terminal_t *term = tlist->heap[idx];
+    while (idx) {
+        const int parent = (idx - 1) / 2;
+        if (tlist->heap[parent]->deadline <= term->deadline) {
+            break;
+        }
+        heap_set(tlist, idx, tlist->heap[parent]);
+        idx = parent;
+    }
+    heap_set(tlist, idx, term);
 }
 
-static inline void addr_free(gpointer data)
+static void heap_sift_down(terminal_list_t *tlist, int idx)
 {
-    free(data);
+    terminal_t *term = tlist->heap[idx];
+    while (true) {
+        int child = 2 * idx + 1;
+        if (child >= tlist->heap_len) {
+            break;
+        }
+        if (child + 1 < tlist->heap_len &&
+                tlist->heap[child + 1]->deadline < tlist->heap[child]->deadline) {
+            ++child;
+        }
+        if (term->deadline <= tlist->heap[child]->deadline) {
+            break;
+        }
+        heap_set(tlist, idx, tlist->heap[child]);
+        idx = child;
+    }
+    heap_set(tlist, idx, term);
+}
+
+/// Insert terminal into heap or move it when it is already there.
+static void heap_schedule(terminal_list_t *tlist, terminal_t *term,
+        int64_t deadline)
+{
+    if (term->heap_idx < 0) {
+        term->deadline = deadline;
+        heap_set(tlist, tlist->heap_len++, term);
+        heap_sift_up(tlist, term->heap_idx);
+        return;
+    }
+
+    const int64_t old_deadline = term->deadline;
+    term->deadline = deadline;
+    if (deadline < old_deadline) {
+        heap_sift_up(tlist, term->heap_idx);
+    } else {
+        heap_sift_down(tlist, term->heap_idx);
+    }
 }
 
-static gint addr_cmp(gconstpointer _a1, gconstpointer _a2, gpointer user_data)
+static void heap_remove(terminal_list_t *tlist, terminal_t *term)
 {
-    const addr_t *a1 = _a1;
-    const addr_t *a2 = _a2;
+    const int idx = term->heap_idx;
+    if (idx < 0) {
+        return;
+    }
+    term->heap_idx = -1;
+
+    terminal_t *last = tlist->heap[--tlist->heap_len];
+    if (last == term) {
+        return;
+    }
+    heap_set(tlist, idx, last);
+    heap_sift_up(tlist, idx);
+    heap_sift_down(tlist, last->heap_idx);
+}
 
-    if (a1->z != a2->z) {
-        return a2->z - a1->z;
+static void lru_unlink(terminal_list_t *tlist, terminal_t *term)
+{
+    if (term->lru_prev) {
+        term->lru_prev->lru_next = term->lru_next;
+    } else {
+        tlist->lru_head = term->lru_next;
     }
-    if (a1->y != a2->y) {
-        return a2->y - a1->y;
+    if (term->lru_next) {
+        term->lru_next->lru_prev = term->lru_prev;
+    } else {
+        tlist->lru_tail = term->lru_prev;
+    }
+}
+
+static void lru_push_front(terminal_list_t *tlist, terminal_t *term)
+{
+    term->last_rx = tlist->now;
+    term->lru_prev = NULL;
+    term->lru_next = tlist->lru_head;
+    if (tlist->lru_head) {
+        tlist->lru_head->lru_prev = term;
+    } else {
+        tlist->lru_tail = term;
     }
-    return a2->x - a1->x;
+    tlist->lru_head = term;
+}
+
+int terminal_push_hdlc_frame(terminal_t* term, const hdlc_frame_t *hdlc_fr)
+{
+    return link_push_hdlc_frame(term->link, hdlc_fr);
 }
 
 terminal_list_t *terminal_list_create(tpol_t * tpol, int log_ch)
 {
-    terminal_list_t *tlist = malloc(sizeof(terminal_list_t));
+    terminal_list_t *tlist = calloc(1, sizeof(terminal_list_t));
     if (!tlist) {
         return NULL;
     }
 
-    tlist->tree = g_tree_new_full(addr_cmp, NULL, addr_free, terminal_destroy_);
-    if (!tlist->tree) {
+    if (table_resize(tlist, TABLE_BITS_MIN)) {
         free(tlist);
         return NULL;
     }
@@ -89,42 +254,164 @@ terminal_list_t *terminal_list_create(tpol_t * tpol, int log_ch)
     tlist->tpol = tpol;
     tlist->log_ch = log_ch;
 
+    const int32_t idle_timeout = tpol->cfg.terminal_idle_timeout ?
+        tpol->cfg.terminal_idle_timeout : TETRAPOL_TERMINAL_IDLE_TIMEOUT;
+    tlist->idle_timeout = (idle_timeout < 0) ? -1 : idle_timeout * (int64_t)1000000;
+
+    if (tpol->cfg.terminal_mem_max) {
+        // terminal with link, table entries (load factor >= 1/4) and pointers
+        const size_t term_size = sizeof(terminal_t) + link_mem_size() +
+            4 * sizeof(table_entry_t) + 2 * sizeof(terminal_t *);
+        const size_t nterms_max = tpol->cfg.terminal_mem_max * (size_t)1024 / term_size;
+        tlist->nterms_max = nterms_max ? nterms_max : 1;
+        LOG(INFO, "memory limit %u kB, %d terminals",
+                tpol->cfg.terminal_mem_max, tlist->nterms_max);
+    }
+
     return tlist;
 }
 
 void terminal_list_destroy(terminal_list_t *tlist)
 {
-    g_tree_destroy(tlist->tree);
+    if (!tlist) {
+        return;
+    }
+
+    for (int i = 0; i < tlist->nterms; ++i) {
+        link_destroy(tlist->terms[i]->link);
+    }
+    tlist->tpol->terminals -= tlist->nterms;
+    while (tlist->slabs) {
+        slab_t *slab = tlist->slabs;
+        tlist->slabs = slab->next;
+        free(slab);
+    }
+    free(tlist->terms);
+    free(tlist->heap);
+    free(tlist->table);
     free(tlist);
 }
 
 terminal_t* terminal_list_lookup(const terminal_list_t* tlist, const addr_t *addr)
 {
-    return g_tree_lookup(tlist->tree, addr);
+    const uint16_t key = addr_key(addr);
+    int idx = table_idx(tlist, key);
+
+    while (tlist->table[idx].term) {
+        if (tlist->table[idx].key == key) {
+            return tlist->table[idx].term;
+        }
+        idx = (idx + 1) & (tlist->table_size - 1);
+    }
+
+    return NULL;
 }
 
 terminal_t* terminal_list_insert(terminal_list_t* tlist, const addr_t *addr)
 {
-    terminal_t *term = terminal_create(tlist->tpol, tlist->log_ch);
+    terminal_t *term = terminal_list_lookup(tlist, addr);
+    if (term) {
+        return term;
+    }
+
+    if (tlist->nterms_max && tlist->nterms >= tlist->nterms_max) {
+        LOG_IF(INFO) {
+            char buf[ADDR_PRINT_BUF_SIZE];
+            LOG(INFO, "memory limit reached, forgetting %s",
+                    addr_print(buf, &tlist->lru_tail->addr));
+        }
+        ++tlist->tpol->terminals_evicted;
+        terminal_list_erase(tlist, &tlist->lru_tail->addr);
+    }
+
+    // keep load factor below 1/2
+    if (2 * (tlist->nterms + 1) > tlist->table_size) {
+        if (table_resize(tlist, tlist->table_bits + 1)) {
+            return NULL;
+        }
+    }
+
+    if (tlist->nterms == tlist->terms_size) {
+        const int size = tlist->terms_size ? 2 * tlist->terms_size : SLAB_LEN;
+        terminal_t **terms = realloc(tlist->terms, sizeof(terminal_t *[size]));
+        if (!terms) {
+            return NULL;
+        }
+        tlist->terms = terms;
+        // heap can hold all terminals, then insertion never fails
+        terms = realloc(tlist->heap, sizeof(terminal_t *[size]));
+        if (!terms) {
+            return NULL;
+        }
+        tlist->heap = terms;
+        tlist->terms_size = size;
+    }
+
+    term = terminal_alloc(tlist);
     if (!term) {
         return NULL;
     }
 
-    addr_t *addr_new = malloc(sizeof(addr_t));
-    if (!addr_new) {
-        terminal_destroy(term);
+    term->link = link_create(tlist->tpol, tlist->log_ch);
+    if (!term->link) {
+        term->next_free = tlist->free_terms;
+        tlist->free_terms = term;
         return NULL;
     }
-    memcpy(addr_new, addr, sizeof(addr_t));
-
-    g_tree_insert(tlist->tree, addr_new, term);
+    term->addr = *addr;
+    term->heap_idx = -1;
+    term->rx_glitch_cnt = tlist->rx_glitch_cnt;
+    term->idx = tlist->nterms;
+    tlist->terms[tlist->nterms++] = term;
+    lru_push_front(tlist, term);
+    ++tlist->tpol->terminals;
+
+    const uint16_t key = addr_key(addr);
+    int idx = table_idx(tlist, key);
+    while (tlist->table[idx].term) {
+        idx = (idx + 1) & (tlist->table_size - 1);
+    }
+    tlist->table[idx].term = term;
+    tlist->table[idx].key = key;
 
     return term;
 }
 
 void terminal_list_erase(terminal_list_t* tlist, const addr_t *addr)
 {
-    g_tree_remove(tlist->tree, addr);
+    const int mask = tlist->table_size - 1;
+    const uint16_t key = addr_key(addr);
+    int idx = table_idx(tlist, key);
+
+    while (tlist->table[idx].term && tlist->table[idx].key != key) {
+        idx = (idx + 1) & mask;
+    }
+    terminal_t *term = tlist->table[idx].term;
+    if (!term) {
+        return;
+    }
+
+    // backward shift deletion, no tombstones are required
+    int next = (idx + 1) & mask;
+    while (tlist->table[next].term) {
+        const int home = table_idx(tlist, tlist->table[next].key);
+        // entry can be moved into hole when its home is not in (idx, next]
+        if (((next - home) & mask) >= ((next - idx) & mask)) {
+            tlist->table[idx] = tlist->table[next];
+            idx = next;
+        }
+        next = (next + 1) & mask;
+    }
+    tlist->table[idx].term = NULL;
+
+    heap_remove(tlist, term);
+    lru_unlink(tlist, term);
+    --tlist->tpol->terminals;
+    terminal_t *last = tlist->terms[--tlist->nterms];
+    tlist->terms[term->idx] = last;
+    last->idx = term->idx;
+
+    terminal_free(tlist, term);
 }
 
 int terminal_list_push_hdlc_frame(terminal_list_t* tlist,
@@ -139,37 +426,74 @@ int terminal_list_push_hdlc_frame(terminal_list_t* tlist,
         }
     }
 
-    return terminal_push_hdlc_frame(term, hdlc_fr);
-}
+    if (tlist->lru_head != term) {
+        lru_unlink(tlist, term);
+        lru_push_front(tlist, term);
+    } else {
+        term->last_rx = tlist->now;
+    }
 
-static gboolean terminal_rx_glitch(gpointer key, gpointer value,
-        gpointer data)
-{
-    terminal_t *term = value;
+    if (term->rx_glitch_cnt != tlist->rx_glitch_cnt) {
+        term->rx_glitch_cnt = tlist->rx_glitch_cnt;
+        link_rx_glitch(term->link);
+    }
+
+    const int ret = terminal_push_hdlc_frame(term, hdlc_fr);
 
-    link_rx_glitch(term->link);
+    if (link_tick_required(term->link)) {
+        // time is never negative, terminal is ticked by next tick
+        heap_schedule(tlist, term, -1);
+    }
 
-    return false;
+    return ret;
 }
 
 void terminal_list_rx_glitch(terminal_list_t* tlist)
 {
-    g_tree_foreach(tlist->tree, terminal_rx_glitch, NULL);
+    ++tlist->rx_glitch_cnt;
 }
 
-static gboolean terminal_tick(gpointer key, gpointer value,
-        gpointer data)
+void terminal_list_tick(terminal_list_t* tlist, time_evt_t *te)
 {
-    terminal_t *term = value;
-    time_evt_t *te = data;
+    if (te->rx_glitch) {
+        ++tlist->rx_glitch_cnt;
+    }
 
-    link_tick(te, term->link);
+    const int64_t now = te->tv.tv_sec * (int64_t)1000000 + te->tv.tv_usec;
+    tlist->now = now;
+    while (tlist->heap_len && tlist->heap[0]->deadline <= now) {
+        terminal_t *term = tlist->heap[0];
+        struct timeval tv;
+        if (link_tick(te, term->link, &tv)) {
+            int64_t deadline = tv.tv_sec * (int64_t)1000000 + tv.tv_usec;
+            // do not loop forever on deadline which is already gone
+            if (deadline <= now) {
+                deadline = now + 1;
+            }
+            heap_schedule(tlist, term, deadline);
+        } else {
+            heap_remove(tlist, term);
+        }
+    }
 
-    return false;
-}
+    if (tlist->idle_timeout < 0) {
+        return;
+    }
 
-void terminal_list_tick(terminal_list_t* tlist, time_evt_t *te)
-{
-    g_tree_foreach(tlist->tree, terminal_tick, te);
+    while (tlist->lru_tail &&
+            tlist->lru_tail->last_rx + tlist->idle_timeout <= now) {
+        terminal_t *term = tlist->lru_tail;
+        if (link_is_busy(term->link)) {
+            // check it again after next timeout
+            lru_unlink(tlist, term);
+            lru_push_front(tlist, term);
+            continue;
+        }
+        LOG_IF(DBG) {
+            char buf[ADDR_PRINT_BUF_SIZE];
+            LOG(DBG, "forgetting idle %s", addr_print(buf, &term->addr));
+        }
+        ++tlist->tpol->terminals_idle;
+        terminal_list_erase(tlist, &term->addr);
+    }
 }
-
@@ -43,10 +43,181 @@ static void test_check_fcs(void **state)
     }
 }
 
+/// incremental FCS must give the same result for any split of data
+static void test_fcs_update(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t in[] = {
+        0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+        0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+        0x00, 0x83, 0xf5, 0x00, 0x04, 0xdf, 0xa8, 0x26,
+    };
+
+    for (int split = 0; split <= sizeof(in); ++split) {
+        fcs_t fcs;
+        fcs_init(&fcs);
+        fcs_update(&fcs, in, 8*split);
+        fcs_update(&fcs, in + split, 8*(sizeof(in) - split));
+        assert_true(fcs_check(&fcs));
+    }
+
+    // any single bit error must be detected
+    for (int bit = 0; bit < 8*sizeof(in); ++bit) {
+        in[bit / 8] ^= 1 << (bit % 8);
+        assert_false(check_fcs(in, 8*sizeof(in)));
+        in[bit / 8] ^= 1 << (bit % 8);
+    }
+
+    // length which is not multiple of 8, bits behind data are ignored
+    {
+        const uint8_t in[] = { 0x55, 0x03, 0x85, 0x98, 0xfe };
+        assert_true(check_fcs(in, 35));
+
+        fcs_t fcs;
+        fcs_init(&fcs);
+        fcs_update(&fcs, in, 16);
+        fcs_update(&fcs, in + 2, 19);
+        assert_true(fcs_check(&fcs));
+    }
+}
+
+static void test_pack8(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t bits[] = { 1, 1, 0, 1,  0, 1, 0, 0, };
+    assert_int_equal(0x2b, pack8(bits));
+
+    for (int i = 0; i < 256; ++i) {
+        uint8_t unpacked[8];
+        uint8_t unpacked_exp[8];
+        memset(unpacked_exp, 0, sizeof(unpacked_exp));
+        for (int j = 0; j < 8; ++j) {
+            unpacked_exp[j] = (i >> j) & 1;
+        }
+
+        unpack8(unpacked, i);
+        assert_memory_equal(unpacked_exp, unpacked, sizeof(unpacked_exp));
+        assert_int_equal(i, pack8(unpacked));
+    }
+}
+
+static void test_set_bits(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t data[4] = { 0xff, 0x00, 0xff, 0x00, };
+    set_bits(12, data, 4, 0xa5c);
+    const uint8_t data_exp[4] = { 0xfa, 0x5c, 0xff, 0x00, };
+    assert_memory_equal(data_exp, data, sizeof(data_exp));
+
+    for (int skip = 0; skip < 16; ++skip) {
+        for (int len = 1; len <= 16; ++len) {
+            const uint32_t val = 0x9e37 & (0xffff >> (16 - len));
+            memset(data, 0x55, sizeof(data));
+            set_bits(len, data, skip, val);
+            assert_int_equal(val, get_bits(len, data, skip));
+            if (skip) {
+                assert_int_equal(get_bits(skip, (const uint8_t[]){
+                            0x55, 0x55, 0x55, 0x55 }, 0),
+                        get_bits(skip, data, 0));
+            }
+        }
+    }
+}
+
+/// reader must give the same values as get_bits() for any field sequence
+static void test_bit_reader(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t data[40];
+    for (int i = 0; i < sizeof(data); ++i) {
+        data[i] = 0x9e * i + 0x37;
+    }
+
+    for (int first = 1; first <= 32; ++first) {
+        bit_reader_t br;
+        bit_reader_init(&br, data, sizeof(data));
+        int pos = 0;
+        for (int nbits = first; pos + nbits <= 8 * sizeof(data);
+                nbits = nbits % 32 + 1) {
+            assert_int_equal(pos, bit_reader_tell(&br));
+            assert_int_equal(get_bits(nbits, data, pos),
+                    bit_reader_get(&br, nbits));
+            pos += nbits;
+        }
+        assert_false(br.overflow);
+
+        bit_reader_seek(&br, 3 * first);
+        assert_int_equal(get_bits(first, data, 3 * first),
+                bit_reader_get(&br, first));
+        bit_reader_skip(&br, 5);
+        assert_int_equal(get_bits(12, data, 4 * first + 5),
+                bit_reader_get(&br, 12));
+    }
+
+    bit_reader_t br;
+    bit_reader_init(&br, data, sizeof(data));
+    bit_reader_skip(&br, 8);
+    uint8_t bytes[9];
+    bit_reader_get_bytes(&br, bytes, sizeof(bytes));
+    assert_memory_equal(&data[1], bytes, sizeof(bytes));
+    bit_reader_skip(&br, 4);
+    bit_reader_get_bytes(&br, bytes, 2);
+    assert_int_equal(get_bits(16, data, 84), (bytes[0] << 8) | bytes[1]);
+    assert_false(br.overflow);
+}
+
+/// data past end are read as zeros and overflow is reported
+static void test_bit_reader_overflow(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t data[8] = { 0xff, 0xff, 0xff, 0xaa, 0xff, };
+
+    bit_reader_t br;
+    bit_reader_init(&br, data, 3);
+    assert_int_equal(0xfff, bit_reader_get(&br, 12));
+    assert_int_equal(0xfff, bit_reader_get(&br, 12));
+    assert_false(br.overflow);
+    assert_int_equal(0, bit_reader_left(&br));
+    assert_int_equal(0, bit_reader_get(&br, 8));
+    assert_true(br.overflow);
+
+    bit_reader_init(&br, data, 3);
+    assert_int_equal(0xffffff0, bit_reader_get(&br, 28));
+    assert_true(br.overflow);
+
+    bit_reader_init(&br, data, 3);
+    bit_reader_skip(&br, 20);
+    assert_false(br.overflow);
+    bit_reader_skip(&br, 5);
+    assert_true(br.overflow);
+
+    bit_reader_init(&br, data, 3);
+    bit_reader_seek(&br, 25);
+    assert_true(br.overflow);
+
+    uint8_t bytes[3] = { 0x11, 0x11, 0x11, };
+    bit_reader_init(&br, data, 4);
+    bit_reader_seek(&br, 16);
+    bit_reader_get_bytes(&br, bytes, sizeof(bytes));
+    assert_memory_equal(((const uint8_t[]){ 0xff, 0xaa, 0x00, }),
+            bytes, sizeof(bytes));
+    assert_true(br.overflow);
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_check_fcs),
+        unit_test(test_fcs_update),
+        unit_test(test_pack8),
+        unit_test(test_set_bits),
+        unit_test(test_bit_reader),
+        unit_test(test_bit_reader_overflow),
     };
 
     return run_tests(tests);
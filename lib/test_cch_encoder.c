@@ -0,0 +1,216 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "cch_encoder.c"
+
+/// HDLC data which fills all blocks of data frame
+#define DATA_LEN_MAX (8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX - 2 - 1 - 2)
+
+/// data frame received from logical channel
+typedef struct {
+    int frame_no;       ///< frame with the first block of data frame
+    int nbits;
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+} rx_data_frame_t;
+
+static rx_data_frame_t rx[ENC_CH_NUM][200];
+static int nrx[ENC_CH_NUM];
+
+/// logical channel of frame, default CCH multiplexing as in cch_push_frame()
+static int enc_ch_of_frame(int frame_no)
+{
+    const int fn_mod = frame_no % 100;
+
+    if (fn_mod <= 3) {
+        return ENC_CH_BCH;
+    }
+    if (fn_mod == 98 || fn_mod == 99) {
+        return ENC_CH_PCH;
+    }
+    if (fn_mod % 25 == 14) {
+        return ENC_CH_RCH;
+    }
+
+    return ENC_CH_SDCH;
+}
+
+/// get whole superframe, frames are demultiplexed and data frames decoded
+static void receive_superframe(cch_encoder_t *enc)
+{
+    data_frame_t *data_frs[ENC_CH_NUM];
+    int start[ENC_CH_NUM];
+    for (int ch = 0; ch < ENC_CH_NUM; ++ch) {
+        data_frs[ch] = data_frame_create();
+        assert_non_null(data_frs[ch]);
+        start[ch] = -1;
+        nrx[ch] = 0;
+    }
+
+    for (int fn = 0; fn < 200; ++fn) {
+        assert_int_equal(cch_encoder_frame_no(enc), fn);
+        frame_t fr;
+        cch_encoder_get_frame(enc, &fr);
+        assert_int_equal(fr.fr_type, FRAME_TYPE_DATA);
+
+        const int ch = enc_ch_of_frame(fn);
+        if (start[ch] < 0) {
+            start[ch] = fn;
+        }
+        const int r = data_frame_push_frame(data_frs[ch], &fr);
+        assert_true(r == 0 || r == 1);
+        if (r == 1) {
+            rx_data_frame_t *rx_fr = &rx[ch][nrx[ch]++];
+            rx_fr->frame_no = start[ch];
+            rx_fr->nbits = data_frame_get_bytes(data_frs[ch], rx_fr->data);
+            start[ch] = -1;
+        }
+    }
+    assert_int_equal(cch_encoder_frame_no(enc), 0);
+
+    for (int ch = 0; ch < ENC_CH_NUM; ++ch) {
+        data_frame_destroy(data_frs[ch]);
+    }
+}
+
+static bool is_stuffing(const rx_data_frame_t *rx_fr)
+{
+    hdlc_frame_t hdlc_fr;
+    return rx_fr->nbits == 64 &&
+        !hdlc_frame_parse(&hdlc_fr, rx_fr->data, rx_fr->nbits) &&
+        hdlc_frame_stuffing_idx(&hdlc_fr) >= 0;
+}
+
+static void test_cch_encoder_placement(void **state)
+{
+    (void) state;   // unused
+
+    cch_encoder_t *enc = cch_encoder_create(200);
+    assert_non_null(enc);
+
+    uint8_t bch[3 * 8], pch[2 * 8], rch[8];
+    for (int i = 0; i < sizeof(bch); ++i) {
+        bch[i] = 0x10 + i;
+    }
+    for (int i = 0; i < sizeof(pch); ++i) {
+        pch[i] = 0x40 + i;
+    }
+    for (int i = 0; i < sizeof(rch); ++i) {
+        rch[i] = 0x80 + i;
+    }
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_BCH, bch, 8 * sizeof(bch)), 0);
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_PCH, pch, 8 * sizeof(pch)), 0);
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_RCH, rch, 8 * sizeof(rch)), 0);
+
+    // SDCH frames of 1, 4 and 8 blocks, the last one is interrupted by RCH
+    const int lens[] = { 3, 20, DATA_LEN_MAX, };
+    hdlc_frame_t hdlc_frs[ARRAY_LEN(lens)];
+    for (int i = 0; i < ARRAY_LEN(lens); ++i) {
+        memset(&hdlc_frs[i], 0, sizeof(hdlc_frs[i]));
+        hdlc_frs[i].addr = (addr_t){ .z = 0, .y = 1, .x = 0x100 + i, };
+        hdlc_frs[i].command.cmd = COMMAND_UNNUMBERED_UI;
+        hdlc_frs[i].nbits = 8 * lens[i];
+        for (int j = 0; j < lens[i]; ++j) {
+            hdlc_frs[i].data[j] = 7 * j + i;
+        }
+        uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+        const int nbits = hdlc_frame_build(data, &hdlc_frs[i]);
+        assert_true(nbits > 0);
+        assert_int_equal(cch_encoder_push(enc, LOG_CH_SDCH, data, nbits), 0);
+    }
+    assert_int_equal(cch_encoder_pending(enc, LOG_CH_SDCH), ARRAY_LEN(lens));
+
+    receive_superframe(enc);
+
+    // BCH in frames 0-3, stuffing in the second half of superframe
+    assert_int_equal(nrx[ENC_CH_BCH], 5);
+    assert_int_equal(rx[ENC_CH_BCH][0].frame_no, 0);
+    assert_int_equal(rx[ENC_CH_BCH][0].nbits, 8 * sizeof(bch));
+    assert_memory_equal(rx[ENC_CH_BCH][0].data, bch, sizeof(bch));
+    for (int i = 1; i < nrx[ENC_CH_BCH]; ++i) {
+        assert_int_equal(rx[ENC_CH_BCH][i].frame_no, 99 + i);
+        assert_true(is_stuffing(&rx[ENC_CH_BCH][i]));
+    }
+
+    // PCH in frames 98-99, idle PCH pages no station
+    assert_int_equal(nrx[ENC_CH_PCH], 2);
+    assert_int_equal(rx[ENC_CH_PCH][0].frame_no, 98);
+    assert_memory_equal(rx[ENC_CH_PCH][0].data, pch, sizeof(pch));
+    assert_int_equal(rx[ENC_CH_PCH][1].frame_no, 198);
+    assert_true(cmpzero(rx[ENC_CH_PCH][1].data, 8));
+
+    // RCH in frames 14, 39, 64, ..., idle RCH carries FCS
+    assert_int_equal(nrx[ENC_CH_RCH], 8);
+    assert_memory_equal(rx[ENC_CH_RCH][0].data, rch, sizeof(rch));
+    for (int i = 0; i < nrx[ENC_CH_RCH]; ++i) {
+        assert_int_equal(rx[ENC_CH_RCH][i].frame_no, 14 + 25 * i);
+        if (i) {
+            assert_true(check_fcs(rx[ENC_CH_RCH][i].data, 64));
+        }
+    }
+
+    // SDCH frames in order of queueing, RCH frame 14 is skipped
+    const int sdch_fns[] = { 4, 5, 10, 20, };
+    for (int i = 0; i < ARRAY_LEN(lens); ++i) {
+        const rx_data_frame_t *rx_fr = &rx[ENC_CH_SDCH][i];
+        assert_int_equal(rx_fr->frame_no, sdch_fns[i]);
+
+        hdlc_frame_t hdlc_fr;
+        assert_true(hdlc_frame_parse(&hdlc_fr, rx_fr->data, rx_fr->nbits));
+        assert_int_equal(hdlc_fr.addr.x, hdlc_frs[i].addr.x);
+        assert_memory_equal(hdlc_fr.data, hdlc_frs[i].data, lens[i]);
+    }
+    assert_int_equal(rx[ENC_CH_SDCH][ARRAY_LEN(lens)].frame_no,
+            sdch_fns[ARRAY_LEN(lens)]);
+    for (int i = ARRAY_LEN(lens); i < nrx[ENC_CH_SDCH]; ++i) {
+        assert_true(is_stuffing(&rx[ENC_CH_SDCH][i]));
+    }
+    // all frames except BCH, PCH and RCH
+    assert_int_equal(nrx[ENC_CH_SDCH], ARRAY_LEN(lens) +
+            200 - 8 - 4 - 8 - (1 + 5 + 9));
+
+    const int log_chs[] = { LOG_CH_BCH, LOG_CH_PCH, LOG_CH_RCH, LOG_CH_SDCH, };
+    for (int i = 0; i < ARRAY_LEN(log_chs); ++i) {
+        assert_int_equal(cch_encoder_pending(enc, log_chs[i]), 0);
+    }
+
+    cch_encoder_destroy(enc);
+}
+
+static void test_cch_encoder_push(void **state)
+{
+    (void) state;   // unused
+
+    cch_encoder_t *enc = cch_encoder_create(0);
+    assert_non_null(enc);
+
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    memset(data, 0, sizeof(data));
+
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_BCH, data, 4 * 64), -1);
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_PCH, data, 64), -1);
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_RCH, data, 2 * 64), -1);
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_SDCH, data, 100), -1);
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_SDCH, data,
+                (SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1) * 64), -1);
+
+    for (int i = 0; i < QUEUE_LEN; ++i) {
+        assert_int_equal(cch_encoder_push(enc, LOG_CH_SDCH, data, 64), 0);
+    }
+    assert_int_equal(cch_encoder_push(enc, LOG_CH_SDCH, data, 64), -1);
+    assert_int_equal(cch_encoder_pending(enc, LOG_CH_SDCH), QUEUE_LEN);
+
+    cch_encoder_destroy(enc);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_cch_encoder_placement),
+        unit_test(test_cch_encoder_push),
+    };
+
+    return run_tests(tests);
+}
@@ -38,10 +38,152 @@ static void test_pack_bits(void **state)
     }
 }
 
+static void mk_frame(frame_t *fr, int fn, const uint8_t *data)
+{
+    memset(fr, 0, sizeof(*fr));
+    fr->fr_type = FRAME_TYPE_DATA;
+    fr->data.data[0] = fn & 1;
+    fr->data.data[1] = fn >> 1;
+    for (int i = 0; i < 64; ++i) {
+        fr->data.data[2 + i] = (data[i / 8] >> (i % 8)) & 1;
+    }
+    fr->data_packed = pack64(fr->data.data + 2);
+}
+
+/// FCS is checked incrementally, including frame fixed by parity
+static void test_data_frame_check_fcs(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t data[] = {
+        0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+        0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+        0x00, 0x83, 0xf5, 0x00, 0x04, 0xdf, 0xa8, 0x26,
+    };
+    const int fns[] = { FN_01, FN_10, FN_10, FN_01 };
+
+    uint8_t parity[8];
+    for (int i = 0; i < 8; ++i) {
+        parity[i] = data[i] ^ data[8 + i] ^ data[16 + i];
+    }
+
+    for (int broken = -1; broken < 3; ++broken) {
+        data_frame_t *data_fr = data_frame_create();
+        assert_non_null(data_fr);
+
+        for (int fr_no = 0; fr_no < 4; ++fr_no) {
+            frame_t fr;
+            mk_frame(&fr, fns[fr_no], (fr_no < 3) ? data + 8*fr_no : parity);
+            if (fr_no == broken) {
+                fr.broken = 1;
+                fr.data_packed ^= 0x9249249249249249ULL;
+            }
+            const int r = data_frame_push_frame(data_fr, &fr);
+            assert_int_equal((fr_no == 3) ? 1 : 0, r);
+        }
+
+        assert_int_equal(4, data_frame_blocks(data_fr));
+        assert_true(data_frame_check_fcs(data_fr));
+
+        uint8_t res[SYS_PAR_N200_BYTES_MAX];
+        assert_int_equal(8*sizeof(data), data_frame_get_bytes(data_fr, res));
+        assert_memory_equal(data, res, sizeof(data));
+
+        data_frame_destroy(data_fr);
+    }
+
+    // first data bit is not covered by parity check
+    for (int bit = 0; bit < 2; ++bit) {
+        data_frame_t *data_fr = data_frame_create();
+        assert_non_null(data_fr);
+
+        for (int fr_no = 0; fr_no < 4; ++fr_no) {
+            frame_t fr;
+            mk_frame(&fr, fns[fr_no], (fr_no < 3) ? data + 8*fr_no : parity);
+            if (fr_no == 3) {
+                fr.data_packed ^= 1ULL << (5 * bit);
+            }
+            const int r = data_frame_push_frame(data_fr, &fr);
+            assert_int_equal((fr_no < 3) ? 0 : (bit ? -1 : 1), r);
+        }
+
+        data_frame_destroy(data_fr);
+    }
+
+    // parity frame is not part of data
+    {
+        data_frame_t *data_fr = data_frame_create();
+        assert_non_null(data_fr);
+
+        frame_t fr;
+        mk_frame(&fr, FN_01, data);
+        data_frame_push_frame(data_fr, &fr);
+        mk_frame(&fr, FN_11, data + 8);
+        assert_int_equal(1, data_frame_push_frame(data_fr, &fr));
+        assert_false(data_frame_check_fcs(data_fr));
+
+        data_frame_destroy(data_fr);
+    }
+}
+
+/// built data frame is decoded back, parity block is added for 3+ blocks
+static void test_data_frame_build(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t data[] = {
+        0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+        0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+        0x00, 0x83, 0xf5, 0x00, 0x04, 0xdf, 0xa8, 0x26,
+    };
+    const int nfrs[] = { 1, 2, 4 };
+    const int fns[][4] = {
+        { FN_00, },
+        { FN_01, FN_11, },
+        { FN_01, FN_10, FN_10, FN_01, },
+    };
+
+    for (int nblocks = 1; nblocks <= 3; ++nblocks) {
+        frame_t frs[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
+        assert_int_equal(nfrs[nblocks - 1],
+                data_frame_build(frs, data, 64 * nblocks, 0));
+
+        data_frame_t *data_fr = data_frame_create();
+        assert_non_null(data_fr);
+
+        for (int fr_no = 0; fr_no < nfrs[nblocks - 1]; ++fr_no) {
+            const frame_t *fr = &frs[fr_no];
+            assert_int_equal(FRAME_TYPE_DATA, fr->fr_type);
+            assert_int_equal(fns[nblocks - 1][fr_no],
+                    fr->data.data[0] | (fr->data.data[1] << 1));
+            assert_true(fr->data_packed == pack64(fr->data.data + 2));
+
+            const int r = data_frame_push_frame(data_fr, fr);
+            assert_int_equal((fr_no == nfrs[nblocks - 1] - 1) ? 1 : 0, r);
+        }
+
+        // data frame with 3 blocks carries valid FCS
+        assert_int_equal(nblocks == 3, data_frame_check_fcs(data_fr));
+        uint8_t res[SYS_PAR_N200_BYTES_MAX];
+        assert_int_equal(64 * nblocks, data_frame_get_bytes(data_fr, res));
+        assert_memory_equal(data, res, 8 * nblocks);
+
+        data_frame_destroy(data_fr);
+    }
+
+    frame_t frs[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
+    assert_int_equal(-1, data_frame_build(frs, data, 0, 0));
+    assert_int_equal(-1, data_frame_build(frs, data, 100, 0));
+    assert_int_equal(-1, data_frame_build(frs, data,
+                64 * (SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1), 0));
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_pack_bits),
+        unit_test(test_data_frame_check_fcs),
+        unit_test(test_data_frame_build),
     };
 
     return run_tests(tests);
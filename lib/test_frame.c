@@ -5,6 +5,7 @@
 
 // include, we are testing static methods
 #include "frame.c"
+#include <tetrapol/misc.h>
 
 // the goal is just to make sure the function provides the same results
 // after refactorization
@@ -70,6 +71,51 @@ static void test_frame_deinterleave(void **state)
     assert_memory_equal(data_exp, fr_data_deint, FRAME_DATA_LEN);
 }
 
+// single pass tables must give the same result as separate steps
+static void test_frame_deinterleave_fused(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t fr_data[FRAME_DATA_LEN];
+    uint32_t x = 1;
+    for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+        x = x * 1103515245 + 12345;
+        fr_data[i] = (x >> 16) & 1;
+    }
+
+    const int bands[] = { TETRAPOL_BAND_VHF, TETRAPOL_BAND_UHF, };
+    const int fr_types[] = { FRAME_TYPE_VOICE, FRAME_TYPE_DATA, };
+    // all bits are inverted in the second pass
+    for (int b = 0; b < 4; ++b) {
+        if (b == 2) {
+            for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                fr_data[i] ^= 1;
+            }
+        }
+        for (int t = 0; t < 2; ++t) {
+            for (int scr = 0; scr < 128; ++scr) {
+                uint8_t fr_data_tmp[FRAME_DATA_LEN];
+                uint8_t deint_exp[FRAME_DATA_LEN];
+                uint8_t deint[FRAME_DATA_LEN];
+
+                frame_descramble(fr_data_tmp, fr_data, scr);
+                if (bands[b % 2] == TETRAPOL_BAND_UHF) {
+                    frame_diff_dec(fr_data_tmp);
+                }
+                frame_deinterleave1(deint_exp, fr_data_tmp, bands[b % 2]);
+                frame_deinterleave2(deint_exp, fr_data_tmp, bands[b % 2],
+                        fr_types[t]);
+
+                frame_deinterleave_fused(deint, fr_data, bands[b % 2], scr,
+                        fr_types[t], 0, FRAME_DATA_LEN1);
+                frame_deinterleave_fused(deint, fr_data, bands[b % 2], scr,
+                        fr_types[t], FRAME_DATA_LEN1, FRAME_DATA_LEN);
+                assert_memory_equal(deint_exp, deint, FRAME_DATA_LEN);
+            }
+        }
+    }
+}
+
 // the goal is just to make sure the function provides the same results
 // after refactorization
 static void test_frame_decoder_data_01(void **state)
@@ -150,6 +196,93 @@ static void test_frame_decoder_data_02(void **state)
     frame_decoder_destroy(fd);
 }
 
+// batch decoding must give the same results as decoding frame by frame
+static void test_frame_decoder_decode_batch(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t fr_data[FRAME_DATA_LEN] = {
+        0, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0,
+        0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 0,
+        0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0,
+        1, 1, 1, 1, 1, 0, 1, 1, 1, 0, 1, 0, 0, 1, 1, 1,
+        0, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0,
+        1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 1,
+        1, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+        0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0,
+        0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0,
+        1, 1, 0, 1, 1, 1, 0, 0
+    };
+
+    // frames with growing number of errors, from valid to broken
+    enum { N = 37 };
+    uint8_t data[N][FRAME_DATA_LEN];
+    const uint8_t *data_ptrs[N];
+    for (int i = 0; i < N; ++i) {
+        memcpy(data[i], fr_data, FRAME_DATA_LEN);
+        for (int j = 0; j < i; ++j) {
+            data[i][(j * 41 + i) % FRAME_DATA_LEN] ^= 1;
+        }
+        data_ptrs[i] = data[i];
+    }
+
+    const int fecs[] = {
+        TETRAPOL_FEC_ACCURATE, TETRAPOL_FEC_FAST, TETRAPOL_FEC_ADAPTIVE,
+    };
+    for (int scr = 66; scr <= 67; ++scr) {
+        int nok[3] = { 0, 0, 0 };
+        bool ok_accurate[N];
+        for (int f = 0; f < 3; ++f) {
+            frame_decoder_t *fd = frame_decoder_create(TETRAPOL_BAND_UHF, scr, FRAME_TYPE_AUTO);
+            assert_non_null(fd);
+            frame_decoder_set_fec(fd, fecs[f]);
+
+            frame_t frs[N];
+            frame_decoder_decode_batch(fd, frs, data_ptrs, N);
+            for (int i = 0; i < N; ++i) {
+                frame_t fr;
+                frame_decoder_decode(fd, &fr, data[i]);
+                assert_int_equal(fr.broken, frs[i].broken);
+                assert_int_equal(fr.bits_fixed, frs[i].bits_fixed);
+                assert_int_equal(fr.syndromes, frs[i].syndromes);
+                assert_int_equal(fr.fr_type, frs[i].fr_type);
+                assert_memory_equal(fr.blob_, frs[i].blob_, sizeof(frame_data_t));
+                nok[f] += !fr.broken;
+                if (fecs[f] == TETRAPOL_FEC_ACCURATE) {
+                    ok_accurate[i] = !fr.broken;
+                }
+                if (fecs[f] == TETRAPOL_FEC_ADAPTIVE && ok_accurate[i]) {
+                    assert_int_equal(0, fr.broken);
+                }
+            }
+            if (scr == 67) {
+                assert_int_equal(0, frs[0].broken);
+            }
+
+            frame_decoder_stats_t stats;
+            frame_decoder_get_stats(fd, &stats);
+            assert_int_equal(2*N, stats.frames);
+            if (fecs[f] == TETRAPOL_FEC_ACCURATE) {
+                assert_int_equal(0, stats.fast);
+                assert_int_equal(2*N - stats.screened, stats.viterbi);
+            } else {
+                assert_int_equal(2*N - stats.screened, stats.fast);
+                assert_int_equal(2*nok[f], stats.fast_ok + stats.viterbi_ok);
+            }
+            if (fecs[f] == TETRAPOL_FEC_FAST) {
+                assert_int_equal(0, stats.viterbi);
+            }
+
+            frame_decoder_destroy(fd);
+        }
+        // Viterbi decoder fixes more errors
+        assert_true(nok[1] <= nok[0]);
+        if (scr == 67) {
+            assert_true(nok[1] < nok[0]);
+        }
+    }
+}
+
 // the goal is just to make sure the function provides the same results
 // after refactorization
 static void test_frame_decoder_voice_01(void **state)
@@ -190,6 +323,171 @@ static void test_frame_decoder_voice_01(void **state)
     frame_decoder_destroy(fd);
 }
 
+// encoded data frame must be decoded unbroken
+static void test_frame_encode_decode_data(void **state)
+{
+    (void) state;   // unused
+
+    const int bands[] = { TETRAPOL_BAND_VHF, TETRAPOL_BAND_UHF, };
+    for (int b = 0; b < ARRAY_LEN(bands); ++b) {
+        for (int scr = 0; scr < 128; scr += 7) {
+            frame_t fr;
+            memset(&fr, 0, sizeof(fr));
+            fr.fr_type = FRAME_TYPE_DATA;
+            for (int i = 0; i < sizeof(fr.data.data); ++i) {
+                fr.data.data[i] = ((i + 1) * (scr + 3) / 5) & 1;
+            }
+            fr.data.asb[0] = scr & 1;
+            fr.data.asb[1] = 1;
+
+            frame_encoder_t *fe = frame_encoder_create(bands[b], scr,
+                    DIR_DOWNLINK);
+            assert_non_null(fe);
+            uint8_t fr_enc[FRAME_LEN / 8];
+            assert_int_equal(0, frame_encoder_encode(fe, fr_enc, &fr));
+            frame_encoder_destroy(fe);
+
+            // differential decoding, as done by physical channel
+            uint8_t fr_data[FRAME_DATA_LEN];
+            uint8_t bit = 0;
+            for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                const int j = FRAME_HDR_LEN + i;
+                bit ^= (fr_enc[j / 8] >> (j % 8)) & 1;
+                fr_data[i] = bit;
+            }
+
+            frame_decoder_t *fd = frame_decoder_create(bands[b], scr,
+                    FRAME_TYPE_DATA);
+            assert_non_null(fd);
+            frame_t fr_dec;
+            frame_decoder_decode(fd, &fr_dec, fr_data);
+            assert_int_equal(0, fr_dec.broken);
+            assert_int_equal(0, fr_dec.bits_fixed);
+            assert_int_equal(FRAME_TYPE_DATA, fr_dec.fr_type);
+            assert_memory_equal(fr.blob_, fr_dec.blob_, sizeof(frame_data_t));
+            frame_decoder_destroy(fd);
+        }
+    }
+}
+
+// batched SCR check must give the same results as decoding for each SCR
+static void test_frame_decoder_check_scr(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t fr_data[FRAME_DATA_LEN] = {
+        0, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0,
+        0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 0,
+        0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0,
+        1, 1, 1, 1, 1, 0, 1, 1, 1, 0, 1, 0, 0, 1, 1, 1,
+        0, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0,
+        1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 1,
+        1, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+        0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0,
+        0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0,
+        1, 1, 0, 1, 1, 1, 0, 0
+    };
+    const uint64_t scr_all[2] = { ~0ULL, ~0ULL };
+
+    const int bands[] = { TETRAPOL_BAND_VHF, TETRAPOL_BAND_UHF, };
+    for (int b = 0; b < ARRAY_LEN(bands); ++b) {
+        frame_decoder_t *fd = frame_decoder_create(bands[b], 5,
+                FRAME_TYPE_DATA);
+        assert_non_null(fd);
+
+        // valid frame first, than frames with up to 3 errors
+        for (int i = 0; i < FRAME_DATA_LEN; i += 7) {
+            uint8_t data[FRAME_DATA_LEN];
+            memcpy(data, fr_data, sizeof(data));
+            if (i) {
+                data[i] ^= 1;
+                data[(3 * i) % FRAME_DATA_LEN] ^= 1;
+                data[(5 * i + 1) % FRAME_DATA_LEN] ^= 1;
+            }
+
+            uint64_t scr_ok[2];
+            frame_decoder_check_scr(fd, scr_ok, scr_all, data);
+
+            uint64_t scr_ok_exp[2] = { 0, 0 };
+            frame_decoder_t *fd2 = frame_decoder_create(bands[b], 0,
+                    FRAME_TYPE_AUTO);
+            for (int scr = 0; scr < 128; ++scr) {
+                frame_t fr;
+                frame_decoder_set_scr(fd2, scr);
+                frame_decoder_decode(fd2, &fr, data);
+                if (!fr.broken) {
+                    scr_ok_exp[scr / 64] |= 1ULL << (scr % 64);
+                }
+            }
+            frame_decoder_destroy(fd2);
+
+            assert_memory_equal(scr_ok_exp, scr_ok, sizeof(scr_ok));
+            if (!i && bands[b] == TETRAPOL_BAND_UHF) {
+                assert_true(scr_ok[1] & (1ULL << (67 - 64)));
+            }
+        }
+
+        assert_int_equal(5, fd->scr);
+        assert_int_equal(FRAME_TYPE_DATA, fd->fr_type);
+        frame_decoder_destroy(fd);
+    }
+}
+
+// the right SCR must have the best score for data and voice frame
+static void test_frame_decoder_scr_score(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t fr_data[FRAME_DATA_LEN] = {
+        0, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0,
+        0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 0,
+        0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0,
+        1, 1, 1, 1, 1, 0, 1, 1, 1, 0, 1, 0, 0, 1, 1, 1,
+        0, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0,
+        1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 1,
+        1, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+        0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0,
+        0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0,
+        1, 1, 0, 1, 1, 1, 0, 0
+    };
+
+    const uint8_t fr_voice[FRAME_DATA_LEN] = {
+        0, 1, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 0,
+        1, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 1, 0, 1, 1, 0,
+        0, 1, 0, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 0,
+        0, 0, 0, 1, 0, 1, 1, 0, 1, 0, 0, 0, 1, 0, 0, 1,
+        0, 1, 1, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 1, 0,
+        1, 0, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0,
+        1, 1, 1, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 1,
+        1, 1, 0, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 1,
+        0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1, 1,
+        0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+    frame_decoder_t *fd = frame_decoder_create(TETRAPOL_BAND_UHF, 0,
+            FRAME_TYPE_AUTO);
+    assert_non_null(fd);
+
+    int scr_score[128];
+    frame_decoder_scr_score(fd, scr_score, fr_data);
+    assert_int_equal(SCR_CHK_COMMON + SCR_CHK_DATA, scr_score[67]);
+    for (int scr = 0; scr < 128; ++scr) {
+        if (scr != 67) {
+            assert_true(scr_score[scr] < 0);
+        }
+    }
+
+    frame_decoder_scr_score(fd, scr_score, fr_voice);
+    assert_int_equal(SCR_CHK_COMMON + SCR_CHK_VOICE, scr_score[118]);
+    for (int scr = 0; scr < 128; ++scr) {
+        if (scr != 118) {
+            assert_true(scr_score[scr] < scr_score[118]);
+        }
+    }
+
+    frame_decoder_destroy(fd);
+}
+
 static void test_mk_crc5(void **state)
 {
     (void) state;   // unused
@@ -219,6 +517,39 @@ static void test_mk_crc5(void **state)
     }
 }
 
+/// table driven CRC must match bit by bit computation
+static void test_crc_table(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t in[80];
+    for (int i = 0; i < sizeof(in); ++i) {
+        in[i] = (i * 7 + i / 5) % 3 == 0;
+    }
+
+    for (int len = 0; len <= sizeof(in); ++len) {
+        uint8_t crc5_exp = 0;
+        uint8_t crc3_exp = 0;
+        for (int i = 0; i < len; ++i) {
+            const int inv5 = in[i] ^ (crc5_exp >> 4);
+            crc5_exp = ((crc5_exp << 1) & 0x1f) ^ (inv5 ? 0x05 : 0);
+            const int inv3 = in[i] ^ (crc3_exp >> 2);
+            crc3_exp = ((crc3_exp << 1) & 0x07) ^ (inv3 ? 0x03 : 0);
+        }
+        crc3_exp ^= 0x07;
+
+        uint8_t crc[5];
+        mk_crc5(crc, in, len);
+        for (int i = 0; i < 5; ++i) {
+            assert_int_equal((crc5_exp >> (4 - i)) & 1, crc[i]);
+        }
+        mk_crc3(crc, in, len);
+        for (int i = 0; i < 3; ++i) {
+            assert_int_equal((crc3_exp >> (2 - i)) & 1, crc[i]);
+        }
+    }
+}
+
 // this test expects the correct frame_decode1 implementation
 static void test_frame_encode1(void **state)
 {
@@ -278,17 +609,109 @@ static void test_frame_encode2(void **state)
     assert_memory_equal(frame_dec2+26, frame_dec+26, 50);
 }
 
+static void test_frame_viterbi(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t frame_dec[26+50];
+    for (int i = 0; i < sizeof(frame_dec); ++i) {
+        frame_dec[i] = (0x2c6b9f13 >> (i % 31)) & 1;
+    }
+    uint8_t frame_enc[19];
+    memset(frame_enc, 0, sizeof(frame_enc));
+    frame_encode1(frame_enc, frame_dec);
+    frame_encode2(frame_enc, frame_dec);
+
+    uint8_t bits[152];
+    for (int i = 0; i < sizeof(bits); ++i) {
+        bits[i] = (frame_enc[i / 8] >> (i % 8)) & 1;
+    }
+
+    uint8_t dec[26+50];
+    assert_int_equal(frame_viterbi26(dec, bits), 0);
+    assert_int_equal(frame_viterbi50(dec + 26, bits + 2*26), 0);
+    assert_memory_equal(dec, frame_dec, sizeof(frame_dec));
+
+    // errors at both ends of tail-biting code
+    bits[0] ^= 1;
+    bits[2*26 - 1] ^= 1;
+    bits[2*26 + 1] ^= 1;
+    bits[2*26 + 47] ^= 1;
+    bits[151] ^= 1;
+    memset(dec, 0, sizeof(dec));
+    assert_int_equal(frame_viterbi26(dec, bits), 2);
+    assert_int_equal(frame_viterbi50(dec + 26, bits + 2*26), 3);
+    assert_memory_equal(dec, frame_dec, sizeof(frame_dec));
+}
+
+/// frames rejected by screen must be broken after Viterbi decoding too
+static void test_frame_screen1(void **state)
+{
+    (void) state;   // unused
+
+    assert_int_equal(0, frame_errs_min1(0));
+    assert_int_equal(1, frame_errs_min1(0x7));
+    assert_int_equal(1, frame_errs_min1(0x2000001));
+    assert_int_equal(2, frame_errs_min1(0xf));
+    assert_int_equal(3, frame_errs_min1(0x1041));
+    assert_int_equal(9, frame_errs_min1(0x3ffffff));
+
+    frame_decoder_t *fd = frame_decoder_create(TETRAPOL_BAND_UHF, 0,
+            FRAME_TYPE_DATA);
+    assert_non_null(fd);
+
+    uint64_t rnd_state = 1;
+    int nscreened = 0;
+    for (int n = 0; n < 20000; ++n) {
+        uint8_t bits[2*26];
+        for (int i = 0; i < sizeof(bits); ++i) {
+            const uint64_t x = xorshift64(&rnd_state);
+            // mostly noise, some frames with few errors only
+            bits[i] = (n % 4) ? (x & 1) : !(x % 13);
+        }
+
+        frame_t fr;
+        fr.broken = 0;
+        uint8_t dec[26];
+        const int f1 = frame_viterbi26(dec, bits);
+        uint8_t fr_errs[26];
+        if (frame_screen1(fd, &fr, fr_errs, bits)) {
+            assert_true(f1 >= 6);
+            assert_int_equal(1, fr.broken);
+            ++nscreened;
+        }
+    }
+
+    // most of noise is rejected
+    assert_true(nscreened > 20000 * 3 / 4 * 3 / 4);
+
+    frame_decoder_stats_t stats;
+    frame_decoder_get_stats(fd, &stats);
+    assert_int_equal(20000, stats.frames);
+    assert_int_equal(nscreened, stats.screened);
+
+    frame_decoder_destroy(fd);
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_frame_diff_dec),
         unit_test(test_frame_deinterleave),
+        unit_test(test_frame_deinterleave_fused),
         unit_test(test_frame_decoder_data_01),
         unit_test(test_frame_decoder_data_02),
+        unit_test(test_frame_decoder_decode_batch),
         unit_test(test_frame_decoder_voice_01),
+        unit_test(test_frame_encode_decode_data),
+        unit_test(test_frame_decoder_check_scr),
+        unit_test(test_frame_decoder_scr_score),
         unit_test(test_mk_crc5),
+        unit_test(test_crc_table),
         unit_test(test_frame_encode1),
         unit_test(test_frame_encode2),
+        unit_test(test_frame_viterbi),
+        unit_test(test_frame_screen1),
     };
 
     return run_tests(tests);
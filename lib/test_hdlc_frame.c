@@ -0,0 +1,134 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "hdlc_frame.c"
+
+/// HDLC data which fills all blocks of data frame
+#define DATA_LEN_MAX (8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX - 2 - 1 - 2)
+
+static void check_build_parse(const hdlc_frame_t *hdlc_fr)
+{
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    const int nbits = hdlc_frame_build(data, hdlc_fr);
+    const int nblocks = (hdlc_fr->nbits / 8 + 2 + 1 + 2 + 7) / 8;
+    assert_int_equal(nbits, 64 * nblocks);
+
+    hdlc_frame_t res;
+    assert_true(hdlc_frame_parse(&res, data, nbits));
+    assert_int_equal(res.addr.z, hdlc_fr->addr.z);
+    assert_int_equal(res.addr.y, hdlc_fr->addr.y);
+    assert_int_equal(res.addr.x, hdlc_fr->addr.x);
+    assert_int_equal(res.command.cmd, hdlc_fr->command.cmd);
+    assert_int_equal(command_build(&res.command),
+            command_build(&hdlc_fr->command));
+    // data are padded by zeros to whole blocks
+    assert_int_equal(res.nbits, nbits - 5*8);
+    assert_memory_equal(res.data, hdlc_fr->data, hdlc_fr->nbits / 8);
+    assert_true(cmpzero(&res.data[hdlc_fr->nbits / 8],
+                (res.nbits - hdlc_fr->nbits) / 8));
+
+    // any bit error breaks FCS
+    for (int i = 0; i < nbits; i += 7) {
+        data[i / 8] ^= 1 << (i % 8);
+        assert_false(hdlc_frame_parse(&res, data, nbits));
+        data[i / 8] ^= 1 << (i % 8);
+    }
+}
+
+static void test_hdlc_frame_build(void **state)
+{
+    (void) state;   // unused
+
+    command_t commands[8];
+    memset(commands, 0, sizeof(commands));
+    commands[0].cmd = COMMAND_INFORMATION;
+    commands[0].information.n_r = 5;
+    commands[0].information.n_s = 3;
+    commands[0].information.p_e = 1;
+    commands[1].cmd = COMMAND_SUPERVISION_RR;
+    commands[1].supervision.n_r = 6;
+    commands[1].supervision.p_e = 1;
+    commands[2].cmd = COMMAND_SUPERVISION_RNR;
+    commands[2].supervision.n_r = 1;
+    commands[3].cmd = COMMAND_DACH;
+    commands[3].dach_access.seq_no = 4;
+    commands[3].dach_access.retry = 1;
+    commands[4].cmd = COMMAND_UNNUMBERED_UI;
+    commands[4].unnumbered.p_e = 1;
+    commands[5].cmd = COMMAND_UNNUMBERED_UI_P0;
+    commands[5].unnumbered.ra = 1;
+    commands[6].cmd = COMMAND_UNNUMBERED_U_RR;
+    commands[6].unnumbered.response_format = 2;
+    commands[6].unnumbered.p_e = 1;
+    commands[7].cmd = COMMAND_UNNUMBERED_DISC;
+
+    const int lens[] = { 0, 3, 4, 11, 12, 30, DATA_LEN_MAX, };
+
+    hdlc_frame_t hdlc_fr;
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+    hdlc_fr.addr = (addr_t){ .z = 1, .y = 2, .x = 0x9ab, };
+    for (int i = 0; i < ARRAY_LEN(hdlc_fr.data); ++i) {
+        hdlc_fr.data[i] = 0x5c ^ i;
+    }
+
+    for (int c = 0; c < ARRAY_LEN(commands); ++c) {
+        hdlc_fr.command = commands[c];
+        for (int l = 0; l < ARRAY_LEN(lens); ++l) {
+            hdlc_fr.nbits = 8 * lens[l];
+            check_build_parse(&hdlc_fr);
+        }
+    }
+
+    hdlc_frame_t res;
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    hdlc_fr.command = commands[0];
+    hdlc_fr.nbits = 0;
+    assert_int_equal(hdlc_frame_build(data, &hdlc_fr), 64);
+    assert_true(hdlc_frame_parse(&res, data, 64));
+    assert_int_equal(res.command.information.n_r, 5);
+    assert_int_equal(res.command.information.n_s, 3);
+    assert_int_equal(res.command.information.p_e, 1);
+
+    hdlc_fr.nbits = 8 * (DATA_LEN_MAX + 1);
+    assert_int_equal(hdlc_frame_build(data, &hdlc_fr), -1);
+    hdlc_fr.nbits = 8 * 3 + 1;
+    assert_int_equal(hdlc_frame_build(data, &hdlc_fr), -1);
+}
+
+static void test_hdlc_frame_stuffing(void **state)
+{
+    (void) state;   // unused
+
+    for (int idx = 0; idx < HDLC_STUFFING_PATTERNS; ++idx) {
+        uint8_t data[8];
+        assert_int_equal(hdlc_frame_build_stuffing(data, idx), 64);
+
+        hdlc_frame_t hdlc_fr;
+        assert_false(hdlc_frame_parse(&hdlc_fr, data, 64));
+        assert_int_equal(hdlc_frame_stuffing_idx(&hdlc_fr), idx);
+    }
+
+    // valid frame is not stuffing
+    hdlc_frame_t hdlc_fr;
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+    hdlc_fr.addr = (addr_t){ .z = 0, .y = 7, .x = 0, };
+    hdlc_fr.command.cmd = COMMAND_UNNUMBERED_UI;
+    hdlc_fr.nbits = 3 * 8;
+    uint8_t data[8];
+    assert_int_equal(hdlc_frame_build(data, &hdlc_fr), 64);
+    assert_true(hdlc_frame_parse(&hdlc_fr, data, 64));
+    assert_int_equal(hdlc_frame_stuffing_idx(&hdlc_fr), -1);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_hdlc_frame_build),
+        unit_test(test_hdlc_frame_stuffing),
+    };
+
+    return run_tests(tests);
+}
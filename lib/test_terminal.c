@@ -0,0 +1,399 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "terminal.c"
+
+// link layer is replaced by counters, only terminal list is tested here
+struct link_priv_t {
+    int nframes;
+    int nglitches;
+    int nticks;
+    bool tick_required;
+    bool busy;
+    bool timer;     ///< timer is running
+    struct timeval tv;
+};
+
+// timeout of link timer in stub (us)
+static const int TIMEOUT = 100000;
+
+static int nlinks;
+
+link_t *link_create(tpol_t *tpol, int log_ch)
+{
+    ++nlinks;
+    return calloc(1, sizeof(link_t));
+}
+
+void link_destroy(link_t *link)
+{
+    if (link) {
+        --nlinks;
+    }
+    free(link);
+}
+
+int link_push_hdlc_frame(link_t *link, const hdlc_frame_t *hdlc_fr)
+{
+    ++link->nframes;
+    // frames with data starts timer, like DU segments
+    if (hdlc_fr->nbits) {
+        link->tick_required = true;
+    }
+    return 0;
+}
+
+void link_rx_glitch(link_t *link)
+{
+    ++link->nglitches;
+}
+
+bool link_tick(time_evt_t* te, link_t *link, struct timeval *deadline)
+{
+    ++link->nticks;
+    if (link->tick_required) {
+        link->tick_required = false;
+        link->timer = true;
+        link->tv = te->tv;
+    } else if (link->timer &&
+            timeval_abs_delta(&link->tv, &te->tv) >= TIMEOUT) {
+        link->timer = false;
+    }
+    if (!link->timer) {
+        return false;
+    }
+
+    deadline->tv_sec = link->tv.tv_sec;
+    deadline->tv_usec = link->tv.tv_usec + TIMEOUT;
+    return true;
+}
+
+bool link_tick_required(const link_t *link)
+{
+    return link->tick_required;
+}
+
+bool link_is_busy(const link_t *link)
+{
+    return link->busy;
+}
+
+size_t link_mem_size(void)
+{
+    return 1000;
+}
+
+static tpol_t tpol;
+
+static void addr_from_key(addr_t *addr, int key)
+{
+    addr->z = key >> 15;
+    addr->y = (key >> 12) & 0x7;
+    addr->x = key & 0xfff;
+}
+
+static void test_addr_key(void **state)
+{
+    (void) state;   // unused
+
+    for (int key = 0; key < 0x10000; key += 0x123) {
+        addr_t addr;
+        uint8_t buf[2];
+
+        addr_from_key(&addr, key);
+        addr_build(buf, &addr);
+        assert_int_equal(addr_key(&addr), key);
+        assert_int_equal(addr_key(&addr), buf[0] << 8 | buf[1]);
+    }
+}
+
+static void test_insert_lookup(void **state)
+{
+    (void) state;   // unused
+
+    terminal_list_t *tlist = terminal_list_create(&tpol, LOG_CH_SDCH);
+    assert_non_null(tlist);
+
+    // all addresses, table is resized many times
+    for (int key = 0; key < 0x10000; ++key) {
+        addr_t addr;
+        addr_from_key(&addr, key);
+        assert_null(terminal_list_lookup(tlist, &addr));
+        terminal_t *term = terminal_list_insert(tlist, &addr);
+        assert_non_null(term);
+        assert_true(terminal_list_insert(tlist, &addr) == term);
+    }
+    assert_int_equal(nlinks, 0x10000);
+
+    for (int key = 0; key < 0x10000; ++key) {
+        addr_t addr;
+        addr_from_key(&addr, key);
+        terminal_t *term = terminal_list_lookup(tlist, &addr);
+        assert_non_null(term);
+        assert_int_equal(addr_key(&term->addr), key);
+    }
+
+    terminal_list_destroy(tlist);
+    assert_int_equal(nlinks, 0);
+}
+
+static void test_erase(void **state)
+{
+    (void) state;   // unused
+
+    terminal_list_t *tlist = terminal_list_create(&tpol, LOG_CH_SDCH);
+    assert_non_null(tlist);
+
+    const int n = 5000;
+    for (int i = 0; i < n; ++i) {
+        addr_t addr;
+        addr_from_key(&addr, (i * 40503) & 0xffff);
+        assert_non_null(terminal_list_insert(tlist, &addr));
+    }
+
+    // erase every third one, erasing of unknown address is ignored
+    for (int i = 0; i < n; i += 3) {
+        addr_t addr;
+        addr_from_key(&addr, (i * 40503) & 0xffff);
+        terminal_list_erase(tlist, &addr);
+        terminal_list_erase(tlist, &addr);
+    }
+    assert_int_equal(nlinks, n - (n + 2) / 3);
+
+    hdlc_frame_t hdlc_fr;
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+    for (int i = 0; i < n; ++i) {
+        addr_from_key(&hdlc_fr.addr, (i * 40503) & 0xffff);
+        terminal_t *term = terminal_list_lookup(tlist, &hdlc_fr.addr);
+        if (i % 3) {
+            assert_non_null(term);
+            assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+            assert_int_equal(term->link->nframes, 1);
+        } else {
+            assert_null(term);
+        }
+    }
+
+    for (int i = 0; i < tlist->nterms; ++i) {
+        assert_int_equal(tlist->terms[i]->idx, i);
+    }
+
+    // erased addresses are pushed again, terminals are recreated
+    for (int i = 0; i < n; i += 3) {
+        addr_from_key(&hdlc_fr.addr, (i * 40503) & 0xffff);
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+    assert_int_equal(nlinks, n);
+    assert_int_equal(tlist->nterms, n);
+
+    terminal_list_destroy(tlist);
+    assert_int_equal(nlinks, 0);
+}
+
+static void tick(terminal_list_t *tlist, time_evt_t *te, int usec)
+{
+    te->tv.tv_usec += usec;
+    te->tv.tv_sec += te->tv.tv_usec / 1000000;
+    te->tv.tv_usec %= 1000000;
+    terminal_list_tick(tlist, te);
+}
+
+static void test_tick(void **state)
+{
+    (void) state;   // unused
+
+    terminal_list_t *tlist = terminal_list_create(&tpol, LOG_CH_SDCH);
+    assert_non_null(tlist);
+
+    time_evt_t te;
+    memset(&te, 0, sizeof(te));
+
+    // many idle terminals, only few of them with running timer
+    hdlc_frame_t hdlc_fr;
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+    const int n = 1000;
+    for (int i = 0; i < n; ++i) {
+        addr_from_key(&hdlc_fr.addr, i);
+        hdlc_fr.nbits = (i % 100) ? 0 : 8;
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+    assert_int_equal(tlist->heap_len, n / 100);
+
+    // the first tick starts timers, then terminals are ticked at deadline
+    for (int t = 0; t < 3; ++t) {
+        tick(tlist, &te, 20000);
+    }
+    assert_int_equal(tlist->heap_len, n / 100);
+    for (int i = 0; i < n; ++i) {
+        addr_t addr;
+        addr_from_key(&addr, i);
+        terminal_t *term = terminal_list_lookup(tlist, &addr);
+        assert_int_equal(term->link->nticks, (i % 100) ? 0 : 1);
+    }
+
+    // restart timer of one terminal
+    addr_from_key(&hdlc_fr.addr, 500);
+    hdlc_fr.nbits = 8;
+    assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    tick(tlist, &te, 20000);
+    tick(tlist, &te, 40000);
+    assert_int_equal(tlist->heap_len, 1);
+    assert_int_equal(addr_key(&tlist->heap[0]->addr), 500);
+    for (int i = 0; i < n; i += 100) {
+        addr_t addr;
+        addr_from_key(&addr, i);
+        terminal_t *term = terminal_list_lookup(tlist, &addr);
+        assert_int_equal(term->link->nticks, 2);
+        assert_int_equal(term->link->timer, i == 500);
+    }
+    tick(tlist, &te, 40000);
+    assert_int_equal(tlist->heap_len, 1);
+    tick(tlist, &te, 20000);
+    assert_int_equal(tlist->heap_len, 0);
+
+    // RX glitch is delivered with the next frame
+    tick(tlist, &te, 20000);
+    terminal_list_rx_glitch(tlist);
+    te.rx_glitch = true;
+    tick(tlist, &te, 20000);
+    hdlc_fr.nbits = 0;
+    for (int i = 0; i < n; i += 2) {
+        addr_from_key(&hdlc_fr.addr, i);
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+    for (int i = 0; i < n; ++i) {
+        addr_t addr;
+        addr_from_key(&addr, i);
+        terminal_t *term = terminal_list_lookup(tlist, &addr);
+        assert_int_equal(term->link->nglitches, (i % 2) ? 0 : 1);
+    }
+
+    terminal_list_destroy(tlist);
+    assert_int_equal(nlinks, 0);
+}
+
+static void test_idle(void **state)
+{
+    (void) state;   // unused
+
+    memset(&tpol, 0, sizeof(tpol));
+    tpol.cfg.terminal_idle_timeout = 2;
+    terminal_list_t *tlist = terminal_list_create(&tpol, LOG_CH_SDCH);
+    assert_non_null(tlist);
+
+    time_evt_t te;
+    memset(&te, 0, sizeof(te));
+    hdlc_frame_t hdlc_fr;
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+
+    const int n = 100;
+    for (int i = 0; i < n; ++i) {
+        addr_from_key(&hdlc_fr.addr, i);
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+    addr_from_key(&hdlc_fr.addr, 60);
+    terminal_list_lookup(tlist, &hdlc_fr.addr)->link->busy = true;
+    assert_int_equal(tpol.terminals, n);
+
+    // the first half is active later
+    tick(tlist, &te, 1000000);
+    for (int i = 0; i < n / 2; ++i) {
+        addr_from_key(&hdlc_fr.addr, i);
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+
+    // the second half expires, except busy one
+    tick(tlist, &te, 1000000);
+    assert_int_equal(tpol.terminals, n / 2 + 1);
+    assert_int_equal(tpol.terminals_idle, n / 2 - 1);
+    for (int i = 0; i < n; ++i) {
+        addr_t addr;
+        addr_from_key(&addr, i);
+        terminal_t *term = terminal_list_lookup(tlist, &addr);
+        if (i < n / 2 || i == 60) {
+            assert_non_null(term);
+        } else {
+            assert_null(term);
+        }
+    }
+
+    // busy terminal is checked again after timeout
+    addr_from_key(&hdlc_fr.addr, 60);
+    terminal_list_lookup(tlist, &hdlc_fr.addr)->link->busy = false;
+    tick(tlist, &te, 1000000);
+    assert_int_equal(tpol.terminals, 1);
+    tick(tlist, &te, 1000000);
+    assert_int_equal(tpol.terminals, 0);
+    assert_int_equal(tpol.terminals_idle, n);
+    assert_int_equal(tlist->nterms, 0);
+    assert_null(tlist->lru_head);
+    assert_null(tlist->lru_tail);
+
+    terminal_list_destroy(tlist);
+    assert_int_equal(nlinks, 0);
+    assert_int_equal(tpol.terminals_evicted, 0);
+}
+
+static void test_mem_limit(void **state)
+{
+    (void) state;   // unused
+
+    memset(&tpol, 0, sizeof(tpol));
+    tpol.cfg.terminal_mem_max = 100;
+    terminal_list_t *tlist = terminal_list_create(&tpol, LOG_CH_SDCH);
+    assert_non_null(tlist);
+
+    const int n = tlist->nterms_max;
+    assert_true(n > 10);
+    assert_true(n * (link_mem_size() + sizeof(terminal_t)) <= 100 * 1024);
+
+    hdlc_frame_t hdlc_fr;
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+    for (int i = 0; i < n; ++i) {
+        addr_from_key(&hdlc_fr.addr, i);
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+    // address 0 becomes the most recent
+    addr_from_key(&hdlc_fr.addr, 0);
+    assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    assert_int_equal(tpol.terminals_evicted, 0);
+
+    for (int i = n; i < n + 5; ++i) {
+        addr_from_key(&hdlc_fr.addr, i);
+        assert_int_equal(terminal_list_push_hdlc_frame(tlist, &hdlc_fr), 0);
+    }
+    assert_int_equal(tpol.terminals_evicted, 5);
+    assert_int_equal(tpol.terminals, n);
+    assert_int_equal(nlinks, n);
+
+    for (int i = 0; i < n + 5; ++i) {
+        addr_t addr;
+        addr_from_key(&addr, i);
+        if (i >= 1 && i <= 5) {
+            assert_null(terminal_list_lookup(tlist, &addr));
+        } else {
+            assert_non_null(terminal_list_lookup(tlist, &addr));
+        }
+    }
+
+    terminal_list_destroy(tlist);
+    assert_int_equal(nlinks, 0);
+    assert_int_equal(tpol.terminals, 0);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_addr_key),
+        unit_test(test_insert_lookup),
+        unit_test(test_erase),
+        unit_test(test_tick),
+        unit_test(test_idle),
+        unit_test(test_mem_limit),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,291 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "tpdu.c"
+
+// TSDUs passed to application are captured here
+static uint8_t tsdu_data[SYS_PAR_N452 * DU_SEG_DATA_MAX];
+static const uint8_t *tsdu_ptr;
+static int tsdu_len;
+static int tsdu_prio;
+static int tsdu_tsap_id;
+static int ntsdus;
+
+void tetrapol_evt_tsdu(tpol_t *tpol, const tpol_tsdu_t *tpol_tsdu)
+{
+    memcpy(tsdu_data, tpol_tsdu->data, tpol_tsdu->data_len);
+    tsdu_ptr = tpol_tsdu->data;
+    tsdu_len = tpol_tsdu->data_len;
+    tsdu_prio = tpol_tsdu->prio;
+    tsdu_tsap_id = tpol_tsdu->tsap_id;
+    ++ntsdus;
+}
+
+int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu,
+        tsdu_arena_t *arena)
+{
+    *tsdu = NULL;
+    return 0;
+}
+
+static const addr_t addr = { .z = 0, .y = 1, .x = 0x123, };
+
+static int build_du(hdlc_frame_t *hdlc_frs, uint8_t *tsdu, int len, int seg_ref)
+{
+    for (int i = 0; i < len; ++i) {
+        tsdu[i] = i * 7 + seg_ref;
+    }
+    const int n = tpdu_ui_build(hdlc_frs, SYS_PAR_N452, &addr, 1, 2,
+            seg_ref, tsdu, len);
+    assert_true(n > 1);
+
+    return n;
+}
+
+static void check_tsdu(const uint8_t *tsdu, int len)
+{
+    assert_int_equal(tsdu_len, len);
+    assert_memory_equal(tsdu_data, tsdu, len);
+}
+
+static void test_du_reassembly(void **state)
+{
+    (void) state;   // unused
+
+    tpol_t tpol;
+    memset(&tpol, 0, sizeof(tpol));
+    tpol.du_pool = tpdu_du_pool_create();
+    assert_non_null(tpol.du_pool);
+    tpdu_ui_t *tpdu = tpdu_ui_create(&tpol, FRAME_TYPE_DATA, LOG_CH_SDCH);
+    assert_non_null(tpdu);
+
+    hdlc_frame_t hdlc_frs[SYS_PAR_N452];
+    uint8_t tsdu[1000];
+    const int len = 300;
+    const int n = build_du(hdlc_frs, tsdu, len, 5);
+
+    // in order, data are not copied
+    ntsdus = 0;
+    for (int i = 0; i < n; ++i) {
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs[i], NULL), 0);
+        assert_int_equal(ntsdus, i == n - 1);
+        assert_int_equal(tpdu_ui_is_busy(tpdu), i != n - 1);
+    }
+    check_tsdu(tsdu, len);
+    assert_int_equal(tpol.du_pool->ndus, 1);
+    assert_true(tsdu_ptr == tpol.du_pool->free->data);
+
+    // out of order, with duplicates, two DUs interleaved
+    hdlc_frame_t hdlc_frs2[SYS_PAR_N452];
+    uint8_t tsdu2[1000];
+    const int len2 = 500;
+    const int n2 = build_du(hdlc_frs2, tsdu2, len2, 100);
+    ntsdus = 0;
+    for (int i = n - 1; i >= 0; --i) {
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs[i], NULL), 0);
+        if (i) {
+            // already received segment
+            assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs[n - 1], NULL), 0);
+        }
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs2[i], NULL), 0);
+    }
+    assert_int_equal(ntsdus, 1);
+    check_tsdu(tsdu, len);
+    for (int i = n; i < n2; ++i) {
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs2[i], NULL), 0);
+    }
+    assert_int_equal(ntsdus, 2);
+    check_tsdu(tsdu2, len2);
+    assert_int_equal(tpol.du_pool->ndus, 2);
+    assert_false(tpdu_ui_is_busy(tpdu));
+
+    tpdu_ui_destroy(tpdu);
+    tpdu_du_pool_destroy(tpol.du_pool);
+}
+
+static void test_du_expiry(void **state)
+{
+    (void) state;   // unused
+
+    tpol_t tpol;
+    memset(&tpol, 0, sizeof(tpol));
+    tpol.du_pool = tpdu_du_pool_create();
+    assert_non_null(tpol.du_pool);
+    tpdu_ui_t *tpdu = tpdu_ui_create(&tpol, FRAME_TYPE_DATA, LOG_CH_SDCH);
+    assert_non_null(tpdu);
+
+    hdlc_frame_t hdlc_frs[SYS_PAR_N452];
+    uint8_t tsdu[1000];
+    const int n = build_du(hdlc_frs, tsdu, 200, 127);
+
+    time_evt_t te;
+    memset(&te, 0, sizeof(te));
+    struct timeval deadline;
+
+    ntsdus = 0;
+    assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs[0], NULL), 0);
+    assert_true(tpdu_du_tick_required(tpdu));
+    te.tv.tv_sec = 1;
+    assert_true(tpdu_du_tick(&te, tpdu, &deadline));
+    assert_false(tpdu_du_tick_required(tpdu));
+    assert_int_equal(deadline.tv_sec, 1 + SYS_PAR_T454 / 1000000);
+    assert_int_equal(deadline.tv_usec, 0);
+
+    te.tv = deadline;
+    assert_false(tpdu_du_tick(&te, tpdu, &deadline));
+    assert_false(tpdu_ui_is_busy(tpdu));
+
+    // segments of expired DU are lost
+    for (int i = 1; i < n; ++i) {
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs[i], NULL), 0);
+    }
+    assert_int_equal(ntsdus, 0);
+    assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_frs[0], NULL), 0);
+    assert_int_equal(ntsdus, 1);
+    check_tsdu(tsdu, 200);
+
+    tpdu_ui_destroy(tpdu);
+    tpdu_du_pool_destroy(tpol.du_pool);
+}
+
+/// pass HDLC frame through hdlc_frame_build() and hdlc_frame_parse()
+static void hdlc_build_parse(hdlc_frame_t *res, const hdlc_frame_t *hdlc_fr)
+{
+    uint8_t data[8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX];
+    const int nbits = hdlc_frame_build(data, hdlc_fr);
+    assert_true(nbits > 0);
+    assert_true(hdlc_frame_parse(res, data, nbits));
+}
+
+/// built DUs are received back, segmentation boundaries are checked
+static void test_du_build(void **state)
+{
+    (void) state;   // unused
+
+    tpol_t tpol;
+    memset(&tpol, 0, sizeof(tpol));
+    tpol.du_pool = tpdu_du_pool_create();
+    assert_non_null(tpol.du_pool);
+    tpdu_ui_t *tpdu = tpdu_ui_create(&tpol, FRAME_TYPE_DATA, LOG_CH_SDCH);
+    assert_non_null(tpdu);
+
+    const int seg_len = HDLC_DATA_LEN_MAX - 3;
+    const int lens[] = {
+        1, 2, 3, HDLC_DATA_LEN_MAX - 2, HDLC_DATA_LEN_MAX - 1,
+        2 * seg_len - 1, 2 * seg_len, 2 * seg_len + 1,
+        SYS_PAR_N452 * seg_len - 1,
+    };
+
+    static hdlc_frame_t hdlc_frs[SYS_PAR_N452];
+    static uint8_t tsdu[SYS_PAR_N452 * DU_SEG_DATA_MAX];
+    for (int l = 0; l < ARRAY_LEN(lens); ++l) {
+        const int len = lens[l];
+        for (int i = 0; i < len; ++i) {
+            tsdu[i] = i * 13 + l;
+        }
+        const int n = tpdu_ui_build(hdlc_frs, SYS_PAR_N452, &addr, 2, 9,
+                l, tsdu, len);
+        assert_int_equal(n, (len <= HDLC_DATA_LEN_MAX - 2) ?
+                1 : len / seg_len + 1);
+
+        ntsdus = 0;
+        for (int i = 0; i < n; ++i) {
+            hdlc_frame_t hdlc_fr;
+            hdlc_build_parse(&hdlc_fr, &hdlc_frs[i]);
+            assert_int_equal(hdlc_fr.command.cmd, COMMAND_UNNUMBERED_UI);
+            assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr, NULL), 0);
+            assert_int_equal(ntsdus, i == n - 1);
+        }
+        assert_int_equal(tsdu_prio, 2);
+        assert_int_equal(tsdu_tsap_id, 9);
+        if (len <= 2) {
+            // single block DU has no length, TSDU is padded
+            assert_int_equal(tsdu_len, 2);
+            assert_memory_equal(tsdu_data, tsdu, len);
+        } else {
+            check_tsdu(tsdu, len);
+        }
+        assert_false(tpdu_ui_is_busy(tpdu));
+    }
+
+    assert_int_equal(tpdu_ui_build(hdlc_frs, SYS_PAR_N452, &addr, 0, 0, 0,
+                tsdu, SYS_PAR_N452 * seg_len), -1);
+    assert_int_equal(tpdu_ui_build(hdlc_frs, 2, &addr, 0, 0, 0,
+                tsdu, 2 * seg_len), -1);
+
+    tpdu_ui_destroy(tpdu);
+    tpdu_du_pool_destroy(tpol.du_pool);
+}
+
+/// connection oriented TPDUs are received back
+static void test_tpdu_build(void **state)
+{
+    (void) state;   // unused
+
+    tpol_t tpol;
+    memset(&tpol, 0, sizeof(tpol));
+    tpdu_t *tpdu = tpdu_create(&tpol, LOG_CH_SDCH);
+    assert_non_null(tpdu);
+
+    const int seg_len = HDLC_DATA_LEN_MAX - 2;
+    const struct {
+        int code;
+        int len;
+    } tpdus[] = {
+        { TPDU_CODE_FCR, 300, },
+        { TPDU_CODE_DT, 10, },
+        { TPDU_CODE_DT, 2 * seg_len, },
+        { TPDU_CODE_DTE, seg_len - 1, },
+        { TPDU_CODE_DR, 0, },
+    };
+
+    hdlc_frame_t hdlc_frs[SYS_PAR_N452];
+    uint8_t tsdu[1000];
+    for (int t = 0; t < ARRAY_LEN(tpdus); ++t) {
+        const int len = tpdus[t].len;
+        for (int i = 0; i < len; ++i) {
+            tsdu[i] = i * 5 + t;
+        }
+        const int n = tpdu_build(hdlc_frs, SYS_PAR_N452, &addr, tpdus[t].code,
+                3, tsdu, len);
+        assert_int_equal(n, len / seg_len + 1);
+
+        ntsdus = 0;
+        for (int i = 0; i < n; ++i) {
+            hdlc_frame_t hdlc_fr;
+            hdlc_build_parse(&hdlc_fr, &hdlc_frs[i]);
+            assert_int_equal(hdlc_fr.command.cmd, COMMAND_INFORMATION);
+            assert_int_equal(tpdu_push_hdlc_frame(tpdu, &hdlc_fr), 0);
+            assert_int_equal(ntsdus, len && i == n - 1);
+            assert_int_equal(tpdu_is_busy(tpdu), i != n - 1);
+        }
+        if (len) {
+            check_tsdu(tsdu, len);
+        }
+    }
+    // connection is released by DR
+    assert_int_equal(tpdu->conns[3].state, CONNECTION_STATE_NC);
+
+    assert_int_equal(tpdu_build(hdlc_frs, SYS_PAR_N452, &addr, TPDU_CODE_CR,
+                3, tsdu, 10), -1);
+    // DR can not be segmented
+    assert_int_equal(tpdu_build(hdlc_frs, SYS_PAR_N452, &addr, TPDU_CODE_DR,
+                3, tsdu, seg_len), -1);
+
+    tpdu_destroy(tpdu);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_du_reassembly),
+        unit_test(test_du_expiry),
+        unit_test(test_du_build),
+        unit_test(test_tpdu_build),
+    };
+
+    return run_tests(tests);
+}
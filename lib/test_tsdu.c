@@ -0,0 +1,531 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "tsdu.c"
+
+#include <tetrapol/tsdu_encode.h>
+#include <tetrapol/tsdu_view.h>
+
+static const uint8_t group_list[] = {
+    D_GROUP_LIST, 0x20, 0x00,
+    0x82, 0x01, 0x20, 0x02, 0x30,   // 2x emergency
+    0x41, 0x05, 0x00, 0x01, 0x23,   // 1x talk group
+    0x81, 0x03, 0x40,               // 1x emergency
+    0xc1, 0x07, 0x3a, 0xbc, 0x14, 0x56, // 1x open
+    0x00,
+};
+
+static void test_arena_alloc(void **state)
+{
+    (void) state;
+
+    tsdu_arena_t *arena = tsdu_arena_create();
+    assert_non_null(arena);
+
+    uint8_t *p1 = arena_alloc(arena, 10);
+    assert_non_null(p1);
+    assert_int_equal((uintptr_t)p1 % ARENA_ALIGN, 0);
+    memset(p1, 0x5a, 10);
+
+    // last block grows in place
+    uint8_t *p2 = arena_realloc(arena, p1, 100);
+    assert_true(p2 == p1);
+
+    uint8_t *p3 = arena_alloc(arena, 1);
+    assert_int_equal((uintptr_t)p3 % ARENA_ALIGN, 0);
+    assert_true(p3 >= p2 + 100);
+
+    // other blocks are copied
+    uint8_t *p4 = arena_realloc(arena, p2, 200);
+    assert_true(p4 != p2);
+    for (int i = 0; i < 10; ++i) {
+        assert_int_equal(p4[i], 0x5a);
+    }
+
+    // chunk is full, another one is allocated
+    assert_non_null(arena_alloc(arena, ARENA_CHUNK_SIZE_MIN));
+    assert_non_null(arena->chunk->prev);
+    const size_t size = arena->size;
+    assert_true(size > ARENA_CHUNK_SIZE_MIN);
+
+    // reset merges chunks
+    tsdu_arena_reset(arena);
+    assert_null(arena->chunk->prev);
+    assert_int_equal(arena->chunk->size, size);
+    assert_int_equal(arena->chunk->used, 0);
+    assert_true(arena_alloc(arena, ARENA_CHUNK_SIZE_MIN) ==
+            (void *)((arena_block_t *)arena->chunk->data + 1));
+    assert_null(arena->chunk->prev);
+
+    tsdu_arena_destroy(arena);
+}
+
+static void test_decode_arena(void **state)
+{
+    (void) state;
+
+    tsdu_arena_t *arena = tsdu_arena_create();
+    assert_non_null(arena);
+
+    for (int i = 0; i < 2; ++i) {
+        tsdu_t *tsdu = NULL;
+        assert_int_equal(tsdu_decode(group_list, sizeof(group_list), &tsdu, arena), 0);
+        assert_non_null(tsdu);
+        assert_true(tsdu->arena == arena);
+        assert_int_equal(tsdu->codop, D_GROUP_LIST);
+
+        const tsdu_d_group_list_t *gl = (const tsdu_d_group_list_t *)tsdu;
+        assert_int_equal(gl->nemergency, 3);
+        for (int j = 0; j < 3; ++j) {
+            assert_int_equal(gl->emergency[j].cell_id.bs_id, j + 1);
+            assert_int_equal(gl->emergency[j].cell_id.rsw_id, j + 2);
+        }
+        assert_int_equal(gl->ngroup, 1);
+        assert_int_equal(gl->group[0].coverage_id, 5);
+        assert_int_equal(gl->group[0].neighbouring_cell, 0x123);
+        assert_int_equal(gl->nopen, 1);
+        assert_int_equal(gl->open[0].group_id, 0xabc);
+
+        // memory is owned by arena
+        tsdu_destroy(tsdu);
+        tsdu_arena_reset(arena);
+    }
+
+    tsdu_arena_destroy(arena);
+}
+
+static void test_view_group_list(void **state)
+{
+    (void) state;
+
+    tsdu_t *tsdu = NULL;
+    assert_int_equal(tsdu_decode(group_list, sizeof(group_list), &tsdu, NULL), 0);
+    assert_non_null(tsdu);
+    const tsdu_d_group_list_t *gl = (const tsdu_d_group_list_t *)tsdu;
+
+    tsdu_view_t view;
+    assert_true(tsdu_view_init(&view, group_list, sizeof(group_list)));
+    assert_int_equal(view.codop, D_GROUP_LIST);
+    assert_int_equal(tsdu_view_reference_list(&view), gl->reference_list._data);
+    assert_int_equal(tsdu_view_group_id(&view), -1);
+
+    assert_int_equal(tsdu_view_group_list_len(&view, TYPE_NB_TYPE_EMERGENCY),
+            gl->nemergency);
+    for (int i = 0; i < gl->nemergency; ++i) {
+        tsdu_d_group_list_emergency_t e;
+        assert_true(tsdu_view_group_list_emergency(&view, i, &e));
+        assert_int_equal(e.cell_id.bs_id, gl->emergency[i].cell_id.bs_id);
+        assert_int_equal(e.cell_id.rsw_id, gl->emergency[i].cell_id.rsw_id);
+    }
+
+    assert_int_equal(tsdu_view_group_list_len(&view, TYPE_NB_TYPE_OPEN),
+            gl->nopen);
+    tsdu_d_group_list_open_t o;
+    assert_true(tsdu_view_group_list_open(&view, 0, &o));
+    assert_int_equal(o.coverage_id, gl->open[0].coverage_id);
+    assert_int_equal(o.call_priority, gl->open[0].call_priority);
+    assert_int_equal(o.group_id, gl->open[0].group_id);
+    assert_int_equal(o.och_parameters.mbn, gl->open[0].och_parameters.mbn);
+    assert_int_equal(o.neighbouring_cell, gl->open[0].neighbouring_cell);
+    assert_false(tsdu_view_group_list_open(&view, 1, &o));
+
+    assert_int_equal(tsdu_view_group_list_len(&view, TYPE_NB_TYPE_TALK_GROUP),
+            gl->ngroup);
+    tsdu_d_group_list_talk_group_t g;
+    assert_true(tsdu_view_group_list_talk_group(&view, 0, &g));
+    assert_int_equal(g.coverage_id, gl->group[0].coverage_id);
+    assert_int_equal(g.neighbouring_cell, gl->group[0].neighbouring_cell);
+
+    // truncated entry is not available
+    tsdu_view_init(&view, group_list, 15);
+    assert_int_equal(tsdu_view_group_list_len(&view, TYPE_NB_TYPE_EMERGENCY), 2);
+
+    tsdu_destroy(tsdu);
+}
+
+static void test_view_fields(void **state)
+{
+    (void) state;
+
+    tsdu_d_registration_ack_t reg_ack = {
+        .base.codop = D_REGISTRATION_ACK,
+        .host_adr.cna = ADDRESS_CNA_RFSI,
+        .host_adr.len = 9,
+        .group_id = 0x345,
+    };
+    for (int i = 0; i < 9; ++i) {
+        reg_ack.host_adr.rfsi.addr[i] = i + 1;
+    }
+    const tsdu_d_group_activation_t grp_act = {
+        .base.codop = D_GROUP_ACTIVATION,
+        .activation_mode.type = ACTIVATION_MODE_TYPE_WITH_TONE,
+        .group_id = 0x123,
+        .coverage_id = 7,
+        .channel_id = 0x765,
+        .key_reference._data = 0x21,
+    };
+
+    uint8_t data[64];
+    int len = tsdu_encode(&reg_ack.base, data, sizeof(data));
+    assert_true(len > 0);
+
+    tsdu_view_t view;
+    tsdu_view_init(&view, data, len);
+    assert_int_equal(tsdu_view_group_id(&view), reg_ack.group_id);
+    assert_int_equal(tsdu_view_channel_id(&view), -1);
+    address_t adr;
+    assert_true(tsdu_view_host_adr(&view, &adr));
+    assert_int_equal(adr.cna, ADDRESS_CNA_RFSI);
+    for (int i = 0; i < 9; ++i) {
+        assert_int_equal(adr.rfsi.addr[i], i + 1);
+    }
+    assert_false(tsdu_view_calling_adr(&view, &adr));
+
+    // address does not fit into truncated data
+    tsdu_view_init(&view, data, 8);
+    assert_false(tsdu_view_host_adr(&view, &adr));
+    assert_int_equal(tsdu_view_group_id(&view), -1);
+
+    len = tsdu_encode(&grp_act.base, data, sizeof(data));
+    assert_true(len > 0);
+    tsdu_view_init(&view, data, len);
+    assert_int_equal(view.codop, D_GROUP_ACTIVATION);
+    assert_int_equal(tsdu_view_group_id(&view), grp_act.group_id);
+    assert_int_equal(tsdu_view_coverage_id(&view), grp_act.coverage_id);
+    assert_int_equal(tsdu_view_channel_id(&view), grp_act.channel_id);
+    assert_int_equal(tsdu_view_key_reference(&view),
+            grp_act.key_reference._data);
+    assert_int_equal(tsdu_view_activation_mode(&view) & 0x3,
+            ACTIVATION_MODE_TYPE_WITH_TONE);
+    assert_int_equal(tsdu_view_call_priority(&view), -1);
+}
+
+/**
+  Encode TSDU, decode it by tsdu_decode() and check that decoded TSDU is
+  encoded into the same data.
+  */
+static tsdu_t *encode_decode(const tsdu_t *tsdu, int len)
+{
+    uint8_t data[64];
+    assert_int_equal(tsdu_encode(tsdu, data, sizeof(data)), len);
+    assert_int_equal(data[0], tsdu->codop);
+
+    tsdu_t *res = NULL;
+    assert_int_equal(tsdu_decode(data, len, &res, NULL), 0);
+    assert_non_null(res);
+    assert_int_equal(res->codop, tsdu->codop);
+
+    uint8_t data2[64];
+    assert_int_equal(tsdu_encode(res, data2, sizeof(data2)), len);
+    assert_memory_equal(data, data2, len);
+
+    return res;
+}
+
+static void test_encode_decode(void **state)
+{
+    (void) state;
+
+    tsdu_d_authentication_t auth = {
+        .base.codop = D_AUTHENTICATION,
+        .key_reference._data = 0x0b,
+    };
+    for (int i = 0; i < ARRAY_LEN(auth.valid_rt); ++i) {
+        auth.valid_rt[i] = 0xa0 + i;
+    }
+    tsdu_d_authentication_t *auth2 =
+        (tsdu_d_authentication_t *)encode_decode(&auth.base, 16);
+    assert_int_equal(auth2->key_reference._data, auth.key_reference._data);
+    assert_memory_equal(auth2->valid_rt, auth.valid_rt, sizeof(auth.valid_rt));
+    tsdu_destroy(&auth2->base);
+
+    const tsdu_d_connect_dch_t dch = {
+        .base.codop = D_CONNECT_DCH,
+        .dch_low_layer = 0x12,
+        .channel_id = 0xabc,
+        .u_ch_scrambling = 0x34,
+        .d_ch_scrambling = 0x56,
+    };
+    tsdu_d_connect_dch_t *dch2 =
+        (tsdu_d_connect_dch_t *)encode_decode(&dch.base, 6);
+    assert_int_equal(dch2->channel_id, dch.channel_id);
+    assert_int_equal(dch2->d_ch_scrambling, dch.d_ch_scrambling);
+    tsdu_destroy(&dch2->base);
+
+    union {
+        tsdu_d_explicit_short_data_t tsdu;
+        uint8_t buf[sizeof(tsdu_d_explicit_short_data_t) + 20];
+    } esd;
+    esd.tsdu.base.codop = D_EXPLICIT_SHORT_DATA;
+    esd.tsdu.len = 20;
+    for (int i = 0; i < esd.tsdu.len; ++i) {
+        esd.tsdu.data[i] = 3 * i;
+    }
+    tsdu_d_explicit_short_data_t *esd2 =
+        (tsdu_d_explicit_short_data_t *)encode_decode(&esd.tsdu.base, 21);
+    assert_int_equal(esd2->len, esd.tsdu.len);
+    assert_memory_equal(esd2->data, esd.tsdu.data, esd.tsdu.len);
+    tsdu_destroy(&esd2->base);
+
+    tsdu_d_group_activation_t act = {
+        .base.codop = D_GROUP_ACTIVATION,
+        .activation_mode.hook = 1,
+        .activation_mode.type = ACTIVATION_MODE_TYPE_RING,
+        .group_id = 0x123,
+        .coverage_id = 7,
+        .channel_id = 0x765,
+        .u_ch_scrambling = 0x11,
+        .d_ch_scrambling = 0x22,
+        .key_reference._data = 0x21,
+    };
+    tsdu_d_group_activation_t *act2 =
+        (tsdu_d_group_activation_t *)encode_decode(&act.base, 9);
+    assert_false(act2->has_addr_tti);
+    assert_int_equal(act2->activation_mode.hook, act.activation_mode.hook);
+    assert_int_equal(act2->activation_mode.type, act.activation_mode.type);
+    assert_int_equal(act2->group_id, act.group_id);
+    assert_int_equal(act2->channel_id, act.channel_id);
+    tsdu_destroy(&act2->base);
+
+    act.has_addr_tti = true;
+    act.addr_tti = (addr_t){ .z = 0, .y = 1, .x = 0x456, };
+    act2 = (tsdu_d_group_activation_t *)encode_decode(&act.base, 12);
+    assert_true(act2->has_addr_tti);
+    assert_int_equal(act2->addr_tti.y, act.addr_tti.y);
+    assert_int_equal(act2->addr_tti.x, act.addr_tti.x);
+    tsdu_destroy(&act2->base);
+
+    const tsdu_d_group_idle_t idle = {
+        .base.codop = D_GROUP_IDLE,
+        .cause = 0x33,
+    };
+    tsdu_d_group_idle_t *idle2 =
+        (tsdu_d_group_idle_t *)encode_decode(&idle.base, 2);
+    assert_int_equal(idle2->cause, idle.cause);
+    tsdu_destroy(&idle2->base);
+
+    tsdu_d_registration_ack_t ack = {
+        .base.codop = D_REGISTRATION_ACK,
+        .complete_reg = 1,
+        .rt_min_activity = 10,
+        .rt_status._data = 0x42,
+        .host_adr.cna = ADDRESS_CNA_RFSI,
+        .host_adr.len = 9,
+        .rt_min_registration = 30,
+        .tlr_value = 20,
+        .rt_data_info._data = 0x81,
+        .group_id = 0xfed,
+    };
+    for (int i = 0; i < 9; ++i) {
+        ack.host_adr.rfsi.addr[i] = i + 1;
+    }
+    tsdu_d_registration_ack_t *ack2 =
+        (tsdu_d_registration_ack_t *)encode_decode(&ack.base, 14);
+    assert_false(ack2->has_coverage_id);
+    assert_int_equal(ack2->nb_subscription, 0);
+    assert_int_equal(ack2->host_adr.cna, ADDRESS_CNA_RFSI);
+    assert_memory_equal(ack2->host_adr.rfsi.addr, ack.host_adr.rfsi.addr, 9);
+    assert_int_equal(ack2->group_id, ack.group_id);
+    tsdu_destroy(&ack2->base);
+
+    ack.has_coverage_id = true;
+    ack.coverage_id = 9;
+    ack.iei_ddch_sub = 0x5a;
+    ack.nb_subscription = 2;
+    for (int i = 0; i < ack.nb_subscription; ++i) {
+        ack.sub_appli_num[i] = i + 1;
+        ack.subscription_info[i] = i + 2;
+        ack.cause[i] = 0x10 + i;
+        ack.ddch_number[i] = i + 3;
+        ack.access_profile[i] = i + 4;
+        ack.first_radio_slot[i] = 0x1234 + i;
+    }
+    ack2 = (tsdu_d_registration_ack_t *)encode_decode(&ack.base, 28);
+    assert_true(ack2->has_coverage_id);
+    assert_int_equal(ack2->coverage_id, ack.coverage_id);
+    assert_int_equal(ack2->nb_subscription, ack.nb_subscription);
+    assert_int_equal(ack2->first_radio_slot[1], ack.first_radio_slot[1]);
+    tsdu_destroy(&ack2->base);
+
+    tsdu_d_registration_nak_t nak = {
+        .base.codop = D_REGISTRATION_NAK,
+        .cause = 0x44,
+        .host_adr = ack.host_adr,
+        .bn_id = 0x55,
+        .cell_id.bs_id = 0x2a,
+        .cell_id.rsw_id = 0x5,
+    };
+    tsdu_d_registration_nak_t *nak2 =
+        (tsdu_d_registration_nak_t *)encode_decode(&nak.base, 10);
+    assert_int_equal(nak2->cause, nak.cause);
+    assert_int_equal(nak2->cell_id.bs_id, nak.cell_id.bs_id);
+    assert_int_equal(nak2->cell_id.rsw_id, nak.cell_id.rsw_id);
+    tsdu_destroy(&nak2->base);
+
+    tsdu_d_system_info_t si = {
+        .base.codop = D_SYSTEM_INFO,
+        .cell_state._data = 0x1a,
+        .cell_config._data = 0x21,
+        .country_code = 0x32,
+        .system_id._data = 0x43,
+        .loc_area_id._data = 0x54,
+        .bn_id = 0x65,
+        .cell_id.bs_id = 0x13,
+        .cell_id.rsw_id = 0x7,
+        .cell_bn._data = 0x987,
+        .u_ch_scrambling = 0x76,
+        .cell_radio_param.tx_max = 5,
+        .cell_radio_param.radio_link_timeout = 17,
+        .cell_radio_param.pwr_tx_adjust = 9,
+        .cell_radio_param.rx_lev_access = 3,
+        .system_time = 0x87,
+        .cell_access._data = 0x98,
+        .superframe_cpt = 0xcba,
+    };
+    tsdu_d_system_info_t *si2 =
+        (tsdu_d_system_info_t *)encode_decode(&si.base, 17);
+    assert_int_equal(si2->cell_state.mode, CELL_STATE_MODE_NORMAL);
+    assert_int_equal(si2->cell_id.bs_id, si.cell_id.bs_id);
+    assert_int_equal(si2->cell_bn._data, si.cell_bn._data);
+    assert_int_equal(si2->superframe_cpt, si.superframe_cpt);
+    tsdu_destroy(&si2->base);
+
+    // cell disconnected from network
+    si.cell_state.mode = CELL_STATE_MODE_DISC_BSC;
+    si.band = 0xa;
+    si.channel_id = 0x3c5;
+    si2 = (tsdu_d_system_info_t *)encode_decode(&si.base, 9);
+    assert_int_equal(si2->cell_state.mode, CELL_STATE_MODE_DISC_BSC);
+    assert_int_equal(si2->cell_id.bs_id, si.cell_id.bs_id);
+    assert_int_equal(si2->cell_id.rsw_id, si.cell_id.rsw_id);
+    assert_int_equal(si2->band, si.band);
+    assert_int_equal(si2->channel_id, si.channel_id);
+    tsdu_destroy(&si2->base);
+
+    uint8_t data[64];
+    assert_int_equal(tsdu_encode(&auth.base, data, 15), -1);
+    tsdu_t unsupported = { .codop = D_GROUP_LIST, };
+    assert_int_equal(tsdu_encode(&unsupported, data, sizeof(data)), -1);
+}
+
+/// tsdu_decode() takes other 2 bytes long TSDUs for D_TTI_ASSIGNMENT
+static void test_encode_decode_short(void **state)
+{
+    (void) state;
+
+    uint8_t data[64];
+
+    const tsdu_d_group_end_t end = { .base.codop = D_GROUP_END, .cause = 1, };
+    assert_int_equal(tsdu_encode(&end.base, data, sizeof(data)), 2);
+    assert_int_equal(data[0], D_GROUP_END);
+    tsdu_d_group_end_t *end2 = d_group_end_decode(data, 2, NULL);
+    assert_non_null(end2);
+    assert_int_equal(end2->cause, end.cause);
+    tsdu_destroy(&end2->base);
+
+    const tsdu_d_return_t ret = { .base.codop = D_RETURN, .cause = 2, };
+    assert_int_equal(tsdu_encode(&ret.base, data, sizeof(data)), 2);
+    assert_int_equal(data[0], D_RETURN);
+    tsdu_d_return_t *ret2 = d_return_decode(data, 2, NULL);
+    assert_non_null(ret2);
+    assert_int_equal(ret2->cause, ret.cause);
+    tsdu_destroy(&ret2->base);
+
+    const tsdu_d_location_activity_ack_t la = {
+        .base.codop = D_LOCATION_ACTIVITY_ACK,
+        .rt_status._data = 0x5c,
+    };
+    assert_int_equal(tsdu_encode(&la.base, data, sizeof(data)), 2);
+    assert_int_equal(data[0], D_LOCATION_ACTIVITY_ACK);
+    tsdu_d_location_activity_ack_t *la2 =
+        d_location_activity_ack_decode(data, 2, NULL);
+    assert_non_null(la2);
+    assert_int_equal(la2->rt_status._data, la.rt_status._data);
+    tsdu_destroy(&la2->base);
+}
+
+/// lists longer than output arrays are refused, truncated lists are cut
+static void test_decode_list_bounds(void **state)
+{
+    (void) state;
+
+    tsdu_d_registration_ack_t ack = {
+        .base.codop = D_REGISTRATION_ACK,
+        .host_adr.cna = ADDRESS_CNA_RFSI,
+        .host_adr.len = 9,
+        .has_coverage_id = true,
+        .nb_subscription = 3,
+    };
+    uint8_t data[200];
+    const int len = tsdu_encode(&ack.base, data, sizeof(data));
+    assert_int_equal(len, 18 + 3 * 5);
+
+    tsdu_t *tsdu = NULL;
+    // NB_SUBSCRIPTION is 4 bits, only 3 subscriptions fit
+    data[17] = 0xf0;
+    assert_int_equal(tsdu_decode(data, len, &tsdu, NULL), 0);
+    assert_null(tsdu);
+
+    data[17] = 0x30;
+    assert_int_equal(tsdu_decode(data, len - 6, &tsdu, NULL), 0);
+    assert_non_null(tsdu);
+    assert_int_equal(((tsdu_d_registration_ack_t *)tsdu)->nb_subscription, 1);
+    tsdu_destroy(tsdu);
+
+    // 64 OGs fit into list, even when split into more elements
+    tsdu_arena_t *arena = tsdu_arena_create();
+    assert_non_null(arena);
+    uint8_t info[300];
+    memset(info, 0, sizeof(info));
+    info[0] = D_INFORMATION_DELIVERY;
+    info[1] = 0x01;
+    info[2] = 48;
+    info[51] = 0x01;
+    info[52] = 48;
+    info[101] = 0x02;
+    info[102] = 96;
+    assert_int_equal(tsdu_decode(info, 199, &tsdu, arena), 0);
+    assert_non_null(tsdu);
+    const tsdu_d_information_delivery_t *id =
+        (const tsdu_d_information_delivery_t *)tsdu;
+    assert_int_equal(id->nb_network_og, 64);
+    assert_int_equal(id->nb_local_og, 64);
+
+    info[199] = 0x02;
+    info[200] = 3;
+    assert_int_equal(tsdu_decode(info, 203, &tsdu, arena), 0);
+    assert_null(tsdu);
+
+    memset(info, 0, sizeof(info));
+    info[0] = D_INFORMATION_DELIVERY;
+    info[1] = 0x03;
+    info[2] = 3 * 65;
+    assert_int_equal(tsdu_decode(info, sizeof(info), &tsdu, arena), 0);
+    assert_null(tsdu);
+
+    // truncated list
+    info[2] = 3 * 10;
+    assert_int_equal(tsdu_decode(info, 3 + 3 * 4 + 1, &tsdu, arena), 0);
+    assert_non_null(tsdu);
+    id = (const tsdu_d_information_delivery_t *)tsdu;
+    assert_int_equal(id->nb_network_tkg, 4);
+    tsdu_arena_destroy(arena);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_arena_alloc),
+        unit_test(test_decode_arena),
+        unit_test(test_view_group_list),
+        unit_test(test_view_fields),
+        unit_test(test_encode_decode),
+        unit_test(test_encode_decode_short),
+        unit_test(test_decode_list_bounds),
+    };
+
+    return run_tests(tests);
+}
@@ -1,7 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
 #define LOG_PREFIX "tetrapol"
 
 #include <tetrapol/log.h>
+#include <tetrapol/misc.h>
 #include <tetrapol/tetrapol_int.h>
+#include <tetrapol/tpdu.h>
 #include <tetrapol/tsdu_json.h>
 #include <tetrapol/tsdu_print.h>
 
@@ -31,15 +34,40 @@ tetrapol_t *tetrapol_create(const tetrapol_cfg_t *cfg)
         return NULL;
     }
 
+    tetrapol->tpol.du_pool = tpdu_du_pool_create();
+    if (!tetrapol->tpol.du_pool) {
+        free(tetrapol);
+        return NULL;
+    }
+
+    tetrapol->tpol.tsdu_arena = tsdu_arena_create();
+    if (!tetrapol->tpol.tsdu_arena) {
+        tpdu_du_pool_destroy(tetrapol->tpol.du_pool);
+        free(tetrapol);
+        return NULL;
+    }
+
     memcpy(&tetrapol->tpol.cfg, cfg, sizeof(tetrapol_cfg_t));
     tetrapol->tpol.rx_offs = 0;
     tetrapol->tpol.frame_no = FRAME_NO_UNKNOWN;
+    tetrapol->tpol.out = stdout;
+    tetrapol->tpol.ch_id = TETRAPOL_CH_ID_NONE;
+    tetrapol->tpol.tsdus = 0;
+    tetrapol->tpol.prof = false;
+    tetrapol->tpol.ns_tsdu = 0;
+    tetrapol->tpol.terminals = 0;
+    tetrapol->tpol.terminals_idle = 0;
+    tetrapol->tpol.terminals_evicted = 0;
 
     return tetrapol;
 }
 
 void tetrapol_destroy(tetrapol_t *tetrapol)
 {
+    if (tetrapol) {
+        tpdu_du_pool_destroy(tetrapol->tpol.du_pool);
+        tsdu_arena_destroy(tetrapol->tpol.tsdu_arena);
+    }
     free(tetrapol);
 }
 
@@ -48,6 +76,16 @@ const tetrapol_cfg_t *tetrapol_get_cfg(tetrapol_t *tetrapol)
     return &tetrapol->tpol.cfg;
 }
 
+void tetrapol_set_output(tetrapol_t *tetrapol, FILE *out)
+{
+    tetrapol->tpol.out = out;
+}
+
+void tetrapol_set_ch_id(tetrapol_t *tetrapol, int ch_id)
+{
+    tetrapol->tpol.ch_id = ch_id;
+}
+
 tpol_t *tetrapol_get_tpol(tetrapol_t *tetrapol)
 {
     return (tpol_t *)tetrapol;
@@ -65,16 +103,43 @@ void tetrapol_evt_tsdu(tpol_t *tpol, const tpol_tsdu_t *tpol_tsdu)
         }
     }
 
+    ++tpol->tsdus;
+    const uint64_t t = tpol->prof ? clock_ns() : 0;
+
     tsdu_t *tsdu = NULL;
-    tsdu_decode(tpol_tsdu->data, tpol_tsdu->data_len, &tsdu);
+    tsdu_decode(tpol_tsdu->data, tpol_tsdu->data_len, &tsdu, tpol->tsdu_arena);
     if (tsdu) {
         LOG_IF(INFO) {
+            // keep multiline dump together when more instances are running
+            flockfile(stderr);
             LOG_("\n");
             LOGF("\tTSAP_ID=%d\tPRIO=%d\n", tpol_tsdu->tsap_id, tpol_tsdu->prio);
             tsdu_print(tsdu);
+            funlockfile(stderr);
         }
-        tsdu_destroy(tsdu);
     }
+    // failed decoding can leave partial allocations in arena
+    tsdu_arena_reset(tpol->tsdu_arena);
 
     tsdu_json(tpol, tpol_tsdu);
+
+    if (tpol->prof) {
+        tpol->ns_tsdu += clock_ns() - t;
+    }
+}
+
+FILE *tetrapol_evt_begin(const tpol_t *tpol, const char *event)
+{
+    flockfile(tpol->out);
+    fprintf(tpol->out, "{ \"event\": \"%s\", ", event);
+    if (tpol->ch_id != TETRAPOL_CH_ID_NONE) {
+        fprintf(tpol->out, "\"channel\": %d, ", tpol->ch_id);
+    }
+
+    return tpol->out;
+}
+
+void tetrapol_evt_end(const tpol_t *tpol)
+{
+    funlockfile(tpol->out);
 }
@@ -56,6 +56,19 @@ static inline void addr_parse(addr_t *addr, const uint8_t *buf, int skip)
     addr->x = get_bits(12, buf, 4 + skip);
 }
 
+/// Store address into 2 bytes, inverse of addr_parse() with skip = 0.
+static inline void addr_build(uint8_t *buf, const addr_t *addr)
+{
+    buf[0] = (addr->z << 7) | ((addr->y & 0x7) << 4) | ((addr->x >> 8) & 0xf);
+    buf[1] = addr->x & 0xff;
+}
+
+/// Pack address into 16 bit key, the same layout as addr_build() produces.
+static inline uint16_t addr_key(const addr_t *addr)
+{
+    return ((addr->z & 0x1) << 15) | ((addr->y & 0x7) << 12) | (addr->x & 0xfff);
+}
+
 // size of buffer required for printing any address
 #define ADDR_PRINT_BUF_SIZE (15)
 
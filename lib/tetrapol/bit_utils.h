@@ -4,6 +4,49 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+
+enum {
+    /// CRC state after data followed by valid FCS (CRC residue)
+    FCS_GOOD = 0xf0b8,
+};
+
+/**
+  State of incremental FCS computation, allows to check FCS while data
+  blocks arrive.
+
+    fcs_t fcs;
+    fcs_init(&fcs);
+    fcs_update(&fcs, block1, 64);
+    fcs_update(&fcs, block2, 64);
+    bool ok = fcs_check(&fcs);
+  */
+typedef struct {
+    uint16_t crc;
+} fcs_t;
+
+static inline void fcs_init(fcs_t *fcs)
+{
+    fcs->crc = 0xffff;
+}
+
+/**
+  Update FCS state with data.
+
+  @param fcs
+  @param data Data packed into bytes (first bit in LSB).
+  @param nbits Lenght of data in bits, must be multiple of 8 except for last
+    update.
+  */
+void fcs_update(fcs_t *fcs, const uint8_t *data, int nbits);
+
+/**
+  @return true when data passed to fcs_update() ends with correct FCS.
+  */
+static inline bool fcs_check(const fcs_t *fcs)
+{
+    return fcs->crc == FCS_GOOD;
+}
 
 /// PAS 0001-3-3 7.4.1.1
 /**
@@ -38,6 +81,161 @@ static inline uint32_t get_bits(int len, const uint8_t *data, int skip)
     return r;
 }
 
+/**
+  Store int into byte array, inverse of get_bits().
+
+  @param len Number of bits to store.
+  @param data
+  @param skip bits skipped from beginning of data (counts from MSB, MSB = bit0)
+  @param val Value, only len lower bits are used.
+  */
+static inline void set_bits(int len, uint8_t *data, int skip, uint32_t val)
+{
+    for (int i = 0; i < len; ++i) {
+        const int pos = skip + i;
+        const uint8_t mask = 0x80 >> (pos % 8);
+        if ((val >> (len - 1 - i)) & 1) {
+            data[pos / 8] |= mask;
+        } else {
+            data[pos / 8] &= ~mask;
+        }
+    }
+}
+
+/**
+  Sequential reader of bits in the same order as get_bits() uses (MSB
+  first). Bits are taken from 64 bit cache refilled by whole words, reads
+  past end of data return zeros and set overflow flag.
+
+    bit_reader_t br;
+    bit_reader_init(&br, data, len);
+    bit_reader_skip(&br, 8);
+    const int a = bit_reader_get(&br, 4);
+    const int b = bit_reader_get(&br, 12);
+    if (br.overflow) {
+        // data too short
+    }
+  */
+typedef struct {
+    const uint8_t *data;
+    int len;            ///< length of data in bytes
+    int pos;            ///< next byte to load into cache, can pass len
+    int ncached;        ///< number of valid bits in cache
+    uint64_t cache;     ///< next bit is in MSB
+    bool overflow;      ///< read past end of data
+} bit_reader_t;
+
+static inline void bit_reader_init(bit_reader_t *br, const uint8_t *data,
+        int len)
+{
+    br->data = data;
+    br->len = len;
+    br->pos = 0;
+    br->ncached = 0;
+    br->cache = 0;
+    br->overflow = false;
+}
+
+static inline void bit_reader_refill(bit_reader_t *br)
+{
+    if (br->pos + 8 <= br->len) {
+        uint64_t v;
+        memcpy(&v, br->data + br->pos, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        // bits behind last whole byte are loaded again by next refill
+        br->cache |= v >> br->ncached;
+        br->pos += (63 - br->ncached) >> 3;
+        br->ncached |= 56;
+        return;
+    }
+
+    while (br->ncached <= 56) {
+        const uint64_t b = br->pos < br->len ? br->data[br->pos] : 0;
+        br->cache |= b << (56 - br->ncached);
+        br->ncached += 8;
+        ++br->pos;
+    }
+}
+
+/// @return position of next bit from begin of data
+static inline int bit_reader_tell(const bit_reader_t *br)
+{
+    return 8 * br->pos - br->ncached;
+}
+
+/// @return number of bits remaining in data, negative after overflow
+static inline int bit_reader_left(const bit_reader_t *br)
+{
+    return 8 * br->len - bit_reader_tell(br);
+}
+
+/**
+  Get int from data, advance position.
+
+  @param nbits Number of bits 1..32.
+  */
+static inline uint32_t bit_reader_get(bit_reader_t *br, int nbits)
+{
+    if (br->ncached < nbits) {
+        bit_reader_refill(br);
+    }
+    const uint32_t r = br->cache >> (64 - nbits);
+    br->cache <<= nbits;
+    br->ncached -= nbits;
+    if (br->pos > br->len && bit_reader_left(br) < 0) {
+        br->overflow = true;
+    }
+
+    return r;
+}
+
+/// Move to bit position pos from begin of data.
+static inline void bit_reader_seek(bit_reader_t *br, int pos)
+{
+    br->pos = pos / 8;
+    br->ncached = 0;
+    br->cache = 0;
+    if (pos % 8) {
+        bit_reader_refill(br);
+        br->cache <<= pos % 8;
+        br->ncached -= pos % 8;
+    }
+    if (bit_reader_left(br) < 0) {
+        br->overflow = true;
+    }
+}
+
+static inline void bit_reader_skip(bit_reader_t *br, int nbits)
+{
+    if (nbits < br->ncached) {
+        br->cache <<= nbits;
+        br->ncached -= nbits;
+        if (br->pos > br->len && bit_reader_left(br) < 0) {
+            br->overflow = true;
+        }
+    } else {
+        bit_reader_seek(br, bit_reader_tell(br) + nbits);
+    }
+}
+
+/// Read n bytes, missing data past end are filled by zeros.
+static inline void bit_reader_get_bytes(bit_reader_t *br, uint8_t *buf,
+        int n)
+{
+    const int pos = bit_reader_tell(br);
+    if (pos % 8 || pos / 8 + n > br->len) {
+        for (int i = 0; i < n; ++i) {
+            buf[i] = bit_reader_get(br, 8);
+        }
+        return;
+    }
+
+    memcpy(buf, br->data + pos / 8, n);
+    bit_reader_seek(br, pos + 8 * n);
+}
+
 static inline int cmpzero(const void *data, int len)
 {
     for (int i = 0; i < len; ++i) {
@@ -61,3 +259,70 @@ static inline int cmpzero(const void *data, int len)
   @param nbits Number of bits to pack;
   */
 void pack_bits(uint8_t *bytes, const uint8_t *bits, int offs, int nbits);
+
+/**
+  Pack 8 bits stored one bit per byte into single byte. First bit is held in
+  LSB (the same bit order as used by pack_bits).
+
+  @param bits Input array of 8 bits, only LSB of each byte is used.
+  @return Packed byte.
+  */
+static inline uint8_t pack8(const uint8_t *bits)
+{
+    uint64_t v;
+    memcpy(&v, bits, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    // each byte holds bit in LSB, multiplication gathers them into top byte
+    return ((v & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+/**
+  Pack 64 bits stored one bit per byte into 64-bit word, first bit is held
+  in LSB.
+
+  @param bits Input array of 64 bits, only LSB of each byte is used.
+  @return Packed bits.
+  */
+static inline uint64_t pack64(const uint8_t *bits)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= (uint64_t)pack8(bits + 8*i) << (8*i);
+    }
+
+    return v;
+}
+
+/**
+  Store 64-bit word of packed bits into bytes, the same layout as pack_bits()
+  gives (first bit in LSB of first byte).
+
+  @param bytes Output array of 8 bytes.
+  @param v Packed bits, first bit in LSB.
+  */
+static inline void pack64_bytes(uint8_t *bytes, uint64_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(bytes, &v, sizeof(v));
+}
+
+/**
+  Unpack byte into 8 bits stored one bit per byte, inverse of pack8().
+
+  @param bits Output array of 8 bits.
+  @param byte Packed bits, first bit is held in LSB.
+  */
+static inline void unpack8(uint8_t *bits, uint8_t byte)
+{
+    // spread bit k into byte k, then turn nonzero bytes into 0x01
+    uint64_t v = (byte * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    v = ((v + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(bits, &v, sizeof(v));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <tetrapol/frame.h>
+#include <tetrapol/tetrapol_int.h>
+
+#include <stdint.h>
+
+/**
+  CCH encoder, places data frames of logical channels into CCH superframe,
+  inverse of cch_push_frame(). Only default CCH multiplexing is supported
+  (PAS 0001-3-3 5.1.3): BCH in frames 0-3, PCH in frames 98-99, RCH in frames
+  where frame_no % 25 == 14, SDCH in all other frames. Superframe consists
+  of 200 frames.
+
+  Logical channel without queued data is filled with idle data frames.
+  PCH and RCH with no station addresses, SDCH and BCH with stuffing frames.
+  */
+typedef struct cch_encoder_priv_t cch_encoder_t;
+
+/**
+  Create CCH encoder.
+
+  @param frame_no Number of the first frame (0-199).
+  */
+cch_encoder_t *cch_encoder_create(int frame_no);
+void cch_encoder_destroy(cch_encoder_t *enc);
+
+/**
+  @return number of frame which is returned by next call of
+    cch_encoder_get_frame().
+  */
+int cch_encoder_frame_no(const cch_encoder_t *enc);
+
+/**
+  Queue data frame for transmission on logical channel.
+
+  @param enc
+  @param log_ch LOG_CH_BCH, LOG_CH_PCH, LOG_CH_RCH or LOG_CH_SDCH.
+  @param data Data frame content packed into bytes, e.g. HDLC frame from
+    hdlc_frame_build(). BCH takes up to 3 blocks, PCH 2 blocks, RCH 1 block
+    and SDCH up to SYS_PAR_DATA_FRAME_BLOCKS_MAX blocks.
+  @param nbits Length of data in bits, multiple of 64.
+
+  @return 0 on success, -1 when queue is full or data length is invalid.
+  */
+int cch_encoder_push(cch_encoder_t *enc, int log_ch, const uint8_t *data,
+        int nbits);
+
+/**
+  @return number of data frames queued for logical channel, including the
+    one which is currently transmitted.
+  */
+int cch_encoder_pending(const cch_encoder_t *enc, int log_ch);
+
+/**
+  Get next frame of CCH, frame number is incremented.
+
+  @param enc
+  @param fr Output frame, ready for frame_encoder_encode().
+  */
+void cch_encoder_get_frame(cch_encoder_t *enc, frame_t *fr);
+
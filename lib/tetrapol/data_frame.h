@@ -2,6 +2,8 @@
 
 #include <tetrapol/frame.h>
 
+#include <stdbool.h>
+
 typedef struct data_frame_priv_t data_frame_t;
 
 data_frame_t *data_frame_create(void);
@@ -30,6 +32,15 @@ int data_frame_blocks(data_frame_t *data_fr);
   */
 int data_frame_push_frame(data_frame_t *data_fr, const frame_t *fr);
 
+/**
+  Check FCS of decoded data frame, must be called before
+  data_frame_get_bytes(). FCS is updated as frames are pushed, so data does
+  not have to be processed again.
+
+  @return true if data frame ends with valid HDLC FCS.
+  */
+bool data_frame_check_fcs(const data_frame_t *data_fr);
+
 /**
   Get data from data_frame, data are packe into bytes.
   Unused bits in last byte are set to zero.
@@ -38,5 +49,19 @@ int data_frame_push_frame(data_frame_t *data_fr, const frame_t *fr);
   */
 int data_frame_get_bytes(data_frame_t *data_fr, uint8_t *data);
 
+/**
+  Split data into blocks of data frame, inverse of data_frame_get_bytes().
+  Parity block is appended to data frame with more than 2 blocks. Frames
+  are ready for frame_encoder_encode().
+
+  @param frs Output array for SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1 frames.
+  @param data Data packed into bytes.
+  @param nbits Length of data in bits, multiple of 64.
+  @param asb ASB bits of all data blocks, asb[0] in LSB.
+
+  @return number of frames or -1 when data does not fit into data frame.
+  */
+int data_frame_build(frame_t *frs, const uint8_t *data, int nbits, int asb);
+
 void data_frame_destroy(data_frame_t *data_fr);
 
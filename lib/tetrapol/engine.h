@@ -0,0 +1,86 @@
+#pragma once
+
+#include <tetrapol/tetrapol.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  Multichannel decoding engine.
+
+  Engine owns set of channels (tetrapol_t and physical channel instances),
+  each channel can have its own band, direction and type (CCH/TCH).
+  Received data are queued into channel and decoded by fixed pool of worker
+  threads. Channel with queued data is scheduled on one worker, idle workers
+  steal channels from queues of busy workers. Each channel is decoded by at
+  most one worker at time, so data of single channel are decoded in order.
+
+  Events of all channels are written into single stream, each event is
+  extended by "channel" item with channel id.
+  */
+
+enum {
+    /// Maximal number of channels handled by single engine
+    TETRAPOL_ENGINE_MAX_CHANNELS = 256,
+};
+
+typedef struct tetrapol_engine_priv_t tetrapol_engine_t;
+
+/**
+  Create engine and start worker threads. Workers inherit log level of
+  calling thread.
+
+  @param nworkers Number of worker threads, 0 to use number of online CPUs.
+  @param out Stream for events of all channels.
+
+  @return new engine instance or NULL on error.
+  */
+tetrapol_engine_t *tetrapol_engine_create(int nworkers, FILE *out);
+
+/**
+  Decode all queued data, stop workers and destroy all channels.
+  */
+void tetrapol_engine_destroy(tetrapol_engine_t *engine);
+
+/**
+  Add new channel.
+
+  @param engine
+  @param cfg Channel configuration.
+  @param packed Data are pushed as packed bits, 8 bits per byte (first bit
+    in LSB), otherwise one bit per byte.
+
+  @return channel id (>= 0) or -1 on error.
+  */
+int tetrapol_engine_add_channel(tetrapol_engine_t *engine,
+        const tetrapol_cfg_t *cfg, bool packed);
+
+/**
+  Queue received data for decoding. Data are copied, decoding is done
+  asynchronously by worker threads. Can be called from any thread, but data
+  for single channel must be pushed by one thread at time.
+
+  @param engine
+  @param ch_id Channel id returned by tetrapol_engine_add_channel().
+  @param buf Demodulated bits, packed or unpacked according to channel.
+  @param len Number of bytes in buf.
+
+  @return Number of bytes queued, less than len when channel queue is full
+    (try again after tetrapol_engine_flush()), negative value on error.
+  */
+int tetrapol_engine_push(tetrapol_engine_t *engine, int ch_id,
+        const uint8_t *buf, int len);
+
+/**
+  Wait until all queued data are decoded and events written.
+  */
+void tetrapol_engine_flush(tetrapol_engine_t *engine);
+
+#ifdef __cplusplus
+}
+#endif
@@ -80,6 +80,12 @@ typedef struct {
         frame_training_t trainign;
         frame_direct_emergecy_t direct_emergecy;
     };
+    /**
+      Data of data frame (data.data[2..65]) packed into 64-bit word, the
+      first bit in LSB. Filled by frame decoder for all decoded frames, even
+      broken ones.
+      */
+    uint64_t data_packed;
     int fr_type;
     /**
       0  - Frame does not have uncorrected errors and CRC matches.
@@ -99,13 +105,37 @@ typedef struct {
 // == Frame decoder ==
 typedef struct frame_decoder_priv_t frame_decoder_t;
 
+/// Frame decoder statistics, counters are not cleared by frame_decoder_reset()
+typedef struct {
+    /// Number of frames decoded
+    unsigned long frames;
+    /// Number of frames rejected by syndrome check before Viterbi decoding
+    unsigned long screened;
+    /// Number of frames decoded by syndrome decoder and how many was valid
+    unsigned long fast;
+    unsigned long fast_ok;
+    /// Number of frames decoded by Viterbi decoder and how many was valid
+    unsigned long viterbi;
+    unsigned long viterbi_ok;
+} frame_decoder_stats_t;
+
 frame_decoder_t *frame_decoder_create(int band, int scr, int fr_type);
 void frame_decoder_destroy(frame_decoder_t *fd);
 void frame_decoder_reset(frame_decoder_t *fd, int band, int scr, int fr_type);
 void frame_decoder_set_scr(frame_decoder_t *fd, int scr);
 
 /**
-  Decode frame from frame data.
+  Select error correction, frame_decoder_reset() does not change it.
+
+  @param fec TETRAPOL_FEC_ACCURATE (default), TETRAPOL_FEC_FAST or
+    TETRAPOL_FEC_ADAPTIVE.
+  */
+void frame_decoder_set_fec(frame_decoder_t *fd, int fec);
+void frame_decoder_get_stats(frame_decoder_t *fd, frame_decoder_stats_t *stats);
+
+/**
+  Decode frame from frame data. Data bits are also packed into
+  fr->data_packed.
 
   @param fd
   @param fr Pointer to preallocated frame_t structure.
@@ -113,6 +143,53 @@ void frame_decoder_set_scr(frame_decoder_t *fd, int scr);
   */
 void frame_decoder_decode(frame_decoder_t *fd, frame_t *fr, const uint8_t *fr_data);
 
+/**
+  Decode more frames at once, results are the same as frame_decoder_decode()
+  would give for each frame. Frames are decoded in groups, one frame per
+  SIMD lane (SSE2 or AVX2 when enabled by compiler flags).
+
+  @param fd
+  @param frs Array of n preallocated frame_t structures.
+  @param fr_data Array of n pointers to frame data.
+  @param n Number of frames.
+  */
+void frame_decoder_decode_batch(frame_decoder_t *fd, frame_t *frs,
+        const uint8_t *const *fr_data, int n);
+
+/**
+  Check for which SCRs (scrambling constants) is frame decoded without
+  errors. Candidates are evaluated together, full decoding runs only for
+  those which passes check of frame first part.
+
+  The result for each SCR is the same as frame_decoder_decode() with
+  FRAME_TYPE_AUTO would give, decoder SCR and frame type are not changed.
+
+  @param fd
+  @param scr_ok Output bitmap for 128 SCRs, bit (scr % 64) of word (scr / 64)
+    is set when frame is valid for SCR.
+  @param scr_mask SCRs to check, the same layout as scr_ok.
+  @param fr_data frame data
+  */
+void frame_decoder_check_scr(frame_decoder_t *fd, uint64_t *scr_ok,
+        const uint64_t *scr_mask, const uint8_t *fr_data);
+
+/**
+  Score SCR (scrambling constant) hypotheses using frame structure.
+
+  Frame is not decoded, only linear checks which must hold for valid frame
+  are evaluated (parity syndromes, frame type bit, zero padding and CRC).
+  Scrambling is linear so the checks are evaluated once per frame and
+  compared with precomputed checks of each scrambling sequence.
+
+  @param fd Frame decoder, only band is used.
+  @param scr_score Output, score for each of 128 SCRs. Each passed check adds
+    1, each failed check subtracts 4, the right SCR gives about +30 for
+    voice and +80 for data frame, wrong SCR about -40.
+  @param fr_data frame data
+  */
+void frame_decoder_scr_score(frame_decoder_t *fd, int *scr_score,
+        const uint8_t *fr_data);
+
 // == Frame encoder ==
 typedef struct frame_encoder_priv_t frame_encoder_t;
 
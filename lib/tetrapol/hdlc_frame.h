@@ -34,6 +34,11 @@ enum {
     //COMMAND_UNNUMBERED__BLANK4 = 0x0f, ///< suspicious blank line in table
 };
 
+enum {
+    /// number of stuffing frame patterns, see hdlc_frame_stuffing_idx()
+    HDLC_STUFFING_PATTERNS = 40,
+};
+
 typedef struct {
     uint8_t cmd;
     union {
@@ -86,6 +91,17 @@ extern const addr_t addr_all;
   */
 bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int len);
 
+/**
+  Parse HDLC frame without FCS check, for data with FCS already checked
+  (see data_frame_check_fcs()).
+
+  @param hdlc_frame Preallocated structure to store result.
+  @param data Input data composed from one or more data blocks packed as bytes.
+  @param len Size of data in bits.
+  */
+void hdlc_frame_parse_data(hdlc_frame_t *hdlc_frame, const uint8_t *data,
+        int len);
+
 /**
   @param hdlc_frame HDLC frame to check (stuffing frames have bad FCS)
 
@@ -93,3 +109,23 @@ bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int len);
   */
 int hdlc_frame_stuffing_idx(const hdlc_frame_t *hdlc_frame);
 
+/**
+  Build HDLC frame, inverse of hdlc_frame_parse(). Frame is padded by zeros
+  to whole data blocks (64 bits) and FCS is stored at the end of last block.
+
+  @param data Output buffer for SYS_PAR_DATA_FRAME_BLOCKS_MAX blocks.
+  @param hdlc_frame Frame to build, nbits is length of data (multiple of 8).
+
+  @return length of frame in bits or -1 when data does not fit into data frame.
+  */
+int hdlc_frame_build(uint8_t *data, const hdlc_frame_t *hdlc_frame);
+
+/**
+  Build stuffing frame (single data block), see hdlc_frame_stuffing_idx().
+
+  @param data Output buffer for single block.
+  @param idx Index of stuffing pattern (0 .. HDLC_STUFFING_PATTERNS-1).
+
+  @return length of frame in bits
+  */
+int hdlc_frame_build_stuffing(uint8_t *data, int idx);
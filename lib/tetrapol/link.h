@@ -4,11 +4,40 @@
 #include <tetrapol/tp_timer.h>
 #include <tetrapol/tetrapol_int.h>
 
+#include <stddef.h>
+
 typedef struct link_priv_t link_t;
 
 link_t *link_create(tpol_t *tpol, int log_ch);
 void link_destroy(link_t *link);
 int link_push_hdlc_frame(link_t *link, const hdlc_frame_t *hdlc_fr);
 void link_rx_glitch(link_t *link);
-void link_tick(time_evt_t* te, link_t *link);
+
+/**
+  Report passing time to link, expires segmented DUs. Link does not have to
+  be ticked every frame, only at the time of deadline. RX glitch of tick
+  event is not propagated, use link_rx_glitch().
+
+  @param te Passing time event.
+  @param link
+  @param deadline Set to time of the next required tick.
+
+  @return true when link has running timers and deadline is set.
+  */
+bool link_tick(time_evt_t* te, link_t *link, struct timeval *deadline);
+
+/**
+  Return true when link_tick() should be called by the next tick to start
+  timers, e.g. after reception of DU segment.
+  */
+bool link_tick_required(const link_t *link);
+
+/**
+  Return true when link is in the middle of TSDU reassembly (segmented DU
+  or connection TSDU), such link should not be destroyed when idle.
+  */
+bool link_is_busy(const link_t *link);
+
+/// Return memory used by single link instance without DU segments (bytes).
+size_t link_mem_size(void);
 
@@ -17,7 +17,11 @@
 #define INFO 40
 #define DBG 60
 
-extern int log_global_lvl;
+/**
+  Log level is kept per thread, threads started by library (see
+  tetrapol/engine.h) inherit log level of thread which created them.
+  */
+extern _Thread_local int log_thread_lvl;
 
 // define LOG_LVL to override log level for single file
 #ifndef LOG_LVL
@@ -41,7 +45,7 @@ extern int log_global_lvl;
     LOG__(__LINE__, msg , ##__VA_ARGS__)
 
 #define LOG_IF(lvl) \
-    if (LOG_LOCAL_LVL(lvl) || lvl <= log_global_lvl)
+    if (LOG_LOCAL_LVL(lvl) || lvl <= log_thread_lvl)
 
 #define LOG(lvl, msg, ...) \
     LOG_IF(lvl) { \
@@ -50,5 +54,10 @@ extern int log_global_lvl;
 
 static inline void log_set_lvl(int lvl)
 {
-    log_global_lvl = lvl;
+    log_thread_lvl = lvl;
+}
+
+static inline int log_get_lvl(void)
+{
+    return log_thread_lvl;
 }
@@ -10,3 +10,15 @@ char *sprint_hex(char *str, const uint8_t *bytes, int n);
 /// Dump bytes as hex with no spaces inserted in output stream.
 char *sprint_hex2(char *str, const uint8_t *bytes, int n);
 
+/// Monotonic clock in nanoseconds, used to measure time spent in decoding.
+uint64_t clock_ns(void);
+
+
+/**
+  Pseudo random generator (xorshift64), gives the same sequence on all
+  platforms, used to generate reproducible test data.
+
+  @param state Generator state, must be initialised to nonzero value.
+  @return Next random value.
+  */
+uint64_t xorshift64(uint64_t *state);
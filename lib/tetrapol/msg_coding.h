@@ -1,5 +1,7 @@
 #pragma once
 
+#include <tetrapol/bit_utils.h>
+
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -490,7 +492,29 @@ enum {
     // values 3..15 are reserved
 };
 
-bool address_decode(address_t *address, const uint8_t **data_ptr);
-void address_print(const address_t *address);
+/**
+  Decode CELL_ID PAS 0001-3-2 5.3.21, invalid type sets ids to -1.
+  Reads 12 bits, padding to 2 bytes is left to caller.
+  */
+void cell_id_decode(cell_id_t *cell_id, bit_reader_t *br);
+
+/**
+  Decode address, reader is moved to the byte following the address.
+  Position is not changed for unsupported CNA.
+
+  @return true if another address follows, false otherwise.
+  */
+bool address_decode(address_t *address, bit_reader_t *br);
 
-int address_list_decode(address_list_t **ptr_addrs, const uint8_t *data);
+/**
+  Encode address, inverse of address_decode().
+
+  @param data Output buffer, at least 8 bytes.
+  @param address Address to encode, only NOT_SIGNIFICANT, RFSI and PABX
+    addresses are supported.
+  @param li Set when another address follows.
+
+  @return length of encoded address in bytes or -1 for unsupported address.
+  */
+int address_encode(uint8_t *data, const address_t *address, bool li);
+void address_print(const address_t *address);
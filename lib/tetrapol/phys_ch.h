@@ -7,8 +7,40 @@
 
 #define PHYS_CH_SCR_DETECT -1
 
+/// SCR estimate with at least this confidence is used to set SCR
+#define PHYS_CH_SCR_EST_CONFIDENCE 100
+
 typedef struct phys_ch_priv_t phys_ch_t;
 
+/**
+  Channel decoder statistics, see tetrapol_phys_ch_get_stats().
+
+  Time spent in decoding layers is measured only when profiling is enabled
+  by tetrapol_phys_ch_set_profiling().
+  */
+typedef struct {
+    /// Number of frames acquired from stream and how many was decoded
+    unsigned long frames;
+    unsigned long frames_ok;
+    /// Number of frame synchronisation losses
+    unsigned long sync_lost;
+    /// Number of TSDUs passed to application
+    unsigned long tsdus;
+    /// Number of terminals kept in memory, how many was forgotten after
+    /// idle timeout and how many to keep memory limit
+    unsigned long terminals;
+    unsigned long terminals_idle;
+    unsigned long terminals_evicted;
+    /// Frame synchronisation, differential decoding (ns)
+    uint64_t ns_sync;
+    /// SCR detection, error correction, frame events (ns)
+    uint64_t ns_frame;
+    /// Data blocks, HDLC, TPDU and timers (ns)
+    uint64_t ns_link;
+    /// TSDU decoding and events (ns)
+    uint64_t ns_tsdu;
+} phys_ch_stats_t;
+
 /**
   Create new TETRAPOL physical channel instance.
   @param band VHF or UHF
@@ -26,6 +58,26 @@ int tetrapol_phys_ch_get_scr(phys_ch_t *phys_ch);
 /** Set SCR, scrambling constant parameter. */
 void tetrapol_phys_ch_set_scr(phys_ch_t *phys_ch, int scr);
 
+/**
+  Get SCR estimated from structure of frames received during SCR detection.
+
+  @param confidence Score difference of the best and the second best SCR,
+    estimate is considered reliable when it reaches
+    PHYS_CH_SCR_EST_CONFIDENCE (~ 2 valid frames). Can be NULL.
+
+  @return SCR with the best score
+  */
+int tetrapol_phys_ch_get_scr_estimate(phys_ch_t *phys_ch, int *confidence);
+
+/**
+  Enable measurement of time spent in decoding layers, it adds a few
+  clock reads per frame.
+  */
+void tetrapol_phys_ch_set_profiling(phys_ch_t *phys_ch, bool enable);
+
+/** Get decoder statistics, counters are never cleared. */
+void tetrapol_phys_ch_get_stats(phys_ch_t *phys_ch, phys_ch_stats_t *stats);
+
 /** Get confidence for SRC detection (~ no. of valid frames). */
 int tetrapol_phys_ch_get_scr_confidence(phys_ch_t *phys_ch);
 
@@ -33,9 +85,49 @@ int tetrapol_phys_ch_get_scr_confidence(phys_ch_t *phys_ch);
 void tetrapol_phys_ch_set_scr_confidence(phys_ch_t *phys_ch, int scr_confidence);
 
 /**
-  Eat some data from buf into channel decoder.
+  Eat data from buf into channel decoder. When internal buffer is full,
+  received data are processed (as by tetrapol_phys_ch_process()) to make
+  some space.
+
+  @param buf Demodulated bits, one bit per byte.
+  @param len Number of bytes (bits) in buf.
 
-  @return number of bytes consumed
+  @return number of bytes consumed (always len) or negative value on error
 */
 int tetrapol_phys_ch_recv(phys_ch_t *phys_ch, uint8_t *buf, int len);
 
+/**
+  Eat packed data from buf into channel decoder, the same as
+  tetrapol_phys_ch_recv() but for packed bits.
+
+  @param buf Demodulated bits packed into bytes (8 bits per byte), first bit
+    is held in LSB.
+  @param len Number of bytes in buf.
+
+  @return number of bytes consumed (always len) or negative value on error
+*/
+int tetrapol_phys_ch_recv_packed(phys_ch_t *phys_ch, uint8_t *buf, int len);
+
+/**
+  Get buffer for direct write of received data into channel decoder, data
+  are not copied when buffer is filled by read(), mmap'd capture etc.
+  When internal buffer is full, received data are processed to make some
+  space. Written data must be passed to decoder by tetrapol_phys_ch_commit().
+
+  @param len Output, maximal number of bytes which can be written.
+
+  @return buffer for demodulated bits packed into bytes (8 bits per byte),
+    first bit is held in LSB, or NULL on error
+*/
+uint8_t *tetrapol_phys_ch_get_write_buffer(phys_ch_t *phys_ch, int *len);
+
+/**
+  Pass data written into buffer from tetrapol_phys_ch_get_write_buffer()
+  to channel decoder.
+
+  @param len Number of bytes written, must not exceed len returned by
+    tetrapol_phys_ch_get_write_buffer().
+
+  @return 0 on success, negative value on error
+*/
+int tetrapol_phys_ch_commit(phys_ch_t *phys_ch, int len);
@@ -49,12 +49,14 @@ int terminal_list_push_hdlc_frame(terminal_list_t* tlist,
         const hdlc_frame_t *hdlc_fr);
 
 /**
-  Report RX glitch to all terminals.
+  Report RX glitch to all terminals, it is delivered to terminal together
+  with its next HDLC frame.
   */
 void terminal_list_rx_glitch(terminal_list_t* tlist);
 
 /**
-  Call periodicaly to expire old sessions.
+  Call periodicaly to expire old sessions. Only terminals with expired
+  deadline are ticked, cost does not depend on number of known terminals.
   @param tlist list with all terminals.
   @param te passing time event.
   */
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,10 +25,41 @@ enum {
     TETRAPOL_RADIO_TCH = 2,
 };
 
+enum {
+    TETRAPOL_CH_ID_NONE = -1,
+};
+
+/** Error correction used by frame decoder. */
+enum {
+    /// Viterbi decoder, fixes the most errors (default)
+    TETRAPOL_FEC_ACCURATE = 0,
+    /// Syndrome decoder, much faster, fixes only few error patterns
+    TETRAPOL_FEC_FAST = 1,
+    /// Syndrome decoder, Viterbi decoder for frames it fails to decode
+    TETRAPOL_FEC_ADAPTIVE = 2,
+};
+
+enum {
+    /// Default time after which terminal without traffic is forgotten (s)
+    TETRAPOL_TERMINAL_IDLE_TIMEOUT = 30 * 60,
+};
+
 typedef struct {
     uint8_t band;
     uint8_t dir;
     uint8_t radio_ch_type;
+    uint8_t fec;
+    /**
+      State of terminal (link layer) without traffic is forgotten after
+      this time (s), 0 for TETRAPOL_TERMINAL_IDLE_TIMEOUT, negative value to
+      keep terminals forever. Terminals receiving segmented TSDU are kept.
+      */
+    int32_t terminal_idle_timeout;
+    /**
+      Limit of memory used by terminals (kB), the least recently active
+      terminals are forgotten when it is reached, 0 for no limit.
+      */
+    uint32_t terminal_mem_max;
 } tetrapol_cfg_t;
 
 typedef struct tetrapol_priv_t tetrapol_t;
@@ -36,6 +68,19 @@ tetrapol_t *tetrapol_create(const tetrapol_cfg_t *cfg);
 void tetrapol_destroy(tetrapol_t *tetrapol);
 const tetrapol_cfg_t *tetrapol_get_cfg(tetrapol_t *tetrapol);
 
+/**
+  Set stream where decoded events (JSON, one per line) are written.
+  Each event is written with stream locked, the same stream can be shared
+  by more instances running in different threads. Default is stdout.
+  */
+void tetrapol_set_output(tetrapol_t *tetrapol, FILE *out);
+
+/**
+  Set channel id included into each event as "channel" item, use
+  TETRAPOL_CH_ID_NONE (default) to omit it.
+  */
+void tetrapol_set_ch_id(tetrapol_t *tetrapol, int ch_id);
+
 #ifdef __cplusplus
 }
 #endif
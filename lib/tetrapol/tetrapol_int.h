@@ -5,6 +5,8 @@
 #include <tetrapol/addr.h>
 #include <tetrapol/tetrapol.h>
 
+#include <stdbool.h>
+
 enum {
     FRAME_NO_UNKNOWN = -1,
 };
@@ -33,6 +35,16 @@ typedef struct {
     tetrapol_cfg_t cfg;
     uint64_t rx_offs;
     int frame_no;
+    FILE *out;      ///< stream for events
+    int ch_id;      ///< channel id for events or TETRAPOL_CH_ID_NONE
+    unsigned long tsdus;    ///< number of TSDUs passed to application
+    bool prof;      ///< measure time spent in TSDU decoding and output
+    uint64_t ns_tsdu;       ///< time spent in TSDU decoding and output
+    unsigned long terminals;        ///< number of terminals in memory
+    unsigned long terminals_idle;   ///< terminals forgotten when idle
+    unsigned long terminals_evicted;    ///< forgotten due to memory limit
+    struct tpdu_du_pool_priv_t *du_pool;    ///< DU reassembly, see tpdu.h
+    struct tsdu_arena_priv_t *tsdu_arena;   ///< TSDU decoding, see tsdu.h
 } tpol_t;
 
 enum {
@@ -54,3 +66,18 @@ typedef struct {
 
 tpol_t *tetrapol_get_tpol(tetrapol_t *tetrapol);
 void tetrapol_evt_tsdu(tpol_t *tpol, const tpol_tsdu_t *tpol_tsdu);
+
+/**
+  Start output of event, lock event stream and write event header.
+
+  @param tpol
+  @param event Event name.
+
+  @return Stream for rest of event, must be finished by tetrapol_evt_end().
+  */
+FILE *tetrapol_evt_begin(const tpol_t *tpol, const char *event);
+
+/**
+  Finish event started by tetrapol_evt_begin(), unlock event stream.
+  */
+void tetrapol_evt_end(const tpol_t *tpol);
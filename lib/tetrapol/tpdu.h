@@ -7,11 +7,34 @@
 #include <tetrapol/tp_timer.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/// CODE field of TPDU header
+enum {
+    TPDU_CODE_CR = 0,
+    TPDU_CODE_CC = 0x8,
+    TPDU_CODE_FCR = 0x10,
+    TPDU_CODE_DR = 0x18,
+    TPDU_CODE_FDR = 0x19,
+    TPDU_CODE_DC = 0x1a,
+    TPDU_CODE_DT = 0x1b,
+    TPDU_CODE_DTE = 0x1c,
+};
+
 typedef struct tpdu_priv_t tpdu_t;
 typedef struct tpdu_priv_ui_t tpdu_ui_t;
 
+/**
+  Pool of buffers for reassembly of segmented DUs shared by all tpdu_ui_t
+  instances of channel (tpol_t.du_pool). Buffers are allocated on demand
+  and reused, memory is released by tpdu_du_pool_destroy() only.
+  */
+typedef struct tpdu_du_pool_priv_t tpdu_du_pool_t;
+
+tpdu_du_pool_t *tpdu_du_pool_create(void);
+void tpdu_du_pool_destroy(tpdu_du_pool_t *pool);
+
 tpdu_t *tpdu_create(tpol_t *tpol, int log_ch);
 int tpdu_push_hdlc_frame(tpdu_t *tpdu, const hdlc_frame_t *hdlc_fr);
 
@@ -23,11 +46,41 @@ int tpdu_push_hdlc_frame(tpdu_t *tpdu, const hdlc_frame_t *hdlc_fr);
 void tpdu_rx_glitch(tpdu_t *tpdu);
 
 void tpdu_destroy(tpdu_t *tpdu);
-void tpdu_du_tick(time_evt_t *te, void *tpdu_du);
+
+/// Return true when some connection is receiving segmented TSDU.
+bool tpdu_is_busy(const tpdu_t *tpdu);
+
+/// Return size of tpdu_t instance (bytes).
+size_t tpdu_mem_size(void);
+
+/**
+  Check T454 timer of segmented DUs, expired DUs are dropped. Timer of DU
+  is started by the first tick after the last received segment.
+
+  @param te Passing time event.
+  @param tpdu
+  @param deadline Set to time when the next DU expires.
+
+  @return true when some DU is still pending (deadline is set), false
+    otherwise.
+  */
+bool tpdu_du_tick(time_evt_t *te, tpdu_ui_t *tpdu, struct timeval *deadline);
+
+/**
+  Return true when DU segment was received since the last tpdu_du_tick(),
+  the next tick should not be skipped to start its T454 timer.
+  */
+bool tpdu_du_tick_required(const tpdu_ui_t *tpdu);
 
 tpdu_ui_t *tpdu_ui_create(tpol_t *tpol, frame_type_t fr_type, int log_ch);
 void tpdu_ui_destroy(tpdu_ui_t *tpdu);
 
+/// Return true when some segmented DU is being received.
+bool tpdu_ui_is_busy(const tpdu_ui_t *tpdu);
+
+/// Return size of tpdu_ui_t instance without DU segments (bytes).
+size_t tpdu_ui_mem_size(void);
+
 /**
  * @brief tpdu_ui_push_hdlc_frame
  * Process HDLC frame, optionaly compose frame from segments.
@@ -49,3 +102,42 @@ int tpdu_ui_push_hdlc_frame(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_fr, tsdu_t
  * @return 0 on sucess, -1 on error
  */
 int tpdu_ui_push_hdlc_frame2(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_fr, tsdu_t **tsdu);
+
+/**
+  Build DU (UI TPDU) carrying TSDU, inverse of tpdu_ui_push_hdlc_frame().
+  TSDU is segmented when it does not fit into single HDLC frame. HDLC
+  frames are UI commands with data length set, see hdlc_frame_build().
+
+  @param hdlc_frs Output array of HDLC frames.
+  @param max_frs Size of hdlc_frs.
+  @param addr Destination address.
+  @param prio Priority.
+  @param id_tsap TSAP identifier.
+  @param seg_ref Segmentation reference (0-127), used for segmented TSDU only.
+  @param tsdu TSDU data.
+  @param len TSDU length in bytes.
+
+  @return number of HDLC frames or -1 when TSDU is too long.
+  */
+int tpdu_ui_build(hdlc_frame_t *hdlc_frs, int max_frs, const addr_t *addr,
+        int prio, int id_tsap, int seg_ref, const uint8_t *tsdu, int len);
+
+/**
+  Build connection oriented TPDU carrying TSDU (can be empty), inverse of
+  tpdu_push_hdlc_frame() for downlink. Only FCR, DT and DTE can be
+  segmented, CR and CC are not supported.
+
+  HDLC frames are Information commands, N(S) and N(R) must be set by caller.
+
+  @param hdlc_frs Output array of HDLC frames.
+  @param max_frs Size of hdlc_frs.
+  @param addr Destination address.
+  @param code TPDU_CODE_*
+  @param tsap_ref TSAP reference of connection (0-14).
+  @param tsdu TSDU data.
+  @param len TSDU length in bytes.
+
+  @return number of HDLC frames or -1 on error.
+  */
+int tpdu_build(hdlc_frame_t *hdlc_frs, int max_frs, const addr_t *addr,
+        int code, int tsap_ref, const uint8_t *tsdu, int len);
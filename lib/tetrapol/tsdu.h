@@ -159,13 +159,24 @@ enum {
     IEI_PROFILE_ID          = 0x85,
 };
 
+/**
+  Bump allocator for TSDU decoding, see tsdu_decode(). Memory of all TSDUs
+  decoded into arena is released at once by tsdu_arena_reset().
+  */
+typedef struct tsdu_arena_priv_t tsdu_arena_t;
+
+tsdu_arena_t *tsdu_arena_create(void);
+void tsdu_arena_reset(tsdu_arena_t *arena);
+void tsdu_arena_destroy(tsdu_arena_t *arena);
+
 // do not use directly, this struct must be first member of each TSDU structure
 typedef struct {
     codop_t codop;
+    tsdu_arena_t *arena;    ///< owner of TSDU memory, NULL for heap
     int noptionals;     ///< number of optionals
     /**
       In subclassed TSDU structure, noptionals pointers should be present.
-      Those are initialized to NULL by tsdu_base_init and freed by tsdu_destroy.
+      Those are initialized to NULL by tsdu_create and freed by tsdu_destroy.
       */
     void *optionals[];
 } tsdu_base_t;
@@ -768,7 +779,11 @@ void tsdu_destroy(tsdu_base_t *tsdu);
  * @param len length of data in bytes
  * @param tsdu Is set to point o decoded TSDU when available or to NULL
  *   otherwise. Caller is responsible for freeing this TSDU.
+ * @param arena TSDU is allocated from arena and is valid until
+ *   tsdu_arena_reset(), tsdu_destroy() does nothing for it. When NULL, TSDU
+ *   is allocated on heap and must be released by tsdu_destroy().
  * @return 0 on success, -1 on fail.
  */
-int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu);
+int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu,
+        tsdu_arena_t *arena);
 
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <tetrapol/tsdu.h>
+
+/**
+  Encode TSDU, inverse of tsdu_decode(). Only downlink TSDUs required to
+  generate control channel traffic are supported: D_AUTHENTICATION,
+  D_CONNECT_DCH, D_EXPLICIT_SHORT_DATA, D_GROUP_ACTIVATION, D_GROUP_END,
+  D_GROUP_IDLE, D_LOCATION_ACTIVITY_ACK, D_REGISTRATION_ACK,
+  D_REGISTRATION_NAK, D_RETURN and D_SYSTEM_INFO.
+
+  @param tsdu TSDU to encode.
+  @param data Output buffer.
+  @param size Size of output buffer.
+
+  @return length of encoded TSDU in bytes, -1 when TSDU is not supported or
+    does not fit into buffer.
+  */
+int tsdu_encode(const tsdu_t *tsdu, uint8_t *data, int size);
+
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <tetrapol/msg_coding.h>
+#include <tetrapol/tsdu.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+  Read-only view of raw TSDU data, alternative to tsdu_decode() when only
+  few fields are required (filters, statistics). Nothing is allocated and
+  nothing is decoded in advance, each accessor extracts just the requested
+  field from data. The view does not copy data, data must remain valid while
+  the view is used.
+
+    tsdu_view_t view;
+    tsdu_view_init(&view, data, len);
+    if (view.codop == D_GROUP_ACTIVATION) {
+        const int group_id = tsdu_view_group_id(&view);
+        ...
+    }
+
+  Scalar accessors return -1 when field is not present in message of given
+  CODOP or when data are too short.
+  */
+typedef struct {
+    const uint8_t *data;
+    int len;
+    codop_t codop;  ///< the same value as tsdu_decode() sets into TSDU
+} tsdu_view_t;
+
+/**
+  Fields with fixed position, X(FIELD, field) generates TSDU_FIELD_FIELD
+  and accessor tsdu_view_field().
+  */
+#define TSDU_VIEW_FIELDS(X) \
+    X(ACTIVATION_MODE,  activation_mode) \
+    X(CALL_PRIORITY,    call_priority) \
+    X(CCR_NUMBER,       ccr_number) \
+    X(CHANNEL_ID,       channel_id) \
+    X(COVERAGE_ID,      coverage_id) \
+    X(GROUP_ID,         group_id) \
+    X(KEY_REFERENCE,    key_reference) \
+    X(REFERENCE_LIST,   reference_list)
+
+/// Addresses, X(FIELD, field) generates accessor tsdu_view_field().
+#define TSDU_VIEW_ADDRESSES(X) \
+    X(CALLED_ADR,       called_adr) \
+    X(CALLING_ADR,      calling_adr) \
+    X(HOST_ADR,         host_adr) \
+    X(RT_ID,            rt_id)
+
+typedef enum {
+#define X(FIELD, field) TSDU_FIELD_ ## FIELD,
+    TSDU_VIEW_FIELDS(X)
+    TSDU_VIEW_ADDRESSES(X)
+#undef X
+} tsdu_field_t;
+
+/**
+  Set view to TSDU data.
+
+  @return false when data are too short to contain CODOP.
+  */
+bool tsdu_view_init(tsdu_view_t *view, const uint8_t *data, int len);
+
+/**
+  Get value of scalar field.
+
+  @return field value or -1 when field is not available.
+  */
+int tsdu_view_get(const tsdu_view_t *view, tsdu_field_t field);
+
+/**
+  Decode address field.
+
+  @return false when field is not available.
+  */
+bool tsdu_view_get_address(const tsdu_view_t *view, tsdu_field_t field,
+        address_t *address);
+
+#define X(FIELD, field) \
+    static inline int tsdu_view_ ## field(const tsdu_view_t *view) \
+    { \
+        return tsdu_view_get(view, TSDU_FIELD_ ## FIELD); \
+    }
+TSDU_VIEW_FIELDS(X)
+#undef X
+
+#define X(FIELD, field) \
+    static inline bool tsdu_view_ ## field(const tsdu_view_t *view, \
+            address_t *address) \
+    { \
+        return tsdu_view_get_address(view, TSDU_FIELD_ ## FIELD, address); \
+    }
+TSDU_VIEW_ADDRESSES(X)
+#undef X
+
+/**
+  Decode CELL_ID of cell which message refers to.
+
+  @return false when message does not contain CELL_ID.
+  */
+bool tsdu_view_cell_id(const tsdu_view_t *view, cell_id_t *cell_id);
+
+/**
+  Get number of entries of given type in D_GROUP_LIST.
+
+  @param type One of TYPE_NB_TYPE_EMERGENCY, TYPE_NB_TYPE_OPEN,
+    TYPE_NB_TYPE_TALK_GROUP.
+  @return number of entries or -1 for other CODOP.
+  */
+int tsdu_view_group_list_len(const tsdu_view_t *view, int type);
+
+/**
+  Decode i-th entry of given type from D_GROUP_LIST, base of entry structure
+  is not touched.
+
+  @return false when entry is not available.
+  */
+bool tsdu_view_group_list_emergency(const tsdu_view_t *view, int i,
+        tsdu_d_group_list_emergency_t *emergency);
+bool tsdu_view_group_list_open(const tsdu_view_t *view, int i,
+        tsdu_d_group_list_open_t *open);
+bool tsdu_view_group_list_talk_group(const tsdu_view_t *view, int i,
+        tsdu_d_group_list_talk_group_t *group);
+
+/**
+  Get CHANNEL_ID of i-th adjacent cell in D_NEIGHBOURING_CELL.
+
+  @return channel id or -1 when not available.
+  */
+int tsdu_view_adj_cell_channel_id(const tsdu_view_t *view, int i);
+
+/**
+  Decode i-th item of CELL_ID_LIST IE from D_NEIGHBOURING_CELL.
+
+  @return false when not available.
+  */
+bool tsdu_view_adj_cell_id(const tsdu_view_t *view, int i,
+        cell_id_t *cell_id);
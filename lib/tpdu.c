@@ -5,29 +5,41 @@
 #include <tetrapol/tpdu.h>
 #include <tetrapol/misc.h>
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define TPDU_CODE_PREFIX_MASK (0x18)
+
 enum {
-    TPDU_CODE_CR = 0,
-    TPDU_CODE_CC = 0x8,
-    TPDU_CODE_FCR = 0x10,
-    TPDU_CODE_DR = 0x18,
-    TPDU_CODE_FDR = 0x19,
-    TPDU_CODE_DC = 0x1a,
-    TPDU_CODE_DT = 0x1b,
-    TPDU_CODE_DTE = 0x1c,
+    /// Maximal DU data in single segment, HDLC data without DU header
+    DU_SEG_DATA_MAX = SIZEOF(hdlc_frame_t, data) - 3,
+    /// Maximal number of DUs in reassembly for single channel
+    DU_POOL_SIZE_MAX = 256,
 };
 
-#define TPDU_CODE_PREFIX_MASK (0x18)
+typedef struct segmented_du_t segmented_du_t;
 
-typedef struct {
+/// Reassembly buffer of segmented DU, taken from tpdu_du_pool_t
+struct segmented_du_t {
     struct timeval tv;
     uint8_t id_tsap;
     uint8_t prio;
     uint8_t nsegments;  ///< total amount of segments (HDLC frames) in DU
-    hdlc_frame_t *hdlc_frs[SYS_PAR_N452];
-} segmented_du_t;
+    bool in_order;      ///< segments are stored in order of PACKET_NUM
+    uint64_t received;  ///< bitmap of received segments, SYS_PAR_N452 = 64
+    int len;            ///< length of data from all received segments
+    uint16_t seg_offs[SYS_PAR_N452];    ///< segment data offset in data
+    uint8_t seg_len[SYS_PAR_N452];
+    segmented_du_t *next_free;
+    /// Segment data are appended as they arrive
+    uint8_t data[SYS_PAR_N452 * DU_SEG_DATA_MAX];
+};
+
+struct tpdu_du_pool_priv_t {
+    segmented_du_t *free;
+    int ndus;           ///< number of allocated DUs, free and used
+};
 
 typedef enum {
     CONNECTION_STATE_NC = 0,    ///< not connected
@@ -56,6 +68,8 @@ struct tpdu_priv_t {
 struct tpdu_priv_ui_t {
     frame_type_t fr_type;
     segmented_du_t *seg_du[128];
+    uint64_t seg_du_mask[2];    ///< bitmap of allocated seg_du
+    bool seg_du_unarmed;        ///< segment received since last tick
     int log_ch;
     tpol_t *tpol;
 };
@@ -373,12 +387,70 @@ void tpdu_destroy(tpdu_t *tpdu)
     free(tpdu);
 }
 
-static void tpdu_ui_segments_destroy(segmented_du_t *du)
+bool tpdu_is_busy(const tpdu_t *tpdu)
+{
+    for (int i = 0; i < ARRAY_LEN(tpdu->conns); ++i) {
+        if (tpdu->conns[i].seg_len) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t tpdu_mem_size(void)
+{
+    return sizeof(tpdu_t);
+}
+
+tpdu_du_pool_t *tpdu_du_pool_create(void)
+{
+    return calloc(1, sizeof(tpdu_du_pool_t));
+}
+
+void tpdu_du_pool_destroy(tpdu_du_pool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    while (pool->free) {
+        segmented_du_t *du = pool->free;
+        pool->free = du->next_free;
+        free(du);
+    }
+    free(pool);
+}
+
+static segmented_du_t *du_pool_get(tpdu_du_pool_t *pool)
 {
-    for (int i = 0; i < SYS_PAR_N452; ++i) {
-        free(du->hdlc_frs[i]);
+    segmented_du_t *du = pool->free;
+    if (du) {
+        pool->free = du->next_free;
+    } else {
+        if (pool->ndus == DU_POOL_SIZE_MAX) {
+            LOG(ERR, "too many segmented DUs");
+            return NULL;
+        }
+        du = malloc(sizeof(segmented_du_t));
+        if (!du) {
+            LOG(ERR, "ERR OOM");
+            return NULL;
+        }
+        ++pool->ndus;
     }
-    free(du);
+
+    // data are not cleared, only received part is used
+    memset(du, 0, offsetof(segmented_du_t, next_free));
+    du->in_order = true;
+
+    return du;
+}
+
+static void du_pool_put(tpdu_du_pool_t *pool, segmented_du_t *du)
+{
+    du->next_free = pool->free;
+    pool->free = du;
 }
 
 tpdu_ui_t *tpdu_ui_create(tpol_t *tpol, frame_type_t fr_type, int log_ch)
@@ -405,7 +477,7 @@ void tpdu_ui_destroy(tpdu_ui_t *tpdu)
         if (!tpdu->seg_du[i]) {
             continue;
         }
-        tpdu_ui_segments_destroy(tpdu->seg_du[i]);
+        du_pool_put(tpdu->tpol->du_pool, tpdu->seg_du[i]);
     }
     free(tpdu);
 }
@@ -449,7 +521,7 @@ static int tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu,
             tetrapol_evt_tsdu(tpdu->tpol, &tpol_tsdu);
 
             if (tsdu) {
-                return tsdu_decode(hdlc_fr->data + 2, len, tsdu);
+                return tsdu_decode(hdlc_fr->data + 2, len, tsdu, NULL);
             }
             return 0;
         }
@@ -461,7 +533,7 @@ static int tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu,
         tetrapol_evt_tsdu(tpdu->tpol, &tpol_tsdu);
 
         if (tsdu) {
-            return tsdu_decode(hdlc_fr->data + 1, len, tsdu);
+            return tsdu_decode(hdlc_fr->data + 1, len, tsdu, NULL);
         }
         return 0;
     }
@@ -498,34 +570,52 @@ static int tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu,
 
     segmented_du_t *seg_du = tpdu->seg_du[seg_ref];
     if (seg_du == NULL) {
-        seg_du = calloc(1, sizeof(segmented_du_t));
+        seg_du = du_pool_get(tpdu->tpol->du_pool);
         if (!seg_du) {
             return -1;
         }
         tpdu->seg_du[seg_ref] = seg_du;
+        tpdu->seg_du_mask[seg_ref / 64] |= 1ULL << (seg_ref % 64);
         seg_du->id_tsap = id_tsap;
         seg_du->prio = prio;
     }
 
-    if (seg_du->hdlc_frs[packet_num]) {
+    if (seg_du->received & (1ULL << packet_num)) {
         // segment already recieved
         return 0;
     }
 
-    seg_du->hdlc_frs[packet_num] = malloc(sizeof(hdlc_frame_t));
-    if (!seg_du->hdlc_frs[packet_num]) {
-        LOG(ERR, "ERR OOM");
-        return -1;
+    // append segment data, DU header (3 bytes) is not stored
+    int n = 0;
+    if (tpdu->fr_type == FRAME_TYPE_DATA) {
+        if (seg) {
+            n = hdlc_fr->nbits / 8 - 3;
+        } else {
+            n = hdlc_fr->data[3];
+            if (n > hdlc_fr->nbits / 8 - 4) {
+                LOG(WTF, "hdlc_fr.len=%d < tsdu_payload_len=%d",
+                        hdlc_fr->nbits / 8, n);
+                return -1;
+            }
+        }
+        memcpy(&seg_du->data[seg_du->len], &hdlc_fr->data[seg ? 3 : 4], n);
+    }
+    if (packet_num != __builtin_popcountll(seg_du->received)) {
+        seg_du->in_order = false;
     }
-    memcpy(seg_du->hdlc_frs[packet_num], hdlc_fr, sizeof(hdlc_frame_t));
+    seg_du->received |= 1ULL << packet_num;
+    seg_du->seg_offs[packet_num] = seg_du->len;
+    seg_du->seg_len[packet_num] = n;
+    seg_du->len += n;
 
     if (seg == 0) {
         seg_du->nsegments = packet_num + 1;
     }
 
-    // reset T454 timer
+    // reset T454 timer, it is started by next tick
     seg_du->tv.tv_sec = 0;
     seg_du->tv.tv_usec = 0;
+    tpdu->seg_du_unarmed = true;
 
     // last segment is still missing
     if (!seg_du->nsegments) {
@@ -533,57 +623,46 @@ static int tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu,
     }
 
     // check if we have all segments
-    for (int i = 0; i < seg_du->nsegments; ++i) {
-        if (!seg_du->hdlc_frs[i]) {
-            return 0;
-        }
+    const uint64_t all = (seg_du->nsegments == 64) ?
+        ~0ULL : (1ULL << seg_du->nsegments) - 1;
+    if ((seg_du->received & all) != all) {
+        return 0;
     }
 
-    // max_segments * (sizeof(hdlc_frame_t->data) - TPDU_DU_header)
-    uint8_t data[SYS_PAR_N452 * (sizeof(((hdlc_frame_t*)NULL)->data) - 3)];
-    int data_len = 0;
-    // collect data from all segments
-    if (tpdu->fr_type == FRAME_TYPE_DATA) {
-        uint8_t *d = data;
-        for (int i = 0; i < seg_du->nsegments; ++i) {
-            hdlc_frame_t *hfr = seg_du->hdlc_frs[i];
-            int n_ext = 1;
-            // skip ext headers
-            while (get_bits(1, hfr->data + n_ext - 1, 0)) {
-                ++n_ext;
-            }
-            int n;
-            if (i == (seg_du->nsegments - 1)) {
-                n = hfr->data[n_ext++];
-                if (n > hfr->nbits / 8) {
-                    LOG(WTF, "hdlc_fr.len=%d < tsdu_payload_len=%d",
-                            hfr->nbits / 8, n);
-                    return -1;
-                }
-            } else {
-                n = (hfr->nbits / 8) - n_ext;
-            }
-            data_len += n;
-            memcpy(d, &hfr->data[n_ext], n);
-            d += n;
-        }
-    } else {    // FRAME_TYPE_HR_DATA
+    if (tpdu->fr_type != FRAME_TYPE_DATA) {
         LOG(WTF, "FRAME_TYPE_HR_DATA not implemented");
         // TODO
     }
 
-    tpdu_ui_segments_destroy(seg_du);
+    // segments are usually received in order, DU data are then contiguous
+    const uint8_t *data = seg_du->data;
+    int data_len = seg_du->len;
+    uint8_t data_ordered[SIZEOF(segmented_du_t, data)];
+    if (!seg_du->in_order) {
+        data_len = 0;
+        for (int i = 0; i < seg_du->nsegments; ++i) {
+            memcpy(&data_ordered[data_len], &seg_du->data[seg_du->seg_offs[i]],
+                    seg_du->seg_len[i]);
+            data_len += seg_du->seg_len[i];
+        }
+        data = data_ordered;
+    }
+
     tpdu->seg_du[seg_ref] = NULL;
+    tpdu->seg_du_mask[seg_ref / 64] &= ~(1ULL << (seg_ref % 64));
 
     memcpy(&tpol_tsdu.addr, &hdlc_fr->addr, sizeof(tpol_tsdu.addr));
     tpol_tsdu.data_len = data_len;
     tpol_tsdu.data = data;
     tetrapol_evt_tsdu(tpdu->tpol, &tpol_tsdu);
 
+    int ret = 0;
     if (tsdu) {
-        return tsdu_decode(data, data_len, tsdu);
+        ret = tsdu_decode(data, data_len, tsdu, NULL);
     }
-    return 0;
+    du_pool_put(tpdu->tpol->du_pool, seg_du);
+
+    return ret;
 }
 
 int tpdu_ui_push_hdlc_frame(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_fr,
@@ -607,28 +686,174 @@ void tpdu_rx_glitch(tpdu_t *tpdu)
     }
 }
 
-void tpdu_du_tick(time_evt_t *te, void *tpdu_du)
+bool tpdu_du_tick(time_evt_t *te, tpdu_ui_t *tpdu, struct timeval *deadline)
 {
-    tpdu_ui_t *tpdu = tpdu_du;
+    bool pending = false;
+
+    tpdu->seg_du_unarmed = false;
+
+    // set/check T454 timer, only allocated DUs are visited
+    for (int w = 0; w < ARRAY_LEN(tpdu->seg_du_mask); ++w) {
+        uint64_t mask = tpdu->seg_du_mask[w];
+        while (mask) {
+            const int i = 64 * w + __builtin_ctzll(mask);
+            mask &= mask - 1;
+            segmented_du_t *seg_du = tpdu->seg_du[i];
+
+            if (!seg_du->tv.tv_sec && !seg_du->tv.tv_usec) {
+                seg_du->tv = te->tv;
+            } else if (timeval_abs_delta(&seg_du->tv, &te->tv) >= SYS_PAR_T454) {
+                // TODO: report error to application layer
+                du_pool_put(tpdu->tpol->du_pool, seg_du);
+                tpdu->seg_du[i] = NULL;
+                tpdu->seg_du_mask[w] &= ~(1ULL << (i % 64));
+                continue;
+            }
 
-    // set/check T454 timer
-    for (int i = 0; i < ARRAY_LEN(tpdu->seg_du); ++i) {
-        if (!tpdu->seg_du[i]) {
-            continue;
+            if (!pending || seg_du->tv.tv_sec < deadline->tv_sec ||
+                    (seg_du->tv.tv_sec == deadline->tv_sec &&
+                     seg_du->tv.tv_usec < deadline->tv_usec)) {
+                *deadline = seg_du->tv;
+            }
+            pending = true;
         }
+    }
 
-        if (!tpdu->seg_du[i]->tv.tv_sec && !tpdu->seg_du[i]->tv.tv_usec) {
-            tpdu->seg_du[i]->tv.tv_sec = te->tv.tv_sec;
-            tpdu->seg_du[i]->tv.tv_usec = te->tv.tv_usec;
-            continue;
+    if (pending) {
+        deadline->tv_usec += SYS_PAR_T454;
+        deadline->tv_sec += deadline->tv_usec / 1000000;
+        deadline->tv_usec %= 1000000;
+    }
+
+    return pending;
+}
+
+bool tpdu_du_tick_required(const tpdu_ui_t *tpdu)
+{
+    return tpdu->seg_du_unarmed;
+}
+
+bool tpdu_ui_is_busy(const tpdu_ui_t *tpdu)
+{
+    return tpdu->seg_du_mask[0] || tpdu->seg_du_mask[1];
+}
+
+size_t tpdu_ui_mem_size(void)
+{
+    return sizeof(tpdu_ui_t);
+}
+
+enum {
+    /// HDLC frame data (without address, command and FCS) in all blocks
+    HDLC_DATA_LEN_MAX = 8 * SYS_PAR_DATA_FRAME_BLOCKS_MAX - 2 - 1 - 2,
+};
+
+static void hdlc_frame_init(hdlc_frame_t *hdlc_fr, const addr_t *addr,
+        uint8_t cmd)
+{
+    memset(&hdlc_fr->command, 0, sizeof(hdlc_fr->command));
+    hdlc_fr->addr = *addr;
+    hdlc_fr->command.cmd = cmd;
+}
+
+int tpdu_ui_build(hdlc_frame_t *hdlc_frs, int max_frs, const addr_t *addr,
+        int prio, int id_tsap, int seg_ref, const uint8_t *tsdu, int len)
+{
+    // EXT=0, SEG=0, PRIO, ID_TSAP
+    const uint8_t hdr = ((prio & 0x3) << 4) | (id_tsap & 0xf);
+
+    if (max_frs < 1) {
+        return -1;
+    }
+
+    // PAS 0001-3-3 9.5.1.2, single block DU has no length field
+    if (len <= 2) {
+        hdlc_frame_init(&hdlc_frs[0], addr, COMMAND_UNNUMBERED_UI);
+        memset(hdlc_frs[0].data, 0, 3);
+        hdlc_frs[0].data[0] = hdr;
+        memcpy(&hdlc_frs[0].data[1], tsdu, len);
+        hdlc_frs[0].nbits = 3*8;
+        return 1;
+    }
+
+    if (2 + len <= HDLC_DATA_LEN_MAX) {
+        hdlc_frame_init(&hdlc_frs[0], addr, COMMAND_UNNUMBERED_UI);
+        hdlc_frs[0].data[0] = hdr;
+        hdlc_frs[0].data[1] = len;
+        memcpy(&hdlc_frs[0].data[2], tsdu, len);
+        hdlc_frs[0].nbits = (2 + len) * 8;
+        return 1;
+    }
+
+    // segmented DU, segments except last one fill all blocks
+    const int seg_len = HDLC_DATA_LEN_MAX - 3;
+    int pos = 0;
+    for (int packet_num = 0; packet_num < max_frs &&
+            packet_num < SYS_PAR_N452; ++packet_num) {
+        hdlc_frame_t *hdlc_fr = &hdlc_frs[packet_num];
+        const bool last = (len - pos) < seg_len;
+
+        hdlc_frame_init(hdlc_fr, addr, COMMAND_UNNUMBERED_UI);
+        // EXT=1, SEG, PRIO, ID_TSAP; EXT=1, SEGM_REF; EXT=0, RES=0, PACKET_NUM
+        hdlc_fr->data[0] = 0x80 | (last ? 0 : 0x40) | hdr;
+        hdlc_fr->data[1] = 0x80 | (seg_ref & 0x7f);
+        hdlc_fr->data[2] = packet_num;
+        if (last) {
+            hdlc_fr->data[3] = len - pos;
+            memcpy(&hdlc_fr->data[4], &tsdu[pos], len - pos);
+            hdlc_fr->nbits = (4 + len - pos) * 8;
+            return packet_num + 1;
         }
+        memcpy(&hdlc_fr->data[3], &tsdu[pos], seg_len);
+        hdlc_fr->nbits = HDLC_DATA_LEN_MAX * 8;
+        pos += seg_len;
+    }
 
-        if (timeval_abs_delta(&tpdu->seg_du[i]->tv, &te->tv) < SYS_PAR_T454) {
-            continue;
+    LOG(ERR, "too long TSDU for DU %d", len);
+    return -1;
+}
+
+int tpdu_build(hdlc_frame_t *hdlc_frs, int max_frs, const addr_t *addr,
+        int code, int tsap_ref, const uint8_t *tsdu, int len)
+{
+    if (code == TPDU_CODE_CR || code == TPDU_CODE_CC) {
+        LOG(ERR, "unsupported TPDU code %d", code);
+        return -1;
+    }
+
+    // PAR_FIELD and DEST_REF, both sides use the same TSAP reference
+    const uint8_t ref = ((tsap_ref & 0xf) << 4) | (tsap_ref & 0xf);
+    // segments except last one fill all blocks
+    const int seg_len = HDLC_DATA_LEN_MAX - 2;
+    int pos = 0;
+    for (int i = 0; i < max_frs; ++i) {
+        hdlc_frame_t *hdlc_fr = &hdlc_frs[i];
+        const bool last = (len - pos) < seg_len;
+
+        if (!last && code != TPDU_CODE_FCR && code != TPDU_CODE_DT &&
+                code != TPDU_CODE_DTE) {
+            break;
         }
 
-        // TODO: report error to application layer
-        tpdu_ui_segments_destroy(tpdu->seg_du[i]);
-        tpdu->seg_du[i] = NULL;
+        hdlc_frame_init(hdlc_fr, addr, COMMAND_INFORMATION);
+        // EXT=0, SEG, D, CODE, connection continues by DT after FCR segment
+        hdlc_fr->data[0] = (last ? 0 : 0x40) | (len ? 0x20 : 0) |
+            ((i && code == TPDU_CODE_FCR) ? TPDU_CODE_DT : code);
+        hdlc_fr->data[1] = ref;
+        if (last) {
+            hdlc_fr->nbits = 2*8;
+            if (len) {
+                hdlc_fr->data[2] = len - pos;
+                memcpy(&hdlc_fr->data[3], &tsdu[pos], len - pos);
+                hdlc_fr->nbits += (1 + len - pos) * 8;
+            }
+            return i + 1;
+        }
+        memcpy(&hdlc_fr->data[2], &tsdu[pos], seg_len);
+        hdlc_fr->nbits = HDLC_DATA_LEN_MAX * 8;
+        pos += seg_len;
     }
+
+    LOG(ERR, "too long TSDU for TPDU %d", len);
+    return -1;
 }
@@ -5,6 +5,7 @@
 #include <tetrapol/misc.h>
 #include <tetrapol/bit_utils.h>
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,28 +29,185 @@ const int CELL_RADIO_PARAM_RX_LEV_ACCESS_TO_DBM[16] = {
 
 
 
-static void tsdu_base_set_nopts(tsdu_base_t *tsdu, int noptionals)
+/// all allocations from arena are aligned to this boundary
+#define ARENA_ALIGN (sizeof(max_align_t))
+/// size of first chunk, fits any TSDU including reassembled DU
+#define ARENA_CHUNK_SIZE_MIN (16 * 1024)
+
+typedef struct arena_chunk_t arena_chunk_t;
+
+struct arena_chunk_t {
+    arena_chunk_t *prev;    ///< previously filled chunk or NULL
+    size_t size;            ///< capacity of data in bytes
+    size_t used;            ///< bytes allocated from data
+    max_align_t data[];
+};
+
+/// header of each allocation, used by realloc
+typedef union {
+    size_t size;
+    max_align_t _align;
+} arena_block_t;
+
+struct tsdu_arena_priv_t {
+    arena_chunk_t *chunk;   ///< allocations are taken from this chunk
+    size_t size;            ///< total capacity of all chunks
+    arena_block_t *last;    ///< last allocated block, can be resized in place
+};
+
+static size_t arena_round(size_t size)
 {
-    tsdu->noptionals = noptionals;
-    memset(tsdu->optionals, 0, sizeof(void *[noptionals]));
+    return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static arena_chunk_t *arena_chunk_create(size_t size, arena_chunk_t *prev)
+{
+    arena_chunk_t *chunk = malloc(sizeof(arena_chunk_t) + size);
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->prev = prev;
+    chunk->size = size;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+static void arena_chunks_free(arena_chunk_t *chunk)
+{
+    while (chunk) {
+        arena_chunk_t *prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+}
+
+tsdu_arena_t *tsdu_arena_create(void)
+{
+    tsdu_arena_t *arena = malloc(sizeof(tsdu_arena_t));
+    if (!arena) {
+        return NULL;
+    }
+
+    arena->chunk = arena_chunk_create(ARENA_CHUNK_SIZE_MIN, NULL);
+    if (!arena->chunk) {
+        free(arena);
+        return NULL;
+    }
+    arena->size = ARENA_CHUNK_SIZE_MIN;
+    arena->last = NULL;
+
+    return arena;
+}
+
+void tsdu_arena_reset(tsdu_arena_t *arena)
+{
+    arena->last = NULL;
+    if (arena->chunk->prev) {
+        // merge chunks, in steady state single chunk is reused without malloc
+        arena_chunk_t *chunk = arena_chunk_create(arena->size, NULL);
+        if (chunk) {
+            arena_chunks_free(arena->chunk);
+            arena->chunk = chunk;
+        } else {
+            arena_chunks_free(arena->chunk->prev);
+            arena->chunk->prev = NULL;
+            arena->size = arena->chunk->size;
+        }
+    }
+    arena->chunk->used = 0;
+}
+
+void tsdu_arena_destroy(tsdu_arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+    arena_chunks_free(arena->chunk);
+    free(arena);
 }
 
-#define tsdu_create(TSDU_TYPE, noptionals) \
-    (TSDU_TYPE *) tsdu_create_(sizeof(TSDU_TYPE), noptionals)
+static void *arena_alloc(tsdu_arena_t *arena, size_t size)
+{
+    const size_t need = sizeof(arena_block_t) + arena_round(size);
+    arena_chunk_t *chunk = arena->chunk;
+    if (chunk->size - chunk->used < need) {
+        const size_t chunk_size = need > 2 * arena->size ?
+            need : 2 * arena->size;
+        chunk = arena_chunk_create(chunk_size, arena->chunk);
+        if (!chunk) {
+            LOG(ERR, "ERR OOM");
+            return NULL;
+        }
+        arena->chunk = chunk;
+        arena->size += chunk_size;
+    }
 
-static tsdu_t *tsdu_create_(int size, int noptionals)
+    arena_block_t *block = (arena_block_t *)((uint8_t *)chunk->data + chunk->used);
+    chunk->used += need;
+    block->size = size;
+    arena->last = block;
+
+    return block + 1;
+}
+
+static void *arena_realloc(tsdu_arena_t *arena, void *ptr, size_t size)
 {
-    tsdu_t *tsdu = malloc(size);
+    if (!ptr) {
+        return arena_alloc(arena, size);
+    }
+
+    arena_block_t *block = (arena_block_t *)ptr - 1;
+    if (block == arena->last) {
+        arena_chunk_t *chunk = arena->chunk;
+        const size_t used = chunk->used - arena_round(block->size) +
+            arena_round(size);
+        if (used <= chunk->size) {
+            chunk->used = used;
+            block->size = size;
+            return ptr;
+        }
+    }
+
+    void *p = arena_alloc(arena, size);
+    if (p) {
+        memcpy(p, ptr, block->size < size ? block->size : size);
+    }
+
+    return p;
+}
+
+/// Allocate from arena, or from heap when arena is NULL.
+static void *tsdu_alloc(tsdu_arena_t *arena, size_t size)
+{
+    return arena ? arena_alloc(arena, size) : malloc(size);
+}
+
+static void *tsdu_realloc(tsdu_arena_t *arena, void *ptr, size_t size)
+{
+    return arena ? arena_realloc(arena, ptr, size) : realloc(ptr, size);
+}
+
+#define tsdu_create(arena, TSDU_TYPE, noptionals) \
+    (TSDU_TYPE *) tsdu_create_(arena, sizeof(TSDU_TYPE), noptionals)
+
+static tsdu_t *tsdu_create_(tsdu_arena_t *arena, size_t size, int noptionals)
+{
+    tsdu_t *tsdu = tsdu_alloc(arena, size);
     if (!tsdu) {
         return NULL;
     }
-    tsdu_base_set_nopts(tsdu, noptionals);
+    tsdu->arena = arena;
+    tsdu->noptionals = noptionals;
+    memset(tsdu->optionals, 0, sizeof(void *[noptionals]));
+
     return tsdu;
 }
 
 void tsdu_destroy(tsdu_base_t *tsdu)
 {
-    if (!tsdu) {
+    // TSDUs in arena are released by tsdu_arena_reset()
+    if (!tsdu || tsdu->arena) {
         return;
     }
     for (int i = 0; i < tsdu->noptionals; ++i) {
@@ -58,38 +216,31 @@ void tsdu_destroy(tsdu_base_t *tsdu)
     free(tsdu);
 }
 
-static void activation_mode_decode(activation_mode_t *am, uint8_t data)
+/// Set reader to the first bit after CODOP.
+static void tsdu_reader_init(bit_reader_t *br, const uint8_t *data, int len)
 {
-    am->hook = get_bits(2, &data, 0);
-    am->type = get_bits(2, &data, 2);
+    bit_reader_init(br, data, len);
+    bit_reader_skip(br, 8);
 }
 
-static void cell_id_decode1(cell_id_t *cell_id, const uint8_t *data)
+static void activation_mode_decode(activation_mode_t *am, bit_reader_t *br)
 {
-    int type = get_bits(2, data, 0);
-    if (type == CELL_ID_FORMAT_0) {
-        cell_id->bs_id = get_bits(6, data, 2);
-        cell_id->rsw_id = get_bits(4, data, 8);
-    } else if (type == CELL_ID_FORMAT_1) {
-        cell_id->bs_id = get_bits(4, data, 8);
-        cell_id->rsw_id = get_bits(6, data, 2);
-    } else {
-        LOG(WTF, "unknown cell_id_type (%d)", type);
-        cell_id->bs_id = -1;
-        cell_id->rsw_id = -1;
-    }
+    am->hook = bit_reader_get(br, 2);
+    am->type = bit_reader_get(br, 2);
 }
 
 // specific for d_system_info - cell in offline mode
-static void cell_id_decode2(cell_id_t *cell_id, const uint8_t *data)
+static void cell_id_decode2(cell_id_t *cell_id, bit_reader_t *br)
 {
-    int type = get_bits(2, data, 8);
+    const int id1 = bit_reader_get(br, 4);
+    const int type = bit_reader_get(br, 2);
+    const int id2 = bit_reader_get(br, 6);
     if (type == CELL_ID_FORMAT_0) {
-        cell_id->bs_id = get_bits(6, data, 10);
-        cell_id->rsw_id = get_bits(4, data, 4);;
+        cell_id->bs_id = id2;
+        cell_id->rsw_id = id1;
     } else if (type == CELL_ID_FORMAT_1) {
-        cell_id->bs_id = get_bits(4, data, 4);;
-        cell_id->rsw_id = get_bits(6, data, 10);;
+        cell_id->bs_id = id1;
+        cell_id->rsw_id = id2;
     } else {
         LOG(WTF, "unknown cell_id_type (%d)", type);
         cell_id->bs_id = -1;
@@ -98,41 +249,46 @@ static void cell_id_decode2(cell_id_t *cell_id, const uint8_t *data)
 }
 
 static tsdu_d_authentication_t *
-d_authentication_decode(const uint8_t *data, int len)
+d_authentication_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_d_authentication_t *tsdu = tsdu_create(tsdu_d_authentication_t, 0);
+    tsdu_d_authentication_t *tsdu = tsdu_create(arena, tsdu_d_authentication_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 16, tsdu);
 
-    tsdu->key_reference._data = data[1];
-    memcpy(tsdu->valid_rt, &data[2], sizeof(tsdu->valid_rt));
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->key_reference._data = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->valid_rt, sizeof(tsdu->valid_rt));
 
     return tsdu;
 }
 
 static tsdu_d_crisis_notification_t *d_crisis_notification_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 10, NULL);
 
-    tsdu_d_crisis_notification_t *tsdu = tsdu_create(
+    tsdu_d_crisis_notification_t *tsdu = tsdu_create(arena,
             tsdu_d_crisis_notification_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    const uint8_t *data_ = &data[1];
-    if (address_decode(&tsdu->calling_adr, &data_)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    if (address_decode(&tsdu->calling_adr, &br)) {
         LOG(WTF, "Only single addres in list is supported.");
     }
-    tsdu->organisation = data[6];
-    tsdu->coverage_id = data[7];
-    if (data[8]) {
-        LOG(WTF, "Crisis - nonzero undocumented field=0x%02x", data[8]);
+    bit_reader_seek(&br, 8 * 6);
+    tsdu->organisation = bit_reader_get(&br, 8);
+    tsdu->coverage_id = bit_reader_get(&br, 8);
+    const int undocumented = bit_reader_get(&br, 8);
+    if (undocumented) {
+        LOG(WTF, "Crisis - nonzero undocumented field=0x%02x", undocumented);
     }
-    tsdu->og_nb = get_bits(4, &data[9], 0);
+    tsdu->og_nb = bit_reader_get(&br, 4);
     if (tsdu->og_nb > 5) {
         LOG(WTF, "Too large OG_NB %d", tsdu->og_nb);
         tsdu_destroy(&tsdu->base);
@@ -140,7 +296,7 @@ static tsdu_d_crisis_notification_t *d_crisis_notification_decode(
     }
     CHECK_LEN(len, 10 + (12 * tsdu->og_nb) / 8, tsdu); // fixed divisor (8 instead of 12)
     for (int i = 0; i < tsdu->og_nb; ++i) {
-        tsdu->group_ids[i] = get_bits(12, &data[9], 4 + 12*i);
+        tsdu->group_ids[i] = bit_reader_get(&br, 12);
     }
 
     return tsdu;
@@ -151,80 +307,95 @@ static tsdu_d_crisis_notification_t *d_crisis_notification_decode(
 
 
 
-static tsdu_d_broadcast_t *d_broadcast_decode(const uint8_t *data, int len)
+static tsdu_d_broadcast_t *d_broadcast_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len < 5) {
 	LOG(WTF, "Too short");
 	return NULL;
     }
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     len -= 5;
     
-    tsdu_d_broadcast_t *tsdu = malloc(sizeof(tsdu_d_broadcast_t) + len);
-
+    tsdu_d_broadcast_t *tsdu = (tsdu_d_broadcast_t *)tsdu_create_(arena,
+            sizeof(tsdu_d_broadcast_t) + len, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu_base_set_nopts(&tsdu->base, 0);
-
-    tsdu->call_priority         = get_bits(4, data + 1, 4);
-    tsdu->message_reference     = data[2] | (data[3] << 8);
-    tsdu->key_reference._data   = data[4];
+    bit_reader_skip(&br, 4);
+    tsdu->call_priority         = bit_reader_get(&br, 4);
+    const int message_reference = bit_reader_get(&br, 8);
+    tsdu->message_reference     = message_reference | (bit_reader_get(&br, 8) << 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
     tsdu->data_len = len;
-    memcpy(tsdu->user_data, data + 5, len);
+    bit_reader_get_bytes(&br, tsdu->user_data, len);
 
     return tsdu;
 }
 
-static tsdu_d_broadcast_notification_t *d_broadcast_notification_decode(const uint8_t *data, int len)
+static tsdu_d_broadcast_notification_t *d_broadcast_notification_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_broadcast_notification_t *tsdu = tsdu_create(tsdu_d_broadcast_notification_t, 0);
+    tsdu_d_broadcast_notification_t *tsdu = tsdu_create(arena, tsdu_d_broadcast_notification_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 1, tsdu);
-    tsdu->og_nb = get_bits(4, data + 1, 4);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    bit_reader_skip(&br, 4);
+    tsdu->og_nb = bit_reader_get(&br, 4);
     
     CHECK_LEN(len, 2 + (12 * tsdu->og_nb) / 8, tsdu); 
+    // FIXME: first GROUP_ID overlaps OG_NB
+    bit_reader_seek(&br, 12);
     for (int i = 0; i < tsdu->og_nb; ++i) {
-        tsdu->group_ids[i] = get_bits(12, &data[1], 4 + 12*i);
+        tsdu->group_ids[i] = bit_reader_get(&br, 12);
     }
     return tsdu;
 }
 
-static tsdu_d_broadcast_waiting_t *d_broadcast_waiting_decode(const uint8_t *data, int len)
+static tsdu_d_broadcast_waiting_t *d_broadcast_waiting_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_broadcast_waiting_t *tsdu = tsdu_create(tsdu_d_broadcast_waiting_t, 0);
+    tsdu_d_broadcast_waiting_t *tsdu = tsdu_create(arena, tsdu_d_broadcast_waiting_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 5, tsdu);
 
-    tsdu->broadcast_reference = get_bits(16, data+1, 0);
-    tsdu->trans_param3 = get_bits(16, data+3, 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->broadcast_reference = bit_reader_get(&br, 16);
+    tsdu->trans_param3 = bit_reader_get(&br, 16);
 
     return tsdu;
 }
 
-static tsdu_d_call_switch_t *d_call_switch_decode(const uint8_t *data, int len)
+static tsdu_d_call_switch_t *d_call_switch_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
 
-    tsdu_d_call_switch_t *tsdu = tsdu_create(tsdu_d_call_switch_t, 0);
+    tsdu_d_call_switch_t *tsdu = tsdu_create(arena, tsdu_d_call_switch_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 17, tsdu);
 
-    tsdu->call_type._data       = data[1];
-    tsdu->channel_id            = get_bits(12, &data[2], 4);
-    tsdu->u_ch_scrambling       = data[4];
-    tsdu->d_ch_scrambling       = data[5];
-    tsdu->key_reference._data   = data[6];
-    memcpy(tsdu->valid_rt, &data[7], SIZEOF(tsdu_d_call_switch_t, valid_rt));
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->call_type._data       = bit_reader_get(&br, 8);
+    bit_reader_skip(&br, 4);
+    tsdu->channel_id            = bit_reader_get(&br, 12);
+    tsdu->u_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->d_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->valid_rt, SIZEOF(tsdu_d_call_switch_t, valid_rt));
     
-    const uint8_t *data_ = &data[15];
-    if (address_decode(&tsdu->calling_adr, &data_)) {
+    if (address_decode(&tsdu->calling_adr, &br)) {
         LOG(WTF, "Only single addres in list is supported.");
     }
 
@@ -234,62 +405,72 @@ static tsdu_d_call_switch_t *d_call_switch_decode(const uint8_t *data, int len)
         (tsdu->key_reference.key_index == KEY_INDEX_KEY_SUPPLIED);
     if (tsdu->has_key_of_call) {
         CHECK_LEN(len, y+16, tsdu);
-        memcpy(tsdu->key_of_call, &data[y+1], sizeof(key_of_call_t));
+        bit_reader_seek(&br, 8 * (y + 1));
+        bit_reader_get_bytes(&br, tsdu->key_of_call, sizeof(key_of_call_t));
     }
     tsdu->has_add_setup_param = false;
     if (len >= y + 16) {
-        uint8_t iei = data[y+16+1]; // get_bits(8, data + y + 16 + 1, 0);
+        bit_reader_seek(&br, 8 * (y + 16 + 1));
+        uint8_t iei = bit_reader_get(&br, 8);
 	tsdu->has_add_setup_param = (iei == IEI_ADD_SETUP_PARAM);
 	if (!tsdu->has_add_setup_param) {
             LOG(WTF, "Expected IEI_ADD_SETUP_PARAM got %d", iei);
 	    return tsdu;
         } else {
-            tsdu->add_setup_param._data = data[y + 16 + 2];
+            tsdu->add_setup_param._data = bit_reader_get(&br, 8);
         }
     }
 
     return tsdu;
 }
 
-static tsdu_d_data_down_status_t *d_data_down_status_decode(const uint8_t *data, int len)
+static tsdu_d_data_down_status_t *d_data_down_status_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_data_down_status_t *tsdu = tsdu_create(tsdu_d_data_down_status_t, 0);
+    tsdu_d_data_down_status_t *tsdu = tsdu_create(arena, tsdu_d_data_down_status_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 9, tsdu);
 
-    tsdu->rt_status_code             = data[1];
-    tsdu->rt_status_info             = data[2];
-    cell_id_decode1(&tsdu->cell_id, data + 3);
-    const uint8_t *adr_data = &data[4] + 4;
-    if (address_decode(&tsdu->rt_id, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->rt_status_code             = bit_reader_get(&br, 8);
+    tsdu->rt_status_info             = bit_reader_get(&br, 8);
+    cell_id_decode(&tsdu->cell_id, &br);
+    bit_reader_seek(&br, 8 * 8);
+    if (address_decode(&tsdu->rt_id, &br)) {
         LOG(ERR, "Only single address is supported in rt_id");
     }
 
     return tsdu;
 }
 
-static tsdu_d_ech_reject_t *d_ech_reject_decode(const uint8_t *data, int len)
+static tsdu_d_ech_reject_t *d_ech_reject_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
 
-    tsdu_d_ech_reject_t *tsdu = tsdu_create(tsdu_d_ech_reject_t, 0);
+    tsdu_d_ech_reject_t *tsdu = tsdu_create(arena, tsdu_d_ech_reject_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 6, tsdu);
 
-    activation_mode_decode(&tsdu->activation_mode, data[1]);
-    tsdu->group_id  = get_bits(12, data + 1, 4);
-    cell_id_decode1(&tsdu->cell_id, data + 3);
-    tsdu->cause = data[5];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    activation_mode_decode(&tsdu->activation_mode, &br);
+    tsdu->group_id  = bit_reader_get(&br, 12);
+    cell_id_decode(&tsdu->cell_id, &br);
+    bit_reader_skip(&br, 4);
+    tsdu->cause = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
-static tsdu_d_emergency_nak_t *d_emergency_nak_decode(const uint8_t *data, int len)
+static tsdu_d_emergency_nak_t *d_emergency_nak_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_emergency_nak_t *tsdu = tsdu_create(tsdu_d_emergency_nak_t, 0);
+    tsdu_d_emergency_nak_t *tsdu = tsdu_create(arena, tsdu_d_emergency_nak_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -300,32 +481,36 @@ static tsdu_d_emergency_nak_t *d_emergency_nak_decode(const uint8_t *data, int l
     return tsdu;
 }
 
-static tsdu_d_extended_status_t *d_extended_status_decode(const uint8_t *data, int len)
+static tsdu_d_extended_status_t *d_extended_status_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_extended_status_t *tsdu = tsdu_create(tsdu_d_extended_status_t, 0);
+    tsdu_d_extended_status_t *tsdu = tsdu_create(arena, tsdu_d_extended_status_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 8, tsdu);
     
-    tsdu->rt_status_code             = data[1];
-    tsdu->rt_status_info             = data[2];
-    const uint8_t *adr_data = &data[3];
-    if (address_decode(&tsdu->calling_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->rt_status_code             = bit_reader_get(&br, 8);
+    tsdu->rt_status_info             = bit_reader_get(&br, 8);
+    if (address_decode(&tsdu->calling_adr, &br)) {
         LOG(ERR, "Only single address is supported in calling_adr");
     }
-    tsdu->call_priority         = get_bits(4, data + 8, 0);
-    const uint8_t *called_adr_data = &data[9];
-    if (address_decode(&tsdu->called_adr, &called_adr_data)) {
+    bit_reader_seek(&br, 8 * 8);
+    tsdu->call_priority         = bit_reader_get(&br, 4);
+    bit_reader_seek(&br, 8 * 9);
+    if (address_decode(&tsdu->called_adr, &br)) {
         LOG(ERR, "Only single address is supported in called_adr");
     }
 
     return tsdu;
 }
 
-static tsdu_d_group_end_t *d_group_end_decode(const uint8_t *data, int len)
+static tsdu_d_group_end_t *d_group_end_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_group_end_t *tsdu = tsdu_create(tsdu_d_group_end_t, 0);
+    tsdu_d_group_end_t *tsdu = tsdu_create(arena, tsdu_d_group_end_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -335,20 +520,74 @@ static tsdu_d_group_end_t *d_group_end_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_information_delivery_t *d_information_delivery_decode(const uint8_t *data, int len)
+/**
+  Append 12 bit OG numbers to list, reading stops at end of data.
+
+  @return false when list does not fit into ogs array.
+  */
+static bool og_list_decode(uint16_t *ogs, int *nb_ogs, int max_ogs,
+        int nb_og, bit_reader_t *br)
 {
-    tsdu_d_information_delivery_t *tsdu = tsdu_create(tsdu_d_information_delivery_t, 0);
+    if (*nb_ogs + nb_og > max_ogs) {
+        LOG(WTF, "Too many OGs %d", *nb_ogs + nb_og);
+        return false;
+    }
+    for (int i = 0; i < nb_og; ++i) {
+        const uint16_t og = bit_reader_get(br, 12);
+        if (br->overflow) {
+            break;
+        }
+        ogs[(*nb_ogs)++] = og;
+    }
+
+    return true;
+}
+
+/**
+  Append talkgroups with coverage to list, reading stops at end of data.
+
+  @return false when list does not fit into tkgs array.
+  */
+static bool tkg_list_decode(uint16_t *tkgs, uint8_t *covs, int *nb_tkgs,
+        int max_tkgs, int nb_tkg, bit_reader_t *br)
+{
+    if (*nb_tkgs + nb_tkg > max_tkgs) {
+        LOG(WTF, "Too many talkgroups %d", *nb_tkgs + nb_tkg);
+        return false;
+    }
+    for (int i = 0; i < nb_tkg; ++i) {
+        bit_reader_skip(br, 4);
+        const uint16_t tkg = bit_reader_get(br, 12);
+        const uint8_t cov = bit_reader_get(br, 8);
+        if (br->overflow) {
+            break;
+        }
+        tkgs[*nb_tkgs] = tkg;
+        covs[*nb_tkgs] = cov;
+        ++*nb_tkgs;
+    }
+
+    return true;
+}
+
+static tsdu_d_information_delivery_t *d_information_delivery_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
+{
+    tsdu_d_information_delivery_t *tsdu = tsdu_create(arena, tsdu_d_information_delivery_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 2, tsdu); //TODO check min size
 
     int i = 1;
-    int j;
 
     // raw data
     tsdu->len = len;
-    tsdu->data = malloc(len);
+    tsdu->data = tsdu_alloc(arena, len);
+    if (!tsdu->data) {
+        tsdu_destroy(&tsdu->base);
+        return NULL;
+    }
     memcpy(tsdu->data, data, len);
 
     tsdu->nb_network_og = 0;
@@ -364,57 +603,59 @@ static tsdu_d_information_delivery_t *d_information_delivery_decode(const uint8_
     
     bool quit = false;
 
-    t_i = data[i];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    t_i = bit_reader_get(&br, 8);
     while (t_i != 0 && !quit){        
         switch(t_i) {
             case 0x00: // not significant
                 //TODO
                 break;
             case 0x01: // network OG
-                l_i = data[i+1];
+                l_i = bit_reader_get(&br, 8);
                 if (l_i != 0) {
                     nb_og = (l_i * 8)/12;
-                    for (j=0; j<nb_og; j++){
-                        tsdu->network_og[tsdu->nb_network_og] = get_bits(12, data + i + 2, j*12);
-                        tsdu->nb_network_og++;
+                    if (!og_list_decode(tsdu->network_og, &tsdu->nb_network_og,
+                                ARRAY_LEN(tsdu->network_og), nb_og, &br)) {
+                        goto err;
                     }
                 } else {
 			tsdu->nb_network_og = 0;
 		}
                 break;
             case 0x02: // local OG
-                l_i = data[i+1];
+                l_i = bit_reader_get(&br, 8);
 		if (l_i != 0) {
                     nb_og = (l_i * 8)/12;
-                    for (j=0; j<nb_og; j++){
-                        tsdu->local_og[tsdu->nb_local_og] = get_bits(12, data + i + 2, j*12);
-                        tsdu->nb_local_og++;
+                    if (!og_list_decode(tsdu->local_og, &tsdu->nb_local_og,
+                                ARRAY_LEN(tsdu->local_og), nb_og, &br)) {
+                        goto err;
                     }
 		} else {
 		    tsdu->nb_local_og = 0;
 		}
                 break;
             case 0x03: // network talkgroup
-                l_i = data[i+1];
+                l_i = bit_reader_get(&br, 8);
 		if (l_i != 0) {
                     nb_tkg = l_i/3;
-                    for (j=0; j<nb_tkg; j++){
-                        tsdu->network_tkg[tsdu->nb_network_tkg] = get_bits(12, data + i + 2 + j*3, 4);
-                        tsdu->network_tkg_cov[tsdu->nb_network_tkg] = data[i + 4 + j*3];
-                        tsdu->nb_network_tkg++;		
+                    if (!tkg_list_decode(tsdu->network_tkg,
+                                tsdu->network_tkg_cov, &tsdu->nb_network_tkg,
+                                ARRAY_LEN(tsdu->network_tkg), nb_tkg, &br)) {
+                        goto err;
                     }
 		} else {
 		    tsdu->nb_network_tkg = 0;
 		}
                 break;
             case 0x04: // local talkgroup
-                l_i = data[i+1];
+                l_i = bit_reader_get(&br, 8);
 		if (l_i != 0) {
                     nb_tkg = l_i/3;
-                    for (j=0; j<nb_tkg; j++){
-                        tsdu->local_tkg[tsdu->nb_local_tkg] = get_bits(12, data + i + 2 + j*3, 4);
-                        tsdu->local_tkg_cov[tsdu->nb_local_tkg] = data[i + 4 + j*3];
-                        tsdu->nb_local_tkg++;
+                    if (!tkg_list_decode(tsdu->local_tkg,
+                                tsdu->local_tkg_cov, &tsdu->nb_local_tkg,
+                                ARRAY_LEN(tsdu->local_tkg), nb_tkg, &br)) {
+                        goto err;
                     }
 		} else {
                     tsdu->nb_local_tkg = 0;
@@ -422,7 +663,8 @@ static tsdu_d_information_delivery_t *d_information_delivery_decode(const uint8_
                 break;
 	    }
         i = i + 2 + l_i;
-        t_i = data[i];
+        bit_reader_seek(&br, 8 * i);
+        t_i = bit_reader_get(&br, 8);
 	// *** TODO remove below after testing, just avoiding infinite loop...
         if (i > 1000) {
 	    LOG(ERR, "Infinite loop during d_information_delivery analysis...");
@@ -430,20 +672,30 @@ static tsdu_d_information_delivery_t *d_information_delivery_decode(const uint8_
 	}       
     }  
     return tsdu;
+
+err:
+    // raw data are not released by tsdu_destroy()
+    if (!tsdu->base.arena) {
+        free(tsdu->data);
+    }
+    tsdu_destroy(&tsdu->base);
+    return NULL;
 }
 
-static tsdu_d_transfer_nak_t *d_transfer_nak_decode(const uint8_t *data, int len)
+static tsdu_d_transfer_nak_t *d_transfer_nak_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_transfer_nak_t *tsdu = tsdu_create(tsdu_d_transfer_nak_t, 0);
+    tsdu_d_transfer_nak_t *tsdu = tsdu_create(arena, tsdu_d_transfer_nak_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 8, tsdu);
 
-    tsdu->cause = data[1];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->cause = bit_reader_get(&br, 8);
     if (tsdu->cause == 0x15) { // PAS 0001-3-1 5.4.8.2 "inconsistent address", PAS 0001-3-2 5.2 value 0x15
-        const uint8_t *adr_data = &data[2];
-        if (address_decode(&tsdu->transfer_adr, &adr_data)) {
+        if (address_decode(&tsdu->transfer_adr, &br)) {
             LOG(ERR, "Only single address is supported in transfer_adr");
 	}
 	tsdu->has_transfer_adr = true;
@@ -456,41 +708,46 @@ static tsdu_d_transfer_nak_t *d_transfer_nak_decode(const uint8_t *data, int len
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
-static tsdu_d_group_reject_t *d_group_reject_decode(const uint8_t *data, int len)
+static tsdu_d_group_reject_t *d_group_reject_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 6, NULL);
 
-    tsdu_d_group_reject_t *tsdu = tsdu_create(tsdu_d_group_reject_t, 0);
+    tsdu_d_group_reject_t *tsdu = tsdu_create(arena, tsdu_d_group_reject_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    activation_mode_decode(&tsdu->activation_mode, data[1]);
-    tsdu->group_id  = get_bits(12, data + 1, 4);
-    tsdu->coverage_id = data[3];
-    tsdu->_zero = data[4];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    activation_mode_decode(&tsdu->activation_mode, &br);
+    tsdu->group_id  = bit_reader_get(&br, 12);
+    tsdu->coverage_id = bit_reader_get(&br, 8);
+    tsdu->_zero = bit_reader_get(&br, 8);
     if (tsdu->_zero) {
         LOG(WTF, "Nonzero zero=0x%02x", tsdu->_zero);
     }
-    tsdu->cause = data[5];
+    tsdu->cause = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
-static tsdu_d_cch_open_t *d_cch_open_decode(const uint8_t *data, int len)
+static tsdu_d_cch_open_t *d_cch_open_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len != 1) {
         LOG(WTF, "Invalid len 1 != %d", len);
         return NULL;
     }
-    return tsdu_create(tsdu_d_cch_open_t, 0);
+    return tsdu_create(arena, tsdu_d_cch_open_t, 0);
 }
 
-static tsdu_d_refusal_t *d_refusal_decode(const uint8_t *data, int len)
+static tsdu_d_refusal_t *d_refusal_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 2, NULL);
 
-    tsdu_d_refusal_t *tsdu = tsdu_create(tsdu_d_refusal_t, 0);
+    tsdu_d_refusal_t *tsdu = tsdu_create(arena, tsdu_d_refusal_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -499,11 +756,12 @@ static tsdu_d_refusal_t *d_refusal_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_reject_t *d_reject_decode(const uint8_t *data, int len)
+static tsdu_d_reject_t *d_reject_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 2, NULL);
 
-    tsdu_d_reject_t *tsdu = tsdu_create(tsdu_d_reject_t, 0);
+    tsdu_d_reject_t *tsdu = tsdu_create(arena, tsdu_d_reject_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -512,17 +770,18 @@ static tsdu_d_reject_t *d_reject_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_call_alert_t *d_call_alert_decode(const uint8_t *data, int len)
+static tsdu_d_call_alert_t *d_call_alert_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    return tsdu_create(tsdu_d_call_alert_t, 0);
+    return tsdu_create(arena, tsdu_d_call_alert_t, 0);
 }
 
 static tsdu_d_hook_on_invitation_t *d_hook_on_invitation_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 2, NULL);
 
-    tsdu_d_hook_on_invitation_t *tsdu = tsdu_create(tsdu_d_hook_on_invitation_t, 0);
+    tsdu_d_hook_on_invitation_t *tsdu = tsdu_create(arena, tsdu_d_hook_on_invitation_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -531,11 +790,12 @@ static tsdu_d_hook_on_invitation_t *d_hook_on_invitation_decode(
     return tsdu;
 }
 
-static tsdu_d_release_t *d_release_decode(const uint8_t *data, int len)
+static tsdu_d_release_t *d_release_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 2, NULL);
 
-    tsdu_d_release_t *tsdu = tsdu_create(tsdu_d_release_t, 0);
+    tsdu_d_release_t *tsdu = tsdu_create(arena, tsdu_d_release_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -544,32 +804,64 @@ static tsdu_d_release_t *d_release_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
+static int address_list_decode(address_list_t **ptr_addrs,
+        bit_reader_t *br, tsdu_arena_t *arena)
+{
+    address_list_t *addrs = *ptr_addrs;
+    bool next;
+    do {
+        const int n = addrs ? (addrs->nadrs + 1) : 1;
+        const int l = sizeof(address_list_t) + n * sizeof(address_t);
+        address_list_t *p = tsdu_realloc(arena, addrs, l);
+        if (!p) {
+            *ptr_addrs = addrs;
+            return -1;
+        }
+        addrs = p;
+        addrs->nadrs = n;
+        const int pos = bit_reader_tell(br);
+        next = address_decode(&addrs->called_adr[addrs->nadrs-1], br);
+        // length of unsupported address is unknown, list can't continue
+        if (bit_reader_tell(br) == pos) {
+            break;
+        }
+    } while (next && !br->overflow);
+
+    *ptr_addrs = addrs;
+
+    return 0;
+}
+
 static tsdu_d_additional_participants_t *d_additional_participants_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 7, NULL);
 
-    tsdu_d_additional_participants_t *tsdu = tsdu_create(
+    tsdu_d_additional_participants_t *tsdu = tsdu_create(arena,
             tsdu_d_additional_participants_t, 1);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu->coverage_id = data[1];
-    if (address_list_decode(&tsdu->calling_adr, &data[2]) == -1) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->coverage_id = bit_reader_get(&br, 8);
+    if (address_list_decode(&tsdu->calling_adr, &br, arena) == -1) {
         tsdu_destroy(&tsdu->base);
         return NULL;
     }
 
     if (len >= 8) {
-        if (address_list_decode(&tsdu->calling_adr, &data[7]) == -1) {
+        bit_reader_seek(&br, 8 * 7);
+        if (address_list_decode(&tsdu->calling_adr, &br, arena) == -1) {
             tsdu_destroy(&tsdu->base);
             return NULL;
         }
     }
 
     if (len >= 13) {
-        if (address_list_decode(&tsdu->calling_adr, &data[12]) == -1) {
+        bit_reader_seek(&br, 8 * 12);
+        if (address_list_decode(&tsdu->calling_adr, &br, arena) == -1) {
             tsdu_destroy(&tsdu->base);
             return NULL;
         }
@@ -578,76 +870,86 @@ static tsdu_d_additional_participants_t *d_additional_participants_decode(
     return tsdu;
 }
 
-static tsdu_d_call_setup_t *d_call_setup_decode(const uint8_t *data, int len)
+static tsdu_d_call_setup_t *d_call_setup_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 6, NULL);
 
-    tsdu_d_call_setup_t *tsdu = tsdu_create(tsdu_d_call_setup_t, 0);
+    tsdu_d_call_setup_t *tsdu = tsdu_create(arena, tsdu_d_call_setup_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    const uint8_t *adr_data = &data[1];
-    if (address_decode(&tsdu->calling_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    if (address_decode(&tsdu->calling_adr, &br)) {
         LOG(ERR, "Only single address is supported in calling_adr");
     }
 
     tsdu->has_add_setup_param = false;
     if (len >= 8) {
-        tsdu->has_add_setup_param = (data[6] == IEI_ADD_SETUP_PARAM);
+        bit_reader_seek(&br, 8 * 6);
+        const uint8_t iei = bit_reader_get(&br, 8);
+        tsdu->has_add_setup_param = (iei == IEI_ADD_SETUP_PARAM);
         if (!tsdu->has_add_setup_param) {
-            LOG(WTF, "Unexpected IEI 0x%02x", data[6]);
+            LOG(WTF, "Unexpected IEI 0x%02x", iei);
             return tsdu;
         }
-        tsdu->add_setup_param._data = data[7];
+        tsdu->add_setup_param._data = bit_reader_get(&br, 8);
     }
 
     return tsdu;
 }
 
-static tsdu_d_ability_mngt_t *d_ability_mngt_decode(const uint8_t *data, int len)
+static tsdu_d_ability_mngt_t *d_ability_mngt_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len - 1 > SIZEOF(tsdu_d_ability_mngt_t, data)) {
         LOG(WTF, "Message too long %d", len - 1);
         return NULL;
     }
 
-    tsdu_d_ability_mngt_t *tsdu = tsdu_create(tsdu_d_ability_mngt_t, 0);
+    tsdu_d_ability_mngt_t *tsdu = tsdu_create(arena, tsdu_d_ability_mngt_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     tsdu->data_len = len - 1;
-    memcpy(tsdu->data, &data[1], len - 1);
+    bit_reader_get_bytes(&br, tsdu->data, len - 1);
 
     return tsdu;
 }
 
-static tsdu_d_dch_open_t *d_dch_open_decode(const uint8_t *data, int len)
+static tsdu_d_dch_open_t *d_dch_open_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len != 1) {
         LOG(WTF, "Invalid len 1 != %d", len);
         return NULL;
     }
 
-    return tsdu_create(tsdu_d_dch_open_t, 0);
+    return tsdu_create(arena, tsdu_d_dch_open_t, 0);
 }
 
-static tsdu_d_ddch_description_t *d_ddch_description_decode(const uint8_t *data, int len)
+static tsdu_d_ddch_description_t *d_ddch_description_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
 
     if (len < 5) {
        LOG(WTF, "Data too short: %d < 5", len);
        return NULL;
     }
-    tsdu_d_ddch_description_t *tsdu = malloc(sizeof(tsdu_d_ddch_description_t));
+    tsdu_d_ddch_description_t *tsdu = tsdu_create(arena,
+            tsdu_d_ddch_description_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu_base_set_nopts(&tsdu->base, 0);
-
-    tsdu->nb_ddch = get_bits(4, &data[1], 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->nb_ddch = bit_reader_get(&br, 4);
     if (tsdu->nb_ddch > 3) {
         LOG(WTF, "Too large NB_DDCH %d", tsdu->nb_ddch);
         tsdu_destroy(&tsdu->base);
@@ -661,66 +963,77 @@ static tsdu_d_ddch_description_t *d_ddch_description_decode(const uint8_t *data,
 	return NULL;
     }
     // decoding
+    for (int i = 0; i < tsdu->nb_ddch; ++i) {
+        tsdu->channel_id[i] = bit_reader_get(&br, 12);
+    }
+    // scrambling of all DDCHs follows
     int start_pos_scr = (expected_len - 2*tsdu->nb_ddch) - 1;
+    bit_reader_seek(&br, 8 * (1 + start_pos_scr));
     for (int i = 0; i < tsdu->nb_ddch; ++i) {
-        tsdu->channel_id[i] = get_bits(12, &data[1], 4 + 12*i);
-	int pos_x = 1 + start_pos_scr + 2*i;
-        tsdu->u_ch_scrambling[i] = get_bits(8, &data[pos_x], 0);
-        tsdu->d_ch_scrambling[i] = get_bits(8, &data[pos_x+1], 0);
+        tsdu->u_ch_scrambling[i] = bit_reader_get(&br, 8);
+        tsdu->d_ch_scrambling[i] = bit_reader_get(&br, 8);
     }
     return tsdu;
 }
 
-static tsdu_d_data_request_t *d_data_request_decode(const uint8_t *data, int len)
+static tsdu_d_data_request_t *d_data_request_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 16, NULL);
 
-    tsdu_d_data_request_t *tsdu = tsdu_create(tsdu_d_data_request_t, 0);
+    tsdu_d_data_request_t *tsdu = tsdu_create(arena, tsdu_d_data_request_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu->key_reference_auth._data = data[1];
-    memcpy(tsdu->valid_rt, &data[2], sizeof(tsdu->valid_rt));
-    tsdu->key_reference_ciph._data = data[10];
-    tsdu->trans_mode =      get_bits(4, &data[11], 4);
-    tsdu->trans_param1 =    get_bits(16, &data[12], 0);
-    tsdu->trans_param2 =    get_bits(16, &data[14], 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->key_reference_auth._data = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->valid_rt, sizeof(tsdu->valid_rt));
+    tsdu->key_reference_ciph._data = bit_reader_get(&br, 8);
+    bit_reader_skip(&br, 4);
+    tsdu->trans_mode =      bit_reader_get(&br, 4);
+    tsdu->trans_param1 =    bit_reader_get(&br, 16);
+    tsdu->trans_param2 =    bit_reader_get(&br, 16);
     tsdu->has_trans_param3 = (tsdu->trans_mode == TRANS_MODE_UDP_MSG);
     if (tsdu->has_trans_param3) {
         CHECK_LEN(len, 18, tsdu);
-        tsdu->trans_param3 = get_bits(16, &data[16], 0);
+        tsdu->trans_param3 = bit_reader_get(&br, 16);
     }
     return tsdu;
 }
 
-static tsdu_d_connect_cch_t *d_connect_cch_decode(const uint8_t *data, int len)
+static tsdu_d_connect_cch_t *d_connect_cch_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len != 1) {
         LOG(WTF, "Invalid len 1 != %d", len);
         return NULL;
     }
 
-    return tsdu_create(tsdu_d_connect_cch_t, 0);
+    return tsdu_create(arena, tsdu_d_connect_cch_t, 0);
 }
 
 static tsdu_d_data_authentication_t *d_data_authentication_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 11, NULL);
 
-    tsdu_d_data_authentication_t *tsdu = tsdu_create(tsdu_d_data_authentication_t, 0);
+    tsdu_d_data_authentication_t *tsdu = tsdu_create(arena, tsdu_d_data_authentication_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu->key_reference_auth._data = data[1];
-    memcpy(tsdu->valid_rt, &data[2], sizeof(tsdu->valid_rt));
-    tsdu->key_reference_ciph._data = data[10];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->key_reference_auth._data = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->valid_rt, sizeof(tsdu->valid_rt));
+    tsdu->key_reference_ciph._data = bit_reader_get(&br, 8);
     return tsdu;
 }
 
-static tsdu_d_data_msg_down_t *d_data_msg_down_decode(const uint8_t *data, int len)
+static tsdu_d_data_msg_down_t *d_data_msg_down_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len - 1 > SIZEOF(tsdu_d_data_msg_down_t, data)) {
         LOG(WTF, "Message too large %d > %d",
@@ -728,90 +1041,103 @@ static tsdu_d_data_msg_down_t *d_data_msg_down_decode(const uint8_t *data, int l
         return NULL;
     }
 
-    tsdu_d_data_msg_down_t *tsdu = tsdu_create(tsdu_d_data_msg_down_t, 0);
+    tsdu_d_data_msg_down_t *tsdu = tsdu_create(arena, tsdu_d_data_msg_down_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     tsdu->data_len = len - 1;
-    memcpy(tsdu->data, &data[1], tsdu->data_len);
+    bit_reader_get_bytes(&br, tsdu->data, tsdu->data_len);
 
     return tsdu;
 }
 
 static tsdu_d_authorisation_t *
-d_authorisation_decode(const uint8_t *data, int len)
+d_authorisation_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_d_authorisation_t *tsdu = tsdu_create(tsdu_d_authorisation_t, 0);
+    tsdu_d_authorisation_t *tsdu = tsdu_create(arena, tsdu_d_authorisation_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 8, tsdu);
 
-    tsdu->has_key_reference = (data[1] == IEI_KEY_REFERENCE);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->has_key_reference = (bit_reader_get(&br, 8) == IEI_KEY_REFERENCE);
     if (tsdu->has_key_reference) {
-        tsdu->key_reference._data = data[2];
+        tsdu->key_reference._data = bit_reader_get(&br, 8);
     }
 
     return tsdu;
 }
 
-static tsdu_d_group_paging_t *d_group_paging_decode(const uint8_t *data, int len)
+static tsdu_d_group_paging_t *d_group_paging_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_group_paging_t *tsdu = tsdu_create(tsdu_d_group_paging_t, 0);
+    tsdu_d_group_paging_t *tsdu = tsdu_create(arena, tsdu_d_group_paging_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 5, tsdu);
 
-    activation_mode_decode(&tsdu->activation_mode, data[1]);
-    tsdu->group_id              = get_bits(12, &data[1], 4);
-    tsdu->coverage_id           = get_bits(8,  &data[3], 0);
-    tsdu->key_reference._data   = get_bits(8,  &data[4], 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    activation_mode_decode(&tsdu->activation_mode, &br);
+    tsdu->group_id              = bit_reader_get(&br, 12);
+    tsdu->coverage_id           = bit_reader_get(&br, 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
 static tsdu_d_forced_registration_t *
-d_forced_registration_decode(const uint8_t *data, int len)
+d_forced_registration_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_d_forced_registration_t *tsdu = tsdu_create(tsdu_d_forced_registration_t, 0);
+    tsdu_d_forced_registration_t *tsdu = tsdu_create(arena, tsdu_d_forced_registration_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 9, tsdu);
 
-    const uint8_t *adr_data = &data[1];
-    if (address_decode(&tsdu->calling_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    if (address_decode(&tsdu->calling_adr, &br)) {
         LOG(ERR, "Only single address is supported in calling_adr");
     }
     return tsdu;
 }
 
-static tsdu_d_ech_activation_t * d_ech_activation_decode(const uint8_t *data, int len)
+static tsdu_d_ech_activation_t * d_ech_activation_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_ech_activation_t *tsdu = tsdu_create(tsdu_d_ech_activation_t, 0);
+    tsdu_d_ech_activation_t *tsdu = tsdu_create(arena, tsdu_d_ech_activation_t, 0);
     if (!tsdu) {
 	return NULL;
     }
     CHECK_LEN(len, 9, tsdu);
 
-    activation_mode_decode(&tsdu->activation_mode, data[1]);
-    tsdu->group_id              = get_bits(12, data + 1, 4);
-    cell_id_decode1(&tsdu->cell_id, data + 3);
-    tsdu->channel_id            = get_bits(12, data + 4, 4);
-    tsdu->u_ch_scrambling       = get_bits(8,  data + 6, 0);
-    tsdu->d_ch_scrambling       = get_bits(8,  data + 7, 0);
-    tsdu->key_reference._data   = get_bits(8,  data + 8, 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    activation_mode_decode(&tsdu->activation_mode, &br);
+    tsdu->group_id              = bit_reader_get(&br, 12);
+    cell_id_decode(&tsdu->cell_id, &br);
+    tsdu->channel_id            = bit_reader_get(&br, 12);
+    tsdu->u_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->d_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
     tsdu->has_addr_tti = false;
     if (len >= 12) {
         // FIXME: proper IEI handling
-        uint8_t iei = get_bits(8, data + 9, 0);
+        uint8_t iei = bit_reader_get(&br, 8);
         if (iei != IEI_TTI) {
             LOG(WTF, "expected IEI_TTI got %d", iei);
         } else {
             tsdu->has_addr_tti = true;
-            addr_parse(&tsdu->addr_tti, &data[10], 0);
+            uint8_t addr_tti[2];
+            bit_reader_get_bytes(&br, addr_tti, sizeof(addr_tti));
+            addr_parse(&tsdu->addr_tti, addr_tti, 0);
         }
     }
 
@@ -822,29 +1148,32 @@ static tsdu_d_ech_activation_t * d_ech_activation_decode(const uint8_t *data, in
     return tsdu;
 }
 
-static tsdu_d_emergency_notification_t * d_emergency_notification_decode(const uint8_t *data, int len)
+static tsdu_d_emergency_notification_t * d_emergency_notification_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_emergency_notification_t *tsdu = tsdu_create(tsdu_d_emergency_notification_t, 0);
+    tsdu_d_emergency_notification_t *tsdu = tsdu_create(arena, tsdu_d_emergency_notification_t, 0);
     if (!tsdu) {
 	return NULL;
     }
 
     CHECK_LEN(len, 8, tsdu);
 
-    const uint8_t *adr_data = &data[1];
-    if (address_decode(&tsdu->calling_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    if (address_decode(&tsdu->calling_adr, &br)) {
         LOG(ERR, "Only single address is supported in calling_adr");
     }
 
-    cell_id_decode1(&tsdu->cell_id, data + 6);
+    bit_reader_seek(&br, 8 * 6);
+    cell_id_decode(&tsdu->cell_id, &br);
 
     return tsdu;
 }
 	
 static tsdu_d_group_activation_t *
-d_group_activation_decode(const uint8_t *data, int len)
+d_group_activation_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_d_group_activation_t *tsdu = tsdu_create(tsdu_d_group_activation_t, 0);
+    tsdu_d_group_activation_t *tsdu = tsdu_create(arena, tsdu_d_group_activation_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -852,14 +1181,16 @@ d_group_activation_decode(const uint8_t *data, int len)
     CHECK_LEN(len, 9, tsdu);
 
     int _zero0;
-    activation_mode_decode(&tsdu->activation_mode, data[1]);
-    tsdu->group_id              = get_bits(12, data + 1, 4);
-    tsdu->coverage_id           = get_bits(8,  data + 3, 0);
-    _zero0                      = get_bits(4,  data + 4, 0);
-    tsdu->channel_id            = get_bits(12, data + 4, 4);
-    tsdu->u_ch_scrambling       = get_bits(8,  data + 6, 0);
-    tsdu->d_ch_scrambling       = get_bits(8,  data + 7, 0);
-    tsdu->key_reference._data   = get_bits(8,  data + 8, 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    activation_mode_decode(&tsdu->activation_mode, &br);
+    tsdu->group_id              = bit_reader_get(&br, 12);
+    tsdu->coverage_id           = bit_reader_get(&br, 8);
+    _zero0                      = bit_reader_get(&br, 4);
+    tsdu->channel_id            = bit_reader_get(&br, 12);
+    tsdu->u_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->d_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
 
     if (_zero0 != 0) {
         LOG(WTF, "nonzero padding: 0x%02x", _zero0);
@@ -868,12 +1199,14 @@ d_group_activation_decode(const uint8_t *data, int len)
     tsdu->has_addr_tti = false;
     if (len >= 12) {
         // FIXME: proper IEI handling
-        uint8_t iei = get_bits(8, data + 9, 0);
+        uint8_t iei = bit_reader_get(&br, 8);
         if (iei != IEI_TTI) {
             LOG(WTF, "expected IEI_TTI got %d", iei);
         } else {
             tsdu->has_addr_tti = true;
-            addr_parse(&tsdu->addr_tti, &data[10], 0);
+            uint8_t addr_tti[2];
+            bit_reader_get_bytes(&br, addr_tti, sizeof(addr_tti));
+            addr_parse(&tsdu->addr_tti, addr_tti, 0);
         }
     }
 
@@ -884,9 +1217,10 @@ d_group_activation_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len)
+static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_group_list_t *tsdu = tsdu_create(tsdu_d_group_list_t, 3);
+    tsdu_d_group_list_t *tsdu = tsdu_create(arena, tsdu_d_group_list_t, 3);
     if (!tsdu) {
         return NULL;
     }
@@ -897,30 +1231,31 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len)
 
     int rlen = 2; ///< required data length
     CHECK_LEN(len, rlen, tsdu);
-    tsdu->reference_list._data = get_bits(8, data + 1, 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->reference_list._data = bit_reader_get(&br, 8);
     if (tsdu->reference_list.revision == 0) {
         return tsdu;
     }
 
     rlen += 1;
     CHECK_LEN(len, rlen, tsdu);
-    tsdu->index_list._data = get_bits(8, data + 2, 0);
-    data += 3;
+    tsdu->index_list._data = bit_reader_get(&br, 8);
     do {
         rlen += 1;
         CHECK_LEN(len, rlen, tsdu);
         const type_nb_t type_nb = {
-            ._data = get_bits(8, data, 0),
+            ._data = bit_reader_get(&br, 8),
         };
         if (type_nb.type == TYPE_NB_TYPE_END) {
             break;
         }
-        data += 1;
 
         if (type_nb.type == TYPE_NB_TYPE_EMERGENCY) {
             const int n = tsdu->nemergency + type_nb.number;
             const int l = sizeof(tsdu_d_group_list_emergency_t[n]);
-            tsdu_d_group_list_emergency_t *p = realloc(tsdu->emergency, l);
+            tsdu_d_group_list_emergency_t *p =
+                tsdu_realloc(arena, tsdu->emergency, l);
             if (!p) {
                 tsdu_destroy(&tsdu->base);
                 return NULL;
@@ -932,19 +1267,19 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len)
                     break;
                 }
                 const int i = tsdu->nemergency;
-                cell_id_decode1(&tsdu->emergency[i].cell_id, data);
-                int zero = get_bits(4, data + 1, 4);
+                cell_id_decode(&tsdu->emergency[i].cell_id, &br);
+                int zero = bit_reader_get(&br, 4);
                 if (zero != 0) {
                     LOG(WTF, "nonzero padding (%d)", zero);
                 }
-                data += 2;
             }
         }
 
         if (type_nb.type == TYPE_NB_TYPE_OPEN) {
             const int n = tsdu->nopen + type_nb.number;
             const int l = sizeof(tsdu_d_group_list_open_t[n]);
-            tsdu_d_group_list_open_t *p = realloc(tsdu->open, l);
+            tsdu_d_group_list_open_t *p =
+                tsdu_realloc(arena, tsdu->open, l);
             if (!p) {
                 tsdu_destroy(&tsdu->base);
                 return NULL;
@@ -956,23 +1291,23 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len)
                     break;
                 }
                 const int i = tsdu->nopen;
-                tsdu->open[i].coverage_id           = get_bits(8, data, 0);
-                tsdu->open[i].call_priority         = get_bits(4, data + 1, 0);
-                tsdu->open[i].group_id              = get_bits(12, data + 1, 4);
-                uint8_t padding                     = get_bits(2, data + 3, 0);
+                tsdu->open[i].coverage_id           = bit_reader_get(&br, 8);
+                tsdu->open[i].call_priority         = bit_reader_get(&br, 4);
+                tsdu->open[i].group_id              = bit_reader_get(&br, 12);
+                uint8_t padding                     = bit_reader_get(&br, 2);
                 if (padding != 0) {
                     LOG(WTF, "nonzero padding (%d)", padding);
                 }
-                tsdu->open[i].och_parameters.add    = get_bits(1, data + 3, 2);
-                tsdu->open[i].och_parameters.mbn    = get_bits(1, data + 3, 3);
-                tsdu->open[i].neighbouring_cell     = get_bits(12, data + 3, 4);
-                data += 5;
+                tsdu->open[i].och_parameters.add    = bit_reader_get(&br, 1);
+                tsdu->open[i].och_parameters.mbn    = bit_reader_get(&br, 1);
+                tsdu->open[i].neighbouring_cell     = bit_reader_get(&br, 12);
             }
         }
         if (type_nb.type == TYPE_NB_TYPE_TALK_GROUP) {
             const int n = tsdu->ngroup + type_nb.number;
             const int l = sizeof(tsdu_d_group_list_talk_group_t[n]);
-            tsdu_d_group_list_talk_group_t *p = realloc(tsdu->group, l);
+            tsdu_d_group_list_talk_group_t *p =
+                tsdu_realloc(arena, tsdu->group, l);
             if (!p) {
                 tsdu_destroy(&tsdu->base);
                 return NULL;
@@ -984,20 +1319,20 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len)
                     break;
                 }
                 const int i = tsdu->ngroup;
-                tsdu->group[i].coverage_id          = get_bits(8, data, 0);
-                uint8_t zero                        = get_bits(8, data + 1, 0);
+                tsdu->group[i].coverage_id          = bit_reader_get(&br, 8);
+                uint8_t zero                        = bit_reader_get(&br, 8);
                 if (zero != 0) {
                     LOG(WTF, "nonzero padding in talk group-1 (%d)", zero);
                 }
 		/* // deprecated : no more zero padding for the first 4 bytes
-                uint8_t padding                     = get_bits(4, data + 2, 0);
+                uint8_t padding                     = bit_reader_get(&br, 4);
 		if (padding != 0) {
                     LOG(WTF, "nonzero padding in talk group-2 (%d)", padding);
                 }
 		*/
-                tsdu->group[i].tkg_parameters.mbn   = get_bits(1, data + 2, 3);
-                tsdu->group[i].neighbouring_cell    = get_bits(12, data + 2, 4);
-                data += 4;
+                bit_reader_skip(&br, 3);
+                tsdu->group[i].tkg_parameters.mbn   = bit_reader_get(&br, 1);
+                tsdu->group[i].neighbouring_cell    = bit_reader_get(&br, 12);
             }
         }
     } while(true);
@@ -1006,35 +1341,35 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int len)
 }
 
 static tsdu_d_group_composition_t *d_group_composition_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_d_group_composition_t *tsdu = tsdu_create(tsdu_d_group_composition_t, 0);
+    tsdu_d_group_composition_t *tsdu = tsdu_create(arena, tsdu_d_group_composition_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 3, tsdu);
 
-    tsdu->group_id = get_bits(12, data + 1, 0);
-    tsdu->og_nb = get_bits(4, data + 2, 4);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->group_id = bit_reader_get(&br, 12);
+    tsdu->og_nb = bit_reader_get(&br, 4);
 
     CHECK_LEN(len, 3 + (12*tsdu->og_nb + 7) / 8, tsdu);
 
-    int skip = 0;
     for (int i = 0; i < tsdu->og_nb; ++i) {
-        tsdu->group_ids[i] = get_bits(12, data + 3, skip);
-        skip += 12;
+        tsdu->group_ids[i] = bit_reader_get(&br, 12);
     }
 
     return tsdu;
 }
 
 static cell_id_list_t *iei_cell_id_list_decode(cell_id_list_t *cell_ids,
-        const uint8_t *data, int len)
+        bit_reader_t *br, int len, tsdu_arena_t *arena)
 {
     int n = cell_ids ? cell_ids->len : 0;
     n += len / 2;
-    cell_id_list_t *p = realloc(cell_ids,
+    cell_id_list_t *p = tsdu_realloc(arena, cell_ids,
             sizeof(cell_id_list_t) + sizeof(cell_id_t[n]));
     if (!p) {
         LOG(ERR, "ERR OOM");
@@ -1046,19 +1381,20 @@ static cell_id_list_t *iei_cell_id_list_decode(cell_id_list_t *cell_ids,
     cell_ids = p;
 
     for ( ; cell_ids->len < n; ++cell_ids->len) {
-        cell_id_decode1(&cell_ids->cell_ids[cell_ids->len], data);
-        data += 2;
+        cell_id_decode(&cell_ids->cell_ids[cell_ids->len], br);
+        bit_reader_skip(br, 4);
     }
 
     return cell_ids;
 }
 
 cell_bn_list_t *iei_cell_bn_list_decode(
-        cell_bn_list_t *cell_bns, const uint8_t *data, int len)
+        cell_bn_list_t *cell_bns, bit_reader_t *br, int len,
+        tsdu_arena_t *arena)
 {
     int n = cell_bns ? cell_bns->len : 0;
     n +=  len * 2 / 3;
-    cell_bn_list_t *p = realloc(cell_bns,
+    cell_bn_list_t *p = tsdu_realloc(arena, cell_bns,
             sizeof(cell_bn_list_t) + sizeof(cell_bn_t[n]));
     if (!p) {
         LOG(ERR, "ERR OOM");
@@ -1069,24 +1405,26 @@ cell_bn_list_t *iei_cell_bn_list_decode(
     }
     cell_bns = p;
 
-    for (int offs = 0; cell_bns->len < n; ++cell_bns->len) {
-        cell_bns->cell_bn[cell_bns->len]._data = get_bits(12, data, offs);
-        offs += 12;
+    for ( ; cell_bns->len < n; ++cell_bns->len) {
+        cell_bns->cell_bn[cell_bns->len]._data = bit_reader_get(br, 12);
     }
 
     return cell_bns;
 }
 
-static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *data, int len)
+static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_neighbouring_cell_t *tsdu = tsdu_create(tsdu_d_neighbouring_cell_t, 2);
+    tsdu_d_neighbouring_cell_t *tsdu = tsdu_create(arena, tsdu_d_neighbouring_cell_t, 2);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 2, tsdu);
 
-    uint8_t _zero                               = get_bits(4, data + 1, 0);
-    tsdu->ccr_config.number                     = get_bits(4, data + 1, 4);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    uint8_t _zero                               = bit_reader_get(&br, 4);
+    tsdu->ccr_config.number                     = bit_reader_get(&br, 4);
     if (_zero != 0) {
         LOG(WTF, "d_neighbouring_cell padding != 0 (%d)", _zero);
     }
@@ -1095,42 +1433,40 @@ static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *dat
         return tsdu;
     }
 
-    tsdu->ccr_param = data[2];
+    tsdu->ccr_param = bit_reader_get(&br, 8);
     if (tsdu->ccr_param) {
         LOG(WTF, "d_neighbouring_cell ccr_param != 0 (%d)", tsdu->ccr_param);
     }
 
-    data += 3;
     len -= 3;
     CHECK_LEN(len, 3 * tsdu->ccr_config.number, tsdu);
     for (int i = 0; i < tsdu->ccr_config.number; ++i) {
-        tsdu->adj_cells[i].bn_nb                = get_bits(4,  data, 0);
-        tsdu->adj_cells[i].channel_id           = get_bits(12, data, 4);
-        tsdu->adj_cells[i].adjacent_param._data = get_bits(8,  data + 2, 0);
+        tsdu->adj_cells[i].bn_nb                = bit_reader_get(&br, 4);
+        tsdu->adj_cells[i].channel_id           = bit_reader_get(&br, 12);
+        tsdu->adj_cells[i].adjacent_param._data = bit_reader_get(&br, 8);
         if (tsdu->adj_cells[i].adjacent_param._reserved) {
             LOG(WTF, "adjacent_param._reserved != 0");
         }
-        data += 3;
         len -= 3;
     }
 
     while (len > 0) {
         CHECK_LEN(len, 2, tsdu);
-        const uint8_t iei                       = get_bits(8, data, 0);
-        const uint8_t ie_len                    = get_bits(8, data + 1, 0);
-        data += 2;
+        const uint8_t iei                       = bit_reader_get(&br, 8);
+        const uint8_t ie_len                    = bit_reader_get(&br, 8);
         len -= 2;
         CHECK_LEN(len, ie_len, tsdu);
+        const int ie_pos = bit_reader_tell(&br);
         if (iei == IEI_CELL_ID_LIST && ie_len) {
             cell_id_list_t *p = iei_cell_id_list_decode(
-                    tsdu->cell_ids, data, ie_len);
+                    tsdu->cell_ids, &br, ie_len, arena);
             if (!p) {
                 break;
             }
             tsdu->cell_ids = p;
         } else if (iei == IEI_ADJACENT_BN_LIST && ie_len) {
             cell_bn_list_t *p = iei_cell_bn_list_decode(
-                    tsdu->cell_bns, data, ie_len);
+                    tsdu->cell_bns, &br, ie_len, arena);
             if (!p) {
                 break;
             }
@@ -1140,16 +1476,17 @@ static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *dat
                 LOG(WTF, "d_neighbouring_cell unknown iei (0x%x)", iei);
             }
         }
-        data += ie_len;
+        bit_reader_seek(&br, ie_pos + 8 * ie_len);
         len -= ie_len;
     }
 
     return tsdu;
 }
 
-static tsdu_d_system_info_t *d_system_info_decode(const uint8_t *data, int len)
+static tsdu_d_system_info_t *d_system_info_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_system_info_t *tsdu = tsdu_create(tsdu_d_system_info_t, 0);
+    tsdu_d_system_info_t *tsdu = tsdu_create(arena, tsdu_d_system_info_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -1157,26 +1494,28 @@ static tsdu_d_system_info_t *d_system_info_decode(const uint8_t *data, int len)
     // minimal size of disconnected mode
     CHECK_LEN(len, 9, tsdu);
 
-    tsdu->cell_state._data = get_bits(8, data + 1, 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->cell_state._data = bit_reader_get(&br, 8);
     switch (tsdu->cell_state.mode) {
         case CELL_STATE_MODE_NORMAL:
             CHECK_LEN(len, 17, tsdu);
-            tsdu->cell_config._data                     = get_bits( 8, data + 2, 0);
-            tsdu->country_code                          = get_bits( 8, data + 3, 0);
-            tsdu->system_id._data                       = get_bits( 8, data + 4, 0);
-            tsdu->loc_area_id._data                     = get_bits( 8, data + 5, 0);
-            tsdu->bn_id                                 = get_bits( 8, data + 6, 0);
-            cell_id_decode1(&tsdu->cell_id, data + 7);
-            tsdu->cell_bn._data                         = get_bits(12, data + 8, 4);
-            tsdu->u_ch_scrambling                       = get_bits( 8, data + 10, 0);
-            tsdu->cell_radio_param.tx_max               = get_bits( 3, data + 11, 0);
-            tsdu->cell_radio_param.radio_link_timeout   = get_bits( 5, data + 11, 3);
-            tsdu->cell_radio_param.pwr_tx_adjust        = get_bits( 4, data + 12, 0);
-            tsdu->cell_radio_param.rx_lev_access        = get_bits( 4, data + 12, 4);
-            tsdu->system_time                           = get_bits( 8, data + 13, 0);
-            tsdu->cell_access._data                     = get_bits( 8, data + 14, 0);
-            tsdu->_unused_1                             = get_bits( 4, data + 15, 0);
-            tsdu->superframe_cpt                        = get_bits(12, data + 15, 4);
+            tsdu->cell_config._data                     = bit_reader_get(&br, 8);
+            tsdu->country_code                          = bit_reader_get(&br, 8);
+            tsdu->system_id._data                       = bit_reader_get(&br, 8);
+            tsdu->loc_area_id._data                     = bit_reader_get(&br, 8);
+            tsdu->bn_id                                 = bit_reader_get(&br, 8);
+            cell_id_decode(&tsdu->cell_id, &br);
+            tsdu->cell_bn._data                         = bit_reader_get(&br, 12);
+            tsdu->u_ch_scrambling                       = bit_reader_get(&br, 8);
+            tsdu->cell_radio_param.tx_max               = bit_reader_get(&br, 3);
+            tsdu->cell_radio_param.radio_link_timeout   = bit_reader_get(&br, 5);
+            tsdu->cell_radio_param.pwr_tx_adjust        = bit_reader_get(&br, 4);
+            tsdu->cell_radio_param.rx_lev_access        = bit_reader_get(&br, 4);
+            tsdu->system_time                           = bit_reader_get(&br, 8);
+            tsdu->cell_access._data                     = bit_reader_get(&br, 8);
+            tsdu->_unused_1                             = bit_reader_get(&br, 4);
+            tsdu->superframe_cpt                        = bit_reader_get(&br, 12);
             break;
 
         default:
@@ -1187,85 +1526,107 @@ static tsdu_d_system_info_t *d_system_info_decode(const uint8_t *data, int len)
         case CELL_STATE_MODE_DISC_RADIOSWITCH:
         case CELL_STATE_MODE_DISC_BSC:
             tsdu->cell_state._data &= 0xf0;
-            cell_id_decode2(&tsdu->cell_id, data + 1);
-            tsdu->bn_id                                 = get_bits( 8, data + 3, 0);
-            tsdu->u_ch_scrambling                       = get_bits( 8, data + 4, 0);
-            tsdu->cell_radio_param.tx_max               = get_bits( 3, data + 5, 0);
-            tsdu->cell_radio_param.radio_link_timeout   = get_bits( 5, data + 5, 3);
-            tsdu->cell_radio_param.pwr_tx_adjust        = get_bits( 4, data + 6, 0);
-            tsdu->cell_radio_param.rx_lev_access        = get_bits( 4, data + 6, 4);
-            tsdu->band                                  = get_bits( 4, data + 7, 0);
-            tsdu->channel_id                            = get_bits(12, data + 7, 4);
+            // CELL_ID starts in lower half of CELL_STATE
+            bit_reader_seek(&br, 12);
+            cell_id_decode2(&tsdu->cell_id, &br);
+            tsdu->bn_id                                 = bit_reader_get(&br, 8);
+            tsdu->u_ch_scrambling                       = bit_reader_get(&br, 8);
+            tsdu->cell_radio_param.tx_max               = bit_reader_get(&br, 3);
+            tsdu->cell_radio_param.radio_link_timeout   = bit_reader_get(&br, 5);
+            tsdu->cell_radio_param.pwr_tx_adjust        = bit_reader_get(&br, 4);
+            tsdu->cell_radio_param.rx_lev_access        = bit_reader_get(&br, 4);
+            tsdu->band                                  = bit_reader_get(&br, 4);
+            tsdu->channel_id                            = bit_reader_get(&br, 12);
             break;
     }
 
     return tsdu;
 }
 
-static tsdu_d_registration_nak_t *d_registration_nak_decode(const uint8_t *data, int len)
+static tsdu_d_registration_nak_t *d_registration_nak_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_registration_nak_t *tsdu = tsdu_create(tsdu_d_registration_nak_t, 0);
+    tsdu_d_registration_nak_t *tsdu = tsdu_create(arena, tsdu_d_registration_nak_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 10, tsdu);
 
-    tsdu->cause                 = data[1];
-    const uint8_t *adr_data = &data[2];
-    if (address_decode(&tsdu->host_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->cause                 = bit_reader_get(&br, 8);
+    if (address_decode(&tsdu->host_adr, &br)) {
         LOG(ERR, "Only single address NAK is supported");
     }
-    tsdu->bn_id                 = data[7];
-    cell_id_decode1(&tsdu->cell_id, data + 8);
+    bit_reader_seek(&br, 8 * 7);
+    tsdu->bn_id                 = bit_reader_get(&br, 8);
+    cell_id_decode(&tsdu->cell_id, &br);
 
     return tsdu;
 }
 
-static tsdu_d_registration_ack_t *d_registration_ack_decode(const uint8_t *data, int len)
+static tsdu_d_registration_ack_t *d_registration_ack_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_registration_ack_t *tsdu = tsdu_create(tsdu_d_registration_ack_t, 0);
+    tsdu_d_registration_ack_t *tsdu = tsdu_create(arena, tsdu_d_registration_ack_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 14, tsdu);
 
-    tsdu->complete_reg          = data[1];
-    tsdu->rt_min_activity       = data[2];
-    tsdu->rt_status._data       = data[3];
-    const uint8_t *adr_data = &data[4];
-    if (address_decode(&tsdu->host_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->complete_reg          = bit_reader_get(&br, 8);
+    tsdu->rt_min_activity       = bit_reader_get(&br, 8);
+    tsdu->rt_status._data       = bit_reader_get(&br, 8);
+    if (address_decode(&tsdu->host_adr, &br)) {
         LOG(ERR, "Only single address ACK is supported");
     }
-    tsdu->rt_min_registration   = data[9];
-    tsdu->tlr_value             = data[10];
-    tsdu->rt_data_info._data    = data[11];
-    tsdu->group_id              = get_bits(12, data + 12, 0);
+    bit_reader_seek(&br, 8 * 9);
+    tsdu->rt_min_registration   = bit_reader_get(&br, 8);
+    tsdu->tlr_value             = bit_reader_get(&br, 8);
+    tsdu->rt_data_info._data    = bit_reader_get(&br, 8);
+    tsdu->group_id              = bit_reader_get(&br, 12);
 
     tsdu->has_coverage_id = false;
     if (len >= 16) {
-        switch(data[14]) {
+        bit_reader_seek(&br, 8 * 14);
+        const uint8_t iei = bit_reader_get(&br, 8);
+        switch(iei) {
             case IEI_COVERAGE_ID:
                 tsdu->has_coverage_id = true;
-                tsdu->coverage_id = data[15];
+                tsdu->coverage_id = bit_reader_get(&br, 8);
                 break;
 
             default:
-                LOG(WTF, "Unexpected IEI 0x%x", data[14]);
+                LOG(WTF, "Unexpected IEI 0x%x", iei);
         };
     }
 
     if (len >= 18) {
-        tsdu->iei_ddch_sub      = data[16];
-        tsdu->nb_subscription   = get_bits(4, data + 17, 0);
+        bit_reader_seek(&br, 8 * 16);
+        tsdu->iei_ddch_sub      = bit_reader_get(&br, 8);
+        tsdu->nb_subscription   = bit_reader_get(&br, 4);
+        if (tsdu->nb_subscription > ARRAY_LEN(tsdu->sub_appli_num)) {
+            LOG(WTF, "Too many subscriptions %d", tsdu->nb_subscription);
+            tsdu_destroy(&tsdu->base);
+            return NULL;
+        }
+        bit_reader_skip(&br, 4);
         for (int i = 0; i < tsdu->nb_subscription; ++i) {
-            tsdu->sub_appli_num[i]     = get_bits(4, &data[18 + 5*i], 0);
-            tsdu->subscription_info[i] = get_bits(4, &data[18 + 5*i], 4);
-            tsdu->cause[i]             = data[19 + 5*i];
-            tsdu->ddch_number[i]       = get_bits(4, &data[20 + 5*i], 0); // DDCH logical number (sur 4 bits)
-            tsdu->access_profile[i]    = get_bits(4, &data[20 + 5*i], 4);
-            tsdu->first_radio_slot[i]  = get_bits(16, &data[21 + 5*i], 0);
+            tsdu->sub_appli_num[i]     = bit_reader_get(&br, 4);
+            tsdu->subscription_info[i] = bit_reader_get(&br, 4);
+            tsdu->cause[i]             = bit_reader_get(&br, 8);
+            tsdu->ddch_number[i]       = bit_reader_get(&br, 4); // DDCH logical number (sur 4 bits)
+            tsdu->access_profile[i]    = bit_reader_get(&br, 4);
+            tsdu->first_radio_slot[i]  = bit_reader_get(&br, 16);
+            if (br.overflow) {
+                // truncated, keep complete subscriptions only
+                tsdu->nb_subscription = i;
+                break;
+            }
         }
     } else {
         tsdu->iei_ddch_sub      = 0; //TODO is there a best value to indicate that there is no subscription?
@@ -1274,26 +1635,31 @@ static tsdu_d_registration_ack_t *d_registration_ack_decode(const uint8_t *data,
     return tsdu;
 }
 
-static tsdu_d_connect_dch_t *d_connect_dch_decode(const uint8_t *data, int len)
+static tsdu_d_connect_dch_t *d_connect_dch_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_connect_dch_t *tsdu = tsdu_create(tsdu_d_connect_dch_t, 0);
+    tsdu_d_connect_dch_t *tsdu = tsdu_create(arena, tsdu_d_connect_dch_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 6, tsdu);
 
-    tsdu->dch_low_layer    = data[1];
-    tsdu->channel_id       = get_bits(12, &data[2], 4);
-    tsdu->u_ch_scrambling  = data[4];
-    tsdu->d_ch_scrambling  = data[5];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->dch_low_layer    = bit_reader_get(&br, 8);
+    bit_reader_skip(&br, 4);
+    tsdu->channel_id       = bit_reader_get(&br, 12);
+    tsdu->u_ch_scrambling  = bit_reader_get(&br, 8);
+    tsdu->d_ch_scrambling  = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
-static tsdu_d_return_t *d_return_decode(const uint8_t *data, int len)
+static tsdu_d_return_t *d_return_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_return_t *tsdu = tsdu_create(tsdu_d_return_t, 0);
+    tsdu_d_return_t *tsdu = tsdu_create(arena, tsdu_d_return_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -1305,9 +1671,10 @@ static tsdu_d_return_t *d_return_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_group_idle_t *d_group_idle_decode(const uint8_t *data, int len)
+static tsdu_d_group_idle_t *d_group_idle_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_group_idle_t *tsdu = tsdu_create(tsdu_d_group_idle_t, 0);
+    tsdu_d_group_idle_t *tsdu = tsdu_create(arena, tsdu_d_group_idle_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -1320,12 +1687,12 @@ static tsdu_d_group_idle_t *d_group_idle_decode(const uint8_t *data, int len)
 }
 
 static tsdu_d_location_activity_ack_t *d_location_activity_ack_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 2, NULL);
 
     tsdu_d_location_activity_ack_t *tsdu =
-        tsdu_create(tsdu_d_location_activity_ack_t, 0);
+        tsdu_create(arena, tsdu_d_location_activity_ack_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -1335,27 +1702,31 @@ static tsdu_d_location_activity_ack_t *d_location_activity_ack_decode(
     return tsdu;
 }
 
-static tsdu_d_ech_overload_id_t *d_ech_overload_id_decode(const uint8_t *data, int len)
+static tsdu_d_ech_overload_id_t *d_ech_overload_id_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_ech_overload_id_t *tsdu = tsdu_create(tsdu_d_ech_overload_id_t, 0);
+    tsdu_d_ech_overload_id_t *tsdu = tsdu_create(arena, tsdu_d_ech_overload_id_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 6, tsdu);
 
-    tsdu->activation_mode.hook = get_bits(2, data + 1, 0);
-    tsdu->activation_mode.type = get_bits(2, data + 1, 2);
-    tsdu->group_id = get_bits(12, data + 1, 4);
-    cell_id_decode1(&tsdu->cell_id, data + 3);
-    tsdu->organisation = get_bits(8, data + 5, 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    activation_mode_decode(&tsdu->activation_mode, &br);
+    tsdu->group_id = bit_reader_get(&br, 12);
+    cell_id_decode(&tsdu->cell_id, &br);
+    bit_reader_skip(&br, 4);
+    tsdu->organisation = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
-static tsdu_unknown_codop_t *d_unknown_parse(const uint8_t *data, int len)
+static tsdu_unknown_codop_t *d_unknown_parse(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_unknown_codop_t *tsdu = tsdu_create(tsdu_unknown_codop_t, 1);
+    tsdu_unknown_codop_t *tsdu = tsdu_create(arena, tsdu_unknown_codop_t, 1);
     if (!tsdu) {
         return NULL;
     }
@@ -1365,7 +1736,7 @@ static tsdu_unknown_codop_t *d_unknown_parse(const uint8_t *data, int len)
         return tsdu;
     }
 
-    tsdu->data = malloc(len);
+    tsdu->data = tsdu_alloc(arena, len);
     if (!tsdu->data) {
         tsdu_destroy(&tsdu->base);
         return NULL;
@@ -1376,9 +1747,10 @@ static tsdu_unknown_codop_t *d_unknown_parse(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_data_end_t *d_data_end_decode(const uint8_t *data, int len)
+static tsdu_d_data_end_t *d_data_end_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_data_end_t *tsdu = tsdu_create(tsdu_d_data_end_t, 0);
+    tsdu_d_data_end_t *tsdu = tsdu_create(arena, tsdu_d_data_end_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -1389,7 +1761,8 @@ static tsdu_d_data_end_t *d_data_end_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_functional_short_data_t *d_functional_short_data_decode(const uint8_t *data, int len)
+static tsdu_d_functional_short_data_t *d_functional_short_data_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len - 1 > SIZEOF(tsdu_d_functional_short_data_t, data)) {
         LOG(WTF, "Message too large %d > %d",
@@ -1397,34 +1770,42 @@ static tsdu_d_functional_short_data_t *d_functional_short_data_decode(const uint
         return NULL;
     }
 
-    tsdu_d_functional_short_data_t *tsdu = tsdu_create(tsdu_d_functional_short_data_t, 0);
+    tsdu_d_functional_short_data_t *tsdu = tsdu_create(arena, tsdu_d_functional_short_data_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     tsdu->data_len = len - 1;
-    memcpy(tsdu->data, &data[1], tsdu->data_len);
+    bit_reader_get_bytes(&br, tsdu->data, tsdu->data_len);
 
     return tsdu;
 }
 
 
 
-static tsdu_d_datagram_notify_t *d_datagram_notify_decode(const uint8_t *data, int len)
+static tsdu_d_datagram_notify_t *d_datagram_notify_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_datagram_notify_t *tsdu = tsdu_create(tsdu_d_datagram_notify_t, 0);
+    tsdu_d_datagram_notify_t *tsdu = tsdu_create(arena, tsdu_d_datagram_notify_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 5, tsdu);
 
-    tsdu->call_priority         = get_bits(4, data + 1, 4);
-    tsdu->message_reference     = data[2] | (data[3] << 8);
-    tsdu->key_reference._data   = data[4];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    bit_reader_skip(&br, 4);
+    tsdu->call_priority         = bit_reader_get(&br, 4);
+    const int message_reference = bit_reader_get(&br, 8);
+    tsdu->message_reference     = message_reference | (bit_reader_get(&br, 8) << 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
 
     if (len >= 7) {
-        tsdu->destination_port  = data[5] | (data[6] << 8);
+        const int destination_port = bit_reader_get(&br, 8);
+        tsdu->destination_port  = destination_port | (bit_reader_get(&br, 8) << 8);
     } else {
         tsdu->destination_port = -1;
     }
@@ -1432,56 +1813,62 @@ static tsdu_d_datagram_notify_t *d_datagram_notify_decode(const uint8_t *data, i
     return tsdu;
 }
 
-static tsdu_d_datagram_t *d_datagram_decode(const uint8_t *data, int len)
+static tsdu_d_datagram_t *d_datagram_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     if (len < 5) {
         LOG(WTF, "too short");
         return NULL;
     }
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     len -= 5;
 
-    tsdu_d_datagram_t *tsdu = malloc(sizeof(tsdu_d_datagram_t) + len);
+    tsdu_d_datagram_t *tsdu = (tsdu_d_datagram_t *)tsdu_create_(arena,
+            sizeof(tsdu_d_datagram_t) + len, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu_base_set_nopts(&tsdu->base, 0);
-
-    tsdu->call_priority = get_bits(4, data + 1, 4);
-    tsdu->message_reference = data[2] | (data[3] << 8);
-    tsdu->key_reference._data = data[4];
+    bit_reader_skip(&br, 4);
+    tsdu->call_priority = bit_reader_get(&br, 4);
+    const int message_reference = bit_reader_get(&br, 8);
+    tsdu->message_reference = message_reference | (bit_reader_get(&br, 8) << 8);
+    tsdu->key_reference._data = bit_reader_get(&br, 8);
     tsdu->len = len;
-    memcpy(tsdu->data, data + 5, len);
+    bit_reader_get_bytes(&br, tsdu->data, len);
 
     return tsdu;
 }
 
 static tsdu_d_explicit_short_data_t *d_explicit_short_data_decode(
-        const uint8_t *data, int len)
+        const uint8_t *data, int len, tsdu_arena_t *arena)
 {
     if (len < 1) {
         LOG(WTF, "too short");
         return NULL;
     }
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     len -= 1;
 
-    tsdu_d_explicit_short_data_t *tsdu = malloc(
-            sizeof(tsdu_d_explicit_short_data_t) + len);
+    tsdu_d_explicit_short_data_t *tsdu = (tsdu_d_explicit_short_data_t *)
+        tsdu_create_(arena, sizeof(tsdu_d_explicit_short_data_t) + len, 0);
     if (!tsdu) {
         LOG(ERR, "ERR OOM");
         return NULL;
     }
-    tsdu_base_set_nopts(&tsdu->base, 0);
 
     tsdu->len = len;
-    memcpy(tsdu->data, data + 1, len);
+    bit_reader_get_bytes(&br, tsdu->data, len);
 
     return tsdu;
 }
 
-static tsdu_d_call_start_t *d_call_start_decode(const uint8_t *data, int len)
+static tsdu_d_call_start_t *d_call_start_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_call_start_t *tsdu = tsdu_create(tsdu_d_call_start_t, 0);
+    tsdu_d_call_start_t *tsdu = tsdu_create(arena, tsdu_d_call_start_t, 0);
     if (!tsdu) {
         return NULL;
     }
@@ -1493,31 +1880,32 @@ static tsdu_d_call_start_t *d_call_start_decode(const uint8_t *data, int len)
     }
 
     CHECK_LEN(len, 2, tsdu);
-    ++data;
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
     --len;
 
     while (len > 0) {
-        const int iei = data[0];
-        ++data;
+        const int iei = bit_reader_get(&br, 8);
         --len;
         switch (iei) {
             case IEI_KEY_REFERENCE:
                 tsdu->has_key_reference = true;
-                tsdu->key_reference._data = data[0];
-                ++data;
+                tsdu->key_reference._data = bit_reader_get(&br, 8);
                 --len;
                 break;
 
-            case IEI_KEY_OF_CALL:
-                if (data[0] > sizeof(key_of_call_t)) {
-                    LOG(WTF, "Wrong IEI size %d", data[0]);
+            case IEI_KEY_OF_CALL: {
+                const int ie_len = bit_reader_get(&br, 8);
+                if (ie_len > (int)sizeof(key_of_call_t)) {
+                    LOG(WTF, "Wrong IEI size %d", ie_len);
+                    bit_reader_skip(&br, 8 * ie_len);
                 } else {
                     tsdu->has_key_of_call = true;
-                    memcpy(tsdu->key_of_call, &data[1], data[0]);
+                    bit_reader_get_bytes(&br, tsdu->key_of_call, ie_len);
                 }
-                len -= data[0] + 1;
-                data += data[0] + 1;
+                len -= ie_len + 1;
                 break;
+            }
 
             default:
                 LOG(WTF, "Unexpected IEI 0x%x", iei);
@@ -1532,177 +1920,201 @@ static tsdu_d_call_start_t *d_call_start_decode(const uint8_t *data, int len)
     return tsdu;
 }
 
-static tsdu_d_call_connect_t *d_call_connect_decode(const uint8_t *data, int len)
+static tsdu_d_call_connect_t *d_call_connect_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_d_call_connect_t *tsdu = tsdu_create(tsdu_d_call_connect_t, 0);
+    tsdu_d_call_connect_t *tsdu = tsdu_create(arena, tsdu_d_call_connect_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 15, tsdu);
 
-    tsdu->call_type._data       = data[1];
-    tsdu->channel_id            = get_bits(12, &data[2], 4);
-    tsdu->u_ch_scrambling       = data[4];
-    tsdu->d_ch_scrambling       = data[5];
-    tsdu->key_reference._data   = data[6];
-    memcpy(tsdu->valid_rt, &data[7], SIZEOF(tsdu_d_call_connect_t, valid_rt));
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->call_type._data       = bit_reader_get(&br, 8);
+    bit_reader_skip(&br, 4);
+    tsdu->channel_id            = bit_reader_get(&br, 12);
+    tsdu->u_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->d_ch_scrambling       = bit_reader_get(&br, 8);
+    tsdu->key_reference._data   = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->valid_rt, SIZEOF(tsdu_d_call_connect_t, valid_rt));
     tsdu->has_key_of_call =
         (tsdu->key_reference.key_type == KEY_TYPE_ESC) &&
         (tsdu->key_reference.key_index == KEY_INDEX_KEY_SUPPLIED);
     if (tsdu->has_key_of_call) {
         CHECK_LEN(len, 31, tsdu);
-        memcpy(tsdu->key_of_call, &data[15], sizeof(key_of_call_t));
+        bit_reader_get_bytes(&br, tsdu->key_of_call, sizeof(key_of_call_t));
     }
 
     return tsdu;
 }
 
 
-static tsdu_d_periodic_access_subscription_ack_t *d_periodic_access_subscription_ack_decode(const uint8_t *data, int len) // NEW
+static tsdu_d_periodic_access_subscription_ack_t *d_periodic_access_subscription_ack_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena) // NEW
 {
-    tsdu_d_periodic_access_subscription_ack_t *tsdu = tsdu_create(tsdu_d_periodic_access_subscription_ack_t, 0);
+    tsdu_d_periodic_access_subscription_ack_t *tsdu = tsdu_create(arena, tsdu_d_periodic_access_subscription_ack_t, 0);
     if (!tsdu) {
         return NULL;
     }
     //CHECK_LEN(len, 7, tsdu); //TODO to check
 
-    tsdu->iei_ddch_sub     = data[1];
-    tsdu->sub_appli_num    = get_bits(4, &data[2], 0);
-    tsdu->subscription_info= get_bits(4, &data[2], 4); // b2b1 = DDCH subscription, b4=0, b3=TYPE_ENC (=0: periodic messages not ciphered by network, 1= ciphered)
-    tsdu->cause            = data[3];
-    tsdu->ddch_number      = get_bits(4, &data[4], 0); // DDCH logical number (sur 4 bits)
-    tsdu->access_profile   = get_bits(4, &data[4], 4); // period index of the message emission (0xF not significant), sur 4 bits
-    tsdu->first_radio_slot = get_bits(16, &data[5], 0);// first DDCH slot in DDCH multiframe, 2 bytes, 0xFFFF if not significant
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->iei_ddch_sub     = bit_reader_get(&br, 8);
+    tsdu->sub_appli_num    = bit_reader_get(&br, 4);
+    tsdu->subscription_info= bit_reader_get(&br, 4); // b2b1 = DDCH subscription, b4=0, b3=TYPE_ENC (=0: periodic messages not ciphered by network, 1= ciphered)
+    tsdu->cause            = bit_reader_get(&br, 8);
+    tsdu->ddch_number      = bit_reader_get(&br, 4); // DDCH logical number (sur 4 bits)
+    tsdu->access_profile   = bit_reader_get(&br, 4); // period index of the message emission (0xF not significant), sur 4 bits
+    tsdu->first_radio_slot = bit_reader_get(&br, 16);// first DDCH slot in DDCH multiframe, 2 bytes, 0xFFFF if not significant
 
     return tsdu;
 
 }
 
 
-static tsdu_d_periodic_access_subscription_nak_t *d_periodic_access_subscription_nak_decode(const uint8_t *data, int len) // NEW
+static tsdu_d_periodic_access_subscription_nak_t *d_periodic_access_subscription_nak_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena) // NEW
 {
-    tsdu_d_periodic_access_subscription_nak_t *tsdu = tsdu_create(tsdu_d_periodic_access_subscription_nak_t, 0);
+    tsdu_d_periodic_access_subscription_nak_t *tsdu = tsdu_create(arena, tsdu_d_periodic_access_subscription_nak_t, 0);
     if (!tsdu) {
         return NULL;
     }
     //CHECK_LEN(len, 4, tsdu); //TODO to check
 
-    tsdu->iei_ddch_sub     = data[1];
-    tsdu->sub_appli_num    = get_bits(4, &data[2], 0);
-    int zero               = get_bits(4, &data[2], 4);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->iei_ddch_sub     = bit_reader_get(&br, 8);
+    tsdu->sub_appli_num    = bit_reader_get(&br, 4);
+    int zero               = bit_reader_get(&br, 4);
     if (zero != 0){
 	return NULL;
     }
-    tsdu->cause            = data[3];
+    tsdu->cause            = bit_reader_get(&br, 8);
 
     return tsdu;
 
 }
 
-static tsdu_d_tti_assignment_t *d_tti_assignment_decode(const uint8_t *data, int len) // NEW
+static tsdu_d_tti_assignment_t *d_tti_assignment_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena) // NEW
 {
-    tsdu_d_tti_assignment_t *tsdu = tsdu_create(tsdu_d_tti_assignment_t, 0);
+    tsdu_d_tti_assignment_t *tsdu = tsdu_create(arena, tsdu_d_tti_assignment_t, 0);
     
     if (!tsdu) {
         return NULL;
     }
     
-    tsdu->z = get_bits(1, &data[0], 0);
-    tsdu->y = get_bits(3, &data[0], 1);
-    tsdu->x = get_bits(12, &data[0], 4);
+    // there is no CODOP
+    bit_reader_t br;
+    bit_reader_init(&br, data, len);
+    tsdu->z = bit_reader_get(&br, 1);
+    tsdu->y = bit_reader_get(&br, 3);
+    tsdu->x = bit_reader_get(&br, 12);
 
     return tsdu;
 }
 
-static tsdu_u_registration_req_t *u_registration_req_decode(const uint8_t *data, int len)
+static tsdu_u_registration_req_t *u_registration_req_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
-    tsdu_u_registration_req_t *tsdu = tsdu_create(tsdu_u_registration_req_t, 0);
+    tsdu_u_registration_req_t *tsdu = tsdu_create(arena, tsdu_u_registration_req_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
     CHECK_LEN(len, 15, tsdu);
 
-    const uint8_t *adr_data = &data[1];
-    if (address_decode(&tsdu->host_adr, &adr_data)) {
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    if (address_decode(&tsdu->host_adr, &br)) {
         LOG(ERR, "Only single address ACK is supported");
     }
-    tsdu->serial_nb[0]          = get_bits(4, data + 7, 0);
-    tsdu->serial_nb[1]          = get_bits(4, data + 7, 4);
-    tsdu->serial_nb[2]          = get_bits(4, data + 8, 0);
-    tsdu->serial_nb[3]          = get_bits(4, data + 8, 4);
-    tsdu->serial_nb[4]          = get_bits(4, data + 9, 0);
-    tsdu->serial_nb[5]          = get_bits(4, data + 9, 4);
-    tsdu->serial_nb[6]          = get_bits(4, data + 10, 0);
-    tsdu->serial_nb[7]          = get_bits(4, data + 10, 4);
-    tsdu->reg_seq               = get_bits(16, data + 11, 0);
-    tsdu->complete_reg          = data[12];
-    tsdu->rt_status._data       = data[13];
+    bit_reader_seek(&br, 8 * 7);
+    for (int i = 0; i < 8; ++i) {
+        tsdu->serial_nb[i]      = bit_reader_get(&br, 4);
+    }
+    tsdu->reg_seq               = bit_reader_get(&br, 16);
+    bit_reader_seek(&br, 8 * 12);
+    tsdu->complete_reg          = bit_reader_get(&br, 8);
+    tsdu->rt_status._data       = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
-static tsdu_u_data_request_t *u_data_request_decode(const uint8_t *data, int len)
+static tsdu_u_data_request_t *u_data_request_decode(const uint8_t *data, int len,
+        tsdu_arena_t *arena)
 {
     CHECK_LEN(len, 5, NULL);
 
-    tsdu_u_data_request_t *tsdu = tsdu_create(tsdu_u_data_request_t, 0);
+    tsdu_u_data_request_t *tsdu = tsdu_create(arena, tsdu_u_data_request_t, 0);
     if (!tsdu) {
         return NULL;
     }
 
-    tsdu->trans_mode =      get_bits(4, &data[1], 4);
-    tsdu->trans_param1 =    get_bits(16, &data[2], 0);
-    tsdu->trans_param2 =    get_bits(16, &data[4], 0);
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    bit_reader_skip(&br, 4);
+    tsdu->trans_mode =      bit_reader_get(&br, 4);
+    tsdu->trans_param1 =    bit_reader_get(&br, 16);
+    tsdu->trans_param2 =    bit_reader_get(&br, 16);
 
     return tsdu;
 }
 
 static tsdu_u_authentication_t *
-u_authentication_decode(const uint8_t *data, int len)
+u_authentication_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_u_authentication_t *tsdu = tsdu_create(tsdu_u_authentication_t, 0);
+    tsdu_u_authentication_t *tsdu = tsdu_create(arena, tsdu_u_authentication_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 6, tsdu);
 
-    tsdu->val             = data[1];
-    memcpy(tsdu->result_rt, &data[2], sizeof(tsdu->result_rt));
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->val             = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->result_rt, sizeof(tsdu->result_rt));
 
     return tsdu;
 }
 
 static tsdu_u_terminate_t *
-u_terminate_decode(const uint8_t *data, int len)
+u_terminate_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_u_terminate_t *tsdu = tsdu_create(tsdu_u_terminate_t, 0);
+    tsdu_u_terminate_t *tsdu = tsdu_create(arena, tsdu_u_terminate_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 1, tsdu);
 
-    tsdu->cause           = data[1];
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->cause           = bit_reader_get(&br, 8);
 
     return tsdu;
 }
 
 static tsdu_u_call_connect_t *
-u_call_connect_decode(const uint8_t *data, int len)
+u_call_connect_decode(const uint8_t *data, int len, tsdu_arena_t *arena)
 {
-    tsdu_u_call_connect_t *tsdu = tsdu_create(tsdu_u_call_connect_t, 0);
+    tsdu_u_call_connect_t *tsdu = tsdu_create(arena, tsdu_u_call_connect_t, 0);
     if (!tsdu) {
         return NULL;
     }
     CHECK_LEN(len, 6, tsdu);
 
-    tsdu->val             = data[1];
-    memcpy(tsdu->result_rt, &data[2], sizeof(tsdu->result_rt));
+    bit_reader_t br;
+    tsdu_reader_init(&br, data, len);
+    tsdu->val             = bit_reader_get(&br, 8);
+    bit_reader_get_bytes(&br, tsdu->result_rt, sizeof(tsdu->result_rt));
 
     return tsdu;
 }
 
-int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu)
+int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu,
+        tsdu_arena_t *arena)
 {
     if (len < 1) {
         LOG(ERR, "%d data too short %d < %d", __LINE__, len, 1);
@@ -1717,90 +2129,90 @@ int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu)
     // @TODO do not confuse with other CODOP containing only 2 bytes
     // for now, only check 0x58 D_GROUP_IDLE, to be continued
     if (len == 2 && data[0] != 0x58) {
-        *tsdu = (tsdu_t *)d_tti_assignment_decode(data, len);
+        *tsdu = (tsdu_t *)d_tti_assignment_decode(data, len, arena);
 	const codop_t codop = 0xff; // arbitrary chosen, this value isn't in PAS
 	(*tsdu)->codop = codop; // normally d_tti_assignment has no codop number
 	return 0;
     }
 
-    const codop_t codop = get_bits(8, data, 0);
+    const codop_t codop = data[0];
 
     *tsdu = NULL;
     switch (codop) {
         case D_ABILITY_MNGT:
-            *tsdu = (tsdu_t *)d_ability_mngt_decode(data, len);
+            *tsdu = (tsdu_t *)d_ability_mngt_decode(data, len, arena);
             break;
 
         case D_ADDITIONAL_PARTICIPANTS:
-            *tsdu = (tsdu_t *)d_additional_participants_decode(data, len);
+            *tsdu = (tsdu_t *)d_additional_participants_decode(data, len, arena);
             break;
 
         case D_AUTHENTICATION:
-            *tsdu = (tsdu_t *)d_authentication_decode(data, len);
+            *tsdu = (tsdu_t *)d_authentication_decode(data, len, arena);
             break;
 
         case D_AUTHORISATION:
-            *tsdu = (tsdu_t *)d_authorisation_decode(data, len);
+            *tsdu = (tsdu_t *)d_authorisation_decode(data, len, arena);
             break;
 
         case D_CALL_ALERT:
-            *tsdu = (tsdu_t *)d_call_alert_decode(data, len);
+            *tsdu = (tsdu_t *)d_call_alert_decode(data, len, arena);
             break;
 
         case D_CALL_CONNECT:
-            *tsdu = (tsdu_t *)d_call_connect_decode(data, len);
+            *tsdu = (tsdu_t *)d_call_connect_decode(data, len, arena);
             break;
 
         case D_CALL_START:
-            *tsdu = (tsdu_t *)d_call_start_decode(data, len);
+            *tsdu = (tsdu_t *)d_call_start_decode(data, len, arena);
             break;
 
         case D_CALL_SETUP:
-            *tsdu = (tsdu_t *)d_call_setup_decode(data, len);
+            *tsdu = (tsdu_t *)d_call_setup_decode(data, len, arena);
             break;
 
         case D_CCH_OPEN:
-            *tsdu = (tsdu_t *)d_cch_open_decode(data, len);
+            *tsdu = (tsdu_t *)d_cch_open_decode(data, len, arena);
             break;
 
         case D_CONNECT_CCH:
-            *tsdu = (tsdu_t *)d_connect_cch_decode(data, len);
+            *tsdu = (tsdu_t *)d_connect_cch_decode(data, len, arena);
             break;
 
         case D_CRISIS_NOTIFICATION:
-            *tsdu = (tsdu_t *)d_crisis_notification_decode(data, len);
+            *tsdu = (tsdu_t *)d_crisis_notification_decode(data, len, arena);
             break;
 
         case D_DATA_AUTHENTICATION:
-            *tsdu = (tsdu_t *)d_data_authentication_decode(data, len);
+            *tsdu = (tsdu_t *)d_data_authentication_decode(data, len, arena);
             break;
 
         case D_DATA_END:
-            *tsdu = (tsdu_t *)d_data_end_decode(data, len);
+            *tsdu = (tsdu_t *)d_data_end_decode(data, len, arena);
             break;
 
         case D_DATA_MSG_DOWN:
-            *tsdu = (tsdu_t *)d_data_msg_down_decode(data, len);
+            *tsdu = (tsdu_t *)d_data_msg_down_decode(data, len, arena);
             break;
 
         case D_DATA_REQUEST:
-            *tsdu = (tsdu_t *)d_data_request_decode(data, len);
+            *tsdu = (tsdu_t *)d_data_request_decode(data, len, arena);
             break;
 
         case D_DATAGRAM:
-            *tsdu = (tsdu_t *)d_datagram_decode(data, len);
+            *tsdu = (tsdu_t *)d_datagram_decode(data, len, arena);
             break;
 
         case D_DATAGRAM_NOTIFY:
-            *tsdu = (tsdu_t *)d_datagram_notify_decode(data, len);
+            *tsdu = (tsdu_t *)d_datagram_notify_decode(data, len, arena);
             break;
 
         case D_DCH_OPEN:
-            *tsdu = (tsdu_t *)d_dch_open_decode(data, len);
+            *tsdu = (tsdu_t *)d_dch_open_decode(data, len, arena);
             break;
 
         case D_DDCH_DESCRIPTION: // NEW
-            *tsdu = (tsdu_t *)d_ddch_description_decode(data, len);
+            *tsdu = (tsdu_t *)d_ddch_description_decode(data, len, arena);
 		if (!*tsdu) {
 		    LOG(ERR, "Decoding failed.");
 		} else {
@@ -1809,167 +2221,167 @@ int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu)
             break;
 
         case D_ECH_ACTIVATION: // NEW
-	    *tsdu = (tsdu_t *)d_ech_activation_decode(data, len);
+	    *tsdu = (tsdu_t *)d_ech_activation_decode(data, len, arena);
 	    break;
 
         case D_ECH_OVERLOAD_ID:
-            *tsdu = (tsdu_t *)d_ech_overload_id_decode(data, len);
+            *tsdu = (tsdu_t *)d_ech_overload_id_decode(data, len, arena);
             break;
 
 	case D_EMERGENCY_NOTIFICATION: // NEW
-	    *tsdu = (tsdu_t *)d_emergency_notification_decode(data, len);
+	    *tsdu = (tsdu_t *)d_emergency_notification_decode(data, len, arena);
 	    break;
 
         case D_EXPLICIT_SHORT_DATA:
-            *tsdu = (tsdu_t *)d_explicit_short_data_decode(data, len);
+            *tsdu = (tsdu_t *)d_explicit_short_data_decode(data, len, arena);
             break;
 
         case D_FUNCTIONAL_SHORT_DATA: // NEW
-            *tsdu = (tsdu_t *)d_functional_short_data_decode(data, len);
+            *tsdu = (tsdu_t *)d_functional_short_data_decode(data, len, arena);
             break;  
 
         case D_FORCED_REGISTRATION:
-            *tsdu = (tsdu_t *)d_forced_registration_decode(data, len);
+            *tsdu = (tsdu_t *)d_forced_registration_decode(data, len, arena);
             break;
 
         case D_GROUP_ACTIVATION:
-            *tsdu = (tsdu_t *)d_group_activation_decode(data, len);
+            *tsdu = (tsdu_t *)d_group_activation_decode(data, len, arena);
             break;
 
         case D_GROUP_COMPOSITION:
-            *tsdu = (tsdu_t *)d_group_composition_decode(data, len);
+            *tsdu = (tsdu_t *)d_group_composition_decode(data, len, arena);
             break;
 
         case D_GROUP_LIST:
-            *tsdu = (tsdu_t *)d_group_list_decode(data, len);
+            *tsdu = (tsdu_t *)d_group_list_decode(data, len, arena);
             break;
 
         case D_GROUP_PAGING:
-            *tsdu = (tsdu_t *)d_group_paging_decode(data, len);
+            *tsdu = (tsdu_t *)d_group_paging_decode(data, len, arena);
             break;
 
         case D_GROUP_REJECT:
-            *tsdu = (tsdu_t *)d_group_reject_decode(data, len);
+            *tsdu = (tsdu_t *)d_group_reject_decode(data, len, arena);
             break;
 
         case D_HOOK_ON_INVITATION:
-            *tsdu = (tsdu_t *)d_hook_on_invitation_decode(data, len);
+            *tsdu = (tsdu_t *)d_hook_on_invitation_decode(data, len, arena);
             break;
 
         case D_LOCATION_ACTIVITY_ACK:
-            *tsdu = (tsdu_t *)d_location_activity_ack_decode(data, len);
+            *tsdu = (tsdu_t *)d_location_activity_ack_decode(data, len, arena);
             break;
 
         case D_NEIGHBOURING_CELL:
-            *tsdu = (tsdu_t *)d_neighbouring_cell_decode(data, len);
+            *tsdu = (tsdu_t *)d_neighbouring_cell_decode(data, len, arena);
             break;
 
         case D_SYSTEM_INFO:
-            *tsdu = (tsdu_t *)d_system_info_decode(data, len);
+            *tsdu = (tsdu_t *)d_system_info_decode(data, len, arena);
             break;
 
         case D_REGISTRATION_NAK:
-            *tsdu = (tsdu_t *)d_registration_nak_decode(data, len);
+            *tsdu = (tsdu_t *)d_registration_nak_decode(data, len, arena);
             break;
 
         case D_REGISTRATION_ACK:
-            *tsdu = (tsdu_t *)d_registration_ack_decode(data, len);
+            *tsdu = (tsdu_t *)d_registration_ack_decode(data, len, arena);
             break;
 
         case D_CONNECT_DCH:
-            *tsdu = (tsdu_t *)d_connect_dch_decode(data, len);
+            *tsdu = (tsdu_t *)d_connect_dch_decode(data, len, arena);
             break;
 
         case D_REFUSAL:
-            *tsdu = (tsdu_t *)d_refusal_decode(data, len);
+            *tsdu = (tsdu_t *)d_refusal_decode(data, len, arena);
             break;
 
         case D_REJECT:
-            *tsdu = (tsdu_t *)d_reject_decode(data, len);
+            *tsdu = (tsdu_t *)d_reject_decode(data, len, arena);
             break;
 
         case D_RELEASE:
-            *tsdu = (tsdu_t *)d_release_decode(data, len);
+            *tsdu = (tsdu_t *)d_release_decode(data, len, arena);
             break;
 
         case D_RETURN:
-            *tsdu = (tsdu_t *)d_return_decode(data, len);
+            *tsdu = (tsdu_t *)d_return_decode(data, len, arena);
             break;
 
         case D_GROUP_IDLE:
-            *tsdu = (tsdu_t *)d_group_idle_decode(data, len);
+            *tsdu = (tsdu_t *)d_group_idle_decode(data, len, arena);
             break;
 
         case D_PERIODIC_ACCESS_SUBSCRIPTION_ACK: // NEW
-            *tsdu = (tsdu_t *)d_periodic_access_subscription_ack_decode(data, len);
+            *tsdu = (tsdu_t *)d_periodic_access_subscription_ack_decode(data, len, arena);
             break;
 
         case D_PERIODIC_ACCESS_SUBSCRIPTION_NAK: // NEW
-            *tsdu = (tsdu_t *)d_periodic_access_subscription_nak_decode(data, len);
+            *tsdu = (tsdu_t *)d_periodic_access_subscription_nak_decode(data, len, arena);
             break;
 
         case U_AUTHENTICATION:
-            *tsdu = (tsdu_t *)u_authentication_decode(data, len);
+            *tsdu = (tsdu_t *)u_authentication_decode(data, len, arena);
             break;
 
         case U_CALL_CONNECT_U_CALL_SWITCH:
-            *tsdu = (tsdu_t *)u_call_connect_decode(data, len);
+            *tsdu = (tsdu_t *)u_call_connect_decode(data, len, arena);
             break;
 
         case U_DATA_REQUEST:
-            *tsdu = (tsdu_t *)u_data_request_decode(data, len);
+            *tsdu = (tsdu_t *)u_data_request_decode(data, len, arena);
             break;
 
         case U_REGISTRATION_REQ:
-            *tsdu = (tsdu_t *)u_registration_req_decode(data, len);
+            *tsdu = (tsdu_t *)u_registration_req_decode(data, len, arena);
             break;
 
         case U_TERMINATE:
-            *tsdu = (tsdu_t *)u_terminate_decode(data, len);
+            *tsdu = (tsdu_t *)u_terminate_decode(data, len, arena);
             break;
 
         case D_BROADCAST:
-	    *tsdu = (tsdu_t *)d_broadcast_decode(data, len);
+	    *tsdu = (tsdu_t *)d_broadcast_decode(data, len, arena);
 	    break;
 
         case D_BROADCAST_NOTIFICATION:
-	    *tsdu = (tsdu_t *)d_broadcast_notification_decode(data, len);
+	    *tsdu = (tsdu_t *)d_broadcast_notification_decode(data, len, arena);
 	    break;
 
         case D_BROADCAST_WAITING:
-	    *tsdu = (tsdu_t *)d_broadcast_waiting_decode(data, len);
+	    *tsdu = (tsdu_t *)d_broadcast_waiting_decode(data, len, arena);
 	    break;
 
         case D_CALL_SWITCH:
-	    *tsdu = (tsdu_t *)d_call_switch_decode(data, len);
+	    *tsdu = (tsdu_t *)d_call_switch_decode(data, len, arena);
 	    break;
 	
         case D_DATA_DOWN_STATUS:
-	    *tsdu = (tsdu_t *)d_data_down_status_decode(data, len);
+	    *tsdu = (tsdu_t *)d_data_down_status_decode(data, len, arena);
 	    break;
 	
         case D_ECH_REJECT:
-	    *tsdu = (tsdu_t *)d_ech_reject_decode(data, len);
+	    *tsdu = (tsdu_t *)d_ech_reject_decode(data, len, arena);
 	    break;
 	
         case D_EMERGENCY_NAK:
-	    *tsdu = (tsdu_t *)d_emergency_nak_decode(data, len);
+	    *tsdu = (tsdu_t *)d_emergency_nak_decode(data, len, arena);
 	    break;
 	
         case D_EXTENDED_STATUS:
-	    *tsdu = (tsdu_t *)d_extended_status_decode(data, len);
+	    *tsdu = (tsdu_t *)d_extended_status_decode(data, len, arena);
 	    break;
 	
         case D_GROUP_END:
-	    *tsdu = (tsdu_t *)d_group_end_decode(data, len);
+	    *tsdu = (tsdu_t *)d_group_end_decode(data, len, arena);
 	    break;
         
 	case D_TRANSFER_NAK:
-	    *tsdu = (tsdu_t *)d_transfer_nak_decode(data, len);
+	    *tsdu = (tsdu_t *)d_transfer_nak_decode(data, len, arena);
 	    break;
 	
         case D_INFORMATION_DELIVERY:
-	    *tsdu = (tsdu_t *)d_information_delivery_decode(data, len);
+	    *tsdu = (tsdu_t *)d_information_delivery_decode(data, len, arena);
 	    break;
 
         case D_ACCESS_DISABLED:
@@ -2015,12 +2427,12 @@ int tsdu_decode(const uint8_t *data, int len, tsdu_t **tsdu)
         case U_OCH_SETUP:
         case U_TRANSFER_REQ:
             LOG(ERR, "Unsupported codop 0x%02x", codop);
-            *tsdu = (tsdu_t *)d_unknown_parse(data, len);
+            *tsdu = (tsdu_t *)d_unknown_parse(data, len, arena);
             break;
 
         default:
             LOG(WTF, "Unknown codop=0x%02x", codop);
-            *tsdu = (tsdu_t *)d_unknown_parse(data, len);
+            *tsdu = (tsdu_t *)d_unknown_parse(data, len, arena);
             break;
     }
 
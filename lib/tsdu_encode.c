@@ -0,0 +1,298 @@
+#define LOG_PREFIX "tsdu_encode"
+
+#include <tetrapol/log.h>
+#include <tetrapol/tsdu_encode.h>
+#include <tetrapol/misc.h>
+#include <tetrapol/bit_utils.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#define CHECK_SIZE(size, len) \
+    if ((size) < (len)) { \
+        LOG(ERR, "buffer too short %d < %d", (size), (len)); \
+        return -1; \
+    }
+
+static void cell_id_encode1(uint8_t *data, const cell_id_t *cell_id)
+{
+    set_bits(2, data, 0, CELL_ID_FORMAT_0);
+    set_bits(6, data, 2, cell_id->bs_id);
+    set_bits(4, data, 8, cell_id->rsw_id);
+}
+
+// specific for d_system_info - cell in offline mode
+static void cell_id_encode2(uint8_t *data, const cell_id_t *cell_id)
+{
+    set_bits(2, data, 8, CELL_ID_FORMAT_0);
+    set_bits(6, data, 10, cell_id->bs_id);
+    set_bits(4, data, 4, cell_id->rsw_id);
+}
+
+static void cell_radio_param_encode(uint8_t *data,
+        const cell_radio_param_t *crp)
+{
+    set_bits(3, data, 0, crp->tx_max);
+    set_bits(5, data, 3, crp->radio_link_timeout);
+    set_bits(4, data, 8, crp->pwr_tx_adjust);
+    set_bits(4, data, 12, crp->rx_lev_access);
+}
+
+/// host address has fixed size of 5 bytes (RFSI address)
+static int host_adr_encode(uint8_t *data, const address_t *host_adr)
+{
+    uint8_t buf[8];
+    const int len = address_encode(buf, host_adr, false);
+    if (len < 0 || len > 5) {
+        LOG(ERR, "unsupported host address");
+        return -1;
+    }
+    memset(data, 0, 5);
+    memcpy(data, buf, len);
+
+    return 0;
+}
+
+static int d_authentication_encode(const tsdu_d_authentication_t *tsdu,
+        uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 16);
+
+    memset(&data[1], 0, 15);
+    data[1] = tsdu->key_reference._data;
+    memcpy(&data[2], tsdu->valid_rt, sizeof(tsdu->valid_rt));
+
+    return 16;
+}
+
+static int d_connect_dch_encode(const tsdu_d_connect_dch_t *tsdu,
+        uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 6);
+
+    data[1] = tsdu->dch_low_layer;
+    data[2] = 0;
+    set_bits(12, &data[2], 4, tsdu->channel_id);
+    data[4] = tsdu->u_ch_scrambling;
+    data[5] = tsdu->d_ch_scrambling;
+
+    return 6;
+}
+
+static int d_explicit_short_data_encode(
+        const tsdu_d_explicit_short_data_t *tsdu, uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 1 + tsdu->len);
+
+    memcpy(&data[1], tsdu->data, tsdu->len);
+
+    return 1 + tsdu->len;
+}
+
+static int d_group_activation_encode(const tsdu_d_group_activation_t *tsdu,
+        uint8_t *data, int size)
+{
+    const int len = tsdu->has_addr_tti ? 12 : 9;
+    CHECK_SIZE(size, len);
+
+    set_bits(2,  data + 1, 0, tsdu->activation_mode.hook);
+    set_bits(2,  data + 1, 2, tsdu->activation_mode.type);
+    set_bits(12, data + 1, 4, tsdu->group_id);
+    data[3] = tsdu->coverage_id;
+    data[4] = 0;
+    set_bits(12, data + 4, 4, tsdu->channel_id);
+    data[6] = tsdu->u_ch_scrambling;
+    data[7] = tsdu->d_ch_scrambling;
+    data[8] = tsdu->key_reference._data;
+    if (tsdu->has_addr_tti) {
+        data[9] = IEI_TTI;
+        addr_build(&data[10], &tsdu->addr_tti);
+    }
+
+    return len;
+}
+
+/// D_GROUP_END, D_GROUP_IDLE and D_RETURN carry only cause
+static int cause_encode(uint8_t cause, uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 2);
+
+    data[1] = cause;
+
+    return 2;
+}
+
+static int d_location_activity_ack_encode(
+        const tsdu_d_location_activity_ack_t *tsdu, uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 2);
+
+    data[1] = tsdu->rt_status._data;
+
+    return 2;
+}
+
+static int d_registration_ack_encode(const tsdu_d_registration_ack_t *tsdu,
+        uint8_t *data, int size)
+{
+    int len = 14;
+    if (tsdu->has_coverage_id) {
+        len += 2;
+        // subscriptions follows coverage_id only
+        if (tsdu->nb_subscription) {
+            len += 2 + 5 * tsdu->nb_subscription;
+        }
+    }
+    if (tsdu->nb_subscription > ARRAY_LEN(tsdu->sub_appli_num)) {
+        LOG(ERR, "too many subscriptions %d", tsdu->nb_subscription);
+        return -1;
+    }
+    CHECK_SIZE(size, len);
+
+    data[1] = tsdu->complete_reg;
+    data[2] = tsdu->rt_min_activity;
+    data[3] = tsdu->rt_status._data;
+    if (host_adr_encode(&data[4], &tsdu->host_adr)) {
+        return -1;
+    }
+    data[9] = tsdu->rt_min_registration;
+    data[10] = tsdu->tlr_value;
+    data[11] = tsdu->rt_data_info._data;
+    data[13] = 0;
+    set_bits(12, data + 12, 0, tsdu->group_id);
+
+    if (!tsdu->has_coverage_id) {
+        return len;
+    }
+    data[14] = IEI_COVERAGE_ID;
+    data[15] = tsdu->coverage_id;
+
+    if (!tsdu->nb_subscription) {
+        return len;
+    }
+    data[16] = tsdu->iei_ddch_sub;
+    data[17] = 0;
+    set_bits(4, data + 17, 0, tsdu->nb_subscription);
+    for (int i = 0; i < tsdu->nb_subscription; ++i) {
+        set_bits(4, &data[18 + 5*i], 0, tsdu->sub_appli_num[i]);
+        set_bits(4, &data[18 + 5*i], 4, tsdu->subscription_info[i]);
+        data[19 + 5*i] = tsdu->cause[i];
+        set_bits(4, &data[20 + 5*i], 0, tsdu->ddch_number[i]);
+        set_bits(4, &data[20 + 5*i], 4, tsdu->access_profile[i]);
+        set_bits(16, &data[21 + 5*i], 0, tsdu->first_radio_slot[i]);
+    }
+
+    return len;
+}
+
+static int d_registration_nak_encode(const tsdu_d_registration_nak_t *tsdu,
+        uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 10);
+
+    data[1] = tsdu->cause;
+    if (host_adr_encode(&data[2], &tsdu->host_adr)) {
+        return -1;
+    }
+    data[7] = tsdu->bn_id;
+    data[9] = 0;
+    cell_id_encode1(&data[8], &tsdu->cell_id);
+
+    return 10;
+}
+
+static int d_system_info_encode(const tsdu_d_system_info_t *tsdu,
+        uint8_t *data, int size)
+{
+    if (tsdu->cell_state.mode == CELL_STATE_MODE_NORMAL) {
+        CHECK_SIZE(size, 17);
+
+        memset(&data[1], 0, 16);
+        data[1] = tsdu->cell_state._data;
+        data[2] = tsdu->cell_config._data;
+        data[3] = tsdu->country_code;
+        data[4] = tsdu->system_id._data;
+        data[5] = tsdu->loc_area_id._data;
+        data[6] = tsdu->bn_id;
+        cell_id_encode1(&data[7], &tsdu->cell_id);
+        set_bits(12, data + 8, 4, tsdu->cell_bn._data);
+        data[10] = tsdu->u_ch_scrambling;
+        cell_radio_param_encode(&data[11], &tsdu->cell_radio_param);
+        data[13] = tsdu->system_time;
+        data[14] = tsdu->cell_access._data;
+        set_bits(4, data + 15, 0, tsdu->_unused_1);
+        set_bits(12, data + 15, 4, tsdu->superframe_cpt);
+
+        return 17;
+    }
+
+    CHECK_SIZE(size, 9);
+
+    memset(&data[1], 0, 8);
+    // low 4 bits of cell_state are used by cell_id
+    data[1] = tsdu->cell_state._data & 0xf0;
+    cell_id_encode2(&data[1], &tsdu->cell_id);
+    data[3] = tsdu->bn_id;
+    data[4] = tsdu->u_ch_scrambling;
+    cell_radio_param_encode(&data[5], &tsdu->cell_radio_param);
+    set_bits(4, data + 7, 0, tsdu->band);
+    set_bits(12, data + 7, 4, tsdu->channel_id);
+
+    return 9;
+}
+
+int tsdu_encode(const tsdu_t *tsdu, uint8_t *data, int size)
+{
+    CHECK_SIZE(size, 1);
+
+    data[0] = tsdu->codop;
+    switch (tsdu->codop) {
+        case D_AUTHENTICATION:
+            return d_authentication_encode(
+                    (const tsdu_d_authentication_t *)tsdu, data, size);
+
+        case D_CONNECT_DCH:
+            return d_connect_dch_encode(
+                    (const tsdu_d_connect_dch_t *)tsdu, data, size);
+
+        case D_EXPLICIT_SHORT_DATA:
+            return d_explicit_short_data_encode(
+                    (const tsdu_d_explicit_short_data_t *)tsdu, data, size);
+
+        case D_GROUP_ACTIVATION:
+            return d_group_activation_encode(
+                    (const tsdu_d_group_activation_t *)tsdu, data, size);
+
+        case D_GROUP_END:
+            return cause_encode(
+                    ((const tsdu_d_group_end_t *)tsdu)->cause, data, size);
+
+        case D_GROUP_IDLE:
+            return cause_encode(
+                    ((const tsdu_d_group_idle_t *)tsdu)->cause, data, size);
+
+        case D_LOCATION_ACTIVITY_ACK:
+            return d_location_activity_ack_encode(
+                    (const tsdu_d_location_activity_ack_t *)tsdu, data, size);
+
+        case D_REGISTRATION_ACK:
+            return d_registration_ack_encode(
+                    (const tsdu_d_registration_ack_t *)tsdu, data, size);
+
+        case D_REGISTRATION_NAK:
+            return d_registration_nak_encode(
+                    (const tsdu_d_registration_nak_t *)tsdu, data, size);
+
+        case D_RETURN:
+            return cause_encode(
+                    ((const tsdu_d_return_t *)tsdu)->cause, data, size);
+
+        case D_SYSTEM_INFO:
+            return d_system_info_encode(
+                    (const tsdu_d_system_info_t *)tsdu, data, size);
+
+        default:
+            LOG(ERR, "unsupported TSDU codop 0x%02x", tsdu->codop);
+            return -1;
+    }
+}
@@ -18,17 +18,17 @@ static const char *addr_json(char *buf, const addr_t *addr)
 
 void tsdu_json(const tpol_t *tpol, const tpol_tsdu_t *tsdu)
 {
-    printf("{ \"event\": \"tsdu\", ");
-    printf("\"rx_offs\": %lu, ", tpol->rx_offs);
+    FILE *out = tetrapol_evt_begin(tpol, "tsdu");
+    fprintf(out, "\"rx_offs\": %lu, ", tpol->rx_offs);
 
-    printf("\"tsdu\": { ");
+    fprintf(out, "\"tsdu\": { ");
     {
         char buf[SPRINTF_BUF_LEN];  ///< buffer for sprintf
 
         if (tpol->frame_no != FRAME_NO_UNKNOWN) {
-            printf("\"frame_no\": %d, ", tpol->frame_no);
+            fprintf(out, "\"frame_no\": %d, ", tpol->frame_no);
         } else {
-            printf("\"frame_no\": null, ");
+            fprintf(out, "\"frame_no\": null, ");
         }
 
         const char *log_ch_str;
@@ -45,8 +45,8 @@ void tsdu_json(const tpol_t *tpol, const tpol_tsdu_t *tsdu)
             default:
                 log_ch_str = "FIXME";
         };
-        printf("\"log_ch\": \"%s\", ", log_ch_str);
-        printf("\"addr\": %s, ", addr_json(buf, &tsdu->addr));
+        fprintf(out, "\"log_ch\": \"%s\", ", log_ch_str);
+        fprintf(out, "\"addr\": %s, ", addr_json(buf, &tsdu->addr));
 
         const char *tpdu_type;
         switch (tsdu->tpdu_type) {
@@ -54,36 +54,37 @@ void tsdu_json(const tpol_t *tpol, const tpol_tsdu_t *tsdu)
             case TPDU_TYPE_TPDU_UI: tpdu_type = "TPDU_UI";  break;
             default:                tpdu_type = "FIXME";
         };
-        printf("\"tpdu_type\": \"%s\", ", tpdu_type);
+        fprintf(out, "\"tpdu_type\": \"%s\", ", tpdu_type);
 
         if (tsdu->tsap_id != TSAP_ID_UNKNOWN) {
-            printf("\"tsap_id\": %d, ", tsdu->tsap_id);
+            fprintf(out, "\"tsap_id\": %d, ", tsdu->tsap_id);
         } else {
-            printf("\"tsap_id\": null, ");
+            fprintf(out, "\"tsap_id\": null, ");
         }
 
         if (tsdu->tpdu_type == TPDU_TYPE_TPDU) {
             if (tsdu->tsap_ref_swmi != TSAP_REF_UNKNOWN) {
-                printf("\"tsap_ref_swmi\": %d, ", tsdu->tsap_ref_swmi);
+                fprintf(out, "\"tsap_ref_swmi\": %d, ", tsdu->tsap_ref_swmi);
             } else {
-                printf("\"tsap_ref_swmi\": null, ");
+                fprintf(out, "\"tsap_ref_swmi\": null, ");
             }
             if (tsdu->tsap_ref_rt != TSAP_REF_UNKNOWN) {
-                printf("\"tsap_ref_rt\": %d, ", tsdu->tsap_ref_rt);
+                fprintf(out, "\"tsap_ref_rt\": %d, ", tsdu->tsap_ref_rt);
             } else {
-                printf("\"tsap_ref_rt\": null, ");
+                fprintf(out, "\"tsap_ref_rt\": null, ");
             }
         } else if (tsdu->tpdu_type == TPDU_TYPE_TPDU_UI) {
         }
 
         if ( (2 * tsdu->data_len + 1) <= sizeof(buf)) {
-            printf("\"data\": { \"encoding\": \"hex\", \"value\": \"%s\" } ",
+            fprintf(out, "\"data\": { \"encoding\": \"hex\", \"value\": \"%s\" } ",
                     sprint_hex2(buf, tsdu->data, tsdu->data_len));
         } else {
-            printf("\"data\": null");
+            fprintf(out, "\"data\": null");
         }
     }
-    printf("} ");
+    fprintf(out, "} ");
 
-    printf("}\n");
+    fprintf(out, "}\n");
+    tetrapol_evt_end(tpol);
 }
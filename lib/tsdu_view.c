@@ -0,0 +1,345 @@
+#include <tetrapol/tsdu_view.h>
+#include <tetrapol/bit_utils.h>
+
+#include <stdint.h>
+
+/**
+  Position of fixed fields, PAS 0001-3-2 4.4, must match decoders in tsdu.c.
+  X(codop, FIELD, byte offset, bit offset, number of bits)
+  */
+#define TSDU_VIEW_LAYOUT(X) \
+    X(D_ECH_ACTIVATION,         ACTIVATION_MODE,    1, 0,  4) \
+    X(D_ECH_REJECT,             ACTIVATION_MODE,    1, 0,  4) \
+    X(D_GROUP_ACTIVATION,       ACTIVATION_MODE,    1, 0,  4) \
+    X(D_GROUP_PAGING,           ACTIVATION_MODE,    1, 0,  4) \
+    X(D_GROUP_REJECT,           ACTIVATION_MODE,    1, 0,  4) \
+    \
+    X(D_BROADCAST,              CALL_PRIORITY,      1, 4,  4) \
+    X(D_DATAGRAM,               CALL_PRIORITY,      1, 4,  4) \
+    X(D_DATAGRAM_NOTIFY,        CALL_PRIORITY,      1, 4,  4) \
+    X(D_EXTENDED_STATUS,        CALL_PRIORITY,      8, 0,  4) \
+    \
+    X(D_NEIGHBOURING_CELL,      CCR_NUMBER,         1, 4,  4) \
+    \
+    X(D_CALL_CONNECT,           CHANNEL_ID,         2, 4, 12) \
+    X(D_CALL_SWITCH,            CHANNEL_ID,         2, 4, 12) \
+    X(D_CONNECT_DCH,            CHANNEL_ID,         2, 4, 12) \
+    X(D_ECH_ACTIVATION,         CHANNEL_ID,         4, 4, 12) \
+    X(D_GROUP_ACTIVATION,       CHANNEL_ID,         4, 4, 12) \
+    \
+    X(D_ADDITIONAL_PARTICIPANTS, COVERAGE_ID,       1, 0,  8) \
+    X(D_CRISIS_NOTIFICATION,    COVERAGE_ID,        7, 0,  8) \
+    X(D_GROUP_ACTIVATION,       COVERAGE_ID,        3, 0,  8) \
+    X(D_GROUP_PAGING,           COVERAGE_ID,        3, 0,  8) \
+    X(D_GROUP_REJECT,           COVERAGE_ID,        3, 0,  8) \
+    \
+    X(D_ECH_ACTIVATION,         GROUP_ID,           1, 4, 12) \
+    X(D_ECH_OVERLOAD_ID,        GROUP_ID,           1, 4, 12) \
+    X(D_ECH_REJECT,             GROUP_ID,           1, 4, 12) \
+    X(D_GROUP_ACTIVATION,       GROUP_ID,           1, 4, 12) \
+    X(D_GROUP_COMPOSITION,      GROUP_ID,           1, 0, 12) \
+    X(D_GROUP_PAGING,           GROUP_ID,           1, 4, 12) \
+    X(D_GROUP_REJECT,           GROUP_ID,           1, 4, 12) \
+    X(D_REGISTRATION_ACK,       GROUP_ID,          12, 0, 12) \
+    \
+    X(D_AUTHENTICATION,         KEY_REFERENCE,      1, 0,  8) \
+    X(D_BROADCAST,              KEY_REFERENCE,      4, 0,  8) \
+    X(D_CALL_CONNECT,           KEY_REFERENCE,      6, 0,  8) \
+    X(D_CALL_SWITCH,            KEY_REFERENCE,      6, 0,  8) \
+    X(D_DATAGRAM,               KEY_REFERENCE,      4, 0,  8) \
+    X(D_DATAGRAM_NOTIFY,        KEY_REFERENCE,      4, 0,  8) \
+    X(D_ECH_ACTIVATION,         KEY_REFERENCE,      8, 0,  8) \
+    X(D_GROUP_ACTIVATION,       KEY_REFERENCE,      8, 0,  8) \
+    X(D_GROUP_PAGING,           KEY_REFERENCE,      4, 0,  8) \
+    \
+    X(D_GROUP_LIST,             REFERENCE_LIST,     1, 0,  8)
+
+/// X(codop, FIELD, byte offset) of first byte of address
+#define TSDU_VIEW_ADDRESS_LAYOUT(X) \
+    X(D_CALL_SETUP,             CALLING_ADR,        1) \
+    X(D_CALL_SWITCH,            CALLING_ADR,       15) \
+    X(D_CRISIS_NOTIFICATION,    CALLING_ADR,        1) \
+    X(D_DATA_DOWN_STATUS,       RT_ID,              8) \
+    X(D_EMERGENCY_NOTIFICATION, CALLING_ADR,        1) \
+    X(D_EXTENDED_STATUS,        CALLING_ADR,        3) \
+    X(D_EXTENDED_STATUS,        CALLED_ADR,         9) \
+    X(D_FORCED_REGISTRATION,    CALLING_ADR,        1) \
+    X(D_REGISTRATION_ACK,       HOST_ADR,           4) \
+    X(D_REGISTRATION_NAK,       HOST_ADR,           2) \
+    X(U_REGISTRATION_REQ,       HOST_ADR,           1)
+
+/// X(codop, byte offset) of CELL_ID
+#define TSDU_VIEW_CELL_ID_LAYOUT(X) \
+    X(D_DATA_DOWN_STATUS,       3) \
+    X(D_ECH_ACTIVATION,         3) \
+    X(D_ECH_OVERLOAD_ID,        3) \
+    X(D_ECH_REJECT,             3) \
+    X(D_EMERGENCY_NOTIFICATION, 6) \
+    X(D_REGISTRATION_NAK,       8)
+
+#define LAYOUT_KEY(codop, field) (((codop) << 8) | (field))
+
+bool tsdu_view_init(tsdu_view_t *view, const uint8_t *data, int len)
+{
+    view->data = data;
+    view->len = len;
+    if (len < 1) {
+        view->codop = 0;
+        return false;
+    }
+
+    // D_TTI_ASSIGNMENT has no CODOP, see tsdu_decode()
+    if (len == 2 && data[0] != D_GROUP_IDLE) {
+        view->codop = 0xff;
+    } else {
+        view->codop = data[0];
+    }
+
+    return true;
+}
+
+/// Set reader to given byte of TSDU data.
+static void view_reader_init(const tsdu_view_t *view, bit_reader_t *br,
+        int offs)
+{
+    bit_reader_init(br, view->data, view->len);
+    bit_reader_seek(br, 8 * offs);
+}
+
+static int view_bits(const tsdu_view_t *view, int offs, int skip, int nbits)
+{
+    bit_reader_t br;
+    view_reader_init(view, &br, offs);
+    bit_reader_skip(&br, skip);
+    const int val = bit_reader_get(&br, nbits);
+
+    return br.overflow ? -1 : val;
+}
+
+int tsdu_view_get(const tsdu_view_t *view, tsdu_field_t field)
+{
+    switch (LAYOUT_KEY(view->codop, field)) {
+#define X(codop, FIELD, offs, skip, nbits) \
+        case LAYOUT_KEY(codop, TSDU_FIELD_ ## FIELD): \
+            return view_bits(view, offs, skip, nbits);
+        TSDU_VIEW_LAYOUT(X)
+#undef X
+
+        default:
+            return -1;
+    }
+}
+
+bool tsdu_view_get_address(const tsdu_view_t *view, tsdu_field_t field,
+        address_t *address)
+{
+    int offs;
+    switch (LAYOUT_KEY(view->codop, field)) {
+#define X(codop, FIELD, offs_) \
+        case LAYOUT_KEY(codop, TSDU_FIELD_ ## FIELD): \
+            offs = offs_; \
+            break;
+        TSDU_VIEW_ADDRESS_LAYOUT(X)
+#undef X
+
+        default:
+            return false;
+    }
+
+    bit_reader_t br;
+    view_reader_init(view, &br, offs);
+    address_decode(address, &br);
+
+    return !br.overflow;
+}
+
+bool tsdu_view_cell_id(const tsdu_view_t *view, cell_id_t *cell_id)
+{
+    int offs;
+    switch (view->codop) {
+#define X(codop, offs_) \
+        case codop: \
+            offs = offs_; \
+            break;
+        TSDU_VIEW_CELL_ID_LAYOUT(X)
+#undef X
+
+        default:
+            return false;
+    }
+
+    if (view->len < offs + 2) {
+        return false;
+    }
+    bit_reader_t br;
+    view_reader_init(view, &br, offs);
+    cell_id_decode(cell_id, &br);
+
+    return true;
+}
+
+static int group_list_entry_len(int type)
+{
+    switch (type) {
+        case TYPE_NB_TYPE_EMERGENCY:    return 2;
+        case TYPE_NB_TYPE_OPEN:         return 5;
+        case TYPE_NB_TYPE_TALK_GROUP:   return 4;
+        default:                        return 0;
+    }
+}
+
+/**
+  Walk entries of D_GROUP_LIST, only entries fully contained in data are
+  considered.
+
+  @param type Type of entries to count/find.
+  @param idx Index of requested entry or -1 to walk whole list.
+  @param n Set to number of walked entries of given type.
+  @return Offset of requested entry or -1.
+  */
+static int group_list_walk(const tsdu_view_t *view, int type,
+        int idx, int *n)
+{
+    *n = 0;
+    if (view->codop != D_GROUP_LIST || view->len < 2) {
+        return -1;
+    }
+
+    const reference_list_t reference_list = { ._data = view->data[1], };
+    if (reference_list.revision == 0) {
+        return -1;
+    }
+
+    int offs = 3;
+    while (offs < view->len) {
+        const type_nb_t type_nb = { ._data = view->data[offs], };
+        if (type_nb.type == TYPE_NB_TYPE_END) {
+            break;
+        }
+        ++offs;
+
+        const int entry_len = group_list_entry_len(type_nb.type);
+        for (int i = 0; i < type_nb.number; ++i) {
+            if (offs + entry_len > view->len) {
+                return -1;
+            }
+            if (type_nb.type == type) {
+                if (*n == idx) {
+                    return offs;
+                }
+                ++*n;
+            }
+            offs += entry_len;
+        }
+    }
+
+    return -1;
+}
+
+int tsdu_view_group_list_len(const tsdu_view_t *view, int type)
+{
+    if (view->codop != D_GROUP_LIST) {
+        return -1;
+    }
+
+    int n;
+    group_list_walk(view, type, -1, &n);
+
+    return n;
+}
+
+bool tsdu_view_group_list_emergency(const tsdu_view_t *view, int i,
+        tsdu_d_group_list_emergency_t *emergency)
+{
+    int n;
+    const int offs = group_list_walk(view, TYPE_NB_TYPE_EMERGENCY, i, &n);
+    if (offs < 0) {
+        return false;
+    }
+    bit_reader_t br;
+    view_reader_init(view, &br, offs);
+    cell_id_decode(&emergency->cell_id, &br);
+
+    return true;
+}
+
+bool tsdu_view_group_list_open(const tsdu_view_t *view, int i,
+        tsdu_d_group_list_open_t *open)
+{
+    int n;
+    const int offs = group_list_walk(view, TYPE_NB_TYPE_OPEN, i, &n);
+    if (offs < 0) {
+        return false;
+    }
+    bit_reader_t br;
+    view_reader_init(view, &br, offs);
+    open->coverage_id           = bit_reader_get(&br, 8);
+    open->call_priority         = bit_reader_get(&br, 4);
+    open->group_id              = bit_reader_get(&br, 12);
+    bit_reader_skip(&br, 2);
+    open->och_parameters.add    = bit_reader_get(&br, 1);
+    open->och_parameters.mbn    = bit_reader_get(&br, 1);
+    open->neighbouring_cell     = bit_reader_get(&br, 12);
+
+    return true;
+}
+
+bool tsdu_view_group_list_talk_group(const tsdu_view_t *view, int i,
+        tsdu_d_group_list_talk_group_t *group)
+{
+    int n;
+    const int offs = group_list_walk(view, TYPE_NB_TYPE_TALK_GROUP, i, &n);
+    if (offs < 0) {
+        return false;
+    }
+    bit_reader_t br;
+    view_reader_init(view, &br, offs);
+    group->coverage_id          = bit_reader_get(&br, 8);
+    bit_reader_skip(&br, 8 + 3);
+    group->tkg_parameters.mbn   = bit_reader_get(&br, 1);
+    group->neighbouring_cell    = bit_reader_get(&br, 12);
+
+    return true;
+}
+
+int tsdu_view_adj_cell_channel_id(const tsdu_view_t *view, int i)
+{
+    const int number = tsdu_view_ccr_number(view);
+    if (i < 0 || i >= number || view->len < 3 + 3 * number) {
+        return -1;
+    }
+
+    return view_bits(view, 3 + 3 * i, 4, 12);
+}
+
+bool tsdu_view_adj_cell_id(const tsdu_view_t *view, int i,
+        cell_id_t *cell_id)
+{
+    // IEs follows list of adjacent cells, which must not be empty
+    const int number = tsdu_view_ccr_number(view);
+    if (i < 0 || number <= 0) {
+        return false;
+    }
+
+    int offs = 3 + 3 * number;
+    while (offs + 2 <= view->len) {
+        const uint8_t iei = view->data[offs];
+        const uint8_t ie_len = view->data[offs + 1];
+        offs += 2;
+        if (offs + ie_len > view->len) {
+            return false;
+        }
+        if (iei == IEI_CELL_ID_LIST) {
+            if (i < ie_len / 2) {
+                bit_reader_t br;
+                view_reader_init(view, &br, offs + 2 * i);
+                cell_id_decode(cell_id, &br);
+                return true;
+            }
+            i -= ie_len / 2;
+        }
+        offs += ie_len;
+    }
+
+    return false;
+}